@@ -0,0 +1,112 @@
+// Copyright 2015 Dario Domizioli
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CORE_CHARS_BUILD_SPACE_H
+#define CORE_CHARS_BUILD_SPACE_H
+
+#include "core/chars/Roster.h"
+#include "core/game/Character.h"
+#include "core/game/Move.h"
+
+#include <stdint.h>
+#include <string>
+
+namespace core {
+namespace chars {
+
+/**
+ * \brief A legal character build, like the ones of
+ *        game::generateRandomCharacter: RA, AT and DF of at least 1 adding up
+ *        to 7, an SP mode, a special move of one symbol, two special moves of
+ *        two symbols and a super move of three symbols.
+ */
+struct Build {
+    /// \brief The number of symbols of all the moves.
+    static constexpr size_t const NUM_SYMBOLS = 8;
+
+    /// \brief RA, AT and DF.
+    int ra;
+    int at;
+    int df;
+    /// \brief The SP gain mode.
+    game::SPMode sp;
+    /// \brief The symbols of the moves: the first special move has symbol 0,
+    ///        the second 1 and 2, the third 3 and 4, the super 5 to 7.
+    game::MoveSymbol symbols[NUM_SYMBOLS];
+
+    /// \brief Equality operator.
+    bool operator==(Build const &other) const;
+};
+
+/**
+ * \brief The space of all the legal builds. Builds which only differ by the
+ *        order of the symbols of a move, or by swapping the second and third
+ *        special moves, are equivalent; each equivalence class has one
+ *        canonical build with a stable id, from 0 to size() - 1.
+ */
+class BuildSpace {
+public:
+    /// \brief Returns the number of canonical builds.
+    static uint64_t size();
+
+    /// \brief Makes a build canonical: sorts the symbols of each move and
+    ///        the second and third special moves.
+    static void canonicalize(Build &build);
+
+    /// \brief Returns the id of a legal build, canonical or not.
+    static uint64_t getId(Build const &build);
+
+    /// \brief Returns the canonical build of an id below size().
+    static Build getBuild(uint64_t id);
+
+    /// \brief Describes a build as a roster entry named "Build<id>", with the
+    ///        given AIs (see makeCharacter).
+    static CharacterSpec getSpec(Build const &build,
+                                 std::string const &attack_ai,
+                                 std::string const &defence_ai);
+};
+
+/**
+ * \brief This class enumerates a range of canonical builds lazily, so that the
+ *        whole space is never in memory; ranges can be split into shards to
+ *        run on several threads or processes.
+ */
+class BuildEnumerator {
+public:
+    /// \brief Enumerates the ids from 'first' to 'last' excluded; 'last' is
+    ///        clamped to BuildSpace::size().
+    BuildEnumerator(uint64_t first, uint64_t last);
+
+    /// \brief Returns the enumerator of shard 'index' out of 'count' equal
+    ///        contiguous shards of the whole space.
+    static BuildEnumerator shard(uint64_t index, uint64_t count);
+
+    /// \brief Gets the next build and its id; returns false at the end.
+    bool next(Build &build, uint64_t &id);
+
+    /// \brief Returns the first id and the end of the range.
+    uint64_t first() const { return m_first; }
+    uint64_t last() const { return m_last; }
+
+private:
+    /// The range and the next id.
+    uint64_t m_first;
+    uint64_t m_last;
+    uint64_t m_next;
+};
+
+}
+}
+
+#endif
@@ -24,6 +24,13 @@
 namespace core {
 namespace chars {
 
+/// \brief Returns the built-in roster of the original Musha Shugyo, in text
+///        form (see readRoster).
+char const * getOriginalRoster();
+
+/// \brief Returns the built-in roster of the Siege of Syde expansion.
+char const * getSiegeOfSydeRoster();
+
 /// \brief Returns a list of the characters of the original Musha Shugyo.
 std::vector<std::shared_ptr<game::Character>> getOriginalCharacters();
 
@@ -0,0 +1,90 @@
+// Copyright 2015 Dario Domizioli
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CORE_CHARS_RANDOM_CHARACTERS_H
+#define CORE_CHARS_RANDOM_CHARACTERS_H
+
+#include "core/chars/BuildSpace.h"
+#include "core/chars/Roster.h"
+#include "core/game/Character.h"
+
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace core {
+namespace chars {
+
+/// \brief The options of the bulk generation of random characters.
+struct GenerationOptions {
+    /// \brief Default values: no characters, seed 0, one thread, evolving
+    ///        AIs only, duplicates allowed, names "Char<n>".
+    GenerationOptions()
+      : count(0), seed(0), threads(1), allow_expert_systems(false),
+        unique(false), prefix("Char") {}
+
+    /// \brief The number of characters.
+    size_t count;
+    /// \brief The seed; the same seed always gives the same characters.
+    uint64_t seed;
+    /// \brief The number of threads; zero means the hardware threads. The
+    ///        characters do not depend on it.
+    unsigned threads;
+    /// \brief Whether expert systems can be chosen, like in
+    ///        game::generateRandomCharacter.
+    bool allow_expert_systems;
+    /// \brief Whether two characters can never have equivalent builds (see
+    ///        BuildSpace).
+    bool unique;
+    /// \brief The prefix of the names; character n is "<prefix><n>".
+    std::string prefix;
+};
+
+/// \brief A build drawn at random, with its AIs: 'combination' is the expert
+///        system combination, or -1 for the evolving AIs.
+struct RandomBuild {
+    Build build;
+    int combination;
+};
+
+/**
+ * \brief Draws the build of character 'index' from its own random stream,
+ *        with the same distribution as game::generateRandomCharacter; the
+ *        stream only depends on the seed, the index and the attempt, which
+ *        tells apart the draws replacing a duplicate.
+ */
+RandomBuild drawRandomBuild(uint64_t seed, uint64_t index, unsigned attempt,
+                            bool allow_expert_systems);
+
+/// \brief Draws the builds of all the characters in parallel, redrawing the
+///        duplicates in order if asked to.
+std::vector<RandomBuild> drawRandomBuilds(GenerationOptions const &options);
+
+/// \brief Describes a random build as a roster entry.
+CharacterSpec getRandomSpec(RandomBuild const &random, std::string const &name);
+
+/// \brief Describes all the characters, without creating their AIs.
+std::vector<CharacterSpec> generateRandomSpecs(GenerationOptions const &options);
+
+/// \brief Creates all the characters in parallel; if 'build_ids' is not null,
+///        it receives the build id of each (see BuildSpace::getId).
+std::vector<std::shared_ptr<game::Character>> generateRandomCharacters(
+    GenerationOptions const &options,
+    std::vector<uint64_t> *build_ids = nullptr);
+
+}
+}
+
+#endif
@@ -0,0 +1,147 @@
+// Copyright 2015 Dario Domizioli
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CORE_CHARS_ROSTER_H
+#define CORE_CHARS_ROSTER_H
+
+#include "core/game/Character.h"
+#include "core/ctrl/CtrlInterfaces.h"
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace core {
+namespace chars {
+
+/**
+ * \brief The description of a character in a roster: everything needed to
+ *        create the Character, without creating it.
+ */
+struct CharacterSpec {
+    /// \brief The name.
+    std::string name;
+    /// \brief RA, AT and DF.
+    int ra;
+    int at;
+    int df;
+    /// \brief The SP gain mode.
+    game::SPMode sp;
+    /// \brief The names of the attack and defence AIs (see makeAttackControl
+    ///        and makeDefendControl).
+    std::string attack_ai;
+    std::string defence_ai;
+    /// \brief The special and super moves; the standard moves are implied.
+    std::vector<game::Move> moves;
+};
+
+/// \brief The maximum number of symbols of a move in a roster.
+size_t const MAX_ROSTER_SYMBOLS = 10;
+
+/// \brief Returns a new attack AI by name: "Evolve", "Markov", "TD", "MCTS",
+///        "Expectiminimax", "Dumb" or the name of an expert system (see
+///        ctrl::getAttackExpertSystem); nullptr if the name is unknown.
+std::shared_ptr<ctrl::AttackControl> makeAttackControl(std::string const &ai);
+
+/// \brief Returns a new defence AI by name, like makeAttackControl.
+std::shared_ptr<ctrl::DefendControl> makeDefendControl(std::string const &ai);
+
+/// \brief Creates a character from its description, or returns nullptr if
+///        one of its AIs is unknown.
+std::shared_ptr<game::Character> makeCharacter(CharacterSpec const &spec);
+
+/// \brief Describes an existing character.
+CharacterSpec describeCharacter(game::Character const &c);
+
+/**
+ * \brief Reads a roster in text form. Each character is a block of lines:
+ *
+ *     character <name>
+ *     stats <RA> <AT> <DF> <SP mode>
+ *     ai <attack AI> <defence AI>
+ *     special <name>: <symbols>
+ *     super <name>: <symbols>
+ *
+ * with as many moves as needed, and names as printed by game::toString.
+ * Empty lines and lines starting with '#' are ignored. Returns false and
+ * describes the problem in 'error' if the text is malformed.
+ */
+bool readRoster(std::istream &in, std::vector<CharacterSpec> &specs,
+                std::string &error);
+
+/// \brief Writes a roster in text form (see readRoster).
+void writeRoster(std::ostream &out, std::vector<CharacterSpec> const &specs);
+
+/**
+ * \brief Writes a roster in binary form, which MappedRoster reads without
+ *        parsing: a header, a fixed-size record per character and per move,
+ *        and the names. Numbers are in the byte order of this machine.
+ *        Returns false if the file cannot be written or a spec does not fit.
+ */
+bool writeBinaryRoster(std::string const &path,
+                       std::vector<CharacterSpec> const &specs,
+                       std::string &error);
+
+/**
+ * \brief This class maps a binary roster file in memory; the characters are
+ *        only created when asked for, so opening a roster of any size only
+ *        costs a check of its records.
+ */
+class MappedRoster {
+public:
+    MappedRoster();
+    ~MappedRoster();
+
+    /// A MappedRoster cannot be copied.
+    MappedRoster(MappedRoster const &other) = delete;
+    MappedRoster& operator=(MappedRoster const &other) = delete;
+
+    /// \brief Maps a binary roster file; returns false and describes the
+    ///        problem in 'error' if it cannot be mapped or is malformed.
+    bool open(std::string const &path, std::string &error);
+
+    /// \brief Unmaps the file.
+    void close();
+
+    /// \brief Returns the number of characters.
+    size_t size() const;
+
+    /// \brief Returns the name of a character, pointing into the file.
+    char const * getName(size_t i) const;
+
+    /// \brief Returns the description of a character.
+    CharacterSpec getSpec(size_t i) const;
+
+    /// \brief Creates a character.
+    std::shared_ptr<game::Character> makeCharacter(size_t i) const;
+
+private:
+    /// The mapped file and its length.
+    void *m_data;
+    size_t m_length;
+};
+
+/// \brief Reads a roster file, in text or binary form, and creates all its
+///        characters; returns false and describes the problem in 'error' if
+///        the file cannot be read. Every character has AIs of its own, so
+///        large rosters are better used through MappedRoster.
+bool loadRoster(std::string const &path,
+                std::vector<std::shared_ptr<game::Character>> &characters,
+                std::string &error);
+
+}
+}
+
+#endif
@@ -15,6 +15,7 @@
 
 // Just to have size_t.
 #include <string>
+#include <iosfwd>
 
 namespace core {
 
@@ -99,6 +100,19 @@ public:
     virtual void updateAfterMatch(game::Character const &me,
                                   game::Character const &opponent,
                                   bool has_won) = 0;
+
+    /// \brief Forgets what the control system keeps about a match of 'me'
+    ///        without learning from it, for fights whose outcome must not be
+    ///        learnt; called instead of updateAfterMatch.
+    virtual void forgetMatch(game::Character const &me);
+
+    /// \brief Writes what the control system has learnt, so that loadState
+    ///        can restore it; by default there is nothing to write.
+    virtual void saveState(std::ostream &out);
+
+    /// \brief Restores what saveState wrote; returns false if the data is
+    ///        malformed. Must not be called during a match.
+    virtual bool loadState(std::istream &in);
 };
 
 /**
@@ -163,6 +177,19 @@ public:
     virtual void updateAfterMatch(game::Character const &me,
                                   game::Character const &opponent,
                                   bool has_won) = 0;
+
+    /// \brief Forgets what the control system keeps about a match of 'me'
+    ///        without learning from it, for fights whose outcome must not be
+    ///        learnt; called instead of updateAfterMatch.
+    virtual void forgetMatch(game::Character const &me);
+
+    /// \brief Writes what the control system has learnt, so that loadState
+    ///        can restore it; by default there is nothing to write.
+    virtual void saveState(std::ostream &out);
+
+    /// \brief Restores what saveState wrote; returns false if the data is
+    ///        malformed. Must not be called during a match.
+    virtual bool loadState(std::istream &in);
 };
 
 }
@@ -14,6 +14,8 @@
 #define CORE_CTRL_DUMBCTRL_H
 
 #include "core/ctrl/CtrlInterfaces.h"
+#include "core/game/Move.h"
+#include "core/game/Character.h"
 
 namespace core {
 namespace ctrl {
@@ -126,6 +128,128 @@ public:
                           bool has_won) override;
 };
 
+// The decision functions are inline so that ExpertAttackDispatch and
+// ExpertDefenceDispatch can inline them when an expert system inherits them.
+
+inline int DumbAttackControl::shouldSpendAPToGainSP(game::Character const &me,
+                          game::Character const &opponent,
+                          bool far) {
+    return 0;
+}
+
+inline bool DumbAttackControl::shouldSpendAPToFallStanding(game::Character const &me,
+                                 game::Character const &opponent,
+                                 bool far) {
+    // Avoid death!
+    return me.cur_life == 1;
+}
+
+inline game::Move const & DumbAttackControl::getNextMove(game::Character const &me,
+                               game::Character const &opponent,
+                               bool far) {
+    for(game::Move const &m : me.moves) {
+        if(!m.isWait()) {
+            return m;
+        }
+    }
+    return game::getWaitMove();
+}
+
+inline bool DumbAttackControl::shouldSpendSPToLowerAPCost(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move,
+                                int current_ap_cost) {
+    return false;
+}
+
+inline bool DumbAttackControl::shouldSpendSPToConcatenate(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move) {
+    return false;
+}
+
+inline bool DumbAttackControl::shouldSpendSPForUltraAgility(game::Character const &me,
+                                  game::Character const &opponent,
+                                  bool far,
+                                  game::Move const &my_move) {
+    return false;
+}
+
+inline bool DumbAttackControl::shouldSpendSPToBoostAttack(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move) {
+    return false;
+}
+
+inline bool DumbAttackControl::shouldSpendSPToBoostDamage(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move) {
+    return false;
+}
+
+inline void DumbAttackControl::updateAfterMove(game::Character const &me,
+                                        game::Character const &opponent,
+                                        game::Move const &move,
+                                        bool successful) {
+    // Do nothing.
+}
+
+
+inline game::Move const & DumbDefendControl::getCounterMove(game::Character const &me,
+                                  game::Character const &opponent,
+                                  bool far,
+                                  game::Move const &opponent_move) {
+    return game::getWaitMove();
+}
+
+inline bool DumbDefendControl::shouldSpendSPToComboBreak(game::Character const &me,
+                               game::Character const &opponent,
+                               bool far,
+                               game::Move const &opponent_move) {
+    // Break only if we're about to die.
+    return opponent_move.damage(1, opponent.at, opponent.df, 0) > me.cur_life;
+}
+
+inline bool DumbDefendControl::shouldSpendSPToLowerAPCost(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move,
+                                int current_ap_cost) {
+    return false;
+}
+
+inline bool DumbDefendControl::shouldSpendSPForUltraAgility(game::Character const &me,
+                                  game::Character const &opponent,
+                                  bool far,
+                                  game::Move const &my_move) {
+    return false;
+}
+
+inline bool DumbDefendControl::shouldSpendSPToBoostDefence(game::Character const &me,
+                                 game::Character const &opponent,
+                                 bool far,
+                                 game::Move const &my_move) {
+    return false;
+}
+
+inline bool DumbDefendControl::shouldSpendSPToBoostCounterDamage(game::Character const &me,
+                                       game::Character const &opponent,
+                                       bool far,
+                                       game::Move const &my_move) {
+    return false;
+}
+
+inline void DumbDefendControl::updateAfterMove(game::Character const &me,
+                                        game::Character const &opponent,
+                                        game::Move const &move,
+                                        bool successful) {
+    // Do nothing.
+}
+
 }
 }
 
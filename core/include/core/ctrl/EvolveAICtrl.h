@@ -15,10 +15,13 @@
 
 #include "core/ctrl/CtrlInterfaces.h"
 
+#include <iosfwd>
 #include <vector>
 #include <unordered_map>
 #include <stdint.h>
 #include <mutex>
+#include <memory>
+#include <random>
 
 namespace core {
 namespace ctrl {
@@ -47,23 +50,88 @@ public:
         MAX_AIR_CASES * MAX_AT_DF_CASES * MAX_OWN_AP_CASES * MAX_OWN_SP_CASES *
         MAX_PARAM_CASES;
 
+    /// \brief The step size of updateGoodness never goes below this, so that
+    ///        the matrix keeps following an opponent that changes.
+    static constexpr double const MIN_LEARNING_RATE = 1.0 / 128.0;
+
+    /// \brief The default tolerance of hasConverged.
+    static constexpr double const DEFAULT_TOLERANCE = 0.01;
+
+    /// \brief A warm-started choice counts as updated this many times at most,
+    ///        so that it still learns fast enough to be fine-tuned.
+    static constexpr unsigned const WARM_START_VISITS = 8;
+
     /// \brief Main constructor initializes the matrix.
     DecisionMatrix();
     /// \brief Gets the currently stored "goodness" of a parametric choice.
     double getGoodness(bool down, bool in_air, int at_or_df, int own_ap, int own_sp, int parameter);
-    /// \brief Updates the currently stored "goodness" of a parametric choice.
+    /// \brief Updates the currently stored "goodness" of a parametric choice;
+    ///        the n-th update of a choice averages it in with weight 1/(n+1),
+    ///        so each choice learns at its own pace.
     void updateGoodness(bool down, bool in_air, int at_or_df, int own_ap, int own_sp, int parameter, double good);
+    /// \brief Moves the currently stored "goodness" of a parametric choice
+    ///        towards a target by a fraction 'rate' of the difference; used
+    ///        by the temporal difference AIs (see TDAIAttack).
+    void learnGoodness(bool down, bool in_air, int at_or_df, int own_ap, int own_sp, int parameter, double target, double rate);
+    /// \brief Returns the position of a parametric choice in the matrix,
+    ///        saturating AP and SP.
+    static size_t getIndex(bool down, bool in_air, int at_or_df, int own_ap, int own_sp, int parameter);
+    /// \brief Returns how many times a parametric choice has been updated,
+    ///        saturating to 65535.
+    unsigned getVisits(bool down, bool in_air, int at_or_df, int own_ap, int own_sp, int parameter) const;
+    /// \brief Returns the number of parametric choices updated at least once.
+    size_t getVisitedCells() const;
+    /// \brief Returns the total number of updates.
+    size_t getUpdates() const { return m_updates; }
+    /// \brief Returns a moving average of how much the recent updates changed
+    ///        the goodness; 1 before any update.
+    double getConvergence() const {
+        return m_recent_weight > 0.0 ? m_recent_change / m_recent_weight : 1.0;
+    }
+    /// \brief Returns whether the recent updates changed the goodness by less
+    ///        than 'tolerance' on average.
+    bool hasConverged(double tolerance = DEFAULT_TOLERANCE) const {
+        return getConvergence() < tolerance;
+    }
+    /// \brief Copies the goodness of the choices of another matrix: choice
+    ///        'p' takes the one of parameter 'parameter_map[p]', or 'p' if the
+    ///        map is shorter; choices mapped to game::NO_MOVE are not touched.
+    ///        The visits are capped to WARM_START_VISITS and the convergence
+    ///        starts again.
+    void warmStartFrom(DecisionMatrix const &other,
+                       std::vector<size_t> const &parameter_map);
+    /// \brief Writes the matrix in binary form, for load.
+    void save(std::ostream &out) const;
+    /// \brief Reads a matrix written by save; returns false if the data is
+    ///        malformed.
+    bool load(std::istream &in);
     /// \brief Dumps the state of the matrix for debugging.
     void dump(std::string const & with_name, 
               std::vector<game::Move> const &with_moves) const;
 private:
+    /// \brief Records an update of the cell at 'idx' to 'good'.
+    void record(size_t idx, double good);
+
     /// \brief The matrix of goodness probabilities of each parametric choice.
     double m_goodness[DECISION_MATRIX_SIZE];
-    /// \brief A learning factor that increases with time, representing the fact
-    ///        that initial choices count less than later choices.
-    double m_learning_factor;
+    /// \brief The number of updates of each parametric choice.
+    uint16_t m_visits[DECISION_MATRIX_SIZE];
+    /// \brief The moving average of the change made by an update, and the
+    ///        total weight of the average, which is less than 1 until there
+    ///        have been enough updates.
+    double m_recent_change;
+    double m_recent_weight;
+    /// \brief The total number of updates.
+    size_t m_updates;
 };
 
+/// \brief Returns the convergence of some matrices (see
+///        DecisionMatrix::getConvergence), weighting each by its number of
+///        updates so that the rarely used ones count little; 'extra_change'
+///        and 'extra_updates' describe one more matrix of another kind.
+double getConvergence(std::vector<DecisionMatrix const *> const &matrices,
+                      double extra_change = 0.0, size_t extra_updates = 0);
+
 /// \brief A decision that has been made.
 struct DecisionRecord {
     /// \brief Whether the opponent was down.
@@ -88,6 +156,75 @@ typedef std::vector<DecisionRecord> DecisionVector;
 /// \brief A context-based data structure for storing DecisionVectors.
 typedef std::unordered_map<size_t, DecisionVector> DecisionVectorMap;
 
+/**
+ * \brief The decisions of a whole fight and its outcome, packed in 32 bits
+ *        per decision (see packDecision).
+ */
+struct Trajectory {
+    /// \brief The packed decisions, in the order they are learnt.
+    std::vector<uint32_t> decisions;
+    /// \brief Whether the fight was won.
+    bool has_won;
+};
+
+/// \brief Packs a decision about the matrix number 'matrix' (0 to 7); AP and
+///        SP saturate like in DecisionMatrix and only whether the goodness
+///        was positive is kept.
+uint32_t packDecision(unsigned matrix, DecisionRecord const &dr);
+
+/// \brief Unpacks a decision packed with packDecision, returning the number
+///        of its matrix.
+unsigned unpackDecision(uint32_t packed, DecisionRecord &dr);
+
+/**
+ * \brief This class represents a bounded buffer of the trajectories of past
+ *        fights; once full, a new trajectory replaces the oldest one.
+ */
+class ReplayBuffer {
+public:
+    /// \brief Main ctor; a capacity of 0 keeps nothing.
+    explicit ReplayBuffer(size_t capacity = 0);
+
+    /// \brief Adds a trajectory.
+    void add(Trajectory const &trajectory);
+
+    /// \brief Returns a trajectory chosen uniformly at random; the buffer must
+    ///        not be empty.
+    Trajectory const & sample(std::default_random_engine &engine) const;
+
+    /// \brief Writes the trajectories in binary form, for load.
+    void save(std::ostream &out) const;
+
+    /// \brief Reads trajectories written by save, replacing the current ones;
+    ///        returns false if the data is malformed or exceeds the capacity.
+    bool load(std::istream &in);
+
+    /// \brief Returns the number of trajectories and the capacity.
+    size_t size() const { return m_trajectories.size(); }
+    size_t capacity() const { return m_capacity; }
+
+private:
+    /// The trajectories.
+    std::vector<Trajectory> m_trajectories;
+    /// The maximum number of trajectories.
+    size_t m_capacity;
+    /// The next trajectory to replace once full.
+    size_t m_next;
+};
+
+/**
+ * \brief The parameters of experience replay for the evolving AIs.
+ */
+struct ReplayOptions {
+    /// \brief Default values: no replay.
+    ReplayOptions() : capacity(0), replays_per_match(0) {}
+
+    /// \brief The number of past fights kept.
+    size_t capacity;
+    /// \brief The number of past fights learnt again after every fight.
+    size_t replays_per_match;
+};
+
 /**
  * \brief This class implements a positive-reinforcement MonteCarlo AI that
  *        plays the game in attack.
@@ -95,6 +232,7 @@ typedef std::unordered_map<size_t, DecisionVector> DecisionVectorMap;
 class EvolveAIAttack : public AttackControl {
 public:
     EvolveAIAttack();
+    explicit EvolveAIAttack(ReplayOptions const &replay);
     virtual ~EvolveAIAttack();
 
     char const * const getName() const override;
@@ -146,7 +284,47 @@ public:
                           game::Character const &opponent,
                           bool has_won) override;
 
+    void forgetMatch(game::Character const &me) override;
+
+    /// \brief Returns how much the learning still changes the decisions, see
+    ///        DecisionMatrix::getConvergence.
+    virtual double getConvergence();
+
+    /// \brief Returns whether getConvergence is below 'tolerance'.
+    bool hasConverged(double tolerance = DecisionMatrix::DEFAULT_TOLERANCE);
+
+    /// \brief Writes the decision matrices and the replay buffer.
+    void saveState(std::ostream &out) override;
+
+    /// \brief Restores what saveState wrote.
+    bool loadState(std::istream &in) override;
+
+    /// \brief Learns again from 'count' past fights sampled from the replay
+    ///        buffer; returns how many were replayed.
+    size_t replay(size_t count);
+
+    /// \brief Initialises the decisions from those learnt by the AI of a
+    ///        similar character; 'move_map' gives the move of 'other' to use
+    ///        for each of our moves (see game::mapMoves).
+    virtual void warmStartFrom(EvolveAIAttack &other,
+                               std::vector<size_t> const &move_map);
+
 protected:
+    /// \brief Returns all the decision matrices.
+    std::vector<DecisionMatrix const *> getMatrices() const;
+
+    /// \brief Learns from the decisions of a fight.
+    void learn(Trajectory const &trajectory);
+
+    /// \brief Replays without locking.
+    size_t replayLocked(size_t count);
+
+    /// The past fights.
+    ReplayBuffer m_replay_buffer;
+
+    /// The number of past fights learnt again after every fight.
+    size_t m_replays_per_match;
+
     /// Decision matrix for investing APs into SPs, if necessary.
     DecisionMatrix m_ap_to_sp_matrix;
 
@@ -206,6 +384,8 @@ protected:
  */
 class EvolveAIDefence : public DefendControl {
 public:
+    EvolveAIDefence();
+    explicit EvolveAIDefence(ReplayOptions const &replay);
     ~EvolveAIDefence();
 
     char const * const getName() const override;
@@ -250,7 +430,47 @@ public:
                           game::Character const &opponent,
                           bool has_won) override;
 
+    void forgetMatch(game::Character const &me) override;
+
+    /// \brief Returns how much the learning still changes the decisions, see
+    ///        DecisionMatrix::getConvergence.
+    virtual double getConvergence();
+
+    /// \brief Returns whether getConvergence is below 'tolerance'.
+    bool hasConverged(double tolerance = DecisionMatrix::DEFAULT_TOLERANCE);
+
+    /// \brief Writes the decision matrices and the replay buffer.
+    void saveState(std::ostream &out) override;
+
+    /// \brief Restores what saveState wrote.
+    bool loadState(std::istream &in) override;
+
+    /// \brief Learns again from 'count' past fights sampled from the replay
+    ///        buffer; returns how many were replayed.
+    size_t replay(size_t count);
+
+    /// \brief Initialises the decisions from those learnt by the AI of a
+    ///        similar character; 'move_map' gives the move of 'other' to use
+    ///        for each of our moves (see game::mapMoves).
+    void warmStartFrom(EvolveAIDefence &other,
+                       std::vector<size_t> const &move_map);
+
 protected:
+    /// \brief Returns all the decision matrices.
+    std::vector<DecisionMatrix const *> getMatrices() const;
+
+    /// \brief Learns from the decisions of a fight.
+    void learn(Trajectory const &trajectory);
+
+    /// \brief Replays without locking.
+    size_t replayLocked(size_t count);
+
+    /// The past fights.
+    ReplayBuffer m_replay_buffer;
+
+    /// The number of past fights learnt again after every fight.
+    size_t m_replays_per_match;
+
     /// Decision matrix for choosing the counter move.
     DecisionMatrix m_move_matrix;
 
@@ -293,6 +513,18 @@ protected:
 };
 
 
+/// \brief Returns whether the learning AIs of a Character have converged;
+///        the controls which do not learn always have.
+bool hasConverged(game::Character const &c,
+                  double tolerance = DecisionMatrix::DEFAULT_TOLERANCE);
+
+/// \brief Initialises the evolving AIs of 'c' from those of the most similar
+///        character in 'trained' (see game::similarity) which has evolving AIs
+///        of its own; returns that character, or nullptr if there is none.
+std::shared_ptr<game::Character> warmStart(
+    game::Character &c,
+    std::vector<std::shared_ptr<game::Character>> const &trained);
+
 /**
  * \brief This class represents a decision matrix for the Markov Attack AI. It
  *        is of the order of hundreds of kilobytes, so quite manageable.
@@ -317,17 +549,41 @@ public:
     MarkovDecisionMatrix();
     /// \brief Gets the currently stored "goodness" of a parametric choice.
     double getGoodness(int at_or_df, int own_ap, int own_sp, int parameter[3]);
-    /// \brief Updates the currently stored "goodness" of a parametric choice.
+    /// \brief Updates the currently stored "goodness" of a parametric choice,
+    ///        like DecisionMatrix::updateGoodness.
     void updateGoodness(int at_or_df, int own_ap, int own_sp, int parameter[3], double good);
+    /// \brief Returns the position of a parametric choice in the matrix,
+    ///        saturating AP and SP.
+    static size_t getIndex(int at_or_df, int own_ap, int own_sp, int parameter[3]);
+    /// \brief Returns the total number of updates.
+    size_t getUpdates() const { return m_updates; }
+    /// \brief See DecisionMatrix::getConvergence.
+    double getConvergence() const {
+        return m_recent_weight > 0.0 ? m_recent_change / m_recent_weight : 1.0;
+    }
+    /// \brief Copies the goodness of the choices of another matrix, like
+    ///        DecisionMatrix::warmStartFrom; each of the three parameters is
+    ///        mapped, and a choice is not touched if any of them maps to
+    ///        game::NO_MOVE.
+    void warmStartFrom(MarkovDecisionMatrix const &other,
+                       std::vector<size_t> const &parameter_map);
+    /// \brief Writes the matrix in binary form, for load.
+    void save(std::ostream &out) const;
+    /// \brief Reads a matrix written by save; returns false if the data is
+    ///        malformed.
+    bool load(std::istream &in);
     /// \brief Dumps the state of the matrix for debugging.
     void dump(std::string const & with_name, 
               std::vector<game::Move> const &with_moves) const;
 private:
     /// \brief The matrix of goodness probabilities of each parametric choice.
     double m_goodness[DECISION_MATRIX_SIZE];
-    /// \brief A learning factor that increases with time, representing the fact
-    ///        that initial choices count less than later choices.
-    double m_learning_factor;
+    /// \brief The number of updates of each parametric choice.
+    uint16_t m_visits[DECISION_MATRIX_SIZE];
+    /// \brief See DecisionMatrix.
+    double m_recent_change;
+    double m_recent_weight;
+    size_t m_updates;
 };
 
 /// \brief A decision that has been made.
@@ -369,6 +625,19 @@ public:
                           game::Character const &opponent,
                           bool has_won) override;
 
+    void forgetMatch(game::Character const &me) override;
+
+    double getConvergence() override;
+
+    void saveState(std::ostream &out) override;
+
+    bool loadState(std::istream &in) override;
+
+    /// \brief Also initialises the Markovian decisions if 'other' is a
+    ///        MarkovAIAttack.
+    void warmStartFrom(EvolveAIAttack &other,
+                       std::vector<size_t> const &move_map) override;
+
 private:
     /// Markovian decision matrix for choosing the next move.
     MarkovDecisionMatrix m_markov_matrix;
@@ -0,0 +1,260 @@
+// Copyright 2015 Dario Domizioli
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CORE_CTRL_EXPECTIMINIMAXCTRL_H
+#define CORE_CTRL_EXPECTIMINIMAXCTRL_H
+
+#include "core/ctrl/CtrlInterfaces.h"
+#include "core/game/Duel.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace core {
+namespace ctrl {
+
+/**
+ * \brief The parameters of an expectiminimax search; see ExpectiminimaxAttack.
+ */
+struct ExpectiminimaxOptions {
+    /// \brief Default values: 20ms per decision, depth up to 8, the Balanced
+    ///        expert systems as policy, 2^16 table entries.
+    ExpectiminimaxOptions();
+
+    /// \brief Time per decision in milliseconds; the deepest search that was
+    ///        completed in time is used. 0 means no limit.
+    double milliseconds;
+    /// \brief The maximum depth, in attacks.
+    int max_depth;
+    /// \brief The expert system combination which takes the decisions that
+    ///        are not searched (see getAttackExpertSystem).
+    int policy;
+    /// \brief The base 2 logarithm of the number of entries of the table.
+    unsigned table_bits;
+};
+
+/// \brief The kind of value stored in a TranspositionEntry.
+enum TranspositionBound : uint8_t {
+    TB_NONE,    ///< The entry is empty.
+    TB_EXACT,   ///< The value is exact.
+    TB_LOWER,   ///< The value is a lower bound.
+    TB_UPPER    ///< The value is an upper bound.
+};
+
+/// \brief The result of searching a fight state.
+struct TranspositionEntry {
+    uint64_t key;
+    float value;
+    int8_t depth;
+    TranspositionBound bound;
+    uint8_t best_move;
+};
+
+/**
+ * \brief This class represents a fixed size hash table of searched fight
+ *        states; an entry is replaced by a search of the same depth or deeper,
+ *        or by another state.
+ */
+class TranspositionTable {
+public:
+    /// \brief Main ctor; the table has 2^bits entries.
+    explicit TranspositionTable(unsigned bits);
+
+    /// \brief Returns the entry for the key, or null.
+    TranspositionEntry const * find(uint64_t key) const;
+
+    /// \brief Stores an entry.
+    void store(TranspositionEntry const &entry);
+
+    /// \brief Returns the number of lookups and how many were found.
+    size_t lookups() const { return m_lookups; }
+    size_t hits() const { return m_hits; }
+
+private:
+    /// The entries.
+    std::vector<TranspositionEntry> m_entries;
+    /// The mask from a key to an index.
+    uint64_t m_mask;
+    /// Statistics.
+    mutable size_t m_lookups;
+    mutable size_t m_hits;
+};
+
+/// \brief Returns the key of a fight state in a TranspositionTable.
+uint64_t hashDuelState(game::DuelState const &state);
+
+/**
+ * \brief This class implements an expectiminimax AI that plays the game in
+ *        attack.
+ *
+ * The search runs over the states of the fight between two attacks. At each
+ * state the attacker chooses a move, maximizing the value for us or
+ * minimizing it for the opponent, and then chance nodes enumerate every roll
+ * of the dice during the attack (see game::ScriptedDiceSource). The other
+ * decisions, like counters and spending SP, are taken by the policy. The
+ * candidates are ordered by damage so that alpha-beta cuts come early, and
+ * the search is deepened one attack at a time until the time runs out.
+ *
+ * The table of searched states is kept for the whole fight, so the next
+ * decisions start from what the previous ones found.
+ */
+class ExpectiminimaxAttack : public AttackControl {
+public:
+    explicit ExpectiminimaxAttack(
+        ExpectiminimaxOptions const &options = ExpectiminimaxOptions());
+    virtual ~ExpectiminimaxAttack();
+
+    char const * const getName() const override;
+
+    int shouldSpendAPToGainSP(game::Character const &me,
+                              game::Character const &opponent,
+                              bool far) override;
+
+    bool shouldSpendAPToFallStanding(game::Character const &me,
+                                     game::Character const &opponent,
+                                     bool far) override;
+
+    game::Move const & getNextMove(game::Character const &me,
+                                   game::Character const &opponent,
+                                   bool far) override;
+
+    bool shouldSpendSPToLowerAPCost(game::Character const &me,
+                                    game::Character const &opponent,
+                                    bool far,
+                                    game::Move const &my_move,
+                                    int current_ap_cost) override;
+
+    bool shouldSpendSPToConcatenate(game::Character const &me,
+                                    game::Character const &opponent,
+                                    bool far,
+                                    game::Move const &my_move) override;
+
+    bool shouldSpendSPForUltraAgility(game::Character const &me,
+                                      game::Character const &opponent,
+                                      bool far,
+                                      game::Move const &my_move) override;
+
+    bool shouldSpendSPToBoostAttack(game::Character const &me,
+                                    game::Character const &opponent,
+                                    bool far,
+                                    game::Move const &my_move) override;
+
+    bool shouldSpendSPToBoostDamage(game::Character const &me,
+                                    game::Character const &opponent,
+                                    bool far,
+                                    game::Move const &my_move) override;
+
+    void updateAfterMove(game::Character const &me,
+                         game::Character const &opponent,
+                         game::Move const &move,
+                         bool successful) override;
+
+    void updateAfterMatch(game::Character const &me,
+                          game::Character const &opponent,
+                          bool has_won) override;
+
+    void forgetMatch(game::Character const &me) override;
+
+    /// \brief Returns the table used in the current fight of 'me', creating
+    ///        it if needed.
+    std::shared_ptr<TranspositionTable> getTable(game::Character const &me);
+
+private:
+    /// The search parameters.
+    ExpectiminimaxOptions m_options;
+    /// The policy, for the decisions that are not searched.
+    std::shared_ptr<AttackControl> m_policy;
+    /// The tables, per Character uid.
+    std::unordered_map<size_t, std::shared_ptr<TranspositionTable>> m_tables;
+    /// Content mutex to protect against multi-threading.
+    std::mutex m_content_mutex;
+};
+
+/**
+ * \brief This class implements an expectiminimax AI that plays the game in
+ *        defence; the counters are searched like the moves of
+ *        ExpectiminimaxAttack, replaying the attack they answer.
+ */
+class ExpectiminimaxDefence : public DefendControl {
+public:
+    explicit ExpectiminimaxDefence(
+        ExpectiminimaxOptions const &options = ExpectiminimaxOptions());
+    virtual ~ExpectiminimaxDefence();
+
+    char const * const getName() const override;
+
+    game::Move const & getCounterMove(game::Character const &me,
+                                      game::Character const &opponent,
+                                      bool far,
+                                      game::Move const &opponent_move) override;
+
+    bool shouldSpendSPToComboBreak(game::Character const &me,
+                                   game::Character const &opponent,
+                                   bool far,
+                                   game::Move const &opponent_move) override;
+
+    bool shouldSpendSPToLowerAPCost(game::Character const &me,
+                                    game::Character const &opponent,
+                                    bool far,
+                                    game::Move const &my_move,
+                                    int current_ap_cost) override;
+
+    bool shouldSpendSPForUltraAgility(game::Character const &me,
+                                      game::Character const &opponent,
+                                      bool far,
+                                      game::Move const &my_move) override;
+
+    bool shouldSpendSPToBoostDefence(game::Character const &me,
+                                     game::Character const &opponent,
+                                     bool far,
+                                     game::Move const &my_move) override;
+
+    bool shouldSpendSPToBoostCounterDamage(game::Character const &me,
+                                           game::Character const &opponent,
+                                           bool far,
+                                           game::Move const &my_move) override;
+
+    void updateAfterMove(game::Character const &me,
+                         game::Character const &opponent,
+                         game::Move const &move,
+                         bool successful) override;
+
+    void updateAfterMatch(game::Character const &me,
+                          game::Character const &opponent,
+                          bool has_won) override;
+
+    void forgetMatch(game::Character const &me) override;
+
+    /// \brief Returns the table used in the current fight of 'me', creating
+    ///        it if needed.
+    std::shared_ptr<TranspositionTable> getTable(game::Character const &me);
+
+private:
+    /// The search parameters.
+    ExpectiminimaxOptions m_options;
+    /// The policy, for the decisions that are not searched.
+    std::shared_ptr<DefendControl> m_policy;
+    /// The tables, per Character uid.
+    std::unordered_map<size_t, std::shared_ptr<TranspositionTable>> m_tables;
+    /// Content mutex to protect against multi-threading.
+    std::mutex m_content_mutex;
+};
+
+}
+}
+
+#endif
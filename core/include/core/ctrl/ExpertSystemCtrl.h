@@ -15,8 +15,10 @@
 
 #include "core/ctrl/CtrlInterfaces.h"
 #include "core/ctrl/DumbCtrl.h"
+#include "core/game/Move.h"
 
 #include <memory>
+#include <vector>
 
 namespace core {
 namespace ctrl {
@@ -32,7 +34,7 @@ namespace ctrl {
 /**
  * \brief This class implements the Grunt expert system in attack.
  */
-class GruntAtk : public DumbAttackControl {
+class GruntAtk final : public DumbAttackControl {
 public:
     virtual ~GruntAtk();
 
@@ -76,7 +78,7 @@ public:
 /**
  * \brief This class implements the Brawler expert system in attack.
  */
-class BrawlerAtk : public DumbAttackControl {
+class BrawlerAtk final : public DumbAttackControl {
 public:
     virtual ~BrawlerAtk();
 
@@ -121,7 +123,7 @@ public:
 /**
  * \brief This class implements the Buffer expert system in attack.
  */
-class BufferAtk : public DumbAttackControl {
+class BufferAtk final : public DumbAttackControl {
 public:
     virtual ~BufferAtk();
 
@@ -165,7 +167,7 @@ public:
 /**
  * \brief This class implements the CounterAttacker expert system in attack.
  */
-class CounterAttackerAtk : public DumbAttackControl {
+class CounterAttackerAtk final : public DumbAttackControl {
 public:
     virtual ~CounterAttackerAtk();
 
@@ -183,7 +185,7 @@ public:
 /**
  * \brief This class implements the KillerChain expert system in attack.
  */
-class KillerChainAtk : public DumbAttackControl {
+class KillerChainAtk final : public DumbAttackControl {
 public:
     virtual ~KillerChainAtk();
 
@@ -227,7 +229,7 @@ public:
 /**
  * \brief This class implements the Kite or Sniper expert system in attack.
  */
-class KiteSniperAtk : public DumbAttackControl {
+class KiteSniperAtk final : public DumbAttackControl {
 public:
     virtual ~KiteSniperAtk();
 
@@ -271,7 +273,7 @@ public:
 /**
  * \brief This class implements the Sniper expert system in attack.
  */
-class SniperAtk : public DumbAttackControl {
+class SniperAtk final : public DumbAttackControl {
 public:
     virtual ~SniperAtk();
 
@@ -315,7 +317,7 @@ public:
 /**
  * \brief This class implements the Balanced expert system in attack.
  */
-class BalancedAtk : public DumbAttackControl {
+class BalancedAtk final : public DumbAttackControl {
 public:
     virtual ~BalancedAtk();
 
@@ -359,7 +361,7 @@ public:
 /**
  * \brief This class implements the Tactical expert system in attack.
  */
-class TacticalAtk : public DumbAttackControl {
+class TacticalAtk final : public DumbAttackControl {
 public:
     virtual ~TacticalAtk();
 
@@ -411,7 +413,7 @@ public:
 /**
  * \brief This class implements the Grunt expert system in defence.
  */
-class GruntDef : public DumbDefendControl {
+class GruntDef final : public DumbDefendControl {
 public:
     virtual ~GruntDef();
 
@@ -426,7 +428,7 @@ public:
 /**
  * \brief This class implements the Brawler expert system in defence.
  */
-class BrawlerDef : public DumbDefendControl {
+class BrawlerDef final : public DumbDefendControl {
 public:
     virtual ~BrawlerDef();
 
@@ -441,7 +443,7 @@ public:
 /**
  * \brief This class implements the Buffer expert system in defence.
  */
-class BufferDef : public DumbDefendControl {
+class BufferDef final : public DumbDefendControl {
 public:
     virtual ~BufferDef();
 
@@ -477,7 +479,7 @@ public:
 /**
  * \brief This class implements the CounterAttacker expert system in defence.
  */
-class CounterAttackerDef : public DumbDefendControl {
+class CounterAttackerDef final : public DumbDefendControl {
 public:
     virtual ~CounterAttackerDef();
 
@@ -518,7 +520,7 @@ public:
 /**
  * \brief This class implements the Killer Chain expert system in defence.
  */
-class KillerChainDef : public DumbDefendControl {
+class KillerChainDef final : public DumbDefendControl {
 public:
     virtual ~KillerChainDef();
 
@@ -533,7 +535,7 @@ public:
 /**
  * \brief This class implements the Kite expert system in defence.
  */
-class KiteDef : public DumbDefendControl {
+class KiteDef final : public DumbDefendControl {
 public:
     virtual ~KiteDef();
 
@@ -569,7 +571,7 @@ public:
 /**
  * \brief This class implements the Sniper expert system in defence.
  */
-class SniperDef : public DumbDefendControl {
+class SniperDef final : public DumbDefendControl {
 public:
     virtual ~SniperDef();
 
@@ -605,7 +607,7 @@ public:
 /**
  * \brief This class implements the Balanced expert system in defence.
  */
-class BalancedDef : public DumbDefendControl {
+class BalancedDef final : public DumbDefendControl {
 public:
     virtual ~BalancedDef();
 
@@ -641,7 +643,7 @@ public:
 /**
  * \brief This class implements the Tactical expert system in defence.
  */
-class TacticalDef : public DumbDefendControl {
+class TacticalDef final : public DumbDefendControl {
 public:
     ~TacticalDef();
 
@@ -705,7 +707,240 @@ std::shared_ptr<AttackControl> getAttackExpertSystem(int combination);
  */
 std::shared_ptr<DefendControl> getDefenceExpertSystem(int combination);
 
+
+
+// ========================================================================
+//    STATIC DISPATCH
+// ========================================================================
+
+
+
+/**
+ * \brief Identifies one of the built-in, stateless control systems (the dumb
+ *        ones and the expert systems). ES_NONE means "anything else", e.g. an
+ *        AI or a user interface.
+ */
+enum ExpertSystemTag {
+    ES_NONE = 0,
+    ES_DUMB,
+    ES_GRUNT,
+    ES_BRAWLER,
+    ES_BUFFER,
+    ES_COUNTER,
+    ES_KILLER_CHAIN,
+    ES_KITE_SNIPER,
+    ES_KITE,
+    ES_SNIPER,
+    ES_BALANCED,
+    ES_TACTICAL
+};
+
+/// \brief Returns the tag of an attack control system, or ES_NONE if it is not
+///        exactly one of the built-in ones.
+ExpertSystemTag getExpertSystemTag(AttackControl const &ctrl);
+
+/// \brief Returns the tag of a defend control system, or ES_NONE if it is not
+///        exactly one of the built-in ones.
+ExpertSystemTag getExpertSystemTag(DefendControl const &ctrl);
+
+/**
+ * \brief A precomputed table of the moves an attack expert system would pick
+ *        for a given character, so that getNextMove becomes a lookup.
+ *
+ * The move scan of the expert systems only depends on the character (moves,
+ * attributes, SP mode), on the distance, on the current AP, on whether a super
+ * is affordable and on the last move performed. The table is immutable once
+ * built, so it can be shared by all the clones of a character that are
+ * fighting concurrently.
+ */
+class BestMoveTable {
+public:
+    /// \brief The AP range covered by the table; outside this range, lookups
+    ///        fail and the expert systems fall back to scanning the moves.
+    static constexpr int const MAX_AP = 20;
+
+    /// \brief Builds the table for the given expert system and character.
+    BestMoveTable(ExpertSystemTag tag, game::Character const &c);
+
+    /// \brief Returns the tag of the expert system the table was built for.
+    ExpertSystemTag tag() const { return m_tag; }
+
+    /// \brief Returns whether the table is still valid for the character,
+    ///        i.e. it was built for its attack control system and for the
+    ///        same moves, compared by id, in the same order.
+    bool isValidFor(game::Character const &c) const;
+
+    /// \brief Looks up the best move; returns false (and leaves "move" alone)
+    ///        if the table cannot answer for these parameters.
+    bool lookup(ExpertSystemTag tag, bool far, int cur_ap, bool super_ok,
+                size_t last_move, size_t &move) const {
+        if(tag != m_tag || cur_ap < 0 || cur_ap > MAX_AP
+           || last_move >= m_num_moves) {
+            return false;
+        }
+        move = m_table[index(far, cur_ap, super_ok, last_move)];
+        return true;
+    }
+
+private:
+    /// \brief Computes the position of an entry in the table.
+    size_t index(bool far, int cur_ap, bool super_ok, size_t last_move) const {
+        return ((((far ? 1 : 0) * (MAX_AP + 1) + cur_ap) * 2 
+                + (super_ok ? 1 : 0)) * m_num_moves) + last_move;
+    }
+
+    /// The expert system.
+    ExpertSystemTag m_tag;
+    /// The number of moves of the character.
+    size_t m_num_moves;
+    /// The ids of the moves of the character.
+    std::vector<game::MoveId> m_move_ids;
+    /// The move indices.
+    std::vector<unsigned char> m_table;
+};
+
+/// \brief Makes sure that the character has a valid BestMoveTable, if its
+///        attack control system can use one. This is thread-safe and it is
+///        meant to be called on the model character before cloning it for a
+///        fight, so that the table is built once and shared by the clones.
+void prepareBestMoveTable(game::Character &c);
+
+/**
+ * \brief Wraps an attack control system and calls its decision functions
+ *        without going through the vtable when it is a built-in one.
+ *
+ * The built-in systems form a closed set of final classes, so a switch on the
+ * tag followed by a qualified call lets the compiler inline the heuristics.
+ * Anything with tag ES_NONE falls back to the virtual call, so it is always
+ * safe to use, but it only pays off when the tag is known.
+ */
+class ExpertAttackDispatch {
+public:
+    /// \brief Main ctor; the control system must outlive the dispatcher.
+    explicit ExpertAttackDispatch(AttackControl &ctrl);
+
+    /// \brief Ctor for callers which already know the tag of the control
+    ///        system, which must be getExpertSystemTag(ctrl).
+    ExpertAttackDispatch(AttackControl &ctrl, ExpertSystemTag tag)
+    :   m_ctrl(&ctrl), m_tag(tag) {}
+
+    /// \brief Returns the tag of the wrapped control system.
+    ExpertSystemTag tag() const { return m_tag; }
+
+    int shouldSpendAPToGainSP(game::Character const &me,
+                              game::Character const &opponent,
+                              bool far);
+
+    bool shouldSpendAPToFallStanding(game::Character const &me,
+                                     game::Character const &opponent,
+                                     bool far);
+
+    game::Move const & getNextMove(game::Character const &me,
+                                   game::Character const &opponent,
+                                   bool far);
+
+    bool shouldSpendSPToLowerAPCost(game::Character const &me,
+                                    game::Character const &opponent,
+                                    bool far,
+                                    game::Move const &my_move,
+                                    int current_ap_cost);
+
+    bool shouldSpendSPToConcatenate(game::Character const &me,
+                                    game::Character const &opponent,
+                                    bool far,
+                                    game::Move const &my_move);
+
+    bool shouldSpendSPForUltraAgility(game::Character const &me,
+                                      game::Character const &opponent,
+                                      bool far,
+                                      game::Move const &my_move);
+
+    bool shouldSpendSPToBoostAttack(game::Character const &me,
+                                    game::Character const &opponent,
+                                    bool far,
+                                    game::Move const &my_move);
+
+    bool shouldSpendSPToBoostDamage(game::Character const &me,
+                                    game::Character const &opponent,
+                                    bool far,
+                                    game::Move const &my_move);
+
+    void updateAfterMove(game::Character const &me,
+                         game::Character const &opponent,
+                         game::Move const &move,
+                         bool successful);
+
+private:
+    /// The wrapped control system.
+    AttackControl *m_ctrl;
+    /// Its tag.
+    ExpertSystemTag m_tag;
+};
+
+/**
+ * \brief Wraps a defend control system and calls its decision functions
+ *        without going through the vtable when it is a built-in one. See
+ *        ExpertAttackDispatch.
+ */
+class ExpertDefenceDispatch {
+public:
+    /// \brief Main ctor; the control system must outlive the dispatcher.
+    explicit ExpertDefenceDispatch(DefendControl &ctrl);
+
+    /// \brief Ctor for callers which already know the tag of the control
+    ///        system, which must be getExpertSystemTag(ctrl).
+    ExpertDefenceDispatch(DefendControl &ctrl, ExpertSystemTag tag)
+    :   m_ctrl(&ctrl), m_tag(tag) {}
+
+    /// \brief Returns the tag of the wrapped control system.
+    ExpertSystemTag tag() const { return m_tag; }
+
+    game::Move const & getCounterMove(game::Character const &me,
+                                      game::Character const &opponent,
+                                      bool far,
+                                      game::Move const &opponent_move);
+
+    bool shouldSpendSPToComboBreak(game::Character const &me,
+                                   game::Character const &opponent,
+                                   bool far,
+                                   game::Move const &opponent_move);
+
+    bool shouldSpendSPToLowerAPCost(game::Character const &me,
+                                    game::Character const &opponent,
+                                    bool far,
+                                    game::Move const &my_move,
+                                    int current_ap_cost);
+
+    bool shouldSpendSPForUltraAgility(game::Character const &me,
+                                      game::Character const &opponent,
+                                      bool far,
+                                      game::Move const &my_move);
+
+    bool shouldSpendSPToBoostDefence(game::Character const &me,
+                                     game::Character const &opponent,
+                                     bool far,
+                                     game::Move const &my_move);
+
+    bool shouldSpendSPToBoostCounterDamage(game::Character const &me,
+                                           game::Character const &opponent,
+                                           bool far,
+                                           game::Move const &my_move);
+
+    void updateAfterMove(game::Character const &me,
+                         game::Character const &opponent,
+                         game::Move const &move,
+                         bool successful);
+
+private:
+    /// The wrapped control system.
+    DefendControl *m_ctrl;
+    /// Its tag.
+    ExpertSystemTag m_tag;
+};
+
 }
 }
 
+#include "core/ctrl/ExpertSystemCtrlInline.h"
+
 #endif
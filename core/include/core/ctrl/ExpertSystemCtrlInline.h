@@ -0,0 +1,1436 @@
+// Copyright 2015 Dario Domizioli
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file is not meant to be included directly; ExpertSystemCtrl.h includes
+// it at the end, so that the decisions of the built-in expert systems and their
+// dispatchers are visible to the compiler wherever they are called.
+
+#ifndef CORE_CTRL_EXPERTSYSTEMCTRLINLINE_H
+#define CORE_CTRL_EXPERTSYSTEMCTRLINLINE_H
+
+#include "core/ctrl/ExpertSystemCtrl.h"
+#include "core/game/Move.h"
+#include "core/game/Character.h"
+
+#include <cassert>
+
+namespace core {
+namespace ctrl {
+
+
+
+// ========================================================================
+//    ATTACK EXPERT SYSTEMS
+// ========================================================================
+
+
+
+inline int GruntAtk::shouldSpendAPToGainSP(game::Character const &me,
+                          game::Character const &opponent,
+                          bool far) {
+    if(me.cur_ap > 4) {
+        return me.cur_ap - 4;
+    }
+    return 0;
+}
+
+namespace detail {
+
+/// The AP a brawler wants to have before attacking.
+constexpr int const BRAWLER_AP_TO_ATTACK = 6;
+
+// The move scans below only depend on the character, the distance, the
+// current AP, whether a super is affordable and the last move performed; this
+// is what allows them to be tabulated in a BestMoveTable.
+
+inline size_t scanForMaxDamage(game::Character const &me, bool far, int cur_ap,
+                               bool super_ok, size_t last_move,
+                               int sp_for_uh) {
+    size_t which_move = 0;
+    size_t this_move = 0;
+    int max_predicted_dmg = 0;
+    for( ; which_move < me.moves.size(); ++which_move) {
+        game::Move const &m = me.moves[which_move];
+        if(m.isWait()) {
+            continue;
+        }
+        if((!me.moves[last_move].isWait()) && which_move == last_move) {
+            continue;
+        }
+        if(m.apCost(far, false) > cur_ap) {
+            continue;
+        }
+        if(m.isSuper() && !super_ok) {
+            continue;
+        }
+        int dmg = m.damage(1, me.at, me.df, sp_for_uh);
+        if(dmg > max_predicted_dmg) {
+            this_move = which_move;
+            max_predicted_dmg = dmg;
+        }
+    }
+    return this_move;
+}
+
+inline size_t scanBrawler(game::Character const &me, bool far, int cur_ap,
+                          bool super_ok, size_t last_move) {
+    size_t which_move = 0;
+    size_t this_move = 0;
+    float goodness = 0.0;
+    for( ; which_move < me.moves.size(); ++which_move) {
+        game::Move const &m = me.moves[which_move];
+        if(m.isWait()) {
+            continue;
+        }
+        if((!me.moves[last_move].isWait()) && which_move == last_move) {
+            continue;
+        }
+        if(m.apCost(far, false) > cur_ap) {
+            continue;
+        }
+        if(m.isSuper() && !super_ok) {
+            continue;
+        }
+        int dmg = m.damage(1, me.at, me.df, 0);
+        int combo = m.comboPoints();
+        float cur_goodness = dmg / (float)(m.apCost(far, false)) + (float)combo;
+        // The last move is only a wait if no moves have been performed yet.
+        if(m.hasThrow() && me.moves[last_move].isWait()) {
+            // Skew towards throw on the first move
+            cur_goodness += 5.0f;
+        }
+        if(goodness < cur_goodness) {
+            this_move = which_move;
+            goodness = cur_goodness;
+        }
+    }
+    return this_move;
+}
+
+inline size_t scanBuffer(game::Character const &me, bool far, int cur_ap,
+                         bool super_ok, size_t last_move) {
+    size_t which_move = 0;
+    size_t this_move = 0;
+    float goodness = 0.0;
+    for( ; which_move < me.moves.size(); ++which_move) {
+        game::Move const &m = me.moves[which_move];
+        if(m.isWait()) {
+            continue;
+        }
+        if((!me.moves[last_move].isWait()) && which_move == last_move) {
+            continue;
+        }
+        if(m.apCost(far, false) > cur_ap) {
+            continue;
+        }
+        if(m.isSuper() && !super_ok) {
+            continue;
+        }
+        int dmg = m.damage(1, me.at, me.df, 0);
+        int combo = m.comboPoints();
+        float potential_sp = 0.0f;
+        if(me.sp == game::SP_DAMAGE) {
+            potential_sp = (float)dmg / 3.0f;
+        }
+        else if(me.sp == game::SP_COMBO) {
+            potential_sp = (float)combo / 2.0;
+        }
+        float cur_goodness = dmg / (float)(m.apCost(far, false)) + potential_sp;
+        if(goodness < cur_goodness) {
+            this_move = which_move;
+            goodness = cur_goodness;
+        }
+    }
+    return this_move;
+}
+
+inline size_t scanKiteSniper(game::Character const &me, bool far, int cur_ap,
+                             bool super_ok, size_t last_move) {
+    // Verify that we have moves with PUSH or DISTANCE
+    bool has_push = false;
+    bool has_distance = false;
+    for(auto const &m : me.moves) {
+        if(m.hasSymbol(game::MS_PUSH)) {
+            has_push = true;
+        } else if(m.hasSymbol(game::MS_DISTANCE)) {
+            has_distance = true;
+        }
+    }
+    // Just get the strongest move, but prefer the ones with MS_PUSH.
+    size_t which_move = 0;
+    size_t this_move = 0;
+    float max_predicted_dmg = 0.0f;
+    for( ; which_move < me.moves.size(); ++which_move) {
+        game::Move const &m = me.moves[which_move];
+        if(m.isWait()) {
+            continue;
+        }
+        if((!me.moves[last_move].isWait()) && which_move == last_move) {
+            continue;
+        }
+        if(m.apCost(far, false) > cur_ap) {
+            continue;
+        }
+        if(m.isSuper() && !super_ok) {
+            continue;
+        }
+        // If we have both PUSH and DISTANCE moves, then stay afar and don't do
+        // any other move.
+        if(has_push && has_distance) {
+            if(!m.hasSymbol(game::MS_PUSH) || !m.hasSymbol(game::MS_DISTANCE)) {
+                continue;
+            }
+        }
+        float dmg = (float)m.damage(1, me.at, me.df, 0);
+        // Skew towards PUSH if we are close.
+        if(!far && m.hasSymbol(game::MS_PUSH)) {
+            dmg *= 2.0f;
+        }
+        // Maximize damage per AP.
+        dmg /= (float)m.apCost(far, false);
+        if(dmg > max_predicted_dmg) {
+            this_move = which_move;
+            max_predicted_dmg = dmg;
+        }
+    }
+    return this_move;
+}
+
+inline size_t scanBalanced(game::Character const &me, bool far, int cur_ap,
+                           bool super_ok, size_t last_move, int ap_margin) {
+    size_t which_move = 0;
+    size_t this_move = 0;
+    float goodness = 0.0;
+    for( ; which_move < me.moves.size(); ++which_move) {
+        game::Move const &m = me.moves[which_move];
+        if(m.isWait()) {
+            continue;
+        }
+        if((!me.moves[last_move].isWait()) && which_move == last_move) {
+            continue;
+        }
+        if(m.apCost(far, false) > cur_ap + ap_margin) {
+            continue;
+        }
+        if(m.isSuper() && !super_ok) {
+            continue;
+        }
+        int dmg = m.damage(1, me.at, me.df, 0);
+        int combo = m.comboPoints();
+        float potential_sp = 0.0f;
+        if(me.sp == game::SP_DAMAGE) {
+            potential_sp = (float)dmg / 3.0f;
+        }
+        else if(me.sp == game::SP_COMBO) {
+            potential_sp = (float)combo / 2.0f;
+        }
+        float cur_goodness = dmg + potential_sp * 3.0f;
+        if(goodness < cur_goodness) {
+            this_move = which_move;
+            goodness = cur_goodness;
+        }
+    }
+    return this_move;
+}
+
+/// Runs the move scan of the given expert system.
+inline size_t scanForBestMove(ExpertSystemTag tag, game::Character const &me,
+                              bool far, int cur_ap, bool super_ok,
+                              size_t last_move) {
+    switch(tag) {
+        case ES_GRUNT: // Fall-through
+        case ES_COUNTER:
+            return scanForMaxDamage(me, far, cur_ap, super_ok, last_move, 0);
+        case ES_BRAWLER:
+            return scanBrawler(me, far, cur_ap, super_ok, last_move);
+        case ES_BUFFER:
+            return scanBuffer(me, far, cur_ap, super_ok, last_move);
+        case ES_KILLER_CHAIN:
+            // Assume we're spending one SP to power it.
+            return scanForMaxDamage(me, far, cur_ap, super_ok, last_move, 1);
+        case ES_KITE_SNIPER:
+            return scanKiteSniper(me, far, cur_ap, super_ok, last_move);
+        case ES_BALANCED:
+            // Keep 2 APs for the counterattack.
+            return scanBalanced(me, far, cur_ap, super_ok, last_move, 2);
+        case ES_TACTICAL:
+            return scanBalanced(me, far, cur_ap, super_ok, last_move, 0);
+        default: break;
+    }
+    assert(false && "No move scan for this control system");
+    return 0;
+}
+
+/// Returns the best move for the expert system in the current state, from the
+/// table of the character if it has one, otherwise by scanning the moves.
+inline game::Move const & bestMove(ExpertSystemTag tag,
+                                   game::Character const &me, bool far) {
+    size_t last_move = me.moves_performed.empty() 
+                       ? 0 
+                       : me.moves_performed.back();
+    bool super_ok = me.cur_sp >= 4;
+    size_t this_move = 0;
+    if(!me.best_moves
+       || !me.best_moves->lookup(tag, far, me.cur_ap, super_ok, last_move,
+                                 this_move)) {
+        this_move = scanForBestMove(tag, me, far, me.cur_ap, super_ok,
+                                    last_move);
+    }
+    return me.moves[this_move];
+}
+
+} // close namespace detail
+
+inline game::Move const & GruntAtk::getNextMove(game::Character const &me,
+                               game::Character const &opponent,
+                               bool far) {
+    return detail::bestMove(ES_GRUNT, me, far);
+}
+
+inline bool GruntAtk::shouldSpendSPToLowerAPCost(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move,
+                                int current_ap_cost) {
+    return (my_move.apCost(far, false) == (me.cur_ap + 1)) && me.cur_sp > 1;
+}
+
+inline bool GruntAtk::shouldSpendSPToConcatenate(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move) {
+    return me.cur_sp > 1;
+}
+
+inline bool GruntAtk::shouldSpendSPForUltraAgility(game::Character const &me,
+                                  game::Character const &opponent,
+                                  bool far,
+                                  game::Move const &my_move) {
+    return true;
+}
+
+inline bool GruntAtk::shouldSpendSPToBoostAttack(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move) {
+    return true;
+}
+
+inline bool GruntAtk::shouldSpendSPToBoostDamage(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move) {
+    return true;
+}
+
+
+inline int BrawlerAtk::shouldSpendAPToGainSP(game::Character const &me,
+                          game::Character const &opponent,
+                          bool far) {
+    // Gain one SP only, and only if we are not going to do any move this turn.
+    if(me.cur_ap < detail::BRAWLER_AP_TO_ATTACK) {
+        return 1;
+    }
+    return 0;
+}
+
+inline game::Move const & BrawlerAtk::getNextMove(game::Character const &me,
+                               game::Character const &opponent,
+                               bool far) {
+    // Only attack when we had a large number of AP to use.
+    int ap_discriminator = me.cur_ap + 1;
+    for(auto const &mv: me.moves_performed) {
+        ap_discriminator += me.moves[mv].apCost(far, false);
+    }
+    if(ap_discriminator < detail::BRAWLER_AP_TO_ATTACK) {
+        return game::getWaitMove();
+    }
+    return detail::bestMove(ES_BRAWLER, me, far);
+}
+
+inline bool BrawlerAtk::shouldSpendSPToLowerAPCost(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move,
+                                int current_ap_cost) {
+    return (my_move.apCost(far, false) == (me.cur_ap + 1)) && me.cur_sp > 1;
+}
+
+inline bool BrawlerAtk::shouldSpendSPToConcatenate(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move) {
+    return true;
+}
+
+inline bool BrawlerAtk::shouldSpendSPForUltraAgility(game::Character const &me,
+                                  game::Character const &opponent,
+                                  bool far,
+                                  game::Move const &my_move) {
+    return me.cur_sp > 1;
+}
+
+inline bool BrawlerAtk::shouldSpendSPToBoostAttack(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move) {
+    return me.cur_sp > 1;
+}
+
+inline bool BrawlerAtk::shouldSpendSPToBoostDamage(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move) {
+    return me.cur_sp > 1;
+}
+
+inline int BufferAtk::shouldSpendAPToGainSP(game::Character const &me,
+                          game::Character const &opponent,
+                          bool far) {
+    // Gain SPs but save enough APs for a special move.
+    if(me.cur_ap >= 4) {
+        return std::min(me.cur_ap - 3, 6 - me.cur_sp);
+    }
+    return 0;
+}
+
+inline game::Move const & BufferAtk::getNextMove(game::Character const &me,
+                               game::Character const &opponent,
+                               bool far) {
+    // Only attack with one move per turn, but give it all.
+    if(!me.moves_performed.empty()) {
+        return game::getWaitMove();
+    }
+    // If we gain SP by Defence or Wounds, attack only when we have more than 4
+    // AP. This is so that we alternate attack rounds and defence rounds.
+    if(me.sp == game::SP_DEFENCE || me.sp == game::SP_WOUND) {
+        if(me.cur_ap <= 4) {
+            return game::getWaitMove();
+        }
+    }
+    return detail::bestMove(ES_BUFFER, me, far);
+}
+
+inline bool BufferAtk::shouldSpendSPToLowerAPCost(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move,
+                                int current_ap_cost) {
+    return (my_move.apCost(far, false) == (me.cur_ap + 1)) && me.cur_sp > 1;
+}
+
+inline bool BufferAtk::shouldSpendSPToConcatenate(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move) {
+    return false;
+}
+
+inline bool BufferAtk::shouldSpendSPForUltraAgility(game::Character const &me,
+                                  game::Character const &opponent,
+                                  bool far,
+                                  game::Move const &my_move) {
+    return me.cur_sp > 1;
+}
+
+inline bool BufferAtk::shouldSpendSPToBoostAttack(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move) {
+    return true;
+}
+
+inline bool BufferAtk::shouldSpendSPToBoostDamage(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move) {
+    return me.cur_sp > 1;
+}
+
+inline int CounterAttackerAtk::shouldSpendAPToGainSP(game::Character const &me,
+                          game::Character const &opponent,
+                          bool far) {
+    if(me.cur_ap > 4) {
+        return std::min(me.cur_ap - 4, 6 - me.cur_sp);
+    }
+    return 0;
+}
+
+inline game::Move const & CounterAttackerAtk::getNextMove(game::Character const &me,
+                               game::Character const &opponent,
+                               bool far) {
+    // ALWAYS keep 4 AP to counter-attack.
+    if(me.cur_ap <= 4) {
+        return game::getWaitMove();
+    }
+    // Otherwise just try to do some damage
+    return detail::bestMove(ES_COUNTER, me, far);
+}
+
+inline int KillerChainAtk::shouldSpendAPToGainSP(game::Character const &me,
+                          game::Character const &opponent,
+                          bool far) {
+    // Power up while waiting.
+    if(me.cur_ap < 7) {
+        return std::min(std::max(1, me.ra - 2), 6 - me.cur_sp);
+    }
+    return 0;
+}
+
+inline game::Move const & KillerChainAtk::getNextMove(game::Character const &me,
+                               game::Character const &opponent,
+                               bool far) {
+    // Find the Super.
+    size_t super_move_idx = 0;
+    for(; super_move_idx < me.moves.size(); ++super_move_idx) {
+        if(me.moves[super_move_idx].isSuper()) {
+            break;
+        }
+    }
+    assert(super_move_idx < me.moves.size());
+    // If we've already done the super, just bail out.
+    if(!me.moves_performed.empty() 
+       && me.moves_performed.back() == super_move_idx) {
+        return game::getWaitMove();
+    }
+    // Otherwise if we can do the super, let's do it.
+    if(me.cur_ap >= me.moves[super_move_idx].apCost(far, false)) {
+        if(me.cur_sp >= 4) {
+            return me.moves[super_move_idx];
+        }
+    }
+    // Otherwise, we must be able to do a chain of three moves.
+    // This means we had a lot of AP. This logic is similar to the Brawler but
+    // our limit is 7 because it's two three-AP moves plus a basic attack.
+    int ap_discriminator = me.cur_ap + 1;
+    for(auto const &mv: me.moves_performed) {
+        ap_discriminator += me.moves[mv].apCost(far, false);
+    }
+    if(ap_discriminator < 7) {
+        return game::getWaitMove();
+    }
+    // At this point just get the strongest move.
+    return detail::bestMove(ES_KILLER_CHAIN, me, far);
+}
+
+inline bool KillerChainAtk::shouldSpendSPToLowerAPCost(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move,
+                                int current_ap_cost) {
+    // Only spend one.
+    return current_ap_cost >= my_move.apCost(far, false);
+}
+
+inline bool KillerChainAtk::shouldSpendSPToConcatenate(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move) {
+    return true;
+}
+
+inline bool KillerChainAtk::shouldSpendSPForUltraAgility(game::Character const &me,
+                                  game::Character const &opponent,
+                                  bool far,
+                                  game::Move const &my_move) {
+    return true;
+}
+
+inline bool KillerChainAtk::shouldSpendSPToBoostAttack(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move) {
+    return true;
+}
+
+inline bool KillerChainAtk::shouldSpendSPToBoostDamage(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move) {
+    return true;
+}
+
+inline int KiteSniperAtk::shouldSpendAPToGainSP(game::Character const &me,
+                          game::Character const &opponent,
+                          bool far) {
+    if(me.cur_ap > 4) {
+        return me.cur_ap - 4;
+    }
+    return 0;
+}
+
+inline game::Move const & KiteSniperAtk::getNextMove(game::Character const &me,
+                               game::Character const &opponent,
+                               bool far) {
+    return detail::bestMove(ES_KITE_SNIPER, me, far);
+}
+
+inline bool KiteSniperAtk::shouldSpendSPToLowerAPCost(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move,
+                                int current_ap_cost) {
+    // Only spend one.
+    return current_ap_cost >= my_move.apCost(far, false);
+}
+
+inline bool KiteSniperAtk::shouldSpendSPToConcatenate(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move) {
+    return true;
+}
+
+inline bool KiteSniperAtk::shouldSpendSPForUltraAgility(game::Character const &me,
+                                  game::Character const &opponent,
+                                  bool far,
+                                  game::Move const &my_move) {
+    return me.cur_sp > 1;
+}
+
+inline bool KiteSniperAtk::shouldSpendSPToBoostAttack(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move) {
+    return me.cur_sp > 1;
+}
+
+inline bool KiteSniperAtk::shouldSpendSPToBoostDamage(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move) {
+    return me.cur_sp > 1;
+}
+
+inline int BalancedAtk::shouldSpendAPToGainSP(game::Character const &me,
+                          game::Character const &opponent,
+                          bool far) {
+    // Gain SPs but save enough APs for a special move.
+    if(me.cur_ap >= 4) {
+        return std::min(me.cur_ap - 3, 6 - me.cur_sp);
+    }
+    return 0;
+}
+
+inline game::Move const & BalancedAtk::getNextMove(game::Character const &me,
+                               game::Character const &opponent,
+                               bool far) {
+    // Only attack with one move per turn.
+    if(!me.moves_performed.empty()) {
+        return game::getWaitMove();
+    }
+    return detail::bestMove(ES_BALANCED, me, far);
+}
+
+inline bool BalancedAtk::shouldSpendSPToLowerAPCost(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move,
+                                int current_ap_cost) {
+    return (my_move.apCost(far, false) == (me.cur_ap + 1)) && me.cur_sp > 1;
+}
+
+inline bool BalancedAtk::shouldSpendSPToConcatenate(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move) {
+    return false;
+}
+
+inline bool BalancedAtk::shouldSpendSPForUltraAgility(game::Character const &me,
+                                  game::Character const &opponent,
+                                  bool far,
+                                  game::Move const &my_move) {
+    return me.cur_sp > 1;
+}
+
+inline bool BalancedAtk::shouldSpendSPToBoostAttack(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move) {
+    return me.cur_sp > 1;
+}
+
+inline bool BalancedAtk::shouldSpendSPToBoostDamage(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move) {
+    return me.cur_sp > 1;
+}
+
+inline int TacticalAtk::shouldSpendAPToGainSP(game::Character const &me,
+                          game::Character const &opponent,
+                          bool far) {
+    // Gain SPs but save enough APs for a special move.
+    if(me.cur_ap > 4) {
+        return std::min(me.cur_ap - 4, 6 - me.cur_sp);
+    }
+    return 0;
+}
+
+inline game::Move const & TacticalAtk::getNextMove(game::Character const &me,
+                               game::Character const &opponent,
+                               bool far) {
+    // If our defence is better than the opponent's attack, then prefer counter
+    // attacking (i.e. save 4 AP), otherwise proceed.
+    if(me.df > opponent.at) {
+        if(me.cur_ap <= 4) {
+            return game::getWaitMove();
+        }
+    }
+    return detail::bestMove(ES_TACTICAL, me, far);
+}
+
+inline bool TacticalAtk::shouldSpendSPToLowerAPCost(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move,
+                                int current_ap_cost) {
+    return (my_move.apCost(far, false) == (me.cur_ap + 1)) && me.cur_sp > 1;
+}
+
+inline bool TacticalAtk::shouldSpendSPToConcatenate(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move) {
+    return false;
+}
+
+inline bool TacticalAtk::shouldSpendSPForUltraAgility(game::Character const &me,
+                                  game::Character const &opponent,
+                                  bool far,
+                                  game::Move const &my_move) {
+    return false;
+}
+
+inline bool TacticalAtk::shouldSpendSPToBoostAttack(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move) {
+    return false;
+}
+
+inline bool TacticalAtk::shouldSpendSPToBoostDamage(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move) {
+    return true;
+}
+
+
+
+// ========================================================================
+//    DEFENCE EXPERT SYSTEMS
+// ========================================================================
+
+
+
+inline game::Move const & GruntDef::getCounterMove(game::Character const &me,
+                                  game::Character const &opponent,
+                                  bool far,
+                                  game::Move const &opponent_move) {
+    size_t which_move = 0;
+    size_t this_move = 0;
+    int max_predicted_dmg = 0;
+    for( ; which_move < me.moves.size(); ++which_move) {
+        game::Move const &m = me.moves[which_move];
+        if(m.isWait()) {
+            continue;
+        }
+        if(m.apCost(far, true) > me.cur_ap) {
+            continue;
+        }
+        if(m.isSuper() && me.cur_sp < 4) {
+            continue;
+        }
+        int dmg = m.counterDamage(1, me.at, me.df, 0, 
+            opponent_move.damage(1, opponent.at, opponent.df, 0));
+        if(dmg > max_predicted_dmg) {
+            this_move = which_move;
+            max_predicted_dmg = dmg;
+        }
+    }
+    return me.moves[this_move];
+}
+
+inline game::Move const & BrawlerDef::getCounterMove(game::Character const &me,
+                                  game::Character const &opponent,
+                                  bool far,
+                                  game::Move const &opponent_move) {
+    // Only counter when we have a large number of AP to use.
+    if(me.cur_ap < detail::BRAWLER_AP_TO_ATTACK) {
+        return game::getWaitMove();
+    }
+    size_t which_move = 0;
+    size_t this_move = 0;
+    float goodness = 0.0f;
+    for( ; which_move < me.moves.size(); ++which_move) {
+        game::Move const &m = me.moves[which_move];
+        if(m.isWait()) {
+            continue;
+        }
+        if(m.apCost(far, true) > me.cur_ap) {
+            continue;
+        }
+        if(m.isSuper() && me.cur_sp < 4) {
+            continue;
+        }
+        int dmg = m.counterDamage(1, me.at, me.df, 0, 
+            opponent_move.damage(1, opponent.at, opponent.df, 0));
+        int combo = m.comboPoints();
+        float cur_goodness = dmg / (float)(m.apCost(far, true)) + (float)combo;
+        if(m.hasThrow() && me.moves_performed.empty()) {
+            // Skew towards throw on the counter move
+            cur_goodness += 5.0f;
+        }
+        if(goodness < cur_goodness) {
+            this_move = which_move;
+            goodness = cur_goodness;
+        }
+    }
+    return me.moves[this_move];
+}
+
+inline game::Move const & BufferDef::getCounterMove(game::Character const &me,
+                                  game::Character const &opponent,
+                                  bool far,
+                                  game::Move const &opponent_move) {
+    // Only counter when we have enough AP to use and we can spend SP.
+    if(me.cur_ap <= 4 || me.cur_sp < 2) {
+        return game::getWaitMove();
+    }
+    size_t which_move = 0;
+    size_t this_move = 0;
+    float goodness = 0.0f;
+    for( ; which_move < me.moves.size(); ++which_move) {
+        game::Move const &m = me.moves[which_move];
+        if(m.isWait()) {
+            continue;
+        }
+        if(m.apCost(far, true) > me.cur_ap) {
+            continue;
+        }
+        if(m.isSuper() && me.cur_sp < 4) {
+            continue;
+        }
+        int dmg = m.counterDamage(1, me.at, me.df, 0, 
+            opponent_move.damage(1, opponent.at, opponent.df, 0));
+        int combo = m.comboPoints();
+        float potential_sp = 0.0f;
+        if(me.sp == game::SP_DAMAGE) {
+            potential_sp = (float)dmg / 3.0f;
+        }
+        else if(me.sp == game::SP_COMBO) {
+            potential_sp = (float)combo / 2.0;
+        }
+        float cur_goodness = dmg / (float)(m.apCost(far, false)) + potential_sp;
+        if(goodness < cur_goodness) {
+            this_move = which_move;
+            goodness = cur_goodness;
+        }
+    }
+    return me.moves[this_move];
+}
+
+inline bool BufferDef::shouldSpendSPToLowerAPCost(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move,
+                                int current_ap_cost) {
+    return me.cur_sp > 1 && current_ap_cost >= 3;
+}
+
+inline bool BufferDef::shouldSpendSPForUltraAgility(game::Character const &me,
+                                  game::Character const &opponent,
+                                  bool far,
+                                  game::Move const &my_move) {
+    return true;
+}
+
+inline bool BufferDef::shouldSpendSPToBoostDefence(game::Character const &me,
+                                 game::Character const &opponent,
+                                 bool far,
+                                 game::Move const &my_move) {
+    return true;
+}
+
+inline bool BufferDef::shouldSpendSPToBoostCounterDamage(game::Character const &me,
+                                       game::Character const &opponent,
+                                       bool far,
+                                       game::Move const &my_move) {
+    return me.cur_sp > 1;
+}
+
+inline game::Move const & CounterAttackerDef::getCounterMove(game::Character const &me,
+                                  game::Character const &opponent,
+                                  bool far,
+                                  game::Move const &opponent_move) {
+    size_t which_move = 0;
+    size_t this_move = 0;
+    int max_predicted_dmg = 0;
+    for( ; which_move < me.moves.size(); ++which_move) {
+        game::Move const &m = me.moves[which_move];
+        if(m.isWait()) {
+            continue;
+        }
+        if(m.apCost(far, true) > me.cur_ap) {
+            continue;
+        }
+        if(m.isSuper() && me.cur_sp < 4) {
+            continue;
+        }
+        int dmg = m.counterDamage(1, me.at, me.df, 0, 
+            opponent_move.damage(1, opponent.at, opponent.df, 0));
+        if(dmg > max_predicted_dmg) {
+            this_move = which_move;
+            max_predicted_dmg = dmg;
+        }
+    }
+    return me.moves[this_move];
+}
+
+inline bool CounterAttackerDef::shouldSpendSPToComboBreak(game::Character const &me,
+                               game::Character const &opponent,
+                               bool far,
+                               game::Move const &opponent_move) {
+    // ALWAYS break.
+    return true;
+}
+
+inline bool CounterAttackerDef::shouldSpendSPToLowerAPCost(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move,
+                                int current_ap_cost) {
+    // Only spend one.
+    return current_ap_cost >= my_move.apCost(far, true);
+}
+
+inline bool CounterAttackerDef::shouldSpendSPForUltraAgility(game::Character const &me,
+                                  game::Character const &opponent,
+                                  bool far,
+                                  game::Move const &my_move) {
+    return true;
+}
+
+inline bool CounterAttackerDef::shouldSpendSPToBoostDefence(game::Character const &me,
+                                 game::Character const &opponent,
+                                 bool far,
+                                 game::Move const &my_move) {
+    return true;
+}
+
+inline bool CounterAttackerDef::shouldSpendSPToBoostCounterDamage(game::Character const &me,
+                                       game::Character const &opponent,
+                                       bool far,
+                                       game::Move const &my_move) {
+    return true;
+}
+
+
+inline game::Move const & KillerChainDef::getCounterMove(game::Character const &me,
+                                  game::Character const &opponent,
+                                  bool far,
+                                  game::Move const &opponent_move) {
+    // Never counterattack, unless we have a lot of APs and we can start the
+    // chain.
+    if(me.cur_ap >= 7) {
+        size_t which_move = 0;
+        size_t this_move = 0;
+        int max_predicted_dmg = 0;
+        for( ; which_move < me.moves.size(); ++which_move) {
+            game::Move const &m = me.moves[which_move];
+            if(m.isWait()) {
+                continue;
+            }
+            if(m.apCost(far, true) > me.cur_ap) {
+                continue;
+            }
+            if(m.isSuper() && me.cur_sp < 4) {
+                continue;
+            }
+            int dmg = m.counterDamage(1, me.at, me.df, 0, 
+                opponent_move.damage(1, opponent.at, opponent.df, 0));
+            if(dmg > max_predicted_dmg) {
+                this_move = which_move;
+                max_predicted_dmg = dmg;
+            }
+        }
+        return me.moves[this_move];
+    }
+    return game::getWaitMove();
+}
+
+inline game::Move const & KiteDef::getCounterMove(game::Character const &me,
+                                  game::Character const &opponent,
+                                  bool far,
+                                  game::Move const &opponent_move) {
+    size_t which_move = 0;
+    size_t this_move = 0;
+    int max_predicted_dmg = 0;
+    for( ; which_move < me.moves.size(); ++which_move) {
+        game::Move const &m = me.moves[which_move];
+        if(m.isWait()) {
+            continue;
+        }
+        // ONLY counter with a PUSH move.
+        if(!m.hasSymbol(game::MS_PUSH)) {
+            continue;
+        }
+        if(m.apCost(far, true) > me.cur_ap) {
+            continue;
+        }
+        if(m.isSuper() && me.cur_sp < 4) {
+            continue;
+        }
+        int dmg = m.damage(1, me.at, me.df, 0);
+        if(dmg > max_predicted_dmg) {
+            this_move = which_move;
+            max_predicted_dmg = dmg;
+        }
+    }
+    return me.moves[this_move];
+}
+
+inline bool KiteDef::shouldSpendSPToLowerAPCost(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move,
+                                int current_ap_cost) {
+    // Only do this for PUSH moves, and only spend one.
+    return my_move.hasSymbol(game::MS_PUSH) 
+           && current_ap_cost >= my_move.apCost(far, true);
+}
+
+inline bool KiteDef::shouldSpendSPForUltraAgility(game::Character const &me,
+                                  game::Character const &opponent,
+                                  bool far,
+                                  game::Move const &my_move) {
+    return my_move.hasSymbol(game::MS_PUSH);
+}
+
+inline bool KiteDef::shouldSpendSPToBoostDefence(game::Character const &me,
+                                 game::Character const &opponent,
+                                 bool far,
+                                 game::Move const &my_move) {
+    return my_move.hasSymbol(game::MS_PUSH);
+}
+
+inline bool KiteDef::shouldSpendSPToBoostCounterDamage(game::Character const &me,
+                                       game::Character const &opponent,
+                                       bool far,
+                                       game::Move const &my_move) {
+    return my_move.hasSymbol(game::MS_PUSH);
+}
+
+inline game::Move const & SniperDef::getCounterMove(game::Character const &me,
+                                  game::Character const &opponent,
+                                  bool far,
+                                  game::Move const &opponent_move) {
+    size_t which_move = 0;
+    size_t this_move = 0;
+    int max_predicted_dmg = 0;
+    for( ; which_move < me.moves.size(); ++which_move) {
+        game::Move const &m = me.moves[which_move];
+        if(m.isWait()) {
+            continue;
+        }
+        // ONLY counter from afar and with a DISTANCE move.
+        if(!far || !m.hasSymbol(game::MS_DISTANCE)) {
+            continue;
+        }
+        if(m.apCost(far, true) > me.cur_ap) {
+            continue;
+        }
+        if(m.isSuper() && me.cur_sp < 4) {
+            continue;
+        }
+        int dmg = m.damage(1, me.at, me.df, 0);
+        if(dmg > max_predicted_dmg) {
+            this_move = which_move;
+            max_predicted_dmg = dmg;
+        }
+    }
+    return me.moves[this_move];
+}
+
+inline bool SniperDef::shouldSpendSPToLowerAPCost(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move,
+                                int current_ap_cost) {
+    // Only do this for DISTANCE moves, and only spend one.
+    return my_move.hasSymbol(game::MS_DISTANCE) 
+           && current_ap_cost >= my_move.apCost(far, true);
+}
+
+inline bool SniperDef::shouldSpendSPForUltraAgility(game::Character const &me,
+                                  game::Character const &opponent,
+                                  bool far,
+                                  game::Move const &my_move) {
+    return my_move.hasSymbol(game::MS_DISTANCE);
+}
+
+inline bool SniperDef::shouldSpendSPToBoostDefence(game::Character const &me,
+                                 game::Character const &opponent,
+                                 bool far,
+                                 game::Move const &my_move) {
+    return my_move.hasSymbol(game::MS_DISTANCE);
+}
+
+inline bool SniperDef::shouldSpendSPToBoostCounterDamage(game::Character const &me,
+                                       game::Character const &opponent,
+                                       bool far,
+                                       game::Move const &my_move) {
+    return my_move.hasSymbol(game::MS_DISTANCE);
+}
+
+inline game::Move const & BalancedDef::getCounterMove(game::Character const &me,
+                                  game::Character const &opponent,
+                                  bool far,
+                                  game::Move const &opponent_move) {
+    size_t which_move = 0;
+    size_t this_move = 0;
+    float goodness = 0.0f;
+    for( ; which_move < me.moves.size(); ++which_move) {
+        game::Move const &m = me.moves[which_move];
+        if(m.isWait()) {
+            continue;
+        }
+        if(m.apCost(far, true) > me.cur_ap) {
+            continue;
+        }
+        if(m.isSuper() && me.cur_sp < 4) {
+            continue;
+        }
+        int dmg = m.counterDamage(1, me.at, me.df, 0, 
+            opponent_move.damage(1, opponent.at, opponent.df, 0));
+        int combo = m.comboPoints();
+        float potential_sp = 0.0f;
+        if(me.sp == game::SP_DAMAGE) {
+            potential_sp = (float)dmg / 3.0f;
+        }
+        else if(me.sp == game::SP_COMBO) {
+            potential_sp = (float)combo / 2.0;
+        }
+        float cur_goodness = dmg + potential_sp * 3.0f;
+        if(goodness < cur_goodness) {
+            this_move = which_move;
+            goodness = cur_goodness;
+        }
+    }
+    return me.moves[this_move];
+}
+
+inline bool BalancedDef::shouldSpendSPToLowerAPCost(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move,
+                                int current_ap_cost) {
+    return true;
+}
+
+inline bool BalancedDef::shouldSpendSPForUltraAgility(game::Character const &me,
+                                  game::Character const &opponent,
+                                  bool far,
+                                  game::Move const &my_move) {
+    return me.cur_sp > 1;
+}
+
+inline bool BalancedDef::shouldSpendSPToBoostDefence(game::Character const &me,
+                                 game::Character const &opponent,
+                                 bool far,
+                                 game::Move const &my_move) {
+    return true;
+}
+
+inline bool BalancedDef::shouldSpendSPToBoostCounterDamage(game::Character const &me,
+                                       game::Character const &opponent,
+                                       bool far,
+                                       game::Move const &my_move) {
+    return me.cur_sp > 1;
+}
+
+inline game::Move const & TacticalDef::getCounterMove(game::Character const &me,
+                                  game::Character const &opponent,
+                                  bool far,
+                                  game::Move const &opponent_move) {
+    size_t which_move = 0;
+    size_t this_move = 0;
+    float goodness = 0.0f;
+    for( ; which_move < me.moves.size(); ++which_move) {
+        game::Move const &m = me.moves[which_move];
+        if(m.isWait()) {
+            continue;
+        }
+        if(m.apCost(far, true) > me.cur_ap) {
+            continue;
+        }
+        if(m.isSuper() && me.cur_sp < 4) {
+            continue;
+        }
+        int dmg = m.counterDamage(1, me.at, me.df, 0, 
+            opponent_move.damage(1, opponent.at, opponent.df, 0));
+        int combo = m.comboPoints();
+        float potential_sp = 0.0f;
+        if(me.sp == game::SP_DAMAGE) {
+            potential_sp = (float)dmg / 3.0f;
+        }
+        else if(me.sp == game::SP_COMBO) {
+            potential_sp = (float)combo / 2.0;
+        }
+        float cur_goodness = dmg + potential_sp * 3.0f;
+        if(goodness < cur_goodness) {
+            this_move = which_move;
+            goodness = cur_goodness;
+        }
+    }
+    return me.moves[this_move];
+}
+
+inline bool TacticalDef::shouldSpendSPToLowerAPCost(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move,
+                                int current_ap_cost) {
+    return true;
+}
+
+inline bool TacticalDef::shouldSpendSPToComboBreak(game::Character const &me,
+                               game::Character const &opponent,
+                               bool far,
+                               game::Move const &opponent_move) {
+    // ALWAYS break.
+    return true;
+}
+
+inline bool TacticalDef::shouldSpendSPForUltraAgility(game::Character const &me,
+                                  game::Character const &opponent,
+                                  bool far,
+                                  game::Move const &my_move) {
+    return false;
+}
+
+inline bool TacticalDef::shouldSpendSPToBoostDefence(game::Character const &me,
+                                 game::Character const &opponent,
+                                 bool far,
+                                 game::Move const &my_move) {
+    return false;
+}
+
+inline bool TacticalDef::shouldSpendSPToBoostCounterDamage(game::Character const &me,
+                                       game::Character const &opponent,
+                                       bool far,
+                                       game::Move const &my_move) {
+    return true;
+}
+
+
+
+// ========================================================================
+//    STATIC DISPATCH
+// ========================================================================
+
+
+
+// The qualified calls below bypass the vtable; since the expert system classes
+// are final and their methods are defined above, the compiler is free to inline
+// them into the fight loop.
+#define DISPATCH_TO_ATTACK_ES(CALL) \
+    switch(m_tag) { \
+        case ES_DUMB: \
+            return static_cast<DumbAttackControl *>(m_ctrl)->DumbAttackControl::CALL; \
+        case ES_GRUNT: \
+            return static_cast<GruntAtk *>(m_ctrl)->GruntAtk::CALL; \
+        case ES_BRAWLER: \
+            return static_cast<BrawlerAtk *>(m_ctrl)->BrawlerAtk::CALL; \
+        case ES_BUFFER: \
+            return static_cast<BufferAtk *>(m_ctrl)->BufferAtk::CALL; \
+        case ES_COUNTER: \
+            return static_cast<CounterAttackerAtk *>(m_ctrl)->CounterAttackerAtk::CALL; \
+        case ES_KILLER_CHAIN: \
+            return static_cast<KillerChainAtk *>(m_ctrl)->KillerChainAtk::CALL; \
+        case ES_KITE_SNIPER: \
+            return static_cast<KiteSniperAtk *>(m_ctrl)->KiteSniperAtk::CALL; \
+        case ES_BALANCED: \
+            return static_cast<BalancedAtk *>(m_ctrl)->BalancedAtk::CALL; \
+        case ES_TACTICAL: \
+            return static_cast<TacticalAtk *>(m_ctrl)->TacticalAtk::CALL; \
+        default: break; \
+    } \
+    return m_ctrl->CALL;
+
+#define DISPATCH_TO_DEFENCE_ES(CALL) \
+    switch(m_tag) { \
+        case ES_DUMB: \
+            return static_cast<DumbDefendControl *>(m_ctrl)->DumbDefendControl::CALL; \
+        case ES_GRUNT: \
+            return static_cast<GruntDef *>(m_ctrl)->GruntDef::CALL; \
+        case ES_BRAWLER: \
+            return static_cast<BrawlerDef *>(m_ctrl)->BrawlerDef::CALL; \
+        case ES_BUFFER: \
+            return static_cast<BufferDef *>(m_ctrl)->BufferDef::CALL; \
+        case ES_COUNTER: \
+            return static_cast<CounterAttackerDef *>(m_ctrl)->CounterAttackerDef::CALL; \
+        case ES_KILLER_CHAIN: \
+            return static_cast<KillerChainDef *>(m_ctrl)->KillerChainDef::CALL; \
+        case ES_KITE: \
+            return static_cast<KiteDef *>(m_ctrl)->KiteDef::CALL; \
+        case ES_SNIPER: \
+            return static_cast<SniperDef *>(m_ctrl)->SniperDef::CALL; \
+        case ES_BALANCED: \
+            return static_cast<BalancedDef *>(m_ctrl)->BalancedDef::CALL; \
+        case ES_TACTICAL: \
+            return static_cast<TacticalDef *>(m_ctrl)->TacticalDef::CALL; \
+        default: break; \
+    } \
+    return m_ctrl->CALL;
+
+inline ExpertAttackDispatch::ExpertAttackDispatch(AttackControl &ctrl)
+:   m_ctrl(&ctrl), m_tag(getExpertSystemTag(ctrl)) {}
+
+inline int ExpertAttackDispatch::shouldSpendAPToGainSP(game::Character const &me,
+                          game::Character const &opponent,
+                          bool far) {
+    DISPATCH_TO_ATTACK_ES(shouldSpendAPToGainSP(me, opponent, far))
+}
+
+inline bool ExpertAttackDispatch::shouldSpendAPToFallStanding(
+                                 game::Character const &me,
+                                 game::Character const &opponent,
+                                 bool far) {
+    DISPATCH_TO_ATTACK_ES(shouldSpendAPToFallStanding(me, opponent, far))
+}
+
+inline game::Move const & ExpertAttackDispatch::getNextMove(game::Character const &me,
+                               game::Character const &opponent,
+                               bool far) {
+    DISPATCH_TO_ATTACK_ES(getNextMove(me, opponent, far))
+}
+
+inline bool ExpertAttackDispatch::shouldSpendSPToLowerAPCost(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move,
+                                int current_ap_cost) {
+    DISPATCH_TO_ATTACK_ES(shouldSpendSPToLowerAPCost(me, opponent, far, my_move,
+                                                     current_ap_cost))
+}
+
+inline bool ExpertAttackDispatch::shouldSpendSPToConcatenate(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move) {
+    DISPATCH_TO_ATTACK_ES(shouldSpendSPToConcatenate(me, opponent, far, my_move))
+}
+
+inline bool ExpertAttackDispatch::shouldSpendSPForUltraAgility(
+                                  game::Character const &me,
+                                  game::Character const &opponent,
+                                  bool far,
+                                  game::Move const &my_move) {
+    DISPATCH_TO_ATTACK_ES(shouldSpendSPForUltraAgility(me, opponent, far, my_move))
+}
+
+inline bool ExpertAttackDispatch::shouldSpendSPToBoostAttack(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move) {
+    DISPATCH_TO_ATTACK_ES(shouldSpendSPToBoostAttack(me, opponent, far, my_move))
+}
+
+inline bool ExpertAttackDispatch::shouldSpendSPToBoostDamage(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move) {
+    DISPATCH_TO_ATTACK_ES(shouldSpendSPToBoostDamage(me, opponent, far, my_move))
+}
+
+inline void ExpertAttackDispatch::updateAfterMove(game::Character const &me,
+                                           game::Character const &opponent,
+                                           game::Move const &move,
+                                           bool successful) {
+    DISPATCH_TO_ATTACK_ES(updateAfterMove(me, opponent, move, successful))
+}
+
+inline ExpertDefenceDispatch::ExpertDefenceDispatch(DefendControl &ctrl)
+:   m_ctrl(&ctrl), m_tag(getExpertSystemTag(ctrl)) {}
+
+inline game::Move const & ExpertDefenceDispatch::getCounterMove(
+                                  game::Character const &me,
+                                  game::Character const &opponent,
+                                  bool far,
+                                  game::Move const &opponent_move) {
+    DISPATCH_TO_DEFENCE_ES(getCounterMove(me, opponent, far, opponent_move))
+}
+
+inline bool ExpertDefenceDispatch::shouldSpendSPToComboBreak(game::Character const &me,
+                               game::Character const &opponent,
+                               bool far,
+                               game::Move const &opponent_move) {
+    DISPATCH_TO_DEFENCE_ES(shouldSpendSPToComboBreak(me, opponent, far,
+                                                     opponent_move))
+}
+
+inline bool ExpertDefenceDispatch::shouldSpendSPToLowerAPCost(game::Character const &me,
+                                game::Character const &opponent,
+                                bool far,
+                                game::Move const &my_move,
+                                int current_ap_cost) {
+    DISPATCH_TO_DEFENCE_ES(shouldSpendSPToLowerAPCost(me, opponent, far, my_move,
+                                                      current_ap_cost))
+}
+
+inline bool ExpertDefenceDispatch::shouldSpendSPForUltraAgility(
+                                  game::Character const &me,
+                                  game::Character const &opponent,
+                                  bool far,
+                                  game::Move const &my_move) {
+    DISPATCH_TO_DEFENCE_ES(shouldSpendSPForUltraAgility(me, opponent, far,
+                                                        my_move))
+}
+
+inline bool ExpertDefenceDispatch::shouldSpendSPToBoostDefence(
+                                 game::Character const &me,
+                                 game::Character const &opponent,
+                                 bool far,
+                                 game::Move const &my_move) {
+    DISPATCH_TO_DEFENCE_ES(shouldSpendSPToBoostDefence(me, opponent, far, my_move))
+}
+
+inline bool ExpertDefenceDispatch::shouldSpendSPToBoostCounterDamage(
+                                       game::Character const &me,
+                                       game::Character const &opponent,
+                                       bool far,
+                                       game::Move const &my_move) {
+    DISPATCH_TO_DEFENCE_ES(shouldSpendSPToBoostCounterDamage(me, opponent, far,
+                                                             my_move))
+}
+
+inline void ExpertDefenceDispatch::updateAfterMove(game::Character const &me,
+                                            game::Character const &opponent,
+                                            game::Move const &move,
+                                            bool successful) {
+    DISPATCH_TO_DEFENCE_ES(updateAfterMove(me, opponent, move, successful))
+}
+
+#undef DISPATCH_TO_ATTACK_ES
+#undef DISPATCH_TO_DEFENCE_ES
+
+
+
+}
+}
+
+#endif
@@ -0,0 +1,213 @@
+// Copyright 2015 Dario Domizioli
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CORE_CTRL_MCTSCTRL_H
+#define CORE_CTRL_MCTSCTRL_H
+
+#include "core/ctrl/CtrlInterfaces.h"
+#include "core/ctrl/PlannedCtrl.h"
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace core {
+
+namespace sim {
+    class ThreadPool;
+}
+
+namespace ctrl {
+
+/**
+ * \brief The parameters of a Monte Carlo search; see MCTSAttack.
+ */
+struct MCTSOptions {
+    /// \brief Default values: 256 rollouts per decision, no time limit, the
+    ///        Balanced expert systems as rollout policy, one thread.
+    MCTSOptions();
+
+    /// \brief Maximum number of rollouts per decision; 0 means no limit.
+    size_t rollouts;
+    /// \brief Maximum time per decision in milliseconds; 0 means no limit.
+    ///        If both limits are 0, every candidate is tried once.
+    double milliseconds;
+    /// \brief The exploration constant of the UCB1 formula.
+    double exploration;
+    /// \brief The expert system combination which plays both sides of the
+    ///        rollouts (see getAttackExpertSystem).
+    int policy;
+    /// \brief The number of Duel steps after which a rollout is scored as a
+    ///        draw.
+    size_t max_steps;
+    /// \brief The number of threads running rollouts; 0 means one per
+    ///        hardware thread.
+    unsigned threads;
+};
+
+/**
+ * \brief This class implements a Monte Carlo search AI that plays the game in
+ *        attack.
+ *
+ * At every move decision the legal moves, each paired with a way of spending
+ * SP on it (see SPStyle), are the arms of a UCB1 bandit. Every rollout plays
+ * the chosen arm from the current state of the fight and then lets the rollout
+ * policy play both characters until the end; the most tried arm is chosen.
+ * The other decisions follow the plan of the chosen arm, or the policy.
+ */
+class MCTSAttack : public AttackControl {
+public:
+    explicit MCTSAttack(MCTSOptions const &options = MCTSOptions());
+    virtual ~MCTSAttack();
+
+    char const * const getName() const override;
+
+    int shouldSpendAPToGainSP(game::Character const &me,
+                              game::Character const &opponent,
+                              bool far) override;
+
+    bool shouldSpendAPToFallStanding(game::Character const &me,
+                                     game::Character const &opponent,
+                                     bool far) override;
+
+    game::Move const & getNextMove(game::Character const &me,
+                                   game::Character const &opponent,
+                                   bool far) override;
+
+    bool shouldSpendSPToLowerAPCost(game::Character const &me,
+                                    game::Character const &opponent,
+                                    bool far,
+                                    game::Move const &my_move,
+                                    int current_ap_cost) override;
+
+    bool shouldSpendSPToConcatenate(game::Character const &me,
+                                    game::Character const &opponent,
+                                    bool far,
+                                    game::Move const &my_move) override;
+
+    bool shouldSpendSPForUltraAgility(game::Character const &me,
+                                      game::Character const &opponent,
+                                      bool far,
+                                      game::Move const &my_move) override;
+
+    bool shouldSpendSPToBoostAttack(game::Character const &me,
+                                    game::Character const &opponent,
+                                    bool far,
+                                    game::Move const &my_move) override;
+
+    bool shouldSpendSPToBoostDamage(game::Character const &me,
+                                    game::Character const &opponent,
+                                    bool far,
+                                    game::Move const &my_move) override;
+
+    void updateAfterMove(game::Character const &me,
+                         game::Character const &opponent,
+                         game::Move const &move,
+                         bool successful) override;
+
+    void updateAfterMatch(game::Character const &me,
+                          game::Character const &opponent,
+                          bool has_won) override;
+
+    void forgetMatch(game::Character const &me) override;
+
+private:
+    /// \brief Answers an SP decision according to the plan for 'me'.
+    bool followPlan(game::Character const &me, bool policy_answer);
+
+    /// The search parameters.
+    MCTSOptions m_options;
+    /// The threads running the rollouts.
+    std::shared_ptr<sim::ThreadPool> m_pool;
+    /// The policy, for the decisions that are not searched.
+    std::shared_ptr<AttackControl> m_policy;
+    /// The SP style of the last chosen move, per Character uid.
+    std::unordered_map<size_t, SPStyle> m_plans;
+    /// Content mutex to protect against multi-threading.
+    std::mutex m_content_mutex;
+};
+
+/**
+ * \brief This class implements a Monte Carlo search AI that plays the game in
+ *        defence; the counter moves are searched like the moves of MCTSAttack.
+ */
+class MCTSDefence : public DefendControl {
+public:
+    explicit MCTSDefence(MCTSOptions const &options = MCTSOptions());
+    virtual ~MCTSDefence();
+
+    char const * const getName() const override;
+
+    game::Move const & getCounterMove(game::Character const &me,
+                                      game::Character const &opponent,
+                                      bool far,
+                                      game::Move const &opponent_move) override;
+
+    bool shouldSpendSPToComboBreak(game::Character const &me,
+                                   game::Character const &opponent,
+                                   bool far,
+                                   game::Move const &opponent_move) override;
+
+    bool shouldSpendSPToLowerAPCost(game::Character const &me,
+                                    game::Character const &opponent,
+                                    bool far,
+                                    game::Move const &my_move,
+                                    int current_ap_cost) override;
+
+    bool shouldSpendSPForUltraAgility(game::Character const &me,
+                                      game::Character const &opponent,
+                                      bool far,
+                                      game::Move const &my_move) override;
+
+    bool shouldSpendSPToBoostDefence(game::Character const &me,
+                                     game::Character const &opponent,
+                                     bool far,
+                                     game::Move const &my_move) override;
+
+    bool shouldSpendSPToBoostCounterDamage(game::Character const &me,
+                                           game::Character const &opponent,
+                                           bool far,
+                                           game::Move const &my_move) override;
+
+    void updateAfterMove(game::Character const &me,
+                         game::Character const &opponent,
+                         game::Move const &move,
+                         bool successful) override;
+
+    void updateAfterMatch(game::Character const &me,
+                          game::Character const &opponent,
+                          bool has_won) override;
+
+    void forgetMatch(game::Character const &me) override;
+
+private:
+    /// \brief Answers an SP decision according to the plan for 'me'.
+    bool followPlan(game::Character const &me, bool policy_answer);
+
+    /// The search parameters.
+    MCTSOptions m_options;
+    /// The threads running the rollouts.
+    std::shared_ptr<sim::ThreadPool> m_pool;
+    /// The policy, for the decisions that are not searched.
+    std::shared_ptr<DefendControl> m_policy;
+    /// The SP style of the last chosen counter, per Character uid.
+    std::unordered_map<size_t, SPStyle> m_plans;
+    /// Content mutex to protect against multi-threading.
+    std::mutex m_content_mutex;
+};
+
+}
+}
+
+#endif
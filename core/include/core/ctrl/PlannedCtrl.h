@@ -0,0 +1,206 @@
+// Copyright 2015 Dario Domizioli
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CORE_CTRL_PLANNEDCTRL_H
+#define CORE_CTRL_PLANNEDCTRL_H
+
+#include "core/ctrl/CtrlInterfaces.h"
+#include "core/game/Duel.h"
+
+#include <memory>
+#include <vector>
+
+namespace core {
+namespace ctrl {
+
+/// \brief An enumeration identifying how a planned move spends SP on the
+///        optional boosts while it is performed.
+enum SPStyle : int {
+    SPS_POLICY,   ///< Ask the policy.
+    SPS_NEVER,    ///< Never spend SP.
+    SPS_ALWAYS    ///< Spend SP whenever the rules allow it.
+};
+
+/// \brief Returns the decision to take in the given style, given the one the
+///        policy would take.
+bool applyStyle(SPStyle style, bool policy_answer);
+
+/// \brief A move to play at the next decision, by index in the moves of the
+///        Character; it is only followed while armed.
+struct MovePlan {
+    bool armed;
+    size_t move;
+    SPStyle style;
+};
+
+/**
+ * \brief This class implements a control system for attack that plays the
+ *        move of a plan while the plan is armed and otherwise asks a policy.
+ *
+ * Searching AIs give these to the characters they simulate, and arm the plan
+ * to try one of their candidate moves. The plan is not owned and is read at
+ * every decision, so it can be changed between steps of the fight.
+ */
+class PlannedAttack final : public AttackControl {
+public:
+    PlannedAttack(std::shared_ptr<AttackControl> policy, MovePlan const &plan);
+    virtual ~PlannedAttack();
+
+    char const * const getName() const override;
+
+    int shouldSpendAPToGainSP(game::Character const &me,
+                              game::Character const &opponent,
+                              bool far) override;
+
+    bool shouldSpendAPToFallStanding(game::Character const &me,
+                                     game::Character const &opponent,
+                                     bool far) override;
+
+    game::Move const & getNextMove(game::Character const &me,
+                                   game::Character const &opponent,
+                                   bool far) override;
+
+    bool shouldSpendSPToLowerAPCost(game::Character const &me,
+                                    game::Character const &opponent,
+                                    bool far,
+                                    game::Move const &my_move,
+                                    int current_ap_cost) override;
+
+    bool shouldSpendSPToConcatenate(game::Character const &me,
+                                    game::Character const &opponent,
+                                    bool far,
+                                    game::Move const &my_move) override;
+
+    bool shouldSpendSPForUltraAgility(game::Character const &me,
+                                      game::Character const &opponent,
+                                      bool far,
+                                      game::Move const &my_move) override;
+
+    bool shouldSpendSPToBoostAttack(game::Character const &me,
+                                    game::Character const &opponent,
+                                    bool far,
+                                    game::Move const &my_move) override;
+
+    bool shouldSpendSPToBoostDamage(game::Character const &me,
+                                    game::Character const &opponent,
+                                    bool far,
+                                    game::Move const &my_move) override;
+
+    void updateAfterMove(game::Character const &me,
+                         game::Character const &opponent,
+                         game::Move const &move,
+                         bool successful) override;
+
+    void updateAfterMatch(game::Character const &me,
+                          game::Character const &opponent,
+                          bool has_won) override;
+
+private:
+    /// \brief Applies the style of the plan if armed.
+    bool follow(bool policy_answer) const;
+
+    /// The policy.
+    std::shared_ptr<AttackControl> m_policy;
+    /// The plan.
+    MovePlan const &m_plan;
+};
+
+/**
+ * \brief This class implements a control system for defence that counters
+ *        with the move of a plan while the plan is armed and otherwise asks a
+ *        policy. The combo break decision always comes from the policy, since
+ *        it is taken before the counter.
+ */
+class PlannedDefence final : public DefendControl {
+public:
+    PlannedDefence(std::shared_ptr<DefendControl> policy, MovePlan const &plan);
+    virtual ~PlannedDefence();
+
+    char const * const getName() const override;
+
+    game::Move const & getCounterMove(game::Character const &me,
+                                      game::Character const &opponent,
+                                      bool far,
+                                      game::Move const &opponent_move) override;
+
+    bool shouldSpendSPToComboBreak(game::Character const &me,
+                                   game::Character const &opponent,
+                                   bool far,
+                                   game::Move const &opponent_move) override;
+
+    bool shouldSpendSPToLowerAPCost(game::Character const &me,
+                                    game::Character const &opponent,
+                                    bool far,
+                                    game::Move const &my_move,
+                                    int current_ap_cost) override;
+
+    bool shouldSpendSPForUltraAgility(game::Character const &me,
+                                      game::Character const &opponent,
+                                      bool far,
+                                      game::Move const &my_move) override;
+
+    bool shouldSpendSPToBoostDefence(game::Character const &me,
+                                     game::Character const &opponent,
+                                     bool far,
+                                     game::Move const &my_move) override;
+
+    bool shouldSpendSPToBoostCounterDamage(game::Character const &me,
+                                           game::Character const &opponent,
+                                           bool far,
+                                           game::Move const &my_move) override;
+
+    void updateAfterMove(game::Character const &me,
+                         game::Character const &opponent,
+                         game::Move const &move,
+                         bool successful) override;
+
+    void updateAfterMatch(game::Character const &me,
+                          game::Character const &opponent,
+                          bool has_won) override;
+
+private:
+    /// \brief Applies the style of the plan if armed.
+    bool follow(bool policy_answer) const;
+
+    /// The policy.
+    std::shared_ptr<DefendControl> m_policy;
+    /// The plan.
+    MovePlan const &m_plan;
+};
+
+/// \brief Creates a copy of a Character with the same attributes and moves
+///        but different control systems, e.g. to simulate its fights.
+std::shared_ptr<game::Character> makeSimulatedCharacter(
+    game::Character const &c, std::shared_ptr<AttackControl> att,
+    std::shared_ptr<DefendControl> def);
+
+/// \brief Returns the indices of the moves worth trying in attack for a
+///        Character in the given state: the legal ones, except the last move
+///        performed, reflections and distance moves when close up, like the
+///        evolving AI does. The wait move comes last.
+std::vector<size_t> getAttackCandidates(game::Character const &c,
+                                        game::FighterState const &fs,
+                                        bool far);
+
+/// \brief Returns the indices of the moves worth trying as counters for a
+///        Character in the given state: the legal ones that can reach the
+///        opponent. The wait move comes last.
+std::vector<size_t> getCounterCandidates(game::Character const &c,
+                                         game::FighterState const &fs,
+                                         bool far);
+
+}
+}
+
+#endif
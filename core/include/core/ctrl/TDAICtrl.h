@@ -0,0 +1,174 @@
+// Copyright 2015 Dario Domizioli
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CORE_CTRL_TDAICTRL_H
+#define CORE_CTRL_TDAICTRL_H
+
+#include "core/ctrl/EvolveAICtrl.h"
+
+#include <mutex>
+#include <unordered_map>
+
+namespace core {
+namespace ctrl {
+
+/**
+ * \brief The parameters of the temporal difference learning; see TDAIAttack.
+ */
+struct TDOptions {
+    /// \brief Default values: learning rate 0.2, shaping 1, exploration 0.1.
+    TDOptions();
+
+    /// \brief The fraction of the TD error applied at each update.
+    double learning_rate;
+    /// \brief The weight of the change in life between two decisions, as a
+    ///        reward; 0 learns from the outcome of the fight only.
+    double shaping;
+    /// \brief The probability of choosing a random legal move instead of the
+    ///        best known one.
+    double exploration;
+};
+
+/// \brief The decisions of a fight which are waiting for their TD update.
+struct TDTrace {
+    /// \brief Whether there is a decision whose move has not ended yet.
+    bool has_current;
+    /// \brief Whether there is a decision waiting for its successor.
+    bool has_previous;
+    /// \brief The decisions.
+    DecisionRecord current;
+    DecisionRecord previous;
+    /// \brief The value of the life lead when the decisions were made.
+    double current_lead;
+    double previous_lead;
+};
+
+/// \brief A context-based data structure for storing TDTraces.
+typedef std::unordered_map<size_t, TDTrace> TDTraceMap;
+
+/**
+ * \brief This class implements a temporal difference AI that plays the game
+ *        in attack.
+ *
+ * The moves are chosen on a DecisionMatrix indexed like the one of
+ * EvolveAIAttack, which holds the expected value of each move (SARSA). When a
+ * move ends, the previous move is updated towards the value of this one plus
+ * the change in life lead between the two decisions, so every move gets the
+ * credit of what happened right after it instead of the outcome of the whole
+ * fight; the last move is updated towards the outcome. The SP decisions are
+ * still learnt as in EvolveAIAttack.
+ */
+class TDAIAttack : public EvolveAIAttack {
+public:
+    explicit TDAIAttack(TDOptions const &options = TDOptions());
+    virtual ~TDAIAttack();
+
+    char const * const getName() const override;
+
+    game::Move const & getNextMove(game::Character const &me,
+                                   game::Character const &opponent,
+                                   bool far) override;
+
+    void updateAfterMove(game::Character const &me,
+                         game::Character const &opponent,
+                         game::Move const &move,
+                         bool successful) override;
+
+    void updateAfterMatch(game::Character const &me,
+                          game::Character const &opponent,
+                          bool has_won) override;
+
+    void forgetMatch(game::Character const &me) override;
+
+    double getConvergence() override;
+
+    void saveState(std::ostream &out) override;
+
+    bool loadState(std::istream &in) override;
+
+    /// \brief Returns the learnt value of a move.
+    double getValue(game::Character const &me,
+                    game::Character const &opponent,
+                    size_t move);
+
+private:
+    /// The learning parameters.
+    TDOptions m_options;
+
+    /// Decision matrix of the move values.
+    DecisionMatrix m_value_matrix;
+
+    /// Decisions waiting for their update.
+    TDTraceMap m_traces;
+
+    /// Content mutex to protect against multi-threading.
+    std::mutex m_td_mutex;
+};
+
+/**
+ * \brief This class implements a temporal difference AI that plays the game
+ *        in defence; the counters are learnt like the moves of TDAIAttack.
+ */
+class TDAIDefence : public EvolveAIDefence {
+public:
+    explicit TDAIDefence(TDOptions const &options = TDOptions());
+    virtual ~TDAIDefence();
+
+    char const * const getName() const override;
+
+    game::Move const & getCounterMove(game::Character const &me,
+                                      game::Character const &opponent,
+                                      bool far,
+                                      game::Move const &opponent_move) override;
+
+    void updateAfterMove(game::Character const &me,
+                         game::Character const &opponent,
+                         game::Move const &move,
+                         bool successful) override;
+
+    void updateAfterMatch(game::Character const &me,
+                          game::Character const &opponent,
+                          bool has_won) override;
+
+    void forgetMatch(game::Character const &me) override;
+
+    double getConvergence() override;
+
+    void saveState(std::ostream &out) override;
+
+    bool loadState(std::istream &in) override;
+
+    /// \brief Returns the learnt value of a counter move.
+    double getValue(game::Character const &me,
+                    game::Character const &opponent,
+                    size_t move);
+
+private:
+    /// The learning parameters.
+    TDOptions m_options;
+
+    /// Decision matrix of the counter move values.
+    DecisionMatrix m_value_matrix;
+
+    /// Decisions waiting for their update.
+    TDTraceMap m_traces;
+
+    /// Content mutex to protect against multi-threading.
+    std::mutex m_td_mutex;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,90 @@
+// Copyright 2015 Dario Domizioli
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CORE_GAME_BATCHDUEL_H
+#define CORE_GAME_BATCHDUEL_H
+
+#include "core/game/Duel.h"
+
+#include <memory>
+#include <vector>
+
+namespace core {
+namespace game {
+
+/**
+ * \brief This class runs many independent fights between the same two
+ *        characters, reusing one Duel for all of them.
+ *
+ * This is a batching helper, not a vector engine: the fights ("lanes") are
+ * still stepped one at a time by the scalar Duel::step(). Their states are
+ * kept in a vector of DuelState, and each sweep swaps the state of every lane
+ * which is still fighting into a single shared Duel, advances it to the start
+ * of its next turn and swaps it back out; the lanes which are over are
+ * dropped from the list of active lanes. Sharing the Duel, and thus a single
+ * pair of clones, saves building one per fight, and the dice are generated
+ * in blocks by a BlockDiceSource owned by the batch.
+ *
+ * Control systems which learn or search keep state per fight, by the uid of
+ * the clone, so they cannot share it between lanes: when a control system of
+ * either character is not one of the built-in stateless ones (see
+ * ctrl::getExpertSystemTag), each lane gets a Duel and clones of its own and
+ * the lanes are fought one after the other, with no shared Duel at all.
+ *
+ * The results have the same distribution as those of Duel::fight(); only the
+ * order in which the dice are used differs.
+ */
+class BatchDuel {
+public:
+    /// \brief Main ctor. Takes the two characters, the number of fights to
+    ///        run and the seed of the dice.
+    BatchDuel(std::shared_ptr<Character> c1, std::shared_ptr<Character> c2,
+              size_t lanes, unsigned long seed);
+
+    /// \brief Dtor.
+    ~BatchDuel();
+
+    /// \brief Runs all the fights until they are over.
+    void fight();
+
+    /// \brief Returns the outcome of each fight.
+    std::vector<DuelResult> const & results() const { return m_results; }
+
+    /// \brief Assigns points to the original characters and informs their
+    ///        control systems of the outcome of every fight.
+    void conclude();
+
+    /// \brief Makes the control systems of the characters forget every
+    ///        fight without learning from it or assigning points.
+    void abandon();
+
+private:
+    /// The dice, generated in blocks.
+    std::unique_ptr<DiceSource> m_dice;
+    /// The Duel shared by the lanes, null if they cannot share one.
+    std::unique_ptr<Duel> m_engine;
+    /// The Duel of each lane, if the lanes cannot share the engine.
+    std::vector<std::unique_ptr<Duel>> m_duels;
+    /// The state of each lane while it is not in the engine.
+    std::vector<DuelState> m_lanes;
+    /// The lanes still fighting.
+    std::vector<size_t> m_active;
+    /// The outcome of each lane.
+    std::vector<DuelResult> m_results;
+};
+
+}
+}
+
+#endif
@@ -17,6 +17,7 @@
 #define CORE_GAME_CHARACTER_H
 
 #include "core/game/Move.h"
+#include <atomic>
 #include <string>
 #include <vector>
 #include <mutex>
@@ -28,6 +29,7 @@ namespace core {
 namespace ctrl {
     class AttackControl;
     class DefendControl;
+    class BestMoveTable;
 }
 
 namespace game {
@@ -131,8 +133,12 @@ public:
     ///        Character; this is often inspected by the AI.
     std::vector<size_t> moves_performed;
 
-    /// \brief Current score.
-    int total_points;
+    /// \brief Current score; atomic, as concurrent fights add to it.
+    std::atomic<int> total_points;
+
+    /// \brief Precomputed move choices of the attack expert system, if any;
+    ///        shared with the clones. See ctrl::prepareBestMoveTable.
+    std::shared_ptr<ctrl::BestMoveTable const> best_moves;
 
     /// \brief Unique identifier for the Character; this is used by AIs in
     ///        multi-threaded mode to maintain contexts.
@@ -146,6 +152,30 @@ public:
 /// \brief Generates a character with random values, moves and AI.
 std::shared_ptr<Character> generateRandomCharacter(bool allow_expert_systems = false);
 
+/// \brief Makes a character like generateRandomCharacter does, from the values
+///        it draws: 'combination' is the expert system combination (see
+///        ctrl::getAttackExpertSystem), or -1 for the evolving AIs; the
+///        symbols are those of the first special move (1), the second (2),
+///        the third (2) and the super move (3).
+std::shared_ptr<Character> makeRandomCharacter(std::string const &name,
+                                               int ra, int at, SPMode sp,
+                                               int combination,
+                                               MoveSymbol const symbols[8]);
+
+/// \brief The index returned by mapMoves for a move with no counterpart.
+size_t const NO_MOVE = static_cast<size_t>(-1);
+
+/// \brief Returns, for each move of 'to', the index of the most similar move of
+///        'from' of the same type (see moveSimilarity), or NO_MOVE if 'from' has
+///        no move of that type. Equally similar moves at the same index are
+///        preferred, so the standard moves map to themselves.
+std::vector<size_t> mapMoves(Character const &from, Character const &to);
+
+/// \brief Returns how similar two characters are, between 0 and 1: it weighs
+///        the difference of RA, AT and DF, whether the SP mode is the same,
+///        and how similar the moves matched by mapMoves are.
+double similarity(Character const &a, Character const &b);
+
 }
 }
 
@@ -17,19 +17,253 @@
 #define CORE_GAME_DICE_H
 
 
+#include <cstdint>
+#include <iosfwd>
 #include <random>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 namespace core {
 namespace game {
 
-/// \brief Returns the roll of a d6, with the 6 changed into an 8.
+/// \brief Returns the roll of a d6, with the 6 changed into an 8. Each thread
+///        rolls from its own BlockDiceSource, so no locking is needed.
 int d6WithCrit();
 
 /// \brief Returns true with a very small probability.
 bool fuzz();
 
+/// \brief Seeds the dice of all threads: each thread restarts from a seed
+///        derived from this one and from the order in which the threads roll
+///        after this call, so single-threaded runs are reproducible.
+void seedDice(unsigned long seed);
+
+/**
+ * \brief The position of a counter-based dice source in its stream of rolls:
+ *        the stream is identified by the key, and the counter says how far
+ *        into it the source is.
+ */
+struct DicePosition {
+    uint64_t key;
+    uint64_t counter;
+};
+
+/**
+ * \brief This class represents a source of dice rolls for a fight. The
+ *        default one rolls the dice of the calling thread, but fights can
+ *        be given other sources, e.g. to enumerate the possible rolls or to
+ *        reproduce a sequence of rolls.
+ */
+class DiceSource {
+public:
+    /// \brief Virtual destructor.
+    virtual ~DiceSource();
+
+    /// \brief Returns the roll of a d6, with the 6 changed into an 8.
+    virtual int d6WithCrit() = 0;
+
+    /// \brief Returns the roll of a d6 made by the first (0) or the second
+    ///        (1) character of a fight; sources can keep a separate sequence
+    ///        of rolls for each of them. By default it is d6WithCrit().
+    virtual int d6WithCritFor(int fighter);
+
+    /// \brief Returns true with a very small probability.
+    virtual bool fuzz() = 0;
+
+    /// \brief Stores the position of the source in its stream of rolls and
+    ///        returns true, or returns false if the source cannot do that.
+    virtual bool getPosition(DicePosition &position) const;
+
+    /// \brief Moves the source to a position in its stream of rolls and
+    ///        returns true, or returns false if the source cannot do that.
+    virtual bool setPosition(DicePosition const &position);
+};
+
+/// \brief Returns the dice source which rolls the dice of the calling thread,
+///        a thread-local BlockDiceSource (xoshiro256**) seeded by seedDice();
+///        the functions above are equivalent to calling it.
+DiceSource &getGlobalDiceSource();
+
+/**
+ * \brief This class represents a dice source with its own random generators,
+ *        so that a fight can be replayed by reseeding it and two fights can be
+ *        run on the same rolls (common random numbers).
+ *
+ * Each character of a fight rolls from its own generator, so that the rolls
+ * of a character do not shift when its opponent rolls more or less often;
+ * this keeps two fights against the same opponent in step for longer.
+ *
+ * In antithetic mode every roll is mirrored, i.e. the faces 1, 2, 3 of the d6
+ * become 8, 5, 4 and vice versa; a fight run with the antithetic source of a
+ * seed is negatively correlated with the one run with the plain source.
+ */
+class SeededDiceSource : public DiceSource {
+public:
+    /// \brief Main ctor.
+    explicit SeededDiceSource(unsigned long seed = 0, bool antithetic = false);
+
+    /// \brief Restarts the source from the given seed.
+    void reset(unsigned long seed, bool antithetic = false);
+
+    /// \brief Returns the roll of a d6, with the 6 changed into an 8.
+    int d6WithCrit() override;
+
+    /// \brief Returns the roll of a d6 for the given character.
+    int d6WithCritFor(int fighter) override;
+
+    /// \brief Returns true with a very small probability.
+    bool fuzz() override;
+
+private:
+    /// The random generators of the two characters.
+    std::default_random_engine m_generators[2];
+    /// The distribution for the d6.
+    std::uniform_int_distribution<int> m_d6;
+    /// The distribution for the d20.
+    std::uniform_int_distribution<int> m_d20;
+    /// Are the rolls mirrored?
+    bool m_antithetic;
+};
+
+/**
+ * \brief This class represents a dice source which generates its rolls in
+ *        blocks and hands them out one at a time from a buffer.
+ *
+ * The generator is xoshiro256**, run as four interleaved streams so that the
+ * refill loop has no dependency between consecutive outputs and can be
+ * vectorized. Each 64-bit output gives two 32-bit values, which are reduced
+ * to the range of the die with Lemire's multiply-and-shift method, rejecting
+ * the few values which would bias the result.
+ */
+class BlockDiceSource : public DiceSource {
+public:
+    /// \brief Main ctor.
+    explicit BlockDiceSource(unsigned long seed = 0);
+
+    /// \brief Restarts the source from the given seed.
+    void reset(unsigned long seed);
+
+    /// \brief Returns the roll of a d6, with the 6 changed into an 8.
+    int d6WithCrit() override {
+        if(m_next_d6 == s_block) {
+            refill(m_d6, 6);
+            m_next_d6 = 0;
+        }
+        return m_d6[m_next_d6++];
+    }
+
+    /// \brief Returns true with a very small probability.
+    bool fuzz() override {
+        if(m_next_d20 == s_block) {
+            refill(m_d20, 20);
+            m_next_d20 = 0;
+        }
+        return m_d20[m_next_d20++] < 2;
+    }
+
+    /// \brief The number of rolls generated at a time.
+    static size_t const s_block = 256;
+
+    /// \brief Writes the state of the source in binary form, for load.
+    void save(std::ostream &out) const;
+
+    /// \brief Reads a state written by save; returns false if the data is
+    ///        malformed.
+    bool load(std::istream &in);
+
+private:
+    /// \brief Fills the buffer with rolls of a die with the given number of
+    ///        faces; for the d6 the 6 is turned into an 8.
+    void refill(unsigned char *buffer, uint32_t faces);
+
+    /// The number of interleaved streams.
+    static size_t const s_lanes = 4;
+    /// The state of the streams, one row per word of state.
+    uint64_t m_state[4][s_lanes];
+    /// The buffered d6 rolls.
+    unsigned char m_d6[s_block];
+    /// The next d6 roll to hand out.
+    size_t m_next_d6;
+    /// The buffered d20 rolls.
+    unsigned char m_d20[s_block];
+    /// The next d20 roll to hand out.
+    size_t m_next_d20;
+};
+
+/**
+ * \brief This class represents a dice source whose whole state is a
+ *        DicePosition: each roll is a hash of the key and of a counter, so the
+ *        source can be saved, restored and forked by copying two integers.
+ */
+class CounterDiceSource : public DiceSource {
+public:
+    /// \brief Main ctor.
+    explicit CounterDiceSource(uint64_t key = 0, uint64_t counter = 0);
+
+    /// \brief Returns the roll of a d6, with the 6 changed into an 8.
+    int d6WithCrit() override;
+
+    /// \brief Returns true with a very small probability.
+    bool fuzz() override;
+
+    /// \brief Stores the position of the source.
+    bool getPosition(DicePosition &position) const override;
+
+    /// \brief Moves the source to the given position.
+    bool setPosition(DicePosition const &position) override;
+
+private:
+    /// \brief Returns a roll of a die with the given number of faces, from 0.
+    uint32_t roll(uint32_t faces);
+
+    /// The position.
+    DicePosition m_position;
+};
+
+/**
+ * \brief This class represents a dice source that replays a script of rolls,
+ *        extending it with the first outcome when more rolls are requested;
+ *        advance() then moves to the next script like an odometer, so that
+ *        repeatedly running a step and advancing enumerates all the possible
+ *        rolls of the step.
+ */
+class ScriptedDiceSource : public DiceSource {
+public:
+    /// \brief Main ctor.
+    ScriptedDiceSource();
+
+    /// \brief Starts replaying the script from the beginning.
+    void rewind() { m_pos = 0; }
+
+    /// \brief Returns the probability of the rolls in the script.
+    double probability() const;
+
+    /// \brief Moves to the next script; returns false if there are no more.
+    bool advance();
+
+    /// \brief Returns the next roll of the script.
+    int d6WithCrit() override;
+
+    /// \brief Returns the next roll of the script.
+    bool fuzz() override;
+
+private:
+    /// One scripted roll.
+    struct Roll {
+        bool is_d6;
+        int choice;
+    };
+
+    /// \brief Returns the next roll of the script, extending it if needed.
+    Roll const & next(bool is_d6);
+
+    /// The script.
+    std::vector<Roll> m_rolls;
+    /// The position in the script.
+    size_t m_pos;
+};
+
 /// \brief Gets the random generator mutex (for locking when using the random
 ///        generator).
 std::mutex &getRandomGenMutex();
@@ -37,6 +271,16 @@ std::mutex &getRandomGenMutex();
 /// \brief Gets the random generator; be sure to lock the mutex first!
 std::default_random_engine &getRandomGenerator();
 
+/// \brief Writes the state of the random generator, of the dice of this
+///        thread and of the seeding of the dice of the other threads, so that
+///        a single-threaded run can be stopped and continued with exactly the
+///        same rolls (see loadRandomState).
+void saveRandomState(std::ostream &out);
+
+/// \brief Restores what saveRandomState wrote; returns false if the data is
+///        malformed.
+bool loadRandomState(std::istream &in);
+
 } 
 }
 
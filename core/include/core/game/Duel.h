@@ -17,12 +17,74 @@
 
 #include "core/game/Move.h"
 #include "core/game/Character.h"
+#include "core/game/Dice.h"
+#include "core/ctrl/ExpertSystemCtrl.h"
 
 #include <memory>
+#include <vector>
 
 namespace core {
 namespace game {
 
+class ScoreSheet;
+
+/// \brief An enumeration identifying the outcome of a fight.
+enum DuelResult : int {
+    DR_ONGOING,
+    DR_C1_WINS,
+    DR_C2_WINS,
+    DR_DRAW
+};
+
+/// \brief An enumeration identifying where a fight is; a fight is advanced
+///        one phase at a time by Duel::step().
+enum DuelPhase : int {
+    DP_INITIATIVE,   ///< Nothing has happened yet, initiative is rolled next.
+    DP_TURN_START,   ///< A turn is about to begin.
+    DP_ATTACK,       ///< The attacker is about to decide the next attack.
+    DP_OVER          ///< The fight is over.
+};
+
+/**
+ * \brief The fight state of one of the characters in a Duel, i.e. everything
+ *        that changes during a fight.
+ */
+struct FighterState {
+    int cur_ap;
+    int cur_sp;
+    int cur_life;
+    int cur_combo;
+    bool air;
+    bool down;
+    size_t nth_move_of_the_round;
+    std::vector<size_t> moves_performed;
+};
+
+/// \brief Returns the fight state of a character.
+FighterState getFighterState(Character const &c);
+
+/**
+ * \brief The complete state of a Duel between two calls to Duel::step(),
+ *        excluding the control systems and the dice.
+ */
+struct DuelState {
+    FighterState c1;
+    FighterState c2;
+    bool far;
+    int turn_counter;
+    bool c1_attacks;
+    DuelPhase phase;
+};
+
+/**
+ * \brief A snapshot of everything that changes during a Duel, including the
+ *        position in the stream of dice rolls when the dice source can tell.
+ */
+struct DuelSnapshot {
+    DuelState state;
+    DicePosition dice;
+    bool has_dice;
+};
 
 /**
  * \brief This class is used to manage a fight between two characters. It
@@ -39,25 +101,116 @@ public:
     /// \brief Main ctor. Takes two characters and creates clones for combat,
     ///        but keeps pointers to the originals to update results; also it
     ///        is possible to pass a stream to report progress to, if the stream
-    ///        is null no progress is reported.
+    ///        is null no progress is reported. The dice source is not owned;
+    ///        if null, the dice of the calling thread (see
+    ///        getGlobalDiceSource()) are used.
     Duel(std::shared_ptr<Character> c1, std::shared_ptr<Character> c2,
-         std::ostream *report_stream);
+         std::ostream *report_stream, DiceSource *dice = nullptr);
 
-    /// \brief Performs the fight.
+    /// \brief Performs the fight and concludes it.
     void fight();
 
+    /// \brief Advances the fight by one phase: rolls initiative, starts a
+    ///        turn, or performs one attack (ending the turn if needed).
+    ///        Returns false once the fight is over.
+    bool step();
+
+    /// \brief Returns the outcome of the fight so far.
+    DuelResult result() const;
+
+    /// \brief Returns the phase the fight is in.
+    DuelPhase phase() const { return m_phase; }
+
+    /// \brief Assigns points to the original characters, or records the
+    ///        outcome in the score sheet if there is one, and informs their
+    ///        control systems of the outcome; call once the fight is over.
+    void conclude();
+
+    /// \brief Makes the control systems of the characters forget the fight
+    ///        without learning from it or assigning points; call instead of
+    ///        conclude() when the fight only measures something.
+    void abandon();
+
+    /// \brief Records the outcome of the fight in 'sheet' (not owned) instead
+    ///        of adding points to the characters; the sheet is not protected,
+    ///        so each thread should have one of its own.
+    void setScoreSheet(ScoreSheet *sheet) { m_score_sheet = sheet; }
+
+    /// \brief Chooses whether built-in expert systems are called through the
+    ///        static fast path (the default) or through their virtual
+    ///        interface; the fast path is still only taken when all control
+    ///        systems are built-in. The fight is the same either way, this
+    ///        exists to measure the difference.
+    void setStaticDispatch(bool enabled);
+
+    /// \brief Returns the current state of the fight.
+    DuelState getState() const;
+
+    /// \brief Overwrites the current state of the fight.
+    void setState(DuelState const &state);
+
+    /// \brief Returns a snapshot of the fight.
+    DuelSnapshot snapshot() const;
+
+    /// \brief Brings the fight back to a snapshot; the dice are moved back
+    ///        too if the snapshot has their position.
+    void restore(DuelSnapshot const &snapshot);
+
+    /// \brief Creates a new Duel between the same characters, in the same
+    ///        state as this one but rolling from the given dice, or from the
+    ///        same dice if null. Forks do not report and are meant to explore
+    ///        what could happen: they should not be concluded. To explore
+    ///        many times from the same point, fork once and then restore() the
+    ///        fork, which is much cheaper than forking again.
+    std::unique_ptr<Duel> fork(DiceSource *dice = nullptr) const;
+
+    /// \brief Exchanges the current state of the fight with the given one;
+    ///        unlike getState() and setState() this does not copy the lists
+    ///        of moves performed.
+    void swapState(DuelState &state);
+
     /// \brief Returns the flag storing whether the contenders are currently at
     ///        a distance.
     bool & far() { return m_far; }
 
 private:
-    /// \brief Runs a single turn with attacker and defender.
-    void turn(Character &attacker, Character &defender);
+    /// \brief Performs a step with the given control dispatchers. The
+    ///        dispatch types decide how the control systems are called: either
+    ///        through their virtual interface or, when all of them are
+    ///        built-in expert systems, through the static fast path.
+    template<typename AttackDispatch, typename DefenceDispatch>
+    bool stepWith(AttackDispatch &c1_actrl, DefenceDispatch &c1_dctrl,
+                  AttackDispatch &c2_actrl, DefenceDispatch &c2_dctrl);
+
+    /// \brief Runs the whole fight with the given dispatch types.
+    template<typename AttackDispatch, typename DefenceDispatch>
+    void mainLoop();
+
+    /// \brief Starts a turn for the attacker: restores AP, handles falls and
+    ///        SP gain. Returns false if the attacker succumbed.
+    template<typename AttackDispatch>
+    bool beginTurn(Character &attacker, Character &defender,
+                   AttackDispatch &actrl);
+
+    /// \brief Lets the attacker decide and perform one attack. Returns false
+    ///        if the attacker passes or has been interrupted.
+    template<typename AttackDispatch, typename DefenceDispatch>
+    bool attackStep(Character &attacker, Character &defender,
+                    AttackDispatch &actrl, DefenceDispatch &dctrl);
+
+    /// \brief Ends the turn of the attacker, handling combo points.
+    void endTurn(Character &attacker);
+
+    /// \brief Passes the initiative to the other character and checks
+    ///        whether the fight is over.
+    void finishTurn();
 
     /// \brief Performs an attack (with a possible counter). Returns true if the 
     ///        attack was successful, false if unsuccessful; "interrupted" is
     ///        also set if the attack was interrupted/countered.
+    template<typename AttackDispatch, typename DefenceDispatch>
     bool performAttack(Character &attacker, Character &defender,
+                       AttackDispatch &actrl, DefenceDispatch &dctrl,
                        Move const &attack_move,
                        int modified_ap_cost, 
                        bool &interrupted);
@@ -68,6 +221,10 @@ private:
     std::shared_ptr<Character> m_c2;
     /// The report stream.
     std::ostream *m_report_stream;
+    /// The dice source.
+    DiceSource *m_dice;
+    /// The score sheet, if any.
+    ScoreSheet *m_score_sheet;
     /// Clone of the first character; we own this.
     std::unique_ptr<Character> m_c1_clone;
     /// Clone of the second character; we own this.
@@ -76,6 +233,15 @@ private:
     bool m_far;
     /// Turn counter
     int m_turn_counter;
+    /// Is the first character the attacker in the current turn?
+    bool m_c1_attacks;
+    /// Where the fight is.
+    DuelPhase m_phase;
+    /// Are all control systems built-in, so that we can use the fast path?
+    bool m_static_dispatch;
+    /// The tags of the control systems of the clones: c1 attack, c1 defence,
+    /// c2 attack and c2 defence.
+    ctrl::ExpertSystemTag m_ctrl_tags[4];
 };
 
 }
@@ -16,6 +16,7 @@
 #ifndef CORE_GAME_MOVE_H
 #define CORE_GAME_MOVE_H
 
+#include <stdint.h>
 #include <string>
 #include <map>
 #include <vector>
@@ -81,10 +82,19 @@ MoveType end(MoveType);
 /// \brief Returns a textual name for a MoveType enum item.
 std::string const & toString(MoveType);
 
+/// \brief The small integer identifying an interned move (see Move::getId).
+typedef uint32_t MoveId;
+
 /**
  * \brief Represents a Move in Musha Shugyo. A Move is a collection of Symbols
  *        and can either be a normal attack, a special move, or a super move.
  *        Once created, a Move is immutable.
+ *
+ * Moves are interned: all the equal moves share the same data in a global
+ * table and have the same id, so copying and comparing moves is as cheap as
+ * copying and comparing a pointer. Each thread remembers the moves it has
+ * created, so only the first creation of a move on a thread takes the lock
+ * of the table.
  */
 class Move {
 public:
@@ -105,22 +115,30 @@ public:
     Move& operator=(Move &&other) = default;
 
     /// \brief Equality operator.
-    bool operator==(Move const &other) const;
+    bool operator==(Move const &other) const { return m_data == other.m_data; }
 
-    /// \brief Strict ordering operator.
+    /// \brief Strict ordering operator; it compares type, name and symbols,
+    ///        so it does not depend on the order of interning.
     bool operator<(Move const &other) const;
 
+    /// \brief Returns the id of the move, the same for all the equal moves.
+    MoveId getId() const { return m_data->id; }
+
     /// \brief Returns the name of the move.
-    std::string const & getName() const { return m_name; }
+    std::string const & getName() const { return m_data->name; }
 
     /// \brief Returns the type of the move.
-    MoveType getType() const { return m_type; }
+    MoveType getType() const { return m_data->type; }
 
     /// \brief Returns the move symbols.
-    std::vector<MoveSymbol> const & getSymbols() const { return m_symbols; }
+    std::vector<MoveSymbol> const & getSymbols() const {
+        return m_data->symbols;
+    }
 
     /// \brief Returns true if the move has the specified symbol.
-    bool hasSymbol(MoveSymbol sym) const;
+    bool hasSymbol(MoveSymbol sym) const {
+        return (m_data->symbol_mask >> sym) & 1U;
+    }
 
     /// \brief Calculates the AP cost of the move; parameters specify whether
     ///        the target is distant and whether to consider a counter cost.
@@ -154,16 +172,16 @@ public:
     int comboPoints() const;
 
     /// \brief Returns true if the move is MT_WAIT.
-    bool isWait() const { return m_type == MT_WAIT; }
+    bool isWait() const { return m_data->type == MT_WAIT; }
 
     /// \brief Returns true if the move is MT_NORMAL.
-    bool isNormal() const { return m_type == MT_NORMAL; }
+    bool isNormal() const { return m_data->type == MT_NORMAL; }
 
     /// \brief Returns true if the move is MT_SPECIAL.
-    bool isSpecial() const { return m_type == MT_SPECIAL; }
+    bool isSpecial() const { return m_data->type == MT_SPECIAL; }
 
     /// \brief Returns true if the move is MT_SUPER.
-    bool isSuper() const { return m_type == MT_SUPER; }
+    bool isSuper() const { return m_data->type == MT_SUPER; }
 
     /// \brief Returns true if the move has the MS_REFLECT symbol.
     bool hasReflect() const { return hasSymbol(MS_REFLECT); }
@@ -191,12 +209,33 @@ public:
     /// \brief Returns true if the move has the MS_ULTRA_HARDNESS symbol.
     bool hasUltraHardness() const { return hasSymbol(MS_ULTRA_HARDNESS); }
 
+    /// \brief The interned data of a move.
+    struct Data {
+        MoveId id;
+        std::string name;
+        MoveType type;
+        std::vector<MoveSymbol> symbols;
+        /// Bit s is set if the move has symbol s.
+        uint32_t symbol_mask;
+    };
+
 private:
-    std::string m_name;
-    MoveType m_type;
-    std::vector<MoveSymbol> m_symbols;
+    /// \brief Private ctor for the interned table.
+    explicit Move(Data const *data) : m_data(data) {}
+
+    friend Move const & getMove(MoveId id);
+
+    /// The interned data, owned by the table and never freed.
+    Data const *m_data;
 };
 
+/// \brief Returns the interned move with the given id, which must be below
+///        getNumMoves().
+Move const & getMove(MoveId id);
+
+/// \brief Returns the number of distinct moves interned so far.
+size_t getNumMoves();
+
 /// \brief Gets the single standard "Wait" move.
 Move const & getWaitMove();
 
@@ -207,6 +246,13 @@ Move const & getWaitMove();
  */
 std::vector<Move> const & getStandardMoves();
 
+/**
+ * \brief Returns how similar two moves are, between 0 and 1: 0 if they are of
+ *        different types, otherwise the number of symbols they share over the
+ *        number of symbols either has (1 if neither has any).
+ */
+double moveSimilarity(Move const &a, Move const &b);
+
 }
 }
 
@@ -0,0 +1,93 @@
+// Copyright 2015 Dario Domizioli
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CORE_GAME_SCORE_SHEET_H
+#define CORE_GAME_SCORE_SHEET_H
+
+#include "core/game/Character.h"
+#include "core/game/Duel.h"
+
+#include <map>
+#include <utility>
+
+namespace core {
+namespace game {
+
+/// \brief The outcomes of the fights of a character against another.
+struct Tally {
+    size_t wins;
+    size_t draws;
+    size_t losses;
+
+    /// \brief Returns the number of fights.
+    size_t fights() const { return wins + draws + losses; }
+
+    /// \brief Returns the points: 3 per win and 1 per draw, as in Duel.
+    int points() const { return static_cast<int>(3 * wins + draws); }
+
+    /// \brief Adds the outcomes of another tally.
+    Tally & operator+=(Tally const &other);
+};
+
+/**
+ * \brief This class collects the outcomes of fights per ordered pair of
+ *        characters, without any locking: each thread fills a sheet of its
+ *        own (see Duel::setScoreSheet) and the sheets are merged when the
+ *        results are needed.
+ */
+class ScoreSheet {
+public:
+    /// \brief The tallies, by the uids of the first and second characters.
+    typedef std::map<std::pair<size_t, size_t>, Tally> Tallies;
+
+    /// \brief Records the outcome of a fight between 'c1' and 'c2', the first
+    ///        and second characters of the Duel.
+    void record(Character const &c1, Character const &c2, DuelResult result);
+
+    /// \brief Adds outcomes of 'c1' against 'c2', the first and second
+    ///        characters of the Duel.
+    void add(Character const &c1, Character const &c2, Tally const &tally);
+
+    /// \brief Adds all the outcomes of another sheet.
+    void merge(ScoreSheet const &other);
+
+    /// \brief Forgets all the outcomes.
+    void clear() { m_tallies.clear(); }
+
+    /// \brief Returns the outcomes of 'c1' against 'c2' when 'c1' was the
+    ///        first character of the Duel.
+    Tally getTally(Character const &c1, Character const &c2) const;
+
+    /// \brief Returns the outcomes of 'a' against 'b' in either order.
+    Tally getResults(Character const &a, Character const &b) const;
+
+    /// \brief Returns the outcomes of all the fights of a character.
+    Tally getTotal(Character const &c) const;
+
+    /// \brief Returns the points of a character, as Duel would have added
+    ///        them to Character::total_points.
+    int getPoints(Character const &c) const { return getTotal(c).points(); }
+
+    /// \brief Returns all the tallies, from the first characters.
+    Tallies const & getTallies() const { return m_tallies; }
+
+private:
+    /// The outcomes for the first character.
+    Tallies m_tallies;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,160 @@
+// Copyright 2015 Dario Domizioli
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CORE_SIM_CHECKPOINT_H
+#define CORE_SIM_CHECKPOINT_H
+
+#include "core/game/Character.h"
+#include "core/game/ScoreSheet.h"
+#include "core/sim/Rating.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace core {
+namespace sim {
+
+/**
+ * \brief A snapshot of a run of rounds of fights: the number of rounds run,
+ *        the points and outcomes so far, what the control systems have learnt
+ *        and the state of the random generators. Taking it only copies the
+ *        state in memory, between two rounds; writing it to disk can then be
+ *        left to a CheckpointWriter.
+ */
+class Checkpoint {
+public:
+    Checkpoint();
+
+    /// \brief Takes a snapshot of the characters, of the outcomes of their
+    ///        fights, of the ratings if not null and of the random generators
+    ///        of this thread (see game::saveRandomState), after 'round' rounds.
+    void take(std::vector<std::shared_ptr<game::Character>> const &characters,
+              game::ScoreSheet const &scores, RatingEngine const *ratings,
+              uint64_t round);
+
+    /// \brief Restores the snapshot into the characters of a new run, which
+    ///        must be the same as when it was taken, and into an empty score
+    ///        sheet; returns false and describes the problem in 'error' if they
+    ///        differ or the snapshot is malformed.
+    bool restore(std::vector<std::shared_ptr<game::Character>> const &characters,
+                 game::ScoreSheet &scores, RatingEngine *ratings,
+                 std::string &error) const;
+
+    /// \brief Returns the number of rounds run when the snapshot was taken.
+    uint64_t round() const { return m_round; }
+
+    /// \brief Writes the snapshot to a file, which is only replaced once the
+    ///        new one is complete; returns false and describes the problem in
+    ///        'error' if it cannot be written.
+    bool write(std::string const &path, std::string &error) const;
+
+    /// \brief Reads a snapshot written by write(); returns false and
+    ///        describes the problem in 'error' if it cannot be read.
+    bool read(std::string const &path, std::string &error);
+
+private:
+    /// The snapshot of a character.
+    struct CharacterState {
+        std::string name;
+        uint64_t hash;
+        int total_points;
+        std::string attack;
+        std::string defence;
+    };
+
+    /// The outcomes of the fights of two characters, by index.
+    struct TallyState {
+        uint32_t first;
+        uint32_t second;
+        game::Tally tally;
+    };
+
+    /// The number of rounds run.
+    uint64_t m_round;
+    /// The characters.
+    std::vector<CharacterState> m_characters;
+    /// The outcomes.
+    std::vector<TallyState> m_tallies;
+    /// The random generators, as written by game::saveRandomState.
+    std::string m_random;
+    /// The ratings, as written by RatingEngine::save, if any.
+    std::string m_ratings;
+};
+
+/**
+ * \brief This class writes checkpoints on a thread of its own, so that a run
+ *        only pays for taking them. A checkpoint submitted while another one
+ *        is being written waits, replacing any older one still waiting.
+ */
+class CheckpointWriter {
+public:
+    /// \brief Main ctor; checkpoints are due every 'interval' seconds.
+    CheckpointWriter(std::string const &path, double interval);
+
+    /// \brief Writes the checkpoint still waiting, if any, and stops.
+    ~CheckpointWriter();
+
+    /// A CheckpointWriter cannot be copied.
+    CheckpointWriter(CheckpointWriter const &other) = delete;
+    CheckpointWriter& operator=(CheckpointWriter const &other) = delete;
+
+    /// \brief Returns true if 'interval' seconds have passed since the last
+    ///        checkpoint was submitted, or since construction.
+    bool isDue() const;
+
+    /// \brief Hands a checkpoint over to be written.
+    void submit(std::unique_ptr<Checkpoint> checkpoint);
+
+    /// \brief Waits until the checkpoints submitted are written; returns false
+    ///        and describes the problem in 'error' if one of them was not.
+    bool flush(std::string &error);
+
+    /// \brief Returns the number of checkpoints written.
+    size_t written() const;
+
+private:
+    /// \brief The body of the writing thread.
+    void work();
+
+    /// The file.
+    std::string m_path;
+    /// The time between checkpoints, and when the last one was submitted.
+    std::chrono::duration<double> m_interval;
+    std::chrono::steady_clock::time_point m_last;
+    /// The checkpoint waiting to be written, if any.
+    std::unique_ptr<Checkpoint> m_pending;
+    /// Whether a checkpoint is being written, and whether to stop.
+    bool m_busy;
+    bool m_stop;
+    /// The number of checkpoints written.
+    size_t m_written;
+    /// The problem with the last checkpoint not written, if any.
+    std::string m_error;
+    /// Protects all the above, and signals changes.
+    mutable std::mutex m_mutex;
+    std::condition_variable m_changed;
+    /// The writing thread.
+    std::thread m_thread;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,70 @@
+// Copyright 2015 Dario Domizioli
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CORE_SIM_COMPARISON_H
+#define CORE_SIM_COMPARISON_H
+
+#include "core/game/Character.h"
+
+#include <memory>
+#include <vector>
+
+namespace core {
+namespace sim {
+
+/// \brief An enumeration identifying how the dice of the two sides of a
+///        comparison relate to each other.
+enum DiceSharing : int {
+    DS_INDEPENDENT,  ///< Each fight uses its own dice.
+    DS_COMMON,       ///< Paired fights use the same dice.
+    DS_ANTITHETIC    ///< As DS_COMMON, and every sample is also fought with
+                     ///< mirrored dice.
+};
+
+/**
+ * \brief The outcome of the comparison of two characters against the same
+ *        opponents.
+ */
+struct Comparison {
+    /// \brief Average score of the first character minus the average score
+    ///        of the second one, with draws counting as half a win.
+    double difference;
+    /// \brief Standard error of the difference.
+    double std_error;
+    /// \brief How many times fewer fights this comparison needed than one
+    ///        using independent dice for the same standard error.
+    double variance_reduction;
+    /// \brief Number of fights simulated.
+    size_t fights;
+};
+
+/// \brief Compares characters "a" and "b" by fighting each of the opponents
+///        "samples" times, both as first and as second character. With
+///        DS_COMMON or DS_ANTITHETIC the fights of "a" and "b" against the same
+///        opponent on the same side use identical dice sequences derived from
+///        "seed", so that the luck of the dice mostly cancels out in the
+///        difference. The characters' points are not updated and their
+///        control systems forget the fights without learning from them;
+///        control systems which use the global random generator (like
+///        evolving AIs) reduce the benefit.
+Comparison compare(std::shared_ptr<game::Character> a,
+                   std::shared_ptr<game::Character> b,
+                   std::vector<std::shared_ptr<game::Character>> const &opponents,
+                   size_t samples, unsigned long seed,
+                   DiceSharing sharing);
+
+}
+}
+
+#endif
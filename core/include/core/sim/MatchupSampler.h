@@ -0,0 +1,146 @@
+// Copyright 2015 Dario Domizioli
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CORE_SIM_MATCHUPSAMPLER_H
+#define CORE_SIM_MATCHUPSAMPLER_H
+
+#include "core/game/Character.h"
+#include "core/sim/Statistics.h"
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace core {
+namespace sim {
+
+class ThreadPool;
+
+/**
+ * \brief The parameters of a MatchupSampler.
+ */
+struct SamplerOptions {
+    /// \brief Fights to run for every pair before looking at the results.
+    size_t min_fights;
+    /// \brief Fights to add to each unsettled pair in every following round.
+    size_t batch;
+    /// \brief Maximum number of fights for a single pair.
+    size_t max_fights;
+    /// \brief Maximum number of fights overall.
+    size_t budget;
+    /// \brief Normal quantile for the confidence intervals.
+    double z;
+    /// \brief Interval width below which a pair is settled even if the
+    ///        interval still contains 0.5, i.e. the pair is really even.
+    double resolution;
+    /// \brief If positive, the interval width every pair must reach: pairs
+    ///        are only settled by it, whatever side of 0.5 they are on.
+    double precision;
+
+    /// \brief Returns options whose budget matches running "reps" fights per
+    ///        ordered pair of "characters" characters.
+    static SamplerOptions forBudget(size_t characters, size_t reps);
+
+    /// \brief Returns options which estimate the score of every ordered pair
+    ///        of "characters" characters within an interval (95%) no wider
+    ///        than "precision".
+    static SamplerOptions forPrecision(size_t characters, double precision);
+};
+
+/**
+ * \brief This class estimates the outcome of every ordered pair of a set of
+ *        characters with as few fights as it can.
+ *
+ * Fights are run in rounds. After a first round of SamplerOptions::min_fights
+ * per pair, a pair is settled once the Wilson interval of the score of the
+ * first character excludes 0.5 (one of the two is clearly stronger) or is
+ * narrower than SamplerOptions::resolution (the pair is even). Each following
+ * round gives a batch of fights to the unsettled pairs, widest intervals
+ * first, until all pairs are settled or the budget is spent. With a
+ * SamplerOptions::precision, pairs are settled only once their interval is
+ * that narrow, so that the whole matrix reaches the same precision.
+ *
+ * The fights are concluded as usual, so the characters' points and control
+ * systems are updated; however the points are not comparable between
+ * characters since pairs get different numbers of fights. Use
+ * expectedPoints() instead.
+ */
+class MatchupSampler {
+public:
+    /// \brief Main ctor.
+    MatchupSampler(std::vector<std::shared_ptr<game::Character>> const &characters,
+                   SamplerOptions const &options);
+
+    /// \brief Runs the fights on the given number of threads. If a report
+    ///        stream is given, the fights are chronicled on it; if a progress
+    ///        stream is given, a line is printed after each round.
+    void run(unsigned threads, std::ostream *report_stream,
+             std::ostream *progress_stream);
+
+    /// \brief Returns the tally of the fights between characters i and j.
+    PairTally const & tally(size_t i, size_t j) const {
+        return m_tallies[i * m_characters.size() + j];
+    }
+
+    /// \brief Returns true if the outcome between characters i and j is
+    ///        settled.
+    bool isSettled(size_t i, size_t j) const;
+
+    /// \brief Returns the number of pairs which are not settled.
+    size_t unsettledPairs() const;
+
+    /// \brief Returns the widest score interval of all the pairs.
+    double widestInterval() const;
+
+    /// \brief Returns the number of fights run so far.
+    size_t fights() const { return m_fights; }
+
+    /// \brief Returns the points character i is expected to collect in a
+    ///        round robin where it fights every other character twice, once
+    ///        as first and once as second.
+    double expectedPoints(size_t i) const;
+
+    /// \brief Writes the matrix of the outcomes as CSV, one ordered pair per
+    ///        line: the names, the number of fights, the probabilities of
+    ///        a win, a draw and a loss of the first character, its score and
+    ///        the interval of the score.
+    void writeMatrix(std::ostream &out) const;
+
+    /// \brief Writes the matrix of the outcomes in binary form: a header,
+    ///        the wins, draws and losses of every ordered pair row by row,
+    ///        and the names. Returns false if the file cannot be written.
+    bool writeBinaryMatrix(std::string const &path, std::string &error) const;
+
+private:
+    /// \brief Runs the given fights, as indices of pairs and numbers of
+    ///        fights on the workers of the pool; the fights of a pair are
+    ///        run as a game::BatchDuel.
+    void runFights(std::vector<std::pair<size_t, size_t>> const &pairs,
+                   ThreadPool &pool, std::ostream *report_stream);
+
+    /// The characters.
+    std::vector<std::shared_ptr<game::Character>> m_characters;
+    /// The options.
+    SamplerOptions m_options;
+    /// The tallies, by i * number of characters + j.
+    std::vector<PairTally> m_tallies;
+    /// The number of fights run so far.
+    size_t m_fights;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,137 @@
+// Copyright 2015 Dario Domizioli
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CORE_SIM_RATING_H
+#define CORE_SIM_RATING_H
+
+#include "core/game/Character.h"
+#include "core/game/ScoreSheet.h"
+
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace core {
+namespace sim {
+
+/// \brief An enumeration identifying the rating systems.
+enum RatingSystem : int {
+    RS_ELO,       ///< Elo: a rating only; the deviation never changes.
+    RS_GLICKO2    ///< Glicko-2: a rating, its deviation and its volatility.
+};
+
+/**
+ * \brief The rating of a character, on the usual scale where new characters
+ *        start at 1500.
+ */
+struct Rating {
+    /// \brief The rating.
+    double rating;
+    /// \brief The deviation: the true rating is within two deviations of
+    ///        the rating with 95% confidence.
+    double deviation;
+    /// \brief How erratic the results are (Glicko-2 only).
+    double volatility;
+    /// \brief The number of fights rated.
+    size_t fights;
+
+    /// \brief Returns the rating of a new character.
+    static Rating initial();
+};
+
+/**
+ * \brief The parameters of a RatingEngine.
+ */
+struct RatingOptions {
+    /// \brief The rating system.
+    RatingSystem system;
+    /// \brief The Elo K factor: the most a single fight can change a rating.
+    double elo_k;
+    /// \brief The Glicko-2 constraint on the change of the volatility.
+    double tau;
+
+    /// \brief Returns the default options of a system.
+    static RatingOptions forSystem(RatingSystem system);
+};
+
+/**
+ * \brief This class maintains the ratings of characters from the outcomes of
+ *        their fights.
+ *
+ * Threads do not report each fight: they fill a game::ScoreSheet of their own
+ * without locking (see game::Duel::setScoreSheet) and hand it over with
+ * update(), which rates all of its fights as one rating period. Ratings are
+ * kept by name, so that they can be saved and loaded back by a later run,
+ * which only needs to fight the new characters against some of the old ones.
+ * Each rating also records the hash of the character it belongs to (see
+ * characterHash), so that a different character under an old name, e.g. a
+ * new random "Char1", does not inherit the rating of the old one.
+ */
+class RatingEngine {
+public:
+    /// \brief Main ctor.
+    explicit RatingEngine(RatingOptions const &options);
+
+    /// \brief Adds a character; it keeps its rating if its name has one for
+    ///        the same character hash, e.g. from load(), otherwise it starts
+    ///        from Rating::initial().
+    void addCharacter(game::Character const &c);
+
+    /// \brief Rates the fights of a score sheet as one rating period; fights
+    ///        of characters which were not added are ignored. Characters
+    ///        which did not fight grow more uncertain.
+    void update(game::ScoreSheet const &sheet);
+
+    /// \brief Returns the rating of a name, or Rating::initial() if it has
+    ///        none.
+    Rating getRating(std::string const &name) const;
+
+    /// \brief Returns the names and ratings, highest rating first.
+    std::vector<std::pair<std::string, Rating>> getRanking() const;
+
+    /// \brief Returns the probability that a character with rating 'a'
+    ///        beats one with rating 'b', counting draws as half.
+    double expectedScore(Rating const &a, Rating const &b) const;
+
+    /// \brief Reads ratings saved by save(), replacing those of the same
+    ///        names, except for characters already added with a different
+    ///        hash; returns false and describes the problem in 'error' if
+    ///        the text is malformed.
+    bool load(std::istream &in, std::string &error);
+
+    /// \brief Writes the ratings, one per line: name, character hash,
+    ///        rating, deviation, volatility and fights, separated by tabs.
+    void save(std::ostream &out) const;
+
+private:
+    /// The options.
+    RatingOptions m_options;
+    /// The ratings, by name.
+    std::map<std::string, Rating> m_ratings;
+    /// The hashes of the characters the ratings belong to, by name.
+    std::map<std::string, uint64_t> m_hashes;
+    /// The names of the characters added, by uid.
+    std::map<size_t, std::string> m_names;
+    /// Protects the ratings.
+    mutable std::mutex m_mutex;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,102 @@
+// Copyright 2015 Dario Domizioli
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CORE_SIM_RESULT_CACHE_H
+#define CORE_SIM_RESULT_CACHE_H
+
+#include "core/game/Character.h"
+#include "core/sim/Statistics.h"
+
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace core {
+namespace sim {
+
+/// \brief Returns a hash of everything that decides how a character fights:
+///        its values, its moves and its control systems. Equal characters
+///        have equal hashes, whatever their names and uids.
+uint64_t characterHash(game::Character const &c);
+
+/// \brief Returns true if the outcomes of a character's fights only depend on
+///        the dice, i.e. its control systems are built-in and stateless, so
+///        that they can be cached.
+bool isCacheable(game::Character const &c);
+
+/**
+ * \brief This class stores the outcomes of fights between characters on
+ *        disk, by the hashes of the characters (see characterHash), so that
+ *        later runs can reuse them.
+ *
+ * The file is append-only: each add() appends a fixed-size record, and
+ * open() sums the records of each ordered pair into an index in memory. A
+ * record cut short by a crash is cut off the file by open(), so that the
+ * records added later stay aligned.
+ */
+class ResultCache {
+public:
+    ResultCache();
+
+    /// A ResultCache cannot be copied.
+    ResultCache(ResultCache const &other) = delete;
+    ResultCache& operator=(ResultCache const &other) = delete;
+
+    /// \brief Opens a cache file, creating it if needed; returns false and
+    ///        describes the problem in 'error' if it cannot be opened or is
+    ///        not a cache file.
+    bool open(std::string const &path, std::string &error);
+
+    /// \brief Returns the outcomes recorded for the first character against
+    ///        the second, the first being the first character of the fights.
+    PairTally lookup(uint64_t first, uint64_t second) const;
+
+    /// \brief Records more outcomes; returns false and describes the problem
+    ///        in 'error' if they cannot be written.
+    bool add(uint64_t first, uint64_t second, PairTally const &tally,
+             std::string &error);
+
+    /// \brief Returns the number of ordered pairs with outcomes.
+    size_t size() const;
+
+private:
+    /// The outcomes, by the hashes of the first and second characters.
+    std::map<std::pair<uint64_t, uint64_t>, PairTally> m_index;
+    /// The file, open for appending.
+    std::ofstream m_out;
+    /// Protects the index and the file.
+    mutable std::mutex m_mutex;
+};
+
+/// \brief Collects at least 'fights' outcomes for every ordered pair of
+///        distinct characters, taking them from the cache when both
+///        characters are cacheable and fighting (on 'threads' threads) only
+///        for the missing ones, which are added to the cache. 'tallies'
+///        receives the outcomes by i * number of characters + j and 'fought'
+///        the number of fights run. Returns false and describes the problem
+///        in 'error' if the new outcomes cannot all be added to the cache.
+bool collectMatrix(
+    std::vector<std::shared_ptr<game::Character>> const &characters,
+    size_t fights, ResultCache &cache, unsigned threads,
+    std::vector<PairTally> &tallies, size_t &fought, std::string &error);
+
+}
+}
+
+#endif
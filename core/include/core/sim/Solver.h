@@ -0,0 +1,110 @@
+// Copyright 2015 Dario Domizioli
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CORE_SIM_SOLVER_H
+#define CORE_SIM_SOLVER_H
+
+#include "core/game/Character.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace core {
+namespace sim {
+
+/**
+ * \brief The probabilities of the outcomes of a fight, seen from the first
+ *        character.
+ */
+struct MatchupOdds {
+    /// \brief Probability that the first character wins.
+    double win;
+    /// \brief Probability of a draw.
+    double draw;
+    /// \brief Probability that the second character wins.
+    double loss;
+    /// \brief True if the odds were computed exactly by the solver, false if
+    ///        they were estimated by simulating fights.
+    bool exact;
+    /// \brief Number of fight states the solver explored.
+    size_t states;
+    /// \brief Number of fights simulated to estimate the odds.
+    size_t fights;
+};
+
+/**
+ * \brief This class computes the exact outcome probabilities of a fight
+ *        between two characters whose control systems are all built-in expert
+ *        systems (or dumb ones).
+ *
+ * Such control systems are deterministic, so the only randomness in a fight
+ * comes from the dice. The solver explores the graph of the fight states
+ * reachable through Duel::step(), enumerating all the possible dice rolls of
+ * each step, and then computes the probability of reaching each outcome from
+ * the initial state. Since fights can loop (e.g. both characters missing and
+ * regaining AP), the probabilities are computed iteratively until they
+ * converge to machine precision.
+ *
+ * If the number of states exceeds a limit, the solver falls back to
+ * estimating the odds by simulation. Results are memoized per pair of
+ * characters, so the same Solver can be shared by several threads.
+ */
+class Solver {
+public:
+    /// \brief Main ctor. Takes the maximum number of states to explore for a
+    ///        pair, and the number of fights to simulate when that is
+    ///        exceeded or the characters cannot be solved exactly.
+    explicit Solver(size_t max_states = 1000000,
+                    size_t fallback_fights = 2000);
+
+    /// \brief Returns true if the fight between the two characters can be
+    ///        solved exactly, i.e. all their control systems are built-in.
+    static bool canSolve(game::Character const &c1,
+                         game::Character const &c2);
+
+    /// \brief Returns the odds of the fight between the two characters.
+    MatchupOdds solve(std::shared_ptr<game::Character> c1,
+                      std::shared_ptr<game::Character> c2);
+
+private:
+    /// \brief Runs the exact solver; returns false if there were too many
+    ///        states.
+    bool solveExactly(std::shared_ptr<game::Character> c1,
+                      std::shared_ptr<game::Character> c2,
+                      MatchupOdds &odds) const;
+
+    /// Maximum number of states to explore.
+    size_t m_max_states;
+    /// Number of fights to simulate when falling back.
+    size_t m_fallback_fights;
+    /// Protects the cache.
+    std::mutex m_cache_mutex;
+    /// Memoized results, by character uids.
+    std::map<std::pair<size_t, size_t>, MatchupOdds> m_cache;
+};
+
+/// \brief Estimates the odds of the fight between the two characters by
+///        simulating the given number of fights. The characters' points are
+///        not updated, and their control systems forget the fights without
+///        learning from them.
+MatchupOdds simulate(std::shared_ptr<game::Character> c1,
+                     std::shared_ptr<game::Character> c2,
+                     size_t fights);
+
+}
+}
+
+#endif
@@ -0,0 +1,90 @@
+// Copyright 2015 Dario Domizioli
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CORE_SIM_STATISTICS_H
+#define CORE_SIM_STATISTICS_H
+
+#include <cstddef>
+
+namespace core {
+namespace sim {
+
+/**
+ * \brief A confidence interval for a proportion.
+ */
+struct Interval {
+    double low;
+    double high;
+
+    /// \brief Returns the width of the interval.
+    double width() const { return high - low; }
+
+    /// \brief Returns true if the value is inside the interval.
+    bool contains(double value) const { return low <= value && value <= high; }
+};
+
+/// \brief Returns the Wilson score interval for a proportion estimated from
+///        "successes" out of "trials", at the confidence given by the normal
+///        quantile "z" (e.g. 1.96 for 95%). Successes can be fractional, so
+///        that a draw can count as half a win.
+Interval wilsonInterval(double successes, size_t trials, double z);
+
+/**
+ * \brief The tally of the outcomes of the fights between an ordered pair of
+ *        characters, from the point of view of the first one.
+ */
+struct PairTally {
+    size_t wins;
+    size_t draws;
+    size_t losses;
+
+    PairTally() : wins(0), draws(0), losses(0) {}
+
+    /// \brief Returns the number of fights.
+    size_t fights() const { return wins + draws + losses; }
+
+    /// \brief Returns the score of the first character, i.e. the fraction of
+    ///        fights it won, with draws counting as half a win.
+    double score() const {
+        return fights() ? (wins + 0.5 * draws) / fights() : 0.5;
+    }
+
+    /// \brief Returns the average points per fight of the first character.
+    double points() const {
+        return fights() ? (3.0 * wins + draws) / fights() : 0.0;
+    }
+
+    /// \brief Returns the average points per fight of the second character.
+    double opponentPoints() const {
+        return fights() ? (3.0 * losses + draws) / fights() : 0.0;
+    }
+
+    /// \brief Returns the Wilson interval of the score.
+    Interval scoreInterval(double z) const {
+        return wilsonInterval(wins + 0.5 * draws, fights(), z);
+    }
+
+    /// \brief Adds another tally to this one.
+    PairTally & operator+=(PairTally const &other) {
+        wins += other.wins;
+        draws += other.draws;
+        losses += other.losses;
+        return *this;
+    }
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,80 @@
+// Copyright 2015 Dario Domizioli
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CORE_SIM_THREADPOOL_H
+#define CORE_SIM_THREADPOOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace core {
+namespace sim {
+
+/**
+ * \brief This class represents a fixed set of worker threads which run the
+ *        same task together, e.g. to share a budget of simulations.
+ *
+ * The calling thread takes part as worker 0, so a pool of size 1 has no
+ * extra thread and runs the task inline. Calls to run() from different
+ * threads are serialized.
+ */
+class ThreadPool {
+public:
+    /// \brief Main ctor. Takes the total number of workers; if zero, uses
+    ///        the number of hardware threads.
+    explicit ThreadPool(unsigned workers = 0);
+
+    /// \brief Dtor; stops the threads.
+    ~ThreadPool();
+
+    /// \brief Returns the number of workers, including the calling thread.
+    unsigned size() const { return m_size; }
+
+    /// \brief Runs task(worker) on every worker, with worker going from 0 to
+    ///        size() - 1, and waits for all of them to finish.
+    void run(std::function<void(unsigned)> const &task);
+
+private:
+    /// \brief The loop of a worker thread.
+    void workerLoop(unsigned worker);
+
+    /// The number of workers.
+    unsigned m_size;
+    /// The worker threads.
+    std::vector<std::thread> m_threads;
+    /// Serializes the calls to run().
+    std::mutex m_run_mutex;
+    /// Protects the fields below.
+    std::mutex m_mutex;
+    /// Signals a new task or the end.
+    std::condition_variable m_start;
+    /// Signals that a worker is done.
+    std::condition_variable m_done;
+    /// The current task.
+    std::function<void(unsigned)> const *m_task;
+    /// Incremented at every task, so that workers can tell it is new.
+    unsigned long m_generation;
+    /// The number of threads still running the current task.
+    unsigned m_running;
+    /// Set to stop the threads.
+    bool m_stop;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,120 @@
+// Copyright 2015 Dario Domizioli
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CORE_SIM_TOURNAMENT_H
+#define CORE_SIM_TOURNAMENT_H
+
+#include "core/game/Character.h"
+#include "core/sim/Statistics.h"
+
+#include <iostream>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace core {
+namespace sim {
+
+/// \brief An enumeration identifying the tournament formats.
+enum TournamentFormat : int {
+    TF_SWISS,                ///< Rounds pairing characters with equal scores.
+    TF_SINGLE_ELIMINATION,   ///< Knockout: one lost match eliminates.
+    TF_DOUBLE_ELIMINATION,   ///< Knockout: two lost matches eliminate.
+    TF_GROUPS                ///< Round robin groups, then a knockout.
+};
+
+/**
+ * \brief The parameters of a Tournament.
+ */
+struct TournamentOptions {
+    /// \brief The format.
+    TournamentFormat format;
+    /// \brief Fights per match, half with each character as the first one.
+    size_t fights_per_match;
+    /// \brief Rounds of a Swiss tournament; zero means ceil(log2(N)) + 1.
+    size_t rounds;
+    /// \brief Characters per group in TF_GROUPS.
+    size_t group_size;
+    /// \brief Characters of each group going to the knockout in TF_GROUPS.
+    size_t qualifiers;
+
+    /// \brief Returns the default options of a format.
+    static TournamentOptions forFormat(TournamentFormat format);
+};
+
+/**
+ * \brief This class ranks a set of characters with a tournament, which needs
+ *        O(N log N) matches (O(N) for the knockouts) instead of the O(N^2) of
+ *        a round robin.
+ *
+ * The characters are seeded in the order they are given, the first being the
+ * strongest: seeds decide the knockout brackets, the first Swiss pairings and
+ * the groups, and break the ties of matches. The matches of each round are
+ * run in parallel, each as game::BatchDuel; the fights are concluded as usual.
+ */
+class Tournament {
+public:
+    /// \brief Main ctor.
+    Tournament(std::vector<std::shared_ptr<game::Character>> const &characters,
+               TournamentOptions const &options);
+
+    /// \brief Runs the tournament on the given number of threads. If a
+    ///        progress stream is given, a line is printed after each round.
+    void run(unsigned threads, std::ostream *progress_stream);
+
+    /// \brief Returns the indices of the characters, best first.
+    std::vector<size_t> const & ranking() const { return m_ranking; }
+
+    /// \brief Returns the number of matches and fights run so far.
+    size_t matches() const { return m_matches; }
+    size_t fights() const { return m_fights; }
+
+    /// \brief Returns the points character i collected in its fights.
+    double points(size_t i) const { return m_points[i]; }
+
+private:
+    /// A match, as the indices of the two characters.
+    typedef std::pair<size_t, size_t> Match;
+
+    /// \brief Runs the matches of a round in parallel and returns the tally
+    ///        of the first character of each against the second.
+    std::vector<PairTally> playRound(std::vector<Match> const &matches,
+                                     unsigned threads,
+                                     std::ostream *progress_stream);
+
+    /// \brief The formats.
+    void runSwiss(unsigned threads, std::ostream *progress_stream);
+    std::vector<size_t> runElimination(std::vector<size_t> const &entrants,
+                                       size_t lives, unsigned threads,
+                                       std::ostream *progress_stream);
+    void runGroups(unsigned threads, std::ostream *progress_stream);
+
+    /// The characters.
+    std::vector<std::shared_ptr<game::Character>> m_characters;
+    /// The options.
+    TournamentOptions m_options;
+    /// The ranking, best first.
+    std::vector<size_t> m_ranking;
+    /// The points collected in the fights, per character.
+    std::vector<double> m_points;
+    /// The numbers of rounds, matches and fights run so far.
+    size_t m_rounds;
+    size_t m_matches;
+    size_t m_fights;
+};
+
+}
+}
+
+#endif
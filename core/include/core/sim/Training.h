@@ -0,0 +1,114 @@
+// Copyright 2015 Dario Domizioli
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CORE_SIM_TRAINING_H
+#define CORE_SIM_TRAINING_H
+
+#include "core/game/Character.h"
+
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace core {
+namespace sim {
+
+class ThreadPool;
+
+/**
+ * \brief The parameters of a Trainer.
+ */
+struct TrainingOptions {
+    /// \brief Maximum number of rounds; a round is a fight for every ordered
+    ///        pair of characters.
+    size_t max_rounds;
+    /// \brief Maximum time in seconds; checked after every round. 0 means no
+    ///        limit.
+    double seconds;
+    /// \brief The learning AIs must change their decisions by less than this
+    ///        per update (see ctrl::hasConverged).
+    double tolerance;
+    /// \brief Number of rounds the win rates are averaged on.
+    size_t window;
+    /// \brief The win rate of every character over the last window must differ
+    ///        by less than this from the one over the window before, not
+    ///        counting two standard errors of noise.
+    double drift;
+
+    /// \brief Returns the options of an AI proficiency level, from 0 (a bit
+    ///        dumb) to 3 (highly trained).
+    static TrainingOptions forLevel(int level);
+};
+
+/**
+ * \brief This class trains the learning AIs of a set of characters by making
+ *        them fight each other, until they are stable.
+ *
+ * Fights are run in rounds, where every character fights every other once as
+ * first and once as second. Training stops when, for every character, the
+ * learning AIs have converged and the win rate has stopped moving between
+ * two consecutive windows of rounds; or when the rounds or the time run out.
+ */
+class Trainer {
+public:
+    /// \brief Main ctor.
+    Trainer(std::vector<std::shared_ptr<game::Character>> const &characters,
+            TrainingOptions const &options);
+
+    /// \brief Runs the training on the given number of threads (0 means one
+    ///        per hardware thread). If a progress stream is given, a line is
+    ///        printed every few rounds and at the end.
+    void run(unsigned threads, std::ostream *progress_stream);
+
+    /// \brief Returns the number of rounds and fights run so far.
+    size_t rounds() const { return m_scores.size(); }
+    size_t fights() const { return m_fights; }
+
+    /// \brief Returns the time spent so far, in seconds.
+    double seconds() const { return m_seconds; }
+
+    /// \brief Returns the largest change per update of the learning AIs (see
+    ///        ctrl::EvolveAIAttack::getConvergence).
+    double worstChange() const;
+
+    /// \brief Returns the largest difference of win rate of a character
+    ///        between the last window of rounds and the one before, or 1 if
+    ///        there are not enough rounds yet.
+    double worstDrift() const;
+
+    /// \brief Returns true if both worstChange() and worstDrift() are within
+    ///        the options.
+    bool isStable() const;
+
+private:
+    /// \brief Runs a round on the pool.
+    void runRound(ThreadPool &pool);
+
+    /// The characters.
+    std::vector<std::shared_ptr<game::Character>> m_characters;
+    /// The options.
+    TrainingOptions m_options;
+    /// The score (1 for a win, 0.5 for a draw) of each character in each
+    /// round, divided by its number of fights.
+    std::vector<std::vector<double>> m_scores;
+    /// The number of fights run so far.
+    size_t m_fights;
+    /// The time spent so far.
+    double m_seconds;
+};
+
+}
+}
+
+#endif
@@ -31,4 +31,8 @@ namespace ctrl {}
 ///        expansion.
 namespace chars {}
 
+/// \brief The namespace containing functionality to analyse fights as a
+///        whole, e.g. computing the odds of a matchup.
+namespace sim {}
+
 } // namespace core
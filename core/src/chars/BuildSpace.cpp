@@ -0,0 +1,207 @@
+// Copyright 2015 Dario Domizioli
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "core/chars/BuildSpace.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace core {
+namespace chars {
+
+using namespace core::game;
+
+namespace {
+
+/// The number of RA/AT/DF combinations: RA from 1 to 5, AT from 1 to 6 - RA.
+uint64_t const NUM_STATS = 15;
+/// The number of SP modes.
+uint64_t const NUM_SP = SP_END__;
+/// The number of move symbols.
+uint64_t const NUM_MS = MS_END__;
+
+/// \brief Returns the number of multisets of 'k' elements out of 'n'.
+uint64_t multisets(uint64_t n, uint64_t k) {
+    // C(n + k - 1, k), computed so that each step is an integer.
+    uint64_t c = 1;
+    for(uint64_t i = 1; i <= k; ++i) {
+        c = c * (n + i - 1) / i;
+    }
+    return c;
+}
+
+/// \brief Returns the position of a sorted multiset of 'k' values below 'n'
+///        in lexicographic order.
+uint64_t rankMultiset(uint64_t const *values, uint64_t k, uint64_t n) {
+    uint64_t rank = 0;
+    uint64_t low = 0;
+    for(uint64_t i = 0; i < k; ++i) {
+        for(uint64_t v = low; v < values[i]; ++v) {
+            rank += multisets(n - v, k - i - 1);
+        }
+        low = values[i];
+    }
+    return rank;
+}
+
+/// \brief The inverse of rankMultiset.
+void unrankMultiset(uint64_t rank, uint64_t *values, uint64_t k, uint64_t n) {
+    uint64_t v = 0;
+    for(uint64_t i = 0; i < k; ++i) {
+        for(;;) {
+            uint64_t c = multisets(n - v, k - i - 1);
+            if(rank < c) {
+                break;
+            }
+            rank -= c;
+            ++v;
+        }
+        assert(v < n);
+        values[i] = v;
+    }
+}
+
+/// The number of two-symbol moves, and of unordered pairs of them.
+uint64_t const NUM_DOUBLES = multisets(NUM_MS, 2);
+uint64_t const NUM_DOUBLE_PAIRS = multisets(NUM_DOUBLES, 2);
+/// The number of three-symbol moves.
+uint64_t const NUM_TRIPLES = multisets(NUM_MS, 3);
+
+/// \brief Returns the rank of the sorted symbols from 'first' to 'last'.
+uint64_t rankSymbols(MoveSymbol const *first, MoveSymbol const *last) {
+    uint64_t values[3];
+    uint64_t k = 0;
+    for(MoveSymbol const *s = first; s != last; ++s) {
+        values[k++] = static_cast<uint64_t>(*s);
+    }
+    return rankMultiset(values, k, NUM_MS);
+}
+
+/// \brief The inverse of rankSymbols.
+void unrankSymbols(uint64_t rank, MoveSymbol *first, MoveSymbol *last) {
+    uint64_t values[3];
+    uint64_t k = static_cast<uint64_t>(last - first);
+    unrankMultiset(rank, values, k, NUM_MS);
+    for(uint64_t i = 0; i < k; ++i) {
+        first[i] = static_cast<MoveSymbol>(values[i]);
+    }
+}
+
+} // close anonymous namespace
+
+bool Build::operator==(Build const &other) const {
+    return ra == other.ra && at == other.at && df == other.df
+           && sp == other.sp
+           && std::equal(symbols, symbols + NUM_SYMBOLS, other.symbols);
+}
+
+uint64_t BuildSpace::size() {
+    return NUM_STATS * NUM_SP * NUM_MS * NUM_DOUBLE_PAIRS * NUM_TRIPLES;
+}
+
+void BuildSpace::canonicalize(Build &build) {
+    std::sort(build.symbols + 1, build.symbols + 3);
+    std::sort(build.symbols + 3, build.symbols + 5);
+    std::sort(build.symbols + 5, build.symbols + 8);
+    if(std::lexicographical_compare(build.symbols + 3, build.symbols + 5,
+                                    build.symbols + 1, build.symbols + 3)) {
+        std::swap_ranges(build.symbols + 1, build.symbols + 3,
+                         build.symbols + 3);
+    }
+}
+
+uint64_t BuildSpace::getId(Build const &build) {
+    Build b = build;
+    canonicalize(b);
+    assert(b.ra >= 1 && b.at >= 1 && b.df >= 1 && b.ra + b.at + b.df == 7);
+    // RA r leaves 6 - r values of AT.
+    uint64_t stats = 0;
+    for(int ra = 1; ra < b.ra; ++ra) {
+        stats += 6 - ra;
+    }
+    stats += b.at - 1;
+    uint64_t doubles[2] = { rankSymbols(b.symbols + 1, b.symbols + 3),
+                            rankSymbols(b.symbols + 3, b.symbols + 5) };
+    uint64_t id = stats;
+    id = id * NUM_SP + static_cast<uint64_t>(b.sp);
+    id = id * NUM_MS + static_cast<uint64_t>(b.symbols[0]);
+    id = id * NUM_DOUBLE_PAIRS + rankMultiset(doubles, 2, NUM_DOUBLES);
+    id = id * NUM_TRIPLES + rankSymbols(b.symbols + 5, b.symbols + 8);
+    return id;
+}
+
+Build BuildSpace::getBuild(uint64_t id) {
+    assert(id < size());
+    Build b;
+    unrankSymbols(id % NUM_TRIPLES, b.symbols + 5, b.symbols + 8);
+    id /= NUM_TRIPLES;
+    uint64_t doubles[2];
+    unrankMultiset(id % NUM_DOUBLE_PAIRS, doubles, 2, NUM_DOUBLES);
+    unrankSymbols(doubles[0], b.symbols + 1, b.symbols + 3);
+    unrankSymbols(doubles[1], b.symbols + 3, b.symbols + 5);
+    id /= NUM_DOUBLE_PAIRS;
+    b.symbols[0] = static_cast<MoveSymbol>(id % NUM_MS);
+    id /= NUM_MS;
+    b.sp = static_cast<SPMode>(id % NUM_SP);
+    id /= NUM_SP;
+    b.ra = 1;
+    while(id >= static_cast<uint64_t>(6 - b.ra)) {
+        id -= 6 - b.ra;
+        ++b.ra;
+    }
+    b.at = static_cast<int>(id) + 1;
+    b.df = 7 - b.ra - b.at;
+    return b;
+}
+
+CharacterSpec BuildSpace::getSpec(Build const &build,
+                                  std::string const &attack_ai,
+                                  std::string const &defence_ai) {
+    MoveSymbol const *s = build.symbols;
+    return CharacterSpec{
+        "Build" + std::to_string(getId(build)),
+        build.ra, build.at, build.df, build.sp, attack_ai, defence_ai,
+        { Move{"First", MT_SPECIAL, {s[0]}},
+          Move{"Second", MT_SPECIAL, {s[1], s[2]}},
+          Move{"Third", MT_SPECIAL, {s[3], s[4]}},
+          Move{"Super", MT_SUPER, {s[5], s[6], s[7]}} }
+    };
+}
+
+BuildEnumerator::BuildEnumerator(uint64_t first, uint64_t last)
+  : m_first(std::min(first, BuildSpace::size())),
+    m_last(std::min(last, BuildSpace::size())),
+    m_next(m_first) {}
+
+BuildEnumerator BuildEnumerator::shard(uint64_t index, uint64_t count) {
+    assert(index < count);
+    // The first 'extra' shards get one more build.
+    uint64_t size = BuildSpace::size();
+    uint64_t base = size / count;
+    uint64_t extra = size % count;
+    uint64_t first = index * base + std::min(index, extra);
+    return BuildEnumerator(first, first + base + (index < extra ? 1 : 0));
+}
+
+bool BuildEnumerator::next(Build &build, uint64_t &id) {
+    if(m_next >= m_last) {
+        return false;
+    }
+    id = m_next++;
+    build = BuildSpace::getBuild(id);
+    return true;
+}
+
+}
+}
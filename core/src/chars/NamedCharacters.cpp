@@ -13,414 +13,252 @@
 // limitations under the License.
 
 #include "core/chars/NamedCharacters.h"
+#include "core/chars/Roster.h"
 
-#include "core/ctrl/DumbCtrl.h"
-#include "core/ctrl/ExpertSystemCtrl.h"
-#include "core/ctrl/EvolveAICtrl.h"
+#include <cassert>
+#include <sstream>
 
 namespace core {
 namespace chars {
 
-using namespace core::game;
-using namespace core::ctrl;
-/*
-    c = std::make_shared<Character>(
-        "", 0, 0, 0, SP_COMBO, 
-        std::make_shared<EvolveAIAttack>(),
-        std::make_shared<EvolveAIDefence>());
-    c->addMove(Move{"", MT_SPECIAL, 
-                    {}});
-    c->addMove(Move{"", MT_SPECIAL, 
-                    {}});
-    c->addMove(Move{"", MT_SPECIAL, 
-                    {}});
-    c->addMove(Move{"", MT_SUPER, 
-                    {}});
-    characters.push_back(c);
-*/
+namespace {
+
+/// The built-in roster of the original Musha Shugyo.
+char const s_original_roster[] = R"(
+character Stella D'Argento
+stats 4 3 0 Combo
+ai Markov Evolve
+special Colpo Affilato: Smash
+special Proiezione Tagliente: Fall 2xCombo
+special Lama Sagittale: Bonus(air) Bonus(down)
+super Ruota della Spada: UltraAgility 2xCombo 2xCombo 2xCombo
+
+character Phanumas
+stats 3 3 1 Wounds
+ai Evolve Evolve
+special Dragon Knee: Dash Throw
+special Dragon Fang: UltraHardness UltraAgility
+special Dragon's Breath: Distance
+super Flying Dragon: Dash Smash
+
+character Jeanne Roux
+stats 2 4 1 Damage
+ai Evolve Evolve
+special Descending Rotation: Fall Bonus(air)
+special Ascending Rotation: Throw Bonus(down)
+special Lightning Throw: Fall
+super Tornado Throw: Throw Smash
+
+character Romeo Rabemanjara
+stats 3 4 0 Combo
+ai Markov Evolve
+special Gatling Attack: 2xCombo 2xCombo 2xCombo
+special Rampaging Kicks: 2xCombo
+special Pressing Punch: Dash
+super Overwhelming Combo: UltraAgility Throw 2xCombo 2xCombo
+
+character Luke Blades
+stats 3 3 1 Damage
+ai Evolve Evolve
+special Ascending Flash: Throw
+special Falling Flash: UltraAgility JumpOK
+special Lightning Kick: UltraHardness
+super Tornado Flash: Powerful UltraAgility
+
+character Ryouko Iga
+stats 5 0 2 AP
+ai Evolve Evolve
+special Cobra no Kyushu: Throw Distance
+special Nishikimebi no Toguro: Fall Distance
+special Mamushi no Kiba: UltraAgility Push
+super Yamata no Orochi no Kamikizu: UltraAgility Bonus(air)
+
+character Johnny Yamashita
+stats 3 1 3 Wounds
+ai Evolve Evolve
+special Cross Counter: Bonus(counter) Bonus(counter)
+special Hurricane Punch: Powerful UltraHardness
+special Tornado Uppercut: Throw
+super XXX Counter: UltraAgility Bonus(counter) Bonus(counter)
+
+character Namgung Hyon-Su
+stats 3 2 2 Combo
+ai Markov Evolve
+special Rising Darkness: Throw UltraAgility
+special Dark Arrows: Distance 2xCombo
+special Dark Moon: Throw Push 2xCombo
+super Hell's Flames: Throw Distance UltraAgility
+
+character Zhang Shi
+stats 2 3 2 Damage
+ai Evolve Evolve
+special Gang Zhao: UltraHardness
+special Feng Zhao: Distance
+special Xin Yue Ti: Push Bonus(air)
+super Fengbao Zhao: UltraAgility Distance Bonus(far)
+
+character Rock Stark
+stats 2 2 3 Defence
+ai Evolve Evolve
+special Radiant Reflection: Reflect Bonus(counter)
+special Radiant Kick: Throw
+special Flash Uppercut: UltraAgility Bonus(air)
+super Atomic Punch: Powerful UltraAgility Bonus(counter)
+)";
+
+/// The built-in roster of the Siege of Syde expansion.
+char const s_siege_of_syde_roster[] = R"(
+# ========================================================================
+# The Army of the Principality
+# ========================================================================
+character Duke Alexis the Sun Spear
+stats 2 1 4 Defence
+ai Evolve Evolve
+special Steel Spear: Smash
+special Resounding Parry: Reflect Push
+special Rolling Wave of Earth: Bonus(near) Throw
+super Invincible Kata of the Spear: Smash Powerful Bonus(near)
+
+character Gunther the Thundering Gryphon
+stats 3 3 1 Wounds
+ai Evolve Evolve
+special Crackling Mace: Push
+special Thunder Clap: Bonus(near) UltraHardness
+special Titan's Maul: Push Smash
+super Call Lightning: Smash Powerful Distance
+
+character Yavanna the Rampant Bear
+stats 2 4 1 Damage
+ai Evolve Evolve
+special Bear Claw: Powerful
+special Bear Hug: Smash Bonus(near)
+special Caber Throw: Smash Throw
+super Fury of the Bear: Push Powerful Smash
+
+character Julius the Sleeping Dragon
+stats 2 3 2 Wounds
+ai Evolve Evolve
+special Waking the Dragon: Throw
+special Tidal Wave: Distance Bonus(far)
+special Tears of the Dragon: Powerful Fall
+super The Storm Where The Sky Meets The Sea: Distance Powerful UltraHardness
+
+character Hartwin the White Raven
+stats 3 3 1 Damage
+ai Evolve Evolve
+special Magic Staff: Smash
+special Blades of Light: UltraAgility Powerful
+special Pressure Wave: UltraAgility Bonus(near)
+super Summoning the Raven of Light: Distance Powerful Powerful
+
+character Isolde the Chrysalis
+stats 1 1 5 Defence
+ai Evolve Evolve
+special Mantis Pounce: JumpOK
+special Falling Tree: Powerful Fall
+special Horrid Swarm: Smash UltraAgility
+super First Flight of the Chrysalis: JumpOK Dash Powerful
+
+character Ross Garnet the Master of Axes
+stats 4 2 1 Combo
+ai Brawler Evolve
+special Rising Quarter: Throw
+special Fleeting Crescent: Bonus(near) 2xCombo
+special Rolling Moon: 2xCombo 2xCombo
+super Feral Fury: Dash Smash Fall
+
+# ========================================================================
+# The Defenders of Syde
+# ========================================================================
+character Duke Thorsten the Dragonslayer
+stats 2 4 1 Damage
+ai Evolve Evolve
+special Rising Strike: Bonus(near)
+special Away from me!: Throw Push
+special Bone Crushing Slash: UltraHardness Fall
+super Dragon Decapitation: Push Smash Powerful
+
+character Bertram the Flying Fish
+stats 2 0 5 Defence
+ai Evolve Evolve
+special Ice Mirror: Reflect
+special Salmon Leap: JumpOK UltraAgility
+special Insidious Ice: Bonus(near) Fall
+super Snow Blizzard: Distance Bonus(far) Powerful
+
+character Eleanor the Hummingsword
+stats 3 3 1 Damage
+ai Evolve Evolve
+special Hummingbird Kiss: Smash
+special Parting the Silk: Powerful Bonus(near)
+special Flight of the Hummingbird: Throw UltraAgility
+super Virtuoso Sword Dance: Bonus(near) Fall UltraHardness
+
+character Lothar the Riding Avalanche
+stats 3 3 1 Wounds
+ai Evolve Evolve
+special Ride-by Attack: Push
+special Impetuous Charge: Dash Bonus(near)
+special Trampling Assault: UltraHardness Powerful
+super Riding the Avalanche: Push Powerful Bonus(near)
+
+character Kestin the Cloud of Arrows
+stats 1 1 5 Defence
+ai Evolve Evolve
+special Hunter Trap: Fall
+special Sure Strike: Distance Bonus(far)
+special Arrow Nova: Push Throw
+super Energy Arrow: Distance Powerful UltraHardness
+
+character Scarlet the Ardent Flame
+stats 3 2 2 Combo
+ai Brawler Evolve
+special Flame Pillar: Throw
+special Spinning Ring of Fire: 2xCombo Powerful
+special The Good Old Fireball: Distance Bonus(far)
+super Burning Wind of Noon: Dash Smash 2xCombo
+
+character Vune the Livid Necromancer
+stats 2 2 3 Defence
+ai Evolve Evolve
+special Horror Vacui: Fall
+special Gust of Lost Souls: UltraAgility Bonus(near)
+special Reaping Darkness: Powerful Powerful
+super Infernal Comet: Dash Smash UltraHardness
+)";
+
+std::vector<std::shared_ptr<game::Character>> makeCharacters(
+    char const *roster) {
+    std::istringstream in(roster);
+    std::vector<CharacterSpec> specs;
+    std::string error;
+    bool ok = readRoster(in, specs, error);
+    assert(ok && "Malformed built-in roster");
+    (void)ok;
+    std::vector<std::shared_ptr<game::Character>> characters;
+    for(auto const &spec : specs) {
+        characters.push_back(makeCharacter(spec));
+    }
+    return characters;
+}
 
-std::vector<std::shared_ptr<game::Character>> getOriginalCharacters() {
-    std::vector<std::shared_ptr<game::Character>> characters{};
-    std::shared_ptr<Character> c;
-
-    // Stella
-    c = std::make_shared<Character>(
-        "Stella D'Argento", 4, 3, 0, SP_COMBO, 
-        std::make_shared<MarkovAIAttack>(),
-        std::make_shared<EvolveAIDefence>());
-    c->addMove(Move{"Colpo Affilato", MT_SPECIAL, 
-                    {MS_SMASH}});
-    c->addMove(Move{"Proiezione Tagliente", MT_SPECIAL, 
-                    {MS_FALL, MS_2XCOMBO}});
-    c->addMove(Move{"Lama Sagittale", MT_SPECIAL,
-                    {MS_BONUS_AIR, MS_BONUS_DOWN}});
-    c->addMove(Move{"Ruota della Spada", MT_SUPER, 
-                    {MS_ULTRA_AGILITY, MS_2XCOMBO, MS_2XCOMBO, MS_2XCOMBO}});
-    characters.push_back(c);
-
-    // Phanumas
-    c = std::make_shared<Character>(
-        "Phanumas", 3, 3, 1, SP_WOUND, 
-        std::make_shared<EvolveAIAttack>(),
-        std::make_shared<EvolveAIDefence>());
-    c->addMove(Move{"Dragon Knee", MT_SPECIAL, 
-                    {MS_DASH, MS_THROW}});
-    c->addMove(Move{"Dragon Fang", MT_SPECIAL, 
-                    {MS_ULTRA_HARDNESS, MS_ULTRA_AGILITY}});
-    c->addMove(Move{"Dragon's Breath", MT_SPECIAL, 
-                    {MS_DISTANCE}});
-    c->addMove(Move{"Flying Dragon", MT_SUPER, 
-                    {MS_DASH, MS_SMASH}});
-    characters.push_back(c);
-
-    // Jeanne Roux
-    c = std::make_shared<Character>(
-        "Jeanne Roux", 2, 4, 1, SP_DAMAGE, 
-        std::make_shared<EvolveAIAttack>(),
-        std::make_shared<EvolveAIDefence>());
-    c->addMove(Move{"Descending Rotation", MT_SPECIAL, 
-                    {MS_FALL, MS_BONUS_AIR}});
-    c->addMove(Move{"Ascending Rotation", MT_SPECIAL, 
-                    {MS_THROW, MS_BONUS_DOWN}});
-    c->addMove(Move{"Lightning Throw", MT_SPECIAL, 
-                    {MS_FALL}});
-    c->addMove(Move{"Tornado Throw", MT_SUPER, 
-                    {MS_THROW, MS_SMASH}});
-    characters.push_back(c);
-
-    // Romeo Rabemanjara
-    c = std::make_shared<Character>(
-        "Romeo Rabemanjara", 3, 4, 0, SP_COMBO, 
-        std::make_shared<MarkovAIAttack>(),
-        std::make_shared<EvolveAIDefence>());
-    c->addMove(Move{"Gatling Attack", MT_SPECIAL, 
-                    {MS_2XCOMBO, MS_2XCOMBO, MS_2XCOMBO}});
-    c->addMove(Move{"Rampaging Kicks", MT_SPECIAL, 
-                    {MS_2XCOMBO}});
-    c->addMove(Move{"Pressing Punch", MT_SPECIAL, 
-                    {MS_DASH}});
-    c->addMove(Move{"Overwhelming Combo", MT_SUPER, 
-                    {MS_ULTRA_AGILITY, MS_THROW, MS_2XCOMBO, MS_2XCOMBO}});
-    characters.push_back(c);
-
-    // Luke Blades
-    c = std::make_shared<Character>(
-        "Luke Blades", 3, 3, 1, SP_DAMAGE, 
-        std::make_shared<EvolveAIAttack>(),
-        std::make_shared<EvolveAIDefence>());
-    c->addMove(Move{"Ascending Flash", MT_SPECIAL, 
-                    {MS_THROW}});
-    c->addMove(Move{"Falling Flash", MT_SPECIAL, 
-                    {MS_ULTRA_AGILITY, MS_JUMPOK}});
-    c->addMove(Move{"Lightning Kick", MT_SPECIAL, 
-                    {MS_ULTRA_HARDNESS}});
-    c->addMove(Move{"Tornado Flash", MT_SUPER, 
-                    {MS_POWERFUL, MS_ULTRA_AGILITY}});
-    characters.push_back(c);
-
-    // Ryouko Iga
-    c = std::make_shared<Character>(
-        "Ryouko Iga", 5, 0, 2, SP_AP, 
-        std::make_shared<EvolveAIAttack>(),
-        std::make_shared<EvolveAIDefence>());
-    c->addMove(Move{"Cobra no Kyushu", MT_SPECIAL, 
-                    {MS_THROW, MS_DISTANCE}});
-    c->addMove(Move{"Nishikimebi no Toguro", MT_SPECIAL, 
-                    {MS_FALL, MS_DISTANCE}});
-    c->addMove(Move{"Mamushi no Kiba", MT_SPECIAL, 
-                    {MS_ULTRA_AGILITY, MS_PUSH}});
-    c->addMove(Move{"Yamata no Orochi no Kamikizu", MT_SUPER, 
-                    {MS_ULTRA_AGILITY, MS_BONUS_AIR}});
-    characters.push_back(c);
-
-    // Johnny Yamashita
-    c = std::make_shared<Character>(
-        "Johnny Yamashita", 3, 1, 3, SP_WOUND, 
-        std::make_shared<EvolveAIAttack>(),
-        std::make_shared<EvolveAIDefence>());
-    c->addMove(Move{"Cross Counter", MT_SPECIAL, 
-                    {MS_BONUS_COUNTER, MS_BONUS_COUNTER}});
-    c->addMove(Move{"Hurricane Punch", MT_SPECIAL, 
-                    {MS_POWERFUL, MS_ULTRA_HARDNESS}});
-    c->addMove(Move{"Tornado Uppercut", MT_SPECIAL, 
-                    {MS_THROW}});
-    c->addMove(Move{"XXX Counter", MT_SUPER, 
-                    {MS_ULTRA_AGILITY, MS_BONUS_COUNTER, MS_BONUS_COUNTER}});
-    characters.push_back(c);
-
-    // Namgung Hyon-Su
-    c = std::make_shared<Character>(
-        "Namgung Hyon-Su", 3, 2, 2, SP_COMBO, 
-        std::make_shared<MarkovAIAttack>(),
-        std::make_shared<EvolveAIDefence>());
-    c->addMove(Move{"Rising Darkness", MT_SPECIAL, 
-                    {MS_THROW, MS_ULTRA_AGILITY}});
-    c->addMove(Move{"Dark Arrows", MT_SPECIAL, 
-                    {MS_DISTANCE, MS_2XCOMBO}});
-    c->addMove(Move{"Dark Moon", MT_SPECIAL, 
-                    {MS_THROW, MS_PUSH, MS_2XCOMBO}});
-    c->addMove(Move{"Hell's Flames", MT_SUPER, 
-                    {MS_THROW, MS_DISTANCE, MS_ULTRA_AGILITY}});
-    characters.push_back(c);
-
-    // Zhang Shi
-    c = std::make_shared<Character>(
-        "Zhang Shi", 2, 3, 2, SP_DAMAGE, 
-        std::make_shared<EvolveAIAttack>(),
-        std::make_shared<EvolveAIDefence>());
-    c->addMove(Move{"Gang Zhao", MT_SPECIAL, 
-                    {MS_ULTRA_HARDNESS}});
-    c->addMove(Move{"Feng Zhao", MT_SPECIAL, 
-                    {MS_DISTANCE}});
-    c->addMove(Move{"Xin Yue Ti", MT_SPECIAL, 
-                    {MS_PUSH, MS_BONUS_AIR}});
-    c->addMove(Move{"Fengbao Zhao", MT_SUPER, 
-                    {MS_ULTRA_AGILITY, MS_DISTANCE, MS_BONUS_FAR}});
-    characters.push_back(c);
-
-    // Rock Stark
-    c = std::make_shared<Character>(
-        "Rock Stark", 2, 2, 3, SP_DEFENCE, 
-        std::make_shared<EvolveAIAttack>(),
-        std::make_shared<EvolveAIDefence>());
-    c->addMove(Move{"Radiant Reflection", MT_SPECIAL, 
-                    {MS_REFLECT, MS_BONUS_COUNTER}});
-    c->addMove(Move{"Radiant Kick", MT_SPECIAL, 
-                    {MS_THROW}});
-    c->addMove(Move{"Flash Uppercut", MT_SPECIAL, 
-                    {MS_ULTRA_AGILITY, MS_BONUS_AIR}});
-    c->addMove(Move{"Atomic Punch", MT_SUPER, 
-                    {MS_POWERFUL, MS_ULTRA_AGILITY, MS_BONUS_COUNTER}});
-    characters.push_back(c);
+} // close anonymous namespace
 
-    return characters;
+char const * getOriginalRoster() {
+    return s_original_roster;
 }
 
+char const * getSiegeOfSydeRoster() {
+    return s_siege_of_syde_roster;
+}
 
-std::vector<std::shared_ptr<game::Character>> getSiegeOfSydeCharacters() {
-    std::vector<std::shared_ptr<game::Character>> characters{};
-    std::shared_ptr<Character> c;
-
-    // ========================================================================
-    // The Army of the Principality
-    // ========================================================================
-
-    // Alexis
-    c = std::make_shared<Character>(
-        "Duke Alexis the Sun Spear", 2, 1, 4, SP_DEFENCE, 
-        std::make_shared<EvolveAIAttack>(),
-        std::make_shared<EvolveAIDefence>());
-    c->addMove(Move{"Steel Spear", MT_SPECIAL, 
-                    {MS_SMASH}});
-    c->addMove(Move{"Resounding Parry", MT_SPECIAL, 
-                    {MS_REFLECT, MS_PUSH}});
-    c->addMove(Move{"Rolling Wave of Earth", MT_SPECIAL, 
-                    {MS_BONUS_NEAR, MS_THROW}});
-    c->addMove(Move{"Invincible Kata of the Spear", MT_SUPER, 
-                    {MS_SMASH, MS_POWERFUL, MS_BONUS_NEAR}});
-    characters.push_back(c);
-
-    // Gunther
-    c = std::make_shared<Character>(
-        "Gunther the Thundering Gryphon", 3, 3, 1, SP_WOUND, 
-        std::make_shared<EvolveAIAttack>(),
-        std::make_shared<EvolveAIDefence>());
-    c->addMove(Move{"Crackling Mace", MT_SPECIAL, 
-                    {MS_PUSH}});
-    c->addMove(Move{"Thunder Clap", MT_SPECIAL, 
-                    {MS_BONUS_NEAR, MS_ULTRA_HARDNESS}});
-    c->addMove(Move{"Titan's Maul", MT_SPECIAL, 
-                    {MS_PUSH, MS_SMASH}});
-    c->addMove(Move{"Call Lightning", MT_SUPER, 
-                    {MS_SMASH, MS_POWERFUL, MS_DISTANCE}});
-    characters.push_back(c);
-
-    // Yavanna
-    c = std::make_shared<Character>(
-        "Yavanna the Rampant Bear", 2, 4, 1, SP_DAMAGE, 
-        std::make_shared<EvolveAIAttack>(),
-        std::make_shared<EvolveAIDefence>());
-    c->addMove(Move{"Bear Claw", MT_SPECIAL, 
-                    {MS_POWERFUL}});
-    c->addMove(Move{"Bear Hug", MT_SPECIAL, 
-                    {MS_SMASH, MS_BONUS_NEAR}});
-    c->addMove(Move{"Caber Throw", MT_SPECIAL, 
-                    {MS_SMASH, MS_THROW}});
-    c->addMove(Move{"Fury of the Bear", MT_SUPER, 
-                    {MS_PUSH, MS_POWERFUL, MS_SMASH}});
-    characters.push_back(c);
-
-    // Julius
-    c = std::make_shared<Character>(
-        "Julius the Sleeping Dragon", 2, 3, 2, SP_WOUND, 
-        std::make_shared<EvolveAIAttack>(),
-        std::make_shared<EvolveAIDefence>());
-    c->addMove(Move{"Waking the Dragon", MT_SPECIAL, 
-                    {MS_THROW}});
-    c->addMove(Move{"Tidal Wave", MT_SPECIAL, 
-                    {MS_DISTANCE, MS_BONUS_FAR}});
-    c->addMove(Move{"Tears of the Dragon", MT_SPECIAL, 
-                    {MS_POWERFUL, MS_FALL}});
-    c->addMove(Move{"The Storm Where The Sky Meets The Sea", MT_SUPER, 
-                    {MS_DISTANCE, MS_POWERFUL, MS_ULTRA_HARDNESS}});
-    characters.push_back(c);
-
-    // Hartwin
-    c = std::make_shared<Character>(
-        "Hartwin the White Raven", 3, 3, 1, SP_DAMAGE, 
-        std::make_shared<EvolveAIAttack>(),
-        std::make_shared<EvolveAIDefence>());
-    c->addMove(Move{"Magic Staff", MT_SPECIAL, 
-                    {MS_SMASH}});
-    c->addMove(Move{"Blades of Light", MT_SPECIAL, 
-                    {MS_ULTRA_AGILITY, MS_POWERFUL}});
-    c->addMove(Move{"Pressure Wave", MT_SPECIAL, 
-                    {MS_ULTRA_AGILITY, MS_BONUS_NEAR}});
-    c->addMove(Move{"Summoning the Raven of Light", MT_SUPER, 
-                    {MS_DISTANCE, MS_POWERFUL, MS_POWERFUL}});
-    characters.push_back(c);
-
-    // Isolde
-    c = std::make_shared<Character>(
-        "Isolde the Chrysalis", 1, 1, 5, SP_DEFENCE, 
-        std::make_shared<EvolveAIAttack>(),
-        std::make_shared<EvolveAIDefence>());
-    c->addMove(Move{"Mantis Pounce", MT_SPECIAL, 
-                    {MS_JUMPOK}});
-    c->addMove(Move{"Falling Tree", MT_SPECIAL, 
-                    {MS_POWERFUL, MS_FALL}});
-    c->addMove(Move{"Horrid Swarm", MT_SPECIAL, 
-                    {MS_SMASH, MS_ULTRA_AGILITY}});
-    c->addMove(Move{"First Flight of the Chrysalis", MT_SUPER, 
-                    {MS_JUMPOK, MS_DASH, MS_POWERFUL}});
-    characters.push_back(c);
-
-    // Ross
-    c = std::make_shared<Character>(
-        "Ross Garnet the Master of Axes", 4, 2, 1, SP_COMBO, 
-        std::make_shared<BrawlerAtk>(),
-        std::make_shared<EvolveAIDefence>());
-    c->addMove(Move{"Rising Quarter", MT_SPECIAL, 
-                    {MS_THROW}});
-    c->addMove(Move{"Fleeting Crescent", MT_SPECIAL, 
-                    {MS_BONUS_NEAR, MS_2XCOMBO}});
-    c->addMove(Move{"Rolling Moon", MT_SPECIAL, 
-                    {MS_2XCOMBO, MS_2XCOMBO}});
-    c->addMove(Move{"Feral Fury", MT_SUPER, 
-                    {MS_DASH, MS_SMASH, MS_FALL}});
-    characters.push_back(c);
-
-    // ========================================================================
-    // The Defenders of Syde
-    // ========================================================================
-
-    // Thorsten
-    c = std::make_shared<Character>(
-        "Duke Thorsten the Dragonslayer", 2, 4, 1, SP_DAMAGE, 
-        std::make_shared<EvolveAIAttack>(),
-        std::make_shared<EvolveAIDefence>());
-    c->addMove(Move{"Rising Strike", MT_SPECIAL, 
-                    {MS_BONUS_NEAR}});
-    c->addMove(Move{"Away from me!", MT_SPECIAL, 
-                    {MS_THROW, MS_PUSH}});
-    c->addMove(Move{"Bone Crushing Slash", MT_SPECIAL, 
-                    {MS_ULTRA_HARDNESS, MS_FALL}});
-    c->addMove(Move{"Dragon Decapitation", MT_SUPER, 
-                    {MS_PUSH, MS_SMASH, MS_POWERFUL}});
-    characters.push_back(c);
-
-    // Bertram
-    c = std::make_shared<Character>(
-        "Bertram the Flying Fish", 2, 0, 5, SP_DEFENCE, 
-        std::make_shared<EvolveAIAttack>(),
-        std::make_shared<EvolveAIDefence>());
-    c->addMove(Move{"Ice Mirror", MT_SPECIAL, 
-                    {MS_REFLECT}});
-    c->addMove(Move{"Salmon Leap", MT_SPECIAL, 
-                    {MS_JUMPOK, MS_ULTRA_AGILITY}});
-    c->addMove(Move{"Insidious Ice", MT_SPECIAL, 
-                    {MS_BONUS_NEAR, MS_FALL}});
-    c->addMove(Move{"Snow Blizzard", MT_SUPER, 
-                    {MS_DISTANCE, MS_BONUS_FAR, MS_POWERFUL}});
-    characters.push_back(c);
-
-    // Eleanor
-    c = std::make_shared<Character>(
-        "Eleanor the Hummingsword", 3, 3, 1, SP_DAMAGE, 
-        std::make_shared<EvolveAIAttack>(),
-        std::make_shared<EvolveAIDefence>());
-    c->addMove(Move{"Hummingbird Kiss", MT_SPECIAL, 
-                    {MS_SMASH}});
-    c->addMove(Move{"Parting the Silk", MT_SPECIAL, 
-                    {MS_POWERFUL, MS_BONUS_NEAR}});
-    c->addMove(Move{"Flight of the Hummingbird", MT_SPECIAL, 
-                    {MS_THROW, MS_ULTRA_AGILITY}});
-    c->addMove(Move{"Virtuoso Sword Dance", MT_SUPER, 
-                    {MS_BONUS_NEAR, MS_FALL, MS_ULTRA_HARDNESS}});
-    characters.push_back(c);
-
-    // Lothar
-    c = std::make_shared<Character>(
-        "Lothar the Riding Avalanche", 3, 3, 1, SP_WOUND, 
-        std::make_shared<EvolveAIAttack>(),
-        std::make_shared<EvolveAIDefence>());
-    c->addMove(Move{"Ride-by Attack", MT_SPECIAL, 
-                    {MS_PUSH}});
-    c->addMove(Move{"Impetuous Charge", MT_SPECIAL, 
-                    {MS_DASH, MS_BONUS_NEAR}});
-    c->addMove(Move{"Trampling Assault", MT_SPECIAL, 
-                    {MS_ULTRA_HARDNESS, MS_POWERFUL}});
-    c->addMove(Move{"Riding the Avalanche", MT_SUPER, 
-                    {MS_PUSH, MS_POWERFUL, MS_BONUS_NEAR}});
-    characters.push_back(c);
-
-    // Kestin
-    c = std::make_shared<Character>(
-        "Kestin the Cloud of Arrows", 1, 1, 5, SP_DEFENCE, 
-        std::make_shared<EvolveAIAttack>(),
-        std::make_shared<EvolveAIDefence>());
-    c->addMove(Move{"Hunter Trap", MT_SPECIAL, 
-                    {MS_FALL}});
-    c->addMove(Move{"Sure Strike", MT_SPECIAL, 
-                    {MS_DISTANCE, MS_BONUS_FAR}});
-    c->addMove(Move{"Arrow Nova", MT_SPECIAL, 
-                    {MS_PUSH, MS_THROW}});
-    c->addMove(Move{"Energy Arrow", MT_SUPER, 
-                    {MS_DISTANCE, MS_POWERFUL, MS_ULTRA_HARDNESS}});
-    characters.push_back(c);
-
-    // Scarlet
-    c = std::make_shared<Character>(
-        "Scarlet the Ardent Flame", 3, 2, 2, SP_COMBO, 
-        std::make_shared<BrawlerAtk>(),
-        std::make_shared<EvolveAIDefence>());
-    c->addMove(Move{"Flame Pillar", MT_SPECIAL, 
-                    {MS_THROW}});
-    c->addMove(Move{"Spinning Ring of Fire", MT_SPECIAL, 
-                    {MS_2XCOMBO, MS_POWERFUL}});
-    c->addMove(Move{"The Good Old Fireball", MT_SPECIAL, 
-                    {MS_DISTANCE, MS_BONUS_FAR}});
-    c->addMove(Move{"Burning Wind of Noon", MT_SUPER, 
-                    {MS_DASH, MS_SMASH, MS_2XCOMBO}});
-    characters.push_back(c);
-
-    // Vune
-    c = std::make_shared<Character>(
-        "Vune the Livid Necromancer", 2, 2, 3, SP_DEFENCE, 
-        std::make_shared<EvolveAIAttack>(),
-        std::make_shared<EvolveAIDefence>());
-    c->addMove(Move{"Horror Vacui", MT_SPECIAL, 
-                    {MS_FALL}});
-    c->addMove(Move{"Gust of Lost Souls", MT_SPECIAL, 
-                    {MS_ULTRA_AGILITY, MS_BONUS_NEAR}});
-    c->addMove(Move{"Reaping Darkness", MT_SPECIAL, 
-                    {MS_POWERFUL, MS_POWERFUL}});
-    c->addMove(Move{"Infernal Comet", MT_SUPER, 
-                    {MS_DASH, MS_SMASH, MS_ULTRA_HARDNESS}});
-    characters.push_back(c);
+std::vector<std::shared_ptr<game::Character>> getOriginalCharacters() {
+    return makeCharacters(s_original_roster);
+}
 
-    return characters;
+std::vector<std::shared_ptr<game::Character>> getSiegeOfSydeCharacters() {
+    return makeCharacters(s_siege_of_syde_roster);
 }
- 
+
 }
 }
@@ -0,0 +1,150 @@
+// Copyright 2015 Dario Domizioli
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "core/chars/RandomCharacters.h"
+
+#include "core/ctrl/ExpertSystemCtrl.h"
+#include "core/sim/ThreadPool.h"
+
+#include <atomic>
+#include <cassert>
+#include <random>
+#include <unordered_set>
+
+namespace core {
+namespace chars {
+
+using namespace core::game;
+
+namespace {
+
+/// \brief Runs task(i) for every i below 'count' on 'threads' threads; each
+///        i is handled exactly once, by whichever thread gets to it first.
+void forEachIndex(size_t count, unsigned threads,
+                  std::function<void(size_t)> const &task) {
+    sim::ThreadPool pool(threads);
+    std::atomic<size_t> next(0);
+    pool.run([&](unsigned) {
+        for(size_t i = next++; i < count; i = next++) {
+            task(i);
+        }
+    });
+}
+
+} // close anonymous namespace
+
+RandomBuild drawRandomBuild(uint64_t seed, uint64_t index, unsigned attempt,
+                            bool allow_expert_systems) {
+    std::seed_seq seq{ static_cast<uint32_t>(seed),
+                       static_cast<uint32_t>(seed >> 32),
+                       static_cast<uint32_t>(index),
+                       static_cast<uint32_t>(index >> 32),
+                       static_cast<uint32_t>(attempt) };
+    std::mt19937 engine(seq);
+
+    RandomBuild r;
+    Build &b = r.build;
+    std::uniform_int_distribution<int> rra(1, 5);
+    b.ra = rra(engine);
+    std::uniform_int_distribution<int> rat(1, 6 - b.ra);
+    b.at = rat(engine);
+    b.df = 7 - b.ra - b.at;
+
+    std::uniform_int_distribution<int> rsp(SP_BEGIN__, SP_END__ - 1);
+    b.sp = static_cast<SPMode>(rsp(engine));
+
+    // If expert systems are allowed, choose 40% Evolving, 60% Expert System
+    r.combination = -1;
+    if(allow_expert_systems && rra(engine) >= 3) {
+        std::uniform_int_distribution<int> expert_sys(
+            0, ctrl::getNumExpertSystemsCombinations() - 1);
+        r.combination = expert_sys(engine);
+    }
+
+    std::uniform_int_distribution<int> rms(MS_BEGIN__, MS_END__ - 1);
+    for(auto &s : b.symbols) {
+        s = static_cast<MoveSymbol>(rms(engine));
+    }
+    return r;
+}
+
+std::vector<RandomBuild> drawRandomBuilds(GenerationOptions const &options) {
+    assert(!options.unique || options.count <= BuildSpace::size());
+    std::vector<RandomBuild> builds(options.count);
+    forEachIndex(options.count, options.threads, [&](size_t i) {
+        builds[i] = drawRandomBuild(options.seed, i, 0,
+                                    options.allow_expert_systems);
+    });
+    if(options.unique) {
+        // Duplicates are rare, so they are redrawn in order on this thread;
+        // the result does not depend on which thread drew what.
+        std::unordered_set<uint64_t> seen;
+        seen.reserve(options.count);
+        for(size_t i = 0; i < builds.size(); ++i) {
+            unsigned attempt = 0;
+            while(!seen.insert(BuildSpace::getId(builds[i].build)).second) {
+                builds[i] = drawRandomBuild(options.seed, i, ++attempt,
+                                            options.allow_expert_systems);
+            }
+        }
+    }
+    return builds;
+}
+
+CharacterSpec getRandomSpec(RandomBuild const &random, std::string const &name) {
+    CharacterSpec spec = BuildSpace::getSpec(random.build, "", "");
+    spec.name = name;
+    if(random.combination < 0) {
+        spec.attack_ai = (random.build.sp == SP_COMBO) ? "Markov" : "Evolve";
+        spec.defence_ai = "Evolve";
+    } else {
+        spec.attack_ai =
+            ctrl::getAttackExpertSystem(random.combination)->getName();
+        spec.defence_ai =
+            ctrl::getDefenceExpertSystem(random.combination)->getName();
+    }
+    return spec;
+}
+
+std::vector<CharacterSpec> generateRandomSpecs(GenerationOptions const &options) {
+    std::vector<RandomBuild> builds = drawRandomBuilds(options);
+    std::vector<CharacterSpec> specs(builds.size());
+    forEachIndex(builds.size(), options.threads, [&](size_t i) {
+        specs[i] = getRandomSpec(builds[i], options.prefix + std::to_string(i));
+    });
+    return specs;
+}
+
+std::vector<std::shared_ptr<Character>> generateRandomCharacters(
+    GenerationOptions const &options,
+    std::vector<uint64_t> *build_ids) {
+    std::vector<RandomBuild> builds = drawRandomBuilds(options);
+    std::vector<std::shared_ptr<Character>> characters(builds.size());
+    forEachIndex(builds.size(), options.threads, [&](size_t i) {
+        RandomBuild const &r = builds[i];
+        characters[i] = makeRandomCharacter(
+            options.prefix + std::to_string(i), r.build.ra, r.build.at,
+            r.build.sp, r.combination, r.build.symbols);
+    });
+    if(build_ids) {
+        build_ids->clear();
+        for(auto const &r : builds) {
+            build_ids->push_back(BuildSpace::getId(r.build));
+        }
+    }
+    return characters;
+}
+
+}
+}
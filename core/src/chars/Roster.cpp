@@ -0,0 +1,578 @@
+// Copyright 2015 Dario Domizioli
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "core/chars/Roster.h"
+
+#include "core/ctrl/DumbCtrl.h"
+#include "core/ctrl/EvolveAICtrl.h"
+#include "core/ctrl/ExpectiminimaxCtrl.h"
+#include "core/ctrl/ExpertSystemCtrl.h"
+#include "core/ctrl/MCTSCtrl.h"
+#include "core/ctrl/TDAICtrl.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace core {
+namespace chars {
+
+using namespace core::game;
+using namespace core::ctrl;
+
+namespace {
+
+// --- AI NAMES
+
+/// The attack AIs a roster can ask for; the expert systems follow the
+/// learning ones, in the order of s_attack_experts.
+char const * const s_attack_ais[] = {
+    "Dumb", "Evolve", "Markov", "TD", "MCTS", "Expectiminimax",
+    "Grunt", "Brawler", "Buffer", "Counter", "KillerChain", "Kite/Sniper",
+    "Balanced", "Tactical"
+};
+/// The expert system combination of each attack expert system.
+int const s_attack_experts[] = { 0, 1, 2, 3, 4, 5, 7, 8 };
+size_t const NUM_ATTACK_AIS = sizeof(s_attack_ais) / sizeof(s_attack_ais[0]);
+
+/// The defence AIs a roster can ask for, like s_attack_ais.
+char const * const s_defence_ais[] = {
+    "Dumb", "Evolve", "TD", "MCTS", "Expectiminimax",
+    "Grunt", "Brawler", "Buffer", "Counter", "KillerChain", "Kite", "Sniper",
+    "Balanced", "Tactical"
+};
+/// The expert system combination of each defence expert system.
+int const s_defence_experts[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8 };
+size_t const NUM_DEFENCE_AIS =
+    sizeof(s_defence_ais) / sizeof(s_defence_ais[0]);
+
+/// \brief Returns the position of a name in a list, or 'count' if missing.
+size_t findName(char const * const names[], size_t count,
+                std::string const &name) {
+    size_t i = 0;
+    for(; i < count; ++i) {
+        if(name == names[i]) {
+            break;
+        }
+    }
+    return i;
+}
+
+std::shared_ptr<AttackControl> makeAttackControl(size_t ai) {
+    switch(ai) {
+        case 0: return std::make_shared<DumbAttackControl>();
+        case 1: return std::make_shared<EvolveAIAttack>();
+        case 2: return std::make_shared<MarkovAIAttack>();
+        case 3: return std::make_shared<TDAIAttack>();
+        case 4: return std::make_shared<MCTSAttack>();
+        case 5: return std::make_shared<ExpectiminimaxAttack>();
+        default: break;
+    }
+    if(ai >= NUM_ATTACK_AIS) {
+        return nullptr;
+    }
+    return getAttackExpertSystem(s_attack_experts[ai - 6]);
+}
+
+std::shared_ptr<DefendControl> makeDefendControl(size_t ai) {
+    switch(ai) {
+        case 0: return std::make_shared<DumbDefendControl>();
+        case 1: return std::make_shared<EvolveAIDefence>();
+        case 2: return std::make_shared<TDAIDefence>();
+        case 3: return std::make_shared<MCTSDefence>();
+        case 4: return std::make_shared<ExpectiminimaxDefence>();
+        default: break;
+    }
+    if(ai >= NUM_DEFENCE_AIS) {
+        return nullptr;
+    }
+    return getDefenceExpertSystem(s_defence_experts[ai - 5]);
+}
+
+// --- TEXT FORM
+
+/// \brief Removes the blanks at both ends of a string.
+std::string trim(std::string const &s) {
+    size_t first = s.find_first_not_of(" \t\r");
+    if(first == s.npos) {
+        return std::string();
+    }
+    size_t last = s.find_last_not_of(" \t\r");
+    return s.substr(first, last - first + 1);
+}
+
+bool parseSPMode(std::string const &name, SPMode &sp) {
+    for(SPMode s = SP_BEGIN__; s != SP_END__; ++s) {
+        if(toString(s) == name) {
+            sp = s;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parseMoveSymbol(std::string const &name, MoveSymbol &symbol) {
+    for(MoveSymbol s = MS_BEGIN__; s != MS_END__; ++s) {
+        if(toString(s) == name) {
+            symbol = s;
+            return true;
+        }
+    }
+    return false;
+}
+
+/// \brief Parses "<name>: <symbols>" into a move of the given type.
+bool parseMove(std::string const &text, MoveType type,
+               std::vector<Move> &moves, std::string &error) {
+    size_t colon = text.find(':');
+    if(colon == text.npos) {
+        error = "missing ':' after the move name";
+        return false;
+    }
+    std::string name = trim(text.substr(0, colon));
+    if(name.empty()) {
+        error = "missing move name";
+        return false;
+    }
+    std::vector<MoveSymbol> symbols;
+    std::istringstream tokens(text.substr(colon + 1));
+    std::string token;
+    while(tokens >> token) {
+        MoveSymbol symbol;
+        if(!parseMoveSymbol(token, symbol)) {
+            error = "unknown move symbol '" + token + "'";
+            return false;
+        }
+        symbols.push_back(symbol);
+    }
+    if(symbols.size() > MAX_ROSTER_SYMBOLS) {
+        error = "too many symbols";
+        return false;
+    }
+    moves.push_back(Move{name, type, symbols});
+    return true;
+}
+
+// --- BINARY FORM
+
+/// The first bytes of a binary roster.
+char const s_magic[8] = { 'M', 'U', 'S', 'H', 'R', 'O', 'S', 'T' };
+/// The version of the binary roster layout.
+uint32_t const BINARY_ROSTER_VERSION = 1;
+
+/// The header of a binary roster, followed by the character records, the
+/// move records and the names, each NUL-terminated.
+struct RosterHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t characters;
+    uint32_t moves;
+    uint32_t names_size;
+    uint32_t reserved[2];
+};
+static_assert(sizeof(RosterHeader) == 32, "Unexpected RosterHeader padding");
+
+struct CharacterRecord {
+    uint32_t name;
+    uint32_t first_move;
+    uint8_t ra;
+    uint8_t at;
+    uint8_t df;
+    uint8_t sp;
+    uint8_t attack_ai;
+    uint8_t defence_ai;
+    uint8_t num_moves;
+    uint8_t reserved;
+};
+static_assert(sizeof(CharacterRecord) == 16,
+              "Unexpected CharacterRecord padding");
+
+struct MoveRecord {
+    uint32_t name;
+    uint8_t type;
+    uint8_t num_symbols;
+    uint8_t symbols[MAX_ROSTER_SYMBOLS];
+};
+static_assert(sizeof(MoveRecord) == 16, "Unexpected MoveRecord padding");
+
+RosterHeader const & header(void const *data) {
+    return *static_cast<RosterHeader const *>(data);
+}
+
+CharacterRecord const * characterRecords(void const *data) {
+    return reinterpret_cast<CharacterRecord const *>(
+        static_cast<char const *>(data) + sizeof(RosterHeader));
+}
+
+MoveRecord const * moveRecords(void const *data) {
+    return reinterpret_cast<MoveRecord const *>(
+        characterRecords(data) + header(data).characters);
+}
+
+char const * names(void const *data) {
+    return reinterpret_cast<char const *>(
+        moveRecords(data) + header(data).moves);
+}
+
+/// \brief Checks a mapped binary roster, so that the accessors can trust it.
+bool checkBinaryRoster(void const *data, size_t length, std::string &error) {
+    if(length < sizeof(RosterHeader)
+       || std::memcmp(header(data).magic, s_magic, sizeof(s_magic)) != 0) {
+        error = "not a binary roster";
+        return false;
+    }
+    RosterHeader const &h = header(data);
+    if(h.version != BINARY_ROSTER_VERSION) {
+        error = "unsupported binary roster version";
+        return false;
+    }
+    uint64_t expected = sizeof(RosterHeader)
+                        + uint64_t(h.characters) * sizeof(CharacterRecord)
+                        + uint64_t(h.moves) * sizeof(MoveRecord)
+                        + h.names_size;
+    if(expected != length || h.names_size == 0
+       || names(data)[h.names_size - 1] != '\0') {
+        error = "truncated binary roster";
+        return false;
+    }
+    CharacterRecord const *characters = characterRecords(data);
+    for(uint32_t i = 0; i < h.characters; ++i) {
+        CharacterRecord const &c = characters[i];
+        if(c.name >= h.names_size || c.sp >= SP_END__
+           || c.attack_ai >= NUM_ATTACK_AIS
+           || c.defence_ai >= NUM_DEFENCE_AIS
+           || uint64_t(c.first_move) + c.num_moves > h.moves) {
+            error = "malformed character record";
+            return false;
+        }
+    }
+    MoveRecord const *moves = moveRecords(data);
+    for(uint32_t i = 0; i < h.moves; ++i) {
+        MoveRecord const &m = moves[i];
+        bool ok = m.name < h.names_size && m.type < MT_END__
+                  && m.num_symbols <= MAX_ROSTER_SYMBOLS;
+        for(uint8_t s = 0; ok && s < m.num_symbols; ++s) {
+            ok = m.symbols[s] < MS_END__;
+        }
+        if(!ok) {
+            error = "malformed move record";
+            return false;
+        }
+    }
+    return true;
+}
+
+} // close anonymous namespace
+
+std::shared_ptr<AttackControl> makeAttackControl(std::string const &ai) {
+    return makeAttackControl(findName(s_attack_ais, NUM_ATTACK_AIS, ai));
+}
+
+std::shared_ptr<DefendControl> makeDefendControl(std::string const &ai) {
+    return makeDefendControl(findName(s_defence_ais, NUM_DEFENCE_AIS, ai));
+}
+
+std::shared_ptr<Character> makeCharacter(CharacterSpec const &spec) {
+    auto att = makeAttackControl(spec.attack_ai);
+    auto def = makeDefendControl(spec.defence_ai);
+    if(!att || !def) {
+        return nullptr;
+    }
+    auto c = std::make_shared<Character>(spec.name, spec.ra, spec.at, spec.df,
+                                         spec.sp, att, def);
+    c->moves.insert(c->moves.end(), spec.moves.cbegin(), spec.moves.cend());
+    return c;
+}
+
+CharacterSpec describeCharacter(Character const &c) {
+    CharacterSpec spec{c.name, c.ra, c.at, c.df, c.sp,
+                       c.actrl->getName(), c.dctrl->getName(), {}};
+    size_t standard = getStandardMoves().size();
+    if(c.moves.size() > standard) {
+        spec.moves.assign(c.moves.cbegin() + standard, c.moves.cend());
+    }
+    return spec;
+}
+
+bool readRoster(std::istream &in, std::vector<CharacterSpec> &specs,
+                std::string &error) {
+    std::string line;
+    size_t line_number = 0;
+    bool in_character = false;
+    while(std::getline(in, line)) {
+        ++line_number;
+        line = trim(line);
+        if(line.empty() || line[0] == '#') {
+            continue;
+        }
+        size_t space = line.find_first_of(" \t");
+        std::string keyword = line.substr(0, space);
+        std::string rest = (space == line.npos) ? std::string()
+                                                : trim(line.substr(space));
+        std::string problem;
+        if(keyword == "character") {
+            if(rest.empty()) {
+                problem = "missing character name";
+            } else {
+                specs.push_back(CharacterSpec{rest, 0, 0, 0, SP_COMBO,
+                                              "Evolve", "Evolve", {}});
+                in_character = true;
+            }
+        } else if(!in_character) {
+            problem = "'" + keyword + "' outside of a character";
+        } else if(keyword == "stats") {
+            std::istringstream tokens(rest);
+            std::string sp;
+            CharacterSpec &spec = specs.back();
+            if(!(tokens >> spec.ra >> spec.at >> spec.df >> sp)
+               || spec.ra < 0 || spec.at < 0 || spec.df < 0
+               || spec.ra > 9 || spec.at > 9 || spec.df > 9) {
+                problem = "malformed stats";
+            } else if(!parseSPMode(sp, spec.sp)) {
+                problem = "unknown SP mode '" + sp + "'";
+            }
+        } else if(keyword == "ai") {
+            std::istringstream tokens(rest);
+            CharacterSpec &spec = specs.back();
+            if(!(tokens >> spec.attack_ai >> spec.defence_ai)) {
+                problem = "malformed AIs";
+            } else if(findName(s_attack_ais, NUM_ATTACK_AIS, spec.attack_ai)
+                      == NUM_ATTACK_AIS) {
+                problem = "unknown attack AI '" + spec.attack_ai + "'";
+            } else if(findName(s_defence_ais, NUM_DEFENCE_AIS,
+                               spec.defence_ai) == NUM_DEFENCE_AIS) {
+                problem = "unknown defence AI '" + spec.defence_ai + "'";
+            }
+        } else if(keyword == "special" || keyword == "super") {
+            parseMove(rest, keyword == "special" ? MT_SPECIAL : MT_SUPER,
+                      specs.back().moves, problem);
+        } else {
+            problem = "unknown keyword '" + keyword + "'";
+        }
+        if(!problem.empty()) {
+            error = "line " + std::to_string(line_number) + ": " + problem;
+            return false;
+        }
+    }
+    return true;
+}
+
+void writeRoster(std::ostream &out, std::vector<CharacterSpec> const &specs) {
+    for(auto const &spec : specs) {
+        out << "character " << spec.name << std::endl
+            << "stats " << spec.ra << " " << spec.at << " " << spec.df << " "
+            << toString(spec.sp) << std::endl
+            << "ai " << spec.attack_ai << " " << spec.defence_ai << std::endl;
+        for(auto const &m : spec.moves) {
+            out << (m.isSuper() ? "super " : "special ") << m.getName() << ":";
+            for(auto s : m.getSymbols()) {
+                out << " " << toString(s);
+            }
+            out << std::endl;
+        }
+        out << std::endl;
+    }
+}
+
+bool writeBinaryRoster(std::string const &path,
+                       std::vector<CharacterSpec> const &specs,
+                       std::string &error) {
+    std::vector<CharacterRecord> characters;
+    std::vector<MoveRecord> moves;
+    std::string names;
+    for(auto const &spec : specs) {
+        size_t attack_ai = findName(s_attack_ais, NUM_ATTACK_AIS,
+                                    spec.attack_ai);
+        size_t defence_ai = findName(s_defence_ais, NUM_DEFENCE_AIS,
+                                     spec.defence_ai);
+        if(attack_ai == NUM_ATTACK_AIS || defence_ai == NUM_DEFENCE_AIS
+           || spec.moves.size() > UINT8_MAX
+           || spec.ra < 0 || spec.at < 0 || spec.df < 0
+           || spec.ra > UINT8_MAX || spec.at > UINT8_MAX
+           || spec.df > UINT8_MAX) {
+            error = "'" + spec.name + "' does not fit a binary roster";
+            return false;
+        }
+        CharacterRecord c;
+        c.name = static_cast<uint32_t>(names.size());
+        c.first_move = static_cast<uint32_t>(moves.size());
+        c.ra = static_cast<uint8_t>(spec.ra);
+        c.at = static_cast<uint8_t>(spec.at);
+        c.df = static_cast<uint8_t>(spec.df);
+        c.sp = static_cast<uint8_t>(spec.sp);
+        c.attack_ai = static_cast<uint8_t>(attack_ai);
+        c.defence_ai = static_cast<uint8_t>(defence_ai);
+        c.num_moves = static_cast<uint8_t>(spec.moves.size());
+        c.reserved = 0;
+        characters.push_back(c);
+        names.append(spec.name.c_str(), spec.name.size() + 1);
+        for(auto const &m : spec.moves) {
+            if(m.getSymbols().size() > MAX_ROSTER_SYMBOLS) {
+                error = "'" + m.getName() + "' has too many symbols";
+                return false;
+            }
+            MoveRecord r;
+            std::memset(&r, 0, sizeof(r));
+            r.name = static_cast<uint32_t>(names.size());
+            r.type = static_cast<uint8_t>(m.getType());
+            r.num_symbols = static_cast<uint8_t>(m.getSymbols().size());
+            for(size_t s = 0; s < m.getSymbols().size(); ++s) {
+                r.symbols[s] = static_cast<uint8_t>(m.getSymbols()[s]);
+            }
+            moves.push_back(r);
+            names.append(m.getName().c_str(), m.getName().size() + 1);
+        }
+    }
+    if(names.empty()) {
+        names.push_back('\0');
+    }
+    RosterHeader h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, s_magic, sizeof(s_magic));
+    h.version = BINARY_ROSTER_VERSION;
+    h.characters = static_cast<uint32_t>(characters.size());
+    h.moves = static_cast<uint32_t>(moves.size());
+    h.names_size = static_cast<uint32_t>(names.size());
+
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<char const *>(&h), sizeof(h));
+    out.write(reinterpret_cast<char const *>(characters.data()),
+              characters.size() * sizeof(CharacterRecord));
+    out.write(reinterpret_cast<char const *>(moves.data()),
+              moves.size() * sizeof(MoveRecord));
+    out.write(names.data(), names.size());
+    if(!out) {
+        error = "cannot write '" + path + "'";
+        return false;
+    }
+    return true;
+}
+
+MappedRoster::MappedRoster() : m_data(nullptr), m_length(0) {}
+
+MappedRoster::~MappedRoster() {
+    close();
+}
+
+bool MappedRoster::open(std::string const &path, std::string &error) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0) {
+        error = "cannot open '" + path + "'";
+        return false;
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        error = "cannot read '" + path + "'";
+        return false;
+    }
+    size_t length = static_cast<size_t>(st.st_size);
+    void *data = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(data == MAP_FAILED) {
+        error = "cannot map '" + path + "'";
+        return false;
+    }
+    if(!checkBinaryRoster(data, length, error)) {
+        munmap(data, length);
+        return false;
+    }
+    m_data = data;
+    m_length = length;
+    return true;
+}
+
+void MappedRoster::close() {
+    if(m_data) {
+        munmap(m_data, m_length);
+        m_data = nullptr;
+        m_length = 0;
+    }
+}
+
+size_t MappedRoster::size() const {
+    return m_data ? header(m_data).characters : 0;
+}
+
+char const * MappedRoster::getName(size_t i) const {
+    return names(m_data) + characterRecords(m_data)[i].name;
+}
+
+CharacterSpec MappedRoster::getSpec(size_t i) const {
+    CharacterRecord const &c = characterRecords(m_data)[i];
+    CharacterSpec spec{getName(i), c.ra, c.at, c.df,
+                       static_cast<SPMode>(c.sp),
+                       s_attack_ais[c.attack_ai], s_defence_ais[c.defence_ai],
+                       {}};
+    MoveRecord const *moves = moveRecords(m_data) + c.first_move;
+    for(uint8_t m = 0; m < c.num_moves; ++m) {
+        std::vector<MoveSymbol> symbols;
+        for(uint8_t s = 0; s < moves[m].num_symbols; ++s) {
+            symbols.push_back(static_cast<MoveSymbol>(moves[m].symbols[s]));
+        }
+        spec.moves.push_back(Move{names(m_data) + moves[m].name,
+                                  static_cast<MoveType>(moves[m].type),
+                                  symbols});
+    }
+    return spec;
+}
+
+std::shared_ptr<Character> MappedRoster::makeCharacter(size_t i) const {
+    return chars::makeCharacter(getSpec(i));
+}
+
+bool loadRoster(std::string const &path,
+                std::vector<std::shared_ptr<Character>> &characters,
+                std::string &error) {
+    std::ifstream in(path, std::ios::binary);
+    if(!in) {
+        error = "cannot open '" + path + "'";
+        return false;
+    }
+    char magic[sizeof(s_magic)] = {};
+    in.read(magic, sizeof(magic));
+    if(in && std::memcmp(magic, s_magic, sizeof(s_magic)) == 0) {
+        in.close();
+        MappedRoster roster;
+        if(!roster.open(path, error)) {
+            return false;
+        }
+        characters.reserve(characters.size() + roster.size());
+        for(size_t i = 0; i < roster.size(); ++i) {
+            characters.push_back(roster.makeCharacter(i));
+        }
+        return true;
+    }
+    in.clear();
+    in.seekg(0);
+    std::vector<CharacterSpec> specs;
+    if(!readRoster(in, specs, error)) {
+        return false;
+    }
+    characters.reserve(characters.size() + specs.size());
+    for(auto const &spec : specs) {
+        characters.push_back(makeCharacter(spec));
+    }
+    return true;
+}
+
+}
+}
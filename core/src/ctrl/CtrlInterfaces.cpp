@@ -19,7 +19,23 @@ namespace ctrl {
 
 AttackControl::~AttackControl() {}
 
+void AttackControl::forgetMatch(game::Character const &) {}
+
+void AttackControl::saveState(std::ostream &) {}
+
+bool AttackControl::loadState(std::istream &) {
+    return true;
+}
+
 DefendControl::~DefendControl() {}
 
+void DefendControl::forgetMatch(game::Character const &) {}
+
+void DefendControl::saveState(std::ostream &) {}
+
+bool DefendControl::loadState(std::istream &) {
+    return true;
+}
+
 }
 }
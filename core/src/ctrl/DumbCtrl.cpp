@@ -23,73 +23,6 @@ DumbAttackControl::~DumbAttackControl() {}
 
 char const * const DumbAttackControl::getName() const { return "Dumb"; }
 
-int DumbAttackControl::shouldSpendAPToGainSP(game::Character const &me,
-                          game::Character const &opponent,
-                          bool far) {
-    return 0;
-}
-
-bool DumbAttackControl::shouldSpendAPToFallStanding(game::Character const &me,
-                                 game::Character const &opponent,
-                                 bool far) {
-    // Avoid death!
-    return me.cur_life == 1;
-}
-
-game::Move const & DumbAttackControl::getNextMove(game::Character const &me,
-                               game::Character const &opponent,
-                               bool far) {
-    for(game::Move const &m : me.moves) {
-        if(!m.isWait()) {
-            return m;
-        }
-    }
-    return game::getWaitMove();
-}
-
-bool DumbAttackControl::shouldSpendSPToLowerAPCost(game::Character const &me,
-                                game::Character const &opponent,
-                                bool far,
-                                game::Move const &my_move,
-                                int current_ap_cost) {
-    return false;
-}
-
-bool DumbAttackControl::shouldSpendSPToConcatenate(game::Character const &me,
-                                game::Character const &opponent,
-                                bool far,
-                                game::Move const &my_move) {
-    return false;
-}
-
-bool DumbAttackControl::shouldSpendSPForUltraAgility(game::Character const &me,
-                                  game::Character const &opponent,
-                                  bool far,
-                                  game::Move const &my_move) {
-    return false;
-}
-
-bool DumbAttackControl::shouldSpendSPToBoostAttack(game::Character const &me,
-                                game::Character const &opponent,
-                                bool far,
-                                game::Move const &my_move) {
-    return false;
-}
-
-bool DumbAttackControl::shouldSpendSPToBoostDamage(game::Character const &me,
-                                game::Character const &opponent,
-                                bool far,
-                                game::Move const &my_move) {
-    return false;
-}
-
-void DumbAttackControl::updateAfterMove(game::Character const &me,
-                                        game::Character const &opponent,
-                                        game::Move const &move,
-                                        bool successful) {
-    // Do nothing.
-}
-
 void DumbAttackControl::updateAfterMatch(game::Character const &me,
                                          game::Character const &opponent,
                                          bool has_won) {
@@ -101,57 +34,6 @@ DumbDefendControl::~DumbDefendControl() {}
 
 char const * const DumbDefendControl::getName() const { return "Dumb"; }
 
-game::Move const & DumbDefendControl::getCounterMove(game::Character const &me,
-                                  game::Character const &opponent,
-                                  bool far,
-                                  game::Move const &opponent_move) {
-    return game::getWaitMove();
-}
-
-bool DumbDefendControl::shouldSpendSPToComboBreak(game::Character const &me,
-                               game::Character const &opponent,
-                               bool far,
-                               game::Move const &opponent_move) {
-    // Break only if we're about to die.
-    return opponent_move.damage(1, opponent.at, opponent.df, 0) > me.cur_life;
-}
-
-bool DumbDefendControl::shouldSpendSPToLowerAPCost(game::Character const &me,
-                                game::Character const &opponent,
-                                bool far,
-                                game::Move const &my_move,
-                                int current_ap_cost) {
-    return false;
-}
-
-bool DumbDefendControl::shouldSpendSPForUltraAgility(game::Character const &me,
-                                  game::Character const &opponent,
-                                  bool far,
-                                  game::Move const &my_move) {
-    return false;
-}
-
-bool DumbDefendControl::shouldSpendSPToBoostDefence(game::Character const &me,
-                                 game::Character const &opponent,
-                                 bool far,
-                                 game::Move const &my_move) {
-    return false;
-}
-
-bool DumbDefendControl::shouldSpendSPToBoostCounterDamage(game::Character const &me,
-                                       game::Character const &opponent,
-                                       bool far,
-                                       game::Move const &my_move) {
-    return false;
-}
-
-void DumbDefendControl::updateAfterMove(game::Character const &me,
-                                        game::Character const &opponent,
-                                        game::Move const &move,
-                                        bool successful) {
-    // Do nothing.
-}
-
 void DumbDefendControl::updateAfterMatch(game::Character const &me,
                                          game::Character const &opponent,
                                          bool has_won) {
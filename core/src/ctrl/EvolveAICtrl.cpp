@@ -17,6 +17,7 @@
 #include "core/game/Character.h"
 #include "core/game/Dice.h"
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <iostream>
@@ -26,16 +27,65 @@ namespace ctrl {
 
 using namespace core::game;
 
+/// \brief Writes a value in binary form.
+template<typename T>
+static void writeBinary(std::ostream &out, T const &value) {
+    out.write(reinterpret_cast<char const *>(&value), sizeof(value));
+}
+
+/// \brief Reads a value written by writeBinary; returns false on failure.
+template<typename T>
+static bool readBinary(std::istream &in, T &value) {
+    return static_cast<bool>(
+        in.read(reinterpret_cast<char *>(&value), sizeof(value)));
+}
+
+/// \brief Writes the cells of a matrix and its convergence statistics.
+template<size_t N>
+static void saveMatrix(std::ostream &out, double const (&goodness)[N],
+                       uint16_t const (&visits)[N], double recent_change,
+                       double recent_weight, size_t updates) {
+    writeBinary(out, static_cast<uint64_t>(N));
+    out.write(reinterpret_cast<char const *>(goodness), sizeof(goodness));
+    out.write(reinterpret_cast<char const *>(visits), sizeof(visits));
+    writeBinary(out, recent_change);
+    writeBinary(out, recent_weight);
+    writeBinary(out, static_cast<uint64_t>(updates));
+}
+
+/// \brief Reads what saveMatrix wrote, if the size matches.
+template<size_t N>
+static bool loadMatrix(std::istream &in, double (&goodness)[N],
+                       uint16_t (&visits)[N], double &recent_change,
+                       double &recent_weight, size_t &updates) {
+    uint64_t size = 0;
+    uint64_t all_updates = 0;
+    if(!readBinary(in, size) || size != N
+       || !in.read(reinterpret_cast<char *>(goodness), sizeof(goodness))
+       || !in.read(reinterpret_cast<char *>(visits), sizeof(visits))
+       || !readBinary(in, recent_change) || !readBinary(in, recent_weight)
+       || !readBinary(in, all_updates)) {
+        return false;
+    }
+    updates = static_cast<size_t>(all_updates);
+    return true;
+}
+
 DecisionMatrix::DecisionMatrix() {
     for(auto &x : m_goodness) {
         x = 0.5;
     }
-    m_learning_factor = 0.5;
+    for(auto &v : m_visits) {
+        v = 0;
+    }
+    m_recent_change = 0.0;
+    m_recent_weight = 0.0;
+    m_updates = 0;
 }
 
-double DecisionMatrix::getGoodness(bool down, bool in_air, int at_or_df,
-                                   int own_ap, int own_sp, 
-                                   int parameter) {
+size_t DecisionMatrix::getIndex(bool down, bool in_air, int at_or_df,
+                                int own_ap, int own_sp,
+                                int parameter) {
     // Saturate ap/sp
     if(own_ap >= MAX_OWN_AP_CASES) {
         own_ap = MAX_OWN_AP_CASES - 1;
@@ -63,47 +113,113 @@ double DecisionMatrix::getGoodness(bool down, bool in_air, int at_or_df,
     idx += own_sp * MAX_PARAM_CASES;
     idx += parameter;
     assert(idx < DECISION_MATRIX_SIZE);
-    return m_goodness[idx];
+    return idx;
+}
+
+double DecisionMatrix::getGoodness(bool down, bool in_air, int at_or_df,
+                                   int own_ap, int own_sp, 
+                                   int parameter) {
+    return m_goodness[getIndex(down, in_air, at_or_df, own_ap, own_sp,
+                               parameter)];
 }
 
 void DecisionMatrix::updateGoodness(bool down, bool in_air, int at_or_df,
                                     int own_ap, int own_sp, 
                                     int parameter, double good) {
-    // Saturate ap/sp
-    if(own_ap >= MAX_OWN_AP_CASES) {
-        own_ap = MAX_OWN_AP_CASES - 1;
+    size_t idx = getIndex(down, in_air, at_or_df, own_ap, own_sp, parameter);
+    // The initial 0.5 counts as one sample.
+    double rate = 1.0 / (m_visits[idx] + 2.0);
+    if(rate < MIN_LEARNING_RATE) {
+        rate = MIN_LEARNING_RATE;
     }
-    if(own_sp >= MAX_OWN_SP_CASES) {
-        own_sp = MAX_OWN_SP_CASES - 1;
+    record(idx, m_goodness[idx] + (good - m_goodness[idx]) * rate);
+}
+
+void DecisionMatrix::learnGoodness(bool down, bool in_air, int at_or_df,
+                                   int own_ap, int own_sp,
+                                   int parameter, double target, double rate) {
+    size_t idx = getIndex(down, in_air, at_or_df, own_ap, own_sp, parameter);
+    record(idx, m_goodness[idx] + (target - m_goodness[idx]) * rate);
+}
+
+void DecisionMatrix::record(size_t idx, double good) {
+    double change = good - m_goodness[idx];
+    m_goodness[idx] = good;
+    if(m_visits[idx] < UINT16_MAX) {
+        ++m_visits[idx];
     }
-    // Assert on other saturation
-    assert(at_or_df >= 0);
-    assert(own_ap >= 0);
-    assert(own_sp >= 0);
-    assert(parameter >= 0);
-    assert(at_or_df < MAX_AT_DF_CASES);
-    assert(own_sp < MAX_OWN_SP_CASES);
-    assert(parameter < MAX_PARAM_CASES);
-    size_t idx = 0;
-    if(down) {
-        idx += MAX_AIR_CASES * MAX_AT_DF_CASES * MAX_OWN_AP_CASES * MAX_OWN_SP_CASES * MAX_PARAM_CASES;
+    ++m_updates;
+    // Average over roughly the last thousand updates.
+    m_recent_change += ((change < 0.0 ? -change : change) - m_recent_change)
+                       * 0.001;
+    m_recent_weight += (1.0 - m_recent_weight) * 0.001;
+}
+
+unsigned DecisionMatrix::getVisits(bool down, bool in_air, int at_or_df,
+                                   int own_ap, int own_sp,
+                                   int parameter) const {
+    return m_visits[getIndex(down, in_air, at_or_df, own_ap, own_sp,
+                             parameter)];
+}
+
+size_t DecisionMatrix::getVisitedCells() const {
+    size_t visited = 0;
+    for(auto v : m_visits) {
+        if(v > 0) {
+            ++visited;
+        }
     }
-    if(in_air) {
-        idx += MAX_AT_DF_CASES * MAX_OWN_AP_CASES * MAX_OWN_SP_CASES * MAX_PARAM_CASES;
+    return visited;
+}
+
+void DecisionMatrix::warmStartFrom(DecisionMatrix const &other,
+                                   std::vector<size_t> const &parameter_map) {
+    for(size_t idx = 0; idx < DECISION_MATRIX_SIZE; ++idx) {
+        // The parameter is the last index of the matrix.
+        size_t parameter = idx % MAX_PARAM_CASES;
+        size_t from = parameter < parameter_map.size()
+                      ? parameter_map[parameter]
+                      : parameter;
+        if(from == game::NO_MOVE) {
+            continue;
+        }
+        assert(from < MAX_PARAM_CASES);
+        size_t from_idx = idx - parameter + from;
+        m_goodness[idx] = other.m_goodness[from_idx];
+        m_visits[idx] = std::min<uint16_t>(other.m_visits[from_idx],
+                                           WARM_START_VISITS);
     }
-    idx += at_or_df * MAX_OWN_AP_CASES * MAX_OWN_SP_CASES * MAX_PARAM_CASES;
-    idx += own_ap * MAX_OWN_SP_CASES * MAX_PARAM_CASES;
-    idx += own_sp * MAX_PARAM_CASES;
-    idx += parameter;
-    assert(idx < DECISION_MATRIX_SIZE);
-    m_goodness[idx] = (m_goodness[idx] + good * (1.0 - m_learning_factor)) * 0.5;
-    m_learning_factor = m_learning_factor * 0.9999;
+    m_recent_change = 0.0;
+    m_recent_weight = 0.0;
+    m_updates = 0;
+}
+
+void DecisionMatrix::save(std::ostream &out) const {
+    saveMatrix(out, m_goodness, m_visits, m_recent_change, m_recent_weight,
+               m_updates);
+}
+
+bool DecisionMatrix::load(std::istream &in) {
+    return loadMatrix(in, m_goodness, m_visits, m_recent_change,
+                      m_recent_weight, m_updates);
+}
+
+double getConvergence(std::vector<DecisionMatrix const *> const &matrices,
+                      double extra_change, size_t extra_updates) {
+    double weighted = extra_change * extra_updates;
+    size_t updates = extra_updates;
+    for(auto m : matrices) {
+        weighted += m->getConvergence() * m->getUpdates();
+        updates += m->getUpdates();
+    }
+    return updates == 0 ? 1.0 : weighted / updates;
 }
 
 void DecisionMatrix::dump(std::string const & with_name, 
                           std::vector<Move> const &with_moves) const {
-    std::cout << "MATRIX '" << with_name << "', learning factor " 
-              << m_learning_factor << ", interesting edge results:" 
+    std::cout << "MATRIX '" << with_name << "', recent change " 
+              << getConvergence() << ", " << getVisitedCells()
+              << " choices visited, interesting edge results:" 
               << std::endl;
     for(size_t down = 0; down < DecisionMatrix::MAX_DOWN_CASES; ++down) {
     for(size_t air = 0; air < DecisionMatrix::MAX_AIR_CASES; ++air) {
@@ -183,22 +299,155 @@ static bool shouldDoX(Character const &me, Character const &opponent,
     return false;
 }
 
-static void updateX(bool has_won, DecisionMatrix &matrix, 
-                    DecisionVector &last_decisions) {
+/// The matrix number of the moves in a Trajectory, both in attack and in
+/// defence, as they are learnt differently.
+static unsigned const MOVE_MATRIX_ID = 7;
+
+uint32_t packDecision(unsigned matrix, DecisionRecord const &dr) {
+    // Saturate ap/sp as the matrices do; negative values wrap around, so
+    // they saturate too.
+    size_t own_ap = static_cast<size_t>(dr.own_ap);
+    if(own_ap >= DecisionMatrix::MAX_OWN_AP_CASES) {
+        own_ap = DecisionMatrix::MAX_OWN_AP_CASES - 1;
+    }
+    size_t own_sp = static_cast<size_t>(dr.own_sp);
+    if(own_sp >= DecisionMatrix::MAX_OWN_SP_CASES) {
+        own_sp = DecisionMatrix::MAX_OWN_SP_CASES - 1;
+    }
+    assert(matrix < 8);
+    assert(dr.enemy_at_or_df >= 0 && dr.enemy_at_or_df < 8);
+    assert(dr.parameter < 16);
+    uint32_t packed = matrix;
+    packed = (packed << 1) | (dr.goodness > 0.0 ? 1 : 0);
+    packed = (packed << 1) | (dr.down ? 1 : 0);
+    packed = (packed << 1) | (dr.air ? 1 : 0);
+    packed = (packed << 3) | static_cast<uint32_t>(dr.enemy_at_or_df);
+    packed = (packed << 4) | static_cast<uint32_t>(own_ap);
+    packed = (packed << 3) | static_cast<uint32_t>(own_sp);
+    packed = (packed << 4) | static_cast<uint32_t>(dr.parameter);
+    return packed;
+}
+
+unsigned unpackDecision(uint32_t packed, DecisionRecord &dr) {
+    dr.parameter = packed & 0xF;
+    packed >>= 4;
+    dr.own_sp = packed & 0x7;
+    packed >>= 3;
+    dr.own_ap = packed & 0xF;
+    packed >>= 4;
+    dr.enemy_at_or_df = packed & 0x7;
+    packed >>= 3;
+    dr.air = (packed & 0x1) != 0;
+    packed >>= 1;
+    dr.down = (packed & 0x1) != 0;
+    packed >>= 1;
+    dr.goodness = (packed & 0x1) ? 1.0 : 0.0;
+    packed >>= 1;
+    return packed & 0x7;
+}
+
+ReplayBuffer::ReplayBuffer(size_t capacity)
+  : m_capacity(capacity), m_next(0) {}
+
+void ReplayBuffer::add(Trajectory const &trajectory) {
+    if(m_capacity == 0) {
+        return;
+    }
+    if(m_trajectories.size() < m_capacity) {
+        m_trajectories.push_back(trajectory);
+        return;
+    }
+    m_trajectories[m_next] = trajectory;
+    m_next = (m_next + 1) % m_capacity;
+}
+
+Trajectory const & ReplayBuffer::sample(std::default_random_engine &engine) const {
+    assert(!m_trajectories.empty());
+    std::uniform_int_distribution<size_t> pick(0, m_trajectories.size() - 1);
+    return m_trajectories[pick(engine)];
+}
+
+void ReplayBuffer::save(std::ostream &out) const {
+    writeBinary(out, static_cast<uint64_t>(m_trajectories.size()));
+    writeBinary(out, static_cast<uint64_t>(m_next));
+    for(auto const &t : m_trajectories) {
+        writeBinary(out, static_cast<uint8_t>(t.has_won ? 1 : 0));
+        writeBinary(out, static_cast<uint64_t>(t.decisions.size()));
+        out.write(reinterpret_cast<char const *>(t.decisions.data()),
+                  t.decisions.size() * sizeof(uint32_t));
+    }
+}
+
+bool ReplayBuffer::load(std::istream &in) {
+    uint64_t size = 0;
+    uint64_t next = 0;
+    if(!readBinary(in, size) || !readBinary(in, next) || size > m_capacity
+       || (size > 0 && next >= size)) {
+        return false;
+    }
+    std::vector<Trajectory> trajectories(static_cast<size_t>(size));
+    for(auto &t : trajectories) {
+        uint8_t has_won = 0;
+        uint64_t decisions = 0;
+        if(!readBinary(in, has_won) || !readBinary(in, decisions)
+           || decisions > (1U << 20)) {
+            return false;
+        }
+        t.has_won = has_won != 0;
+        t.decisions.resize(static_cast<size_t>(decisions));
+        if(!in.read(reinterpret_cast<char *>(t.decisions.data()),
+                    t.decisions.size() * sizeof(uint32_t))) {
+            return false;
+        }
+    }
+    m_trajectories.swap(trajectories);
+    m_next = static_cast<size_t>(next);
+    return true;
+}
+
+/// \brief Appends the decisions of a fight to a trajectory, last first, and
+///        clears them.
+static void collect(unsigned matrix, DecisionVector &last_decisions,
+                    Trajectory &trajectory) {
     while(!last_decisions.empty()) {
-        auto &dr = last_decisions.back();
-        if(has_won) {
-            dr.goodness = (dr.goodness > 0.0) ? 1.0 : 0.0;
-        } else {
-            dr.goodness = (dr.goodness > 0.0) ? 0.0 : 1.0;
-        }
-        matrix.updateGoodness(dr.down, dr.air, dr.enemy_at_or_df, dr.own_ap,
-                              dr.own_sp, dr.parameter, dr.goodness);
+        trajectory.decisions.push_back(packDecision(matrix,
+                                                    last_decisions.back()));
         last_decisions.pop_back();
     }
 }
 
-EvolveAIAttack::EvolveAIAttack() {}
+/// \brief Learns a decision: a choice is reinforced if the fight was won and
+///        the opposite choice otherwise; a move is reinforced if the fight was
+///        won, and the other moves are pulled back to 0.5.
+static void learnDecision(DecisionMatrix &matrix, bool is_move,
+                          DecisionRecord const &dr, bool has_won) {
+    double good = 0.0;
+    if(is_move) {
+        good = has_won ? 1.0 : 0.0;
+    } else if(has_won) {
+        good = (dr.goodness > 0.0) ? 1.0 : 0.0;
+    } else {
+        good = (dr.goodness > 0.0) ? 0.0 : 1.0;
+    }
+    matrix.updateGoodness(dr.down, dr.air, dr.enemy_at_or_df, dr.own_ap,
+                          dr.own_sp, dr.parameter, good);
+    // If we have won, for all OTHER moves, reduce probability!
+    if(is_move && has_won) {
+        for(size_t i = 0; i < DecisionMatrix::MAX_PARAM_CASES; ++i) {
+            if(i == dr.parameter) {
+                continue;
+            }
+            matrix.updateGoodness(dr.down, dr.air, dr.enemy_at_or_df,
+                                  dr.own_ap, dr.own_sp, i, 0.5);
+        }
+    }
+}
+
+EvolveAIAttack::EvolveAIAttack() : m_replays_per_match(0) {}
+
+EvolveAIAttack::EvolveAIAttack(ReplayOptions const &replay)
+  : m_replay_buffer(replay.capacity),
+    m_replays_per_match(replay.replays_per_match) {}
 
 EvolveAIAttack::~EvolveAIAttack() {}
 
@@ -405,43 +654,154 @@ void EvolveAIAttack::updateAfterMatch(game::Character const &me,
     // Protect ourselves against multi-threading
     std::lock_guard<std::mutex> protect(m_content_mutex);
 
-    updateX(has_won, m_ap_to_sp_matrix, m_last_ap_to_sp_decisions[me.uid]);
+    Trajectory trajectory;
+    trajectory.has_won = has_won;
+    collect(0, m_last_ap_to_sp_decisions[me.uid], trajectory);
     m_last_ap_to_sp_decisions.erase(me.uid);
-    updateX(has_won, m_fall_matrix, m_last_fall_decisions[me.uid]);
+    collect(1, m_last_fall_decisions[me.uid], trajectory);
     m_last_fall_decisions.erase(me.uid);
-    updateX(has_won, m_lower_matrix, m_last_lower_decisions[me.uid]);
+    collect(2, m_last_lower_decisions[me.uid], trajectory);
     m_last_lower_decisions.erase(me.uid);
-    updateX(has_won, m_concat_matrix, m_last_concat_decisions[me.uid]);
+    collect(3, m_last_concat_decisions[me.uid], trajectory);
     m_last_concat_decisions.erase(me.uid);
-    updateX(has_won, m_agility_matrix, m_last_agility_decisions[me.uid]);
+    collect(4, m_last_agility_decisions[me.uid], trajectory);
     m_last_agility_decisions.erase(me.uid);
-    updateX(has_won, m_at_boost_matrix, m_last_at_boost_decisions[me.uid]);
+    collect(5, m_last_at_boost_decisions[me.uid], trajectory);
     m_last_at_boost_decisions.erase(me.uid);
-    updateX(has_won, m_dmg_boost_matrix, m_last_dmg_boost_decisions[me.uid]);
+    collect(6, m_last_dmg_boost_decisions[me.uid], trajectory);
     m_last_dmg_boost_decisions.erase(me.uid);
+    collect(MOVE_MATRIX_ID, m_last_move_decisions[me.uid], trajectory);
+    m_last_move_decisions.erase(me.uid);
 
-    // Moves are a special case.
-    while(!m_last_move_decisions[me.uid].empty()) {
-        auto &dr = m_last_move_decisions[me.uid].back();
-        dr.goodness = has_won ? 1.0 : 0.0;
-        m_move_matrix.updateGoodness(dr.down, dr.air, dr.enemy_at_or_df, 
-                                     dr.own_ap, dr.own_sp, dr.parameter,
-                                     dr.goodness);
-        // If we have won, for all OTHER moves, reduce probability!
-        if(has_won) {
-            for(size_t i = 0; i < DecisionMatrix::MAX_PARAM_CASES; ++i) {
-                if(i == dr.parameter) {
-                    continue;
-                }
-                m_move_matrix.updateGoodness(dr.down, dr.air, dr.enemy_at_or_df,
-                                             dr.own_ap, dr.own_sp, i, 0.5);
-            }
-        }
-        m_last_move_decisions[me.uid].pop_back();
+    learn(trajectory);
+    if(m_replay_buffer.capacity() > 0) {
+        replayLocked(m_replays_per_match);
+        m_replay_buffer.add(trajectory);
     }
+}
+
+void EvolveAIAttack::forgetMatch(game::Character const &me) {
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> protect(m_content_mutex);
+
+    m_last_ap_to_sp_decisions.erase(me.uid);
+    m_last_fall_decisions.erase(me.uid);
     m_last_move_decisions.erase(me.uid);
+    m_last_lower_decisions.erase(me.uid);
+    m_last_concat_decisions.erase(me.uid);
+    m_last_agility_decisions.erase(me.uid);
+    m_last_at_boost_decisions.erase(me.uid);
+    m_last_dmg_boost_decisions.erase(me.uid);
 }
 
+void EvolveAIAttack::learn(Trajectory const &trajectory) {
+    DecisionMatrix *matrices[] = {
+        &m_ap_to_sp_matrix, &m_fall_matrix, &m_lower_matrix, &m_concat_matrix,
+        &m_agility_matrix, &m_at_boost_matrix, &m_dmg_boost_matrix,
+        &m_move_matrix
+    };
+    DecisionRecord dr;
+    for(uint32_t packed : trajectory.decisions) {
+        unsigned matrix = unpackDecision(packed, dr);
+        assert(matrix <= MOVE_MATRIX_ID);
+        learnDecision(*matrices[matrix], matrix == MOVE_MATRIX_ID, dr,
+                      trajectory.has_won);
+    }
+}
+
+size_t EvolveAIAttack::replay(size_t count) {
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> protect(m_content_mutex);
+
+    return replayLocked(count);
+}
+
+size_t EvolveAIAttack::replayLocked(size_t count) {
+    if(m_replay_buffer.size() == 0) {
+        return 0;
+    }
+    for(size_t i = 0; i < count; ++i) {
+        Trajectory const *trajectory = nullptr;
+        if(true) { // Just to have a scope
+            std::lock_guard<std::mutex> protect(getRandomGenMutex());
+            trajectory = &m_replay_buffer.sample(getRandomGenerator());
+        }
+        learn(*trajectory);
+    }
+    return count;
+}
+
+void EvolveAIAttack::warmStartFrom(EvolveAIAttack &other,
+                                   std::vector<size_t> const &move_map) {
+    if(&other == this) {
+        return;
+    }
+    // Protect ourselves against multi-threading
+    std::lock(m_content_mutex, other.m_content_mutex);
+    std::lock_guard<std::mutex> protect(m_content_mutex, std::adopt_lock);
+    std::lock_guard<std::mutex> protect_other(other.m_content_mutex,
+                                              std::adopt_lock);
+
+    std::vector<size_t> same;
+    m_ap_to_sp_matrix.warmStartFrom(other.m_ap_to_sp_matrix, same);
+    m_fall_matrix.warmStartFrom(other.m_fall_matrix, same);
+    m_move_matrix.warmStartFrom(other.m_move_matrix, move_map);
+    m_lower_matrix.warmStartFrom(other.m_lower_matrix, move_map);
+    m_concat_matrix.warmStartFrom(other.m_concat_matrix, move_map);
+    m_agility_matrix.warmStartFrom(other.m_agility_matrix, move_map);
+    m_at_boost_matrix.warmStartFrom(other.m_at_boost_matrix, move_map);
+    m_dmg_boost_matrix.warmStartFrom(other.m_dmg_boost_matrix, move_map);
+}
+
+double EvolveAIAttack::getConvergence() {
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> protect(m_content_mutex);
+
+    return ctrl::getConvergence(getMatrices());
+}
+
+std::vector<DecisionMatrix const *> EvolveAIAttack::getMatrices() const {
+    return {&m_ap_to_sp_matrix, &m_fall_matrix, &m_move_matrix,
+            &m_lower_matrix, &m_concat_matrix, &m_agility_matrix,
+            &m_at_boost_matrix, &m_dmg_boost_matrix};
+}
+
+bool EvolveAIAttack::hasConverged(double tolerance) {
+    return getConvergence() < tolerance;
+}
+
+void EvolveAIAttack::saveState(std::ostream &out) {
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> protect(m_content_mutex);
+
+    for(auto m : getMatrices()) {
+        m->save(out);
+    }
+    m_replay_buffer.save(out);
+}
+
+bool EvolveAIAttack::loadState(std::istream &in) {
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> protect(m_content_mutex);
+
+    // In the order of getMatrices.
+    for(DecisionMatrix *m : {&m_ap_to_sp_matrix, &m_fall_matrix,
+                             &m_move_matrix, &m_lower_matrix,
+                             &m_concat_matrix, &m_agility_matrix,
+                             &m_at_boost_matrix, &m_dmg_boost_matrix}) {
+        if(!m->load(in)) {
+            return false;
+        }
+    }
+    return m_replay_buffer.load(in);
+}
+
+
+EvolveAIDefence::EvolveAIDefence() : m_replays_per_match(0) {}
+
+EvolveAIDefence::EvolveAIDefence(ReplayOptions const &replay)
+  : m_replay_buffer(replay.capacity),
+    m_replays_per_match(replay.replays_per_match) {}
 
 EvolveAIDefence::~EvolveAIDefence() {}
 
@@ -608,37 +968,190 @@ void EvolveAIDefence::updateAfterMatch(game::Character const &me,
     // Protect ourselves against multi-threading
     std::lock_guard<std::mutex> protect(m_content_mutex);
 
-    updateX(has_won, m_break_matrix, m_last_break_decisions[me.uid]);
+    Trajectory trajectory;
+    trajectory.has_won = has_won;
+    collect(0, m_last_break_decisions[me.uid], trajectory);
     m_last_break_decisions.erase(me.uid);
-    updateX(has_won, m_lower_matrix, m_last_lower_decisions[me.uid]);
+    collect(1, m_last_lower_decisions[me.uid], trajectory);
     m_last_lower_decisions.erase(me.uid);
-    updateX(has_won, m_agility_matrix, m_last_agility_decisions[me.uid]);
+    collect(2, m_last_agility_decisions[me.uid], trajectory);
     m_last_agility_decisions.erase(me.uid);
-    updateX(has_won, m_df_boost_matrix, m_last_df_boost_decisions[me.uid]);
+    collect(3, m_last_df_boost_decisions[me.uid], trajectory);
     m_last_df_boost_decisions.erase(me.uid);
-    updateX(has_won, m_dmg_boost_matrix, m_last_dmg_boost_decisions[me.uid]);
+    collect(4, m_last_dmg_boost_decisions[me.uid], trajectory);
     m_last_dmg_boost_decisions.erase(me.uid);
+    collect(MOVE_MATRIX_ID, m_last_move_decisions[me.uid], trajectory);
+    m_last_move_decisions.erase(me.uid);
 
-    // Moves are a special case.
-    while(!m_last_move_decisions[me.uid].empty()) {
-        auto &dr = m_last_move_decisions[me.uid].back();
-        dr.goodness = has_won ? 1.0 : 0.0;
-        m_move_matrix.updateGoodness(dr.down, dr.air, dr.enemy_at_or_df, 
-                                     dr.own_ap, dr.own_sp, dr.parameter,
-                                     dr.goodness);
-        // If we have won, for all OTHER moves, reduce probability!
-        if(has_won) {
-            for(size_t i = 0; i < DecisionMatrix::MAX_PARAM_CASES; ++i) {
-                if(i == dr.parameter) {
-                    continue;
-                }
-                m_move_matrix.updateGoodness(dr.down, dr.air, dr.enemy_at_or_df,
-                                             dr.own_ap, dr.own_sp, i, 0.5);
-            }
-        }
-        m_last_move_decisions[me.uid].pop_back();
+    learn(trajectory);
+    if(m_replay_buffer.capacity() > 0) {
+        replayLocked(m_replays_per_match);
+        m_replay_buffer.add(trajectory);
     }
+}
+
+void EvolveAIDefence::forgetMatch(game::Character const &me) {
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> protect(m_content_mutex);
+
     m_last_move_decisions.erase(me.uid);
+    m_last_break_decisions.erase(me.uid);
+    m_last_lower_decisions.erase(me.uid);
+    m_last_agility_decisions.erase(me.uid);
+    m_last_df_boost_decisions.erase(me.uid);
+    m_last_dmg_boost_decisions.erase(me.uid);
+}
+
+void EvolveAIDefence::learn(Trajectory const &trajectory) {
+    // The matrices 5 and 6 are not used in defence.
+    DecisionMatrix *matrices[] = {
+        &m_break_matrix, &m_lower_matrix, &m_agility_matrix,
+        &m_df_boost_matrix, &m_dmg_boost_matrix, nullptr, nullptr,
+        &m_move_matrix
+    };
+    DecisionRecord dr;
+    for(uint32_t packed : trajectory.decisions) {
+        unsigned matrix = unpackDecision(packed, dr);
+        assert(matrix <= MOVE_MATRIX_ID && matrices[matrix]);
+        learnDecision(*matrices[matrix], matrix == MOVE_MATRIX_ID, dr,
+                      trajectory.has_won);
+    }
+}
+
+size_t EvolveAIDefence::replay(size_t count) {
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> protect(m_content_mutex);
+
+    return replayLocked(count);
+}
+
+size_t EvolveAIDefence::replayLocked(size_t count) {
+    if(m_replay_buffer.size() == 0) {
+        return 0;
+    }
+    for(size_t i = 0; i < count; ++i) {
+        Trajectory const *trajectory = nullptr;
+        if(true) { // Just to have a scope
+            std::lock_guard<std::mutex> protect(getRandomGenMutex());
+            trajectory = &m_replay_buffer.sample(getRandomGenerator());
+        }
+        learn(*trajectory);
+    }
+    return count;
+}
+
+void EvolveAIDefence::warmStartFrom(EvolveAIDefence &other,
+                                    std::vector<size_t> const &move_map) {
+    if(&other == this) {
+        return;
+    }
+    // Protect ourselves against multi-threading
+    std::lock(m_content_mutex, other.m_content_mutex);
+    std::lock_guard<std::mutex> protect(m_content_mutex, std::adopt_lock);
+    std::lock_guard<std::mutex> protect_other(other.m_content_mutex,
+                                              std::adopt_lock);
+
+    // The parameter of the combo breaks is a move of the opponent.
+    m_break_matrix.warmStartFrom(other.m_break_matrix, std::vector<size_t>());
+    m_move_matrix.warmStartFrom(other.m_move_matrix, move_map);
+    m_lower_matrix.warmStartFrom(other.m_lower_matrix, move_map);
+    m_agility_matrix.warmStartFrom(other.m_agility_matrix, move_map);
+    m_df_boost_matrix.warmStartFrom(other.m_df_boost_matrix, move_map);
+    m_dmg_boost_matrix.warmStartFrom(other.m_dmg_boost_matrix, move_map);
+}
+
+double EvolveAIDefence::getConvergence() {
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> protect(m_content_mutex);
+
+    return ctrl::getConvergence(getMatrices());
+}
+
+std::vector<DecisionMatrix const *> EvolveAIDefence::getMatrices() const {
+    return {&m_move_matrix, &m_break_matrix, &m_lower_matrix,
+            &m_agility_matrix, &m_df_boost_matrix, &m_dmg_boost_matrix};
+}
+
+bool EvolveAIDefence::hasConverged(double tolerance) {
+    return getConvergence() < tolerance;
+}
+
+void EvolveAIDefence::saveState(std::ostream &out) {
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> protect(m_content_mutex);
+
+    for(auto m : getMatrices()) {
+        m->save(out);
+    }
+    m_replay_buffer.save(out);
+}
+
+bool EvolveAIDefence::loadState(std::istream &in) {
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> protect(m_content_mutex);
+
+    // In the order of getMatrices.
+    for(DecisionMatrix *m : {&m_move_matrix, &m_break_matrix,
+                             &m_lower_matrix, &m_agility_matrix,
+                             &m_df_boost_matrix, &m_dmg_boost_matrix}) {
+        if(!m->load(in)) {
+            return false;
+        }
+    }
+    return m_replay_buffer.load(in);
+}
+
+bool hasConverged(Character const &c, double tolerance) {
+    auto att = std::dynamic_pointer_cast<EvolveAIAttack>(c.actrl);
+    if(att && !att->hasConverged(tolerance)) {
+        return false;
+    }
+    auto def = std::dynamic_pointer_cast<EvolveAIDefence>(c.dctrl);
+    if(def && !def->hasConverged(tolerance)) {
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<Character> warmStart(
+    Character &c, std::vector<std::shared_ptr<Character>> const &trained) {
+    auto att = std::dynamic_pointer_cast<EvolveAIAttack>(c.actrl);
+    auto def = std::dynamic_pointer_cast<EvolveAIDefence>(c.dctrl);
+    if(!att && !def) {
+        return nullptr;
+    }
+    std::shared_ptr<Character> nearest;
+    double best = -1.0;
+    for(auto const &t : trained) {
+        if(t.get() == &c) {
+            continue;
+        }
+        bool evolving_att =
+            att && std::dynamic_pointer_cast<EvolveAIAttack>(t->actrl);
+        bool evolving_def =
+            def && std::dynamic_pointer_cast<EvolveAIDefence>(t->dctrl);
+        if(!evolving_att && !evolving_def) {
+            continue;
+        }
+        double s = similarity(*t, c);
+        if(s > best) {
+            best = s;
+            nearest = t;
+        }
+    }
+    if(!nearest) {
+        return nullptr;
+    }
+    std::vector<size_t> move_map = mapMoves(*nearest, c);
+    auto other_att = std::dynamic_pointer_cast<EvolveAIAttack>(nearest->actrl);
+    if(att && other_att) {
+        att->warmStartFrom(*other_att, move_map);
+    }
+    auto other_def = std::dynamic_pointer_cast<EvolveAIDefence>(nearest->dctrl);
+    if(def && other_def) {
+        def->warmStartFrom(*other_def, move_map);
+    }
+    return nearest;
 }
 
 
@@ -646,12 +1159,16 @@ MarkovDecisionMatrix::MarkovDecisionMatrix() {
     for(auto &x : m_goodness) {
         x = 0.5;
     }
-    m_learning_factor = 0.5;
+    for(auto &v : m_visits) {
+        v = 0;
+    }
+    m_recent_change = 0.0;
+    m_recent_weight = 0.0;
+    m_updates = 0;
 }
 
-double MarkovDecisionMatrix::getGoodness(int at_or_df,
-                                         int own_ap, int own_sp, 
-                                         int parameter[3]) {
+size_t MarkovDecisionMatrix::getIndex(int at_or_df, int own_ap, int own_sp,
+                                      int parameter[3]) {
     // Saturate ap/sp
     if(own_ap >= MAX_OWN_AP_CASES) {
         own_ap = MAX_OWN_AP_CASES - 1;
@@ -679,49 +1196,87 @@ double MarkovDecisionMatrix::getGoodness(int at_or_df,
     idx += parameter[1] * MAX_PARAM_CASES;
     idx += parameter[2];
     assert(idx < DECISION_MATRIX_SIZE);
-    return m_goodness[idx];
+    return idx;
+}
+
+double MarkovDecisionMatrix::getGoodness(int at_or_df,
+                                         int own_ap, int own_sp, 
+                                         int parameter[3]) {
+    return m_goodness[getIndex(at_or_df, own_ap, own_sp, parameter)];
 }
 
 void MarkovDecisionMatrix::updateGoodness(int at_or_df,
                                           int own_ap, int own_sp, 
                                           int parameter[3], double good) {
-    // Saturate ap/sp
-    if(own_ap >= MAX_OWN_AP_CASES) {
-        own_ap = MAX_OWN_AP_CASES - 1;
+    size_t idx = getIndex(at_or_df, own_ap, own_sp, parameter);
+    // Same step size as DecisionMatrix::updateGoodness.
+    double rate = 1.0 / (m_visits[idx] + 2.0);
+    if(rate < DecisionMatrix::MIN_LEARNING_RATE) {
+        rate = DecisionMatrix::MIN_LEARNING_RATE;
     }
-    if(own_sp >= MAX_OWN_SP_CASES) {
-        own_sp = MAX_OWN_SP_CASES - 1;
+    double change = (good - m_goodness[idx]) * rate;
+    m_goodness[idx] += change;
+    if(m_visits[idx] < UINT16_MAX) {
+        ++m_visits[idx];
     }
-    // Assert on other saturation
-    assert(at_or_df >= 0);
-    assert(own_ap >= 0);
-    assert(own_sp >= 0);
-    assert(parameter[0] >= 0);
-    assert(parameter[1] >= 0);
-    assert(parameter[2] >= 0);
-    assert(at_or_df < MAX_AT_DF_CASES);
-    assert(own_sp < MAX_OWN_SP_CASES);
-    assert(parameter[0] < MAX_PARAM_CASES);
-    assert(parameter[1] < MAX_PARAM_CASES);
-    assert(parameter[2] < MAX_PARAM_CASES);
-    size_t idx = 0;
-    idx += at_or_df * MAX_OWN_AP_CASES * MAX_OWN_SP_CASES * MAX_PARAM_CASES * MAX_PARAM_CASES * MAX_PARAM_CASES;
-    idx += own_ap * MAX_OWN_SP_CASES * MAX_PARAM_CASES * MAX_PARAM_CASES * MAX_PARAM_CASES;
-    idx += own_sp * MAX_PARAM_CASES * MAX_PARAM_CASES * MAX_PARAM_CASES;
-    idx += parameter[0] * MAX_PARAM_CASES * MAX_PARAM_CASES;
-    idx += parameter[1] * MAX_PARAM_CASES;
-    idx += parameter[2];
-    assert(idx < DECISION_MATRIX_SIZE);
-    m_goodness[idx] = (m_goodness[idx] + good * (1.0 - m_learning_factor)) * 0.5;
-    m_learning_factor = m_learning_factor * 0.9999;
+    ++m_updates;
+    m_recent_change += ((change < 0.0 ? -change : change) - m_recent_change)
+                       * 0.001;
+    m_recent_weight += (1.0 - m_recent_weight) * 0.001;
+}
+
+void MarkovDecisionMatrix::warmStartFrom(
+    MarkovDecisionMatrix const &other,
+    std::vector<size_t> const &parameter_map) {
+    size_t const params = MAX_PARAM_CASES * MAX_PARAM_CASES * MAX_PARAM_CASES;
+    for(size_t idx = 0; idx < DECISION_MATRIX_SIZE; ++idx) {
+        // The three parameters are the last indices of the matrix.
+        size_t base = idx - idx % params;
+        size_t rest = idx % params;
+        size_t from_idx = base;
+        bool skip = false;
+        for(size_t scale = params / MAX_PARAM_CASES; scale > 0;
+            scale /= MAX_PARAM_CASES) {
+            size_t parameter = rest / scale;
+            rest %= scale;
+            size_t from = parameter < parameter_map.size()
+                          ? parameter_map[parameter]
+                          : parameter;
+            if(from == game::NO_MOVE) {
+                skip = true;
+                break;
+            }
+            assert(from < MAX_PARAM_CASES);
+            from_idx += from * scale;
+        }
+        if(skip) {
+            continue;
+        }
+        m_goodness[idx] = other.m_goodness[from_idx];
+        m_visits[idx] = std::min<uint16_t>(
+            other.m_visits[from_idx], DecisionMatrix::WARM_START_VISITS);
+    }
+    m_recent_change = 0.0;
+    m_recent_weight = 0.0;
+    m_updates = 0;
+}
+
+void MarkovDecisionMatrix::save(std::ostream &out) const {
+    saveMatrix(out, m_goodness, m_visits, m_recent_change, m_recent_weight,
+               m_updates);
+}
+
+bool MarkovDecisionMatrix::load(std::istream &in) {
+    return loadMatrix(in, m_goodness, m_visits, m_recent_change,
+                      m_recent_weight, m_updates);
 }
 
 void MarkovDecisionMatrix::dump(std::string const & with_name, 
                           std::vector<Move> const &with_moves) const {
     // TODO
 /*
-    std::cout << "MATRIX '" << with_name << "', learning factor " 
-              << m_learning_factor << ", interesting edge results:" 
+    std::cout << "MATRIX '" << with_name << "', recent change " 
+              << getConvergence() << ", interesting edge results:" 
               << std::endl;
     for(size_t down = 0; down < DecisionMatrix::MAX_DOWN_CASES; ++down) {
     for(size_t air = 0; air < DecisionMatrix::MAX_AIR_CASES; ++air) {
@@ -868,5 +1423,59 @@ void MarkovAIAttack::updateAfterMatch(game::Character const &me,
     m_last_markov_decisions.erase(me.uid);
 }
 
+void MarkovAIAttack::forgetMatch(game::Character const &me) {
+    EvolveAIAttack::forgetMatch(me);
+
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> protect(m_content_mutex);
+
+    m_last_markov_decisions.erase(me.uid);
+}
+
+double MarkovAIAttack::getConvergence() {
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> protect(m_content_mutex);
+
+    return ctrl::getConvergence(getMatrices(),
+                                m_markov_matrix.getConvergence(),
+                                m_markov_matrix.getUpdates());
+}
+
+void MarkovAIAttack::saveState(std::ostream &out) {
+    EvolveAIAttack::saveState(out);
+
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> protect(m_content_mutex);
+
+    m_markov_matrix.save(out);
+}
+
+bool MarkovAIAttack::loadState(std::istream &in) {
+    if(!EvolveAIAttack::loadState(in)) {
+        return false;
+    }
+
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> protect(m_content_mutex);
+
+    return m_markov_matrix.load(in);
+}
+
+void MarkovAIAttack::warmStartFrom(EvolveAIAttack &other,
+                                   std::vector<size_t> const &move_map) {
+    EvolveAIAttack::warmStartFrom(other, move_map);
+    MarkovAIAttack *markov = dynamic_cast<MarkovAIAttack *>(&other);
+    if(!markov || markov == this) {
+        return;
+    }
+    // Protect ourselves against multi-threading
+    std::lock(m_content_mutex, markov->m_content_mutex);
+    std::lock_guard<std::mutex> protect(m_content_mutex, std::adopt_lock);
+    std::lock_guard<std::mutex> protect_other(markov->m_content_mutex,
+                                              std::adopt_lock);
+
+    m_markov_matrix.warmStartFrom(markov->m_markov_matrix, move_map);
+}
+
 }
 }
@@ -0,0 +1,587 @@
+// Copyright 2015 Dario Domizioli
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "core/ctrl/ExpectiminimaxCtrl.h"
+#include "core/ctrl/ExpertSystemCtrl.h"
+#include "core/ctrl/PlannedCtrl.h"
+#include "core/game/Move.h"
+#include "core/game/Character.h"
+#include "core/game/Dice.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace core {
+namespace ctrl {
+
+using namespace core::game;
+
+namespace {
+
+/// No best move in a TranspositionEntry.
+uint8_t const s_no_move = 0xFF;
+
+/// A state reached by an attack (or the start of a turn), with its
+/// probability; states that are reached by different rolls are merged.
+struct Outcome {
+    DuelState state;
+    DuelResult result;
+    uint64_t key;
+    double probability;
+};
+
+uint64_t mixIn(uint64_t h, int64_t value) {
+    // FNV-1a over the whole value.
+    h ^= static_cast<uint64_t>(value);
+    return h * 0x100000001B3ULL;
+}
+
+uint64_t mixInFighter(uint64_t h, FighterState const &fs) {
+    h = mixIn(h, fs.cur_ap);
+    h = mixIn(h, fs.cur_sp);
+    h = mixIn(h, fs.cur_life);
+    h = mixIn(h, fs.cur_combo);
+    h = mixIn(h, (fs.air ? 1 : 0) | (fs.down ? 2 : 0));
+    h = mixIn(h, static_cast<int64_t>(fs.nth_move_of_the_round));
+    h = mixIn(h, static_cast<int64_t>(fs.moves_performed.size()));
+    for(size_t m : fs.moves_performed) {
+        h = mixIn(h, static_cast<int64_t>(m));
+    }
+    return h;
+}
+
+double terminalValue(DuelResult result) {
+    switch(result) {
+    case DR_C1_WINS: return 1.0;
+    case DR_C2_WINS: return 0.0;
+    default: return 0.5;
+    }
+}
+
+/// \brief The value of a state where the search stops: life counts most, SP
+///        and AP a bit.
+double evaluate(DuelState const &state) {
+    double lead = (state.c1.cur_life - state.c2.cur_life)
+                  + 0.5 * (state.c1.cur_sp - state.c2.cur_sp)
+                  + 0.25 * (state.c1.cur_ap - state.c2.cur_ap);
+    return 1.0 / (1.0 + std::exp(-lead / 8.0));
+}
+
+/// \brief Sorts the candidates by the damage of an average hit, the most
+///        damaging first, then moves the hint (if any) to the front.
+void orderCandidates(std::vector<size_t> &candidates, Character const &c,
+                     int hint) {
+    auto damage = [&c](size_t move) {
+        Move const &m = c.moves[move];
+        return m.isWait() ? -1 : m.damage(4 + c.at, c.at, c.df, 0);
+    };
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [&](size_t a, size_t b) { return damage(a) > damage(b); });
+    auto it = std::find(candidates.begin(), candidates.end(),
+                        static_cast<size_t>(hint));
+    if(hint >= 0 && it != candidates.end()) {
+        std::rotate(candidates.begin(), it, it + 1);
+    }
+}
+
+/**
+ * \brief The search for one decision. Values are the chances of winning for
+ *        'me', which is the first character of the simulated fight.
+ */
+class Search {
+public:
+    Search(Character const &me, Character const &opponent,
+           ExpectiminimaxOptions const &options, TranspositionTable &table)
+      : m_my_plan{false, 0, SPS_POLICY},
+        m_opponent_plan{false, 0, SPS_POLICY},
+        m_me(makeSimulatedCharacter(
+            me,
+            std::make_shared<PlannedAttack>(
+                getAttackExpertSystem(options.policy), m_my_plan),
+            std::make_shared<PlannedDefence>(
+                getDefenceExpertSystem(options.policy), m_my_plan))),
+        m_opponent(makeSimulatedCharacter(
+            opponent,
+            std::make_shared<PlannedAttack>(
+                getAttackExpertSystem(options.policy), m_opponent_plan),
+            std::make_shared<PlannedDefence>(
+                getDefenceExpertSystem(options.policy), m_opponent_plan))),
+        m_duel(m_me, m_opponent, nullptr, &m_dice),
+        m_table(table),
+        m_options(options),
+        m_deadline(std::chrono::steady_clock::now()
+                   + std::chrono::microseconds(static_cast<long long>(
+                       options.milliseconds * 1000.0))),
+        m_aborted(false),
+        m_nodes(0) {}
+
+    /// \brief Chooses the best of our candidates at the root by iterative
+    ///        deepening. If 'forced_move' is not negative, the opponent
+    ///        attacks with it first and the candidates are counters.
+    size_t chooseMove(DuelState const &root, std::vector<size_t> candidates,
+                      int forced_move) {
+        orderCandidates(candidates, *m_me, -1);
+        size_t best = candidates.front();
+        for(int depth = 1; depth <= m_options.max_depth; ++depth) {
+            // The best move of the last iteration goes first.
+            orderCandidates(candidates, *m_me, static_cast<int>(best));
+            size_t iteration_best = best;
+            double v = decide(root, candidates, m_my_plan, forced_move, true,
+                              depth, 0.0, 1.0, iteration_best);
+            if(m_aborted) {
+                break;
+            }
+            best = iteration_best;
+            // Nothing more to learn if the outcome is certain.
+            if(v <= 0.0 || v >= 1.0) {
+                break;
+            }
+        }
+        return best;
+    }
+
+private:
+    /// \brief Returns the value of a state.
+    double value(DuelState const &state, int depth, double alpha,
+                 double beta) {
+        if(depth <= 0 || timeUp()) {
+            return evaluate(state);
+        }
+        uint64_t key = hashDuelState(state);
+        int hint = -1;
+        if(TranspositionEntry const *e = m_table.find(key)) {
+            hint = e->best_move == s_no_move ? -1 : e->best_move;
+            if(e->depth >= depth) {
+                if(e->bound == TB_EXACT
+                   || (e->bound == TB_LOWER && e->value >= beta)
+                   || (e->bound == TB_UPPER && e->value <= alpha)) {
+                    return e->value;
+                }
+            }
+        }
+
+        double v = 0.0;
+        size_t best = s_no_move;
+        if(state.phase != DP_ATTACK) {
+            // A turn starts: only the dice and the policy are involved.
+            std::vector<Outcome> outcomes;
+            expand(state, outcomes);
+            v = chance(outcomes, depth, alpha, beta);
+        }
+        else {
+            bool mine = state.c1_attacks;
+            Character const &model = mine ? *m_me : *m_opponent;
+            std::vector<size_t> candidates = getAttackCandidates(
+                model, mine ? state.c1 : state.c2, state.far);
+            orderCandidates(candidates, model, hint);
+            v = decide(state, candidates, mine ? m_my_plan : m_opponent_plan,
+                       -1, mine, depth, alpha, beta, best);
+        }
+        if(!m_aborted) {
+            TranspositionEntry entry;
+            entry.key = key;
+            entry.value = static_cast<float>(v);
+            entry.depth = static_cast<int8_t>(depth);
+            entry.bound = v <= alpha ? TB_UPPER
+                          : (v >= beta ? TB_LOWER : TB_EXACT);
+            entry.best_move = static_cast<uint8_t>(best);
+            m_table.store(entry);
+        }
+        return v;
+    }
+
+    /// \brief Tries the ordered candidates with the plan, maximizing or
+    ///        minimizing; the best one is returned in 'best'. The opponent
+    ///        attacks with 'forced_move' first if it is not negative.
+    double decide(DuelState const &state,
+                  std::vector<size_t> const &candidates, MovePlan &plan,
+                  int forced_move, bool maximizing, int depth,
+                  double alpha, double beta, size_t &best) {
+        double best_value = maximizing ? -1.0 : 2.0;
+        std::vector<Outcome> outcomes;
+        for(size_t move : candidates) {
+            plan.armed = true;
+            plan.move = move;
+            if(forced_move >= 0) {
+                m_opponent_plan.armed = true;
+                m_opponent_plan.move = static_cast<size_t>(forced_move);
+            }
+            expand(state, outcomes);
+            plan.armed = false;
+            m_opponent_plan.armed = false;
+            double v = chance(outcomes, depth - 1, alpha, beta);
+            if(maximizing ? (v > best_value) : (v < best_value)) {
+                best_value = v;
+                best = move;
+            }
+            if(maximizing) {
+                alpha = std::max(alpha, v);
+            }
+            else {
+                beta = std::min(beta, v);
+            }
+            if(alpha >= beta || m_aborted) {
+                break;
+            }
+        }
+        return best_value;
+    }
+
+    /// \brief Returns the expected value of the outcomes; the window of each
+    ///        outcome is narrowed so that the search can stop as soon as the
+    ///        expectation is known to be out of [alpha, beta].
+    double chance(std::vector<Outcome> const &outcomes, int depth,
+                  double alpha, double beta) {
+        double sum = 0.0;
+        double remaining = 1.0;
+        for(auto const &o : outcomes) {
+            remaining -= o.probability;
+            double v = 0.0;
+            if(o.result != DR_ONGOING) {
+                v = terminalValue(o.result);
+            }
+            else {
+                double low = (alpha - sum - remaining) / o.probability;
+                double high = (beta - sum) / o.probability;
+                v = value(o.state, depth, std::max(0.0, low),
+                          std::min(1.0, high));
+            }
+            sum += o.probability * v;
+            if(sum + remaining <= alpha) {
+                return sum + remaining;
+            }
+            if(sum >= beta) {
+                return sum;
+            }
+        }
+        return sum;
+    }
+
+    /// \brief Runs the next step of the fight from the state with every
+    ///        possible roll of the dice, and collects where it leads.
+    void expand(DuelState const &state, std::vector<Outcome> &outcomes) {
+        outcomes.clear();
+        do {
+            m_dice.rewind();
+            m_duel.setState(state);
+            m_duel.step();
+            double p = m_dice.probability();
+            DuelResult result = m_duel.result();
+            DuelState next;
+            uint64_t key = static_cast<uint64_t>(result);
+            if(result == DR_ONGOING) {
+                next = m_duel.getState();
+                key = hashDuelState(next);
+            }
+            auto it = std::find_if(outcomes.begin(), outcomes.end(),
+                [&](Outcome const &o) {
+                    return o.result == result && o.key == key;
+                });
+            if(it != outcomes.end()) {
+                it->probability += p;
+            }
+            else {
+                outcomes.push_back(Outcome{next, result, key, p});
+            }
+        } while(m_dice.advance());
+        // The likeliest first, so that the expectation is bounded early.
+        std::sort(outcomes.begin(), outcomes.end(),
+                  [](Outcome const &a, Outcome const &b) {
+                      return a.probability > b.probability;
+                  });
+    }
+
+    /// \brief Checks the clock every now and then.
+    bool timeUp() {
+        if(!m_aborted && m_options.milliseconds > 0.0
+           && (++m_nodes & 63) == 0
+           && std::chrono::steady_clock::now() >= m_deadline) {
+            m_aborted = true;
+        }
+        return m_aborted;
+    }
+
+    /// Our plan; the controls of the simulated characters read the plans.
+    MovePlan m_my_plan;
+    /// The plan of the opponent.
+    MovePlan m_opponent_plan;
+    /// The simulated characters.
+    std::shared_ptr<Character> m_me;
+    std::shared_ptr<Character> m_opponent;
+    /// The dice enumerating the rolls.
+    ScriptedDiceSource m_dice;
+    /// The simulated fight.
+    Duel m_duel;
+    /// The table of searched states.
+    TranspositionTable &m_table;
+    /// The parameters.
+    ExpectiminimaxOptions const &m_options;
+    /// When to stop.
+    std::chrono::steady_clock::time_point m_deadline;
+    /// Set when the time ran out.
+    bool m_aborted;
+    /// Nodes searched, to check the clock.
+    size_t m_nodes;
+};
+
+/// \brief Returns the state of the fight seen from 'me', as the first
+///        character.
+DuelState makeRoot(Character const &me, Character const &opponent, bool far,
+                   bool my_attack) {
+    DuelState root;
+    root.c1 = getFighterState(me);
+    root.c2 = getFighterState(opponent);
+    root.far = far;
+    // Past the first two turns, so that AP are restored at every turn.
+    root.turn_counter = 2;
+    root.c1_attacks = my_attack;
+    root.phase = DP_ATTACK;
+    return root;
+}
+
+}
+
+ExpectiminimaxOptions::ExpectiminimaxOptions()
+  : milliseconds(20.0), max_depth(8), policy(7), table_bits(16) {}
+
+TranspositionTable::TranspositionTable(unsigned bits)
+  : m_entries(size_t(1) << bits, TranspositionEntry{0, 0.0f, 0, TB_NONE, 0}),
+    m_mask((uint64_t(1) << bits) - 1), m_lookups(0), m_hits(0) {}
+
+TranspositionEntry const * TranspositionTable::find(uint64_t key) const {
+    ++m_lookups;
+    TranspositionEntry const &e = m_entries[key & m_mask];
+    if(e.bound == TB_NONE || e.key != key) {
+        return nullptr;
+    }
+    ++m_hits;
+    return &e;
+}
+
+void TranspositionTable::store(TranspositionEntry const &entry) {
+    TranspositionEntry &e = m_entries[entry.key & m_mask];
+    if(e.bound == TB_NONE || e.key != entry.key || entry.depth >= e.depth) {
+        e = entry;
+    }
+}
+
+uint64_t hashDuelState(DuelState const &state) {
+    uint64_t h = 0xCBF29CE484222325ULL;
+    h = mixInFighter(h, state.c1);
+    h = mixInFighter(h, state.c2);
+    h = mixIn(h, state.far ? 1 : 0);
+    // The turn counter only matters for the first two turns.
+    h = mixIn(h, std::min(state.turn_counter, 2));
+    h = mixIn(h, state.c1_attacks ? 1 : 0);
+    h = mixIn(h, static_cast<int64_t>(state.phase));
+    // Spread the bits, since the table uses the low ones.
+    h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+    return h ^ (h >> 31);
+}
+
+// --- ATTACK
+
+ExpectiminimaxAttack::ExpectiminimaxAttack(ExpectiminimaxOptions const &options)
+  : m_options(options), m_policy(getAttackExpertSystem(options.policy)) {}
+
+ExpectiminimaxAttack::~ExpectiminimaxAttack() {}
+
+char const * const ExpectiminimaxAttack::getName() const {
+    return "Expectiminimax";
+}
+
+std::shared_ptr<TranspositionTable> ExpectiminimaxAttack::getTable(
+    Character const &me) {
+    std::lock_guard<std::mutex> protect(m_content_mutex);
+    std::shared_ptr<TranspositionTable> &table = m_tables[me.uid];
+    if(!table) {
+        table = std::make_shared<TranspositionTable>(m_options.table_bits);
+    }
+    return table;
+}
+
+int ExpectiminimaxAttack::shouldSpendAPToGainSP(Character const &me,
+                                                Character const &opponent,
+                                                bool far) {
+    return m_policy->shouldSpendAPToGainSP(me, opponent, far);
+}
+
+bool ExpectiminimaxAttack::shouldSpendAPToFallStanding(
+    Character const &me, Character const &opponent, bool far) {
+    return m_policy->shouldSpendAPToFallStanding(me, opponent, far);
+}
+
+Move const & ExpectiminimaxAttack::getNextMove(Character const &me,
+                                               Character const &opponent,
+                                               bool far) {
+    std::vector<size_t> candidates = getAttackCandidates(
+        me, getFighterState(me), far);
+    if(candidates.size() == 1) {
+        return me.moves[candidates.front()];
+    }
+    std::shared_ptr<TranspositionTable> table = getTable(me);
+    Search search(me, opponent, m_options, *table);
+    size_t move = search.chooseMove(makeRoot(me, opponent, far, true),
+                                    candidates, -1);
+    return me.moves[move];
+}
+
+bool ExpectiminimaxAttack::shouldSpendSPToLowerAPCost(
+    Character const &me, Character const &opponent, bool far,
+    Move const &my_move, int current_ap_cost) {
+    return m_policy->shouldSpendSPToLowerAPCost(me, opponent, far, my_move,
+                                                current_ap_cost);
+}
+
+bool ExpectiminimaxAttack::shouldSpendSPToConcatenate(
+    Character const &me, Character const &opponent, bool far,
+    Move const &my_move) {
+    return m_policy->shouldSpendSPToConcatenate(me, opponent, far, my_move);
+}
+
+bool ExpectiminimaxAttack::shouldSpendSPForUltraAgility(
+    Character const &me, Character const &opponent, bool far,
+    Move const &my_move) {
+    return m_policy->shouldSpendSPForUltraAgility(me, opponent, far, my_move);
+}
+
+bool ExpectiminimaxAttack::shouldSpendSPToBoostAttack(
+    Character const &me, Character const &opponent, bool far,
+    Move const &my_move) {
+    return m_policy->shouldSpendSPToBoostAttack(me, opponent, far, my_move);
+}
+
+bool ExpectiminimaxAttack::shouldSpendSPToBoostDamage(
+    Character const &me, Character const &opponent, bool far,
+    Move const &my_move) {
+    return m_policy->shouldSpendSPToBoostDamage(me, opponent, far, my_move);
+}
+
+void ExpectiminimaxAttack::updateAfterMove(Character const &,
+                                           Character const &,
+                                           Move const &, bool) {}
+
+void ExpectiminimaxAttack::updateAfterMatch(Character const &me,
+                                            Character const &, bool) {
+    std::lock_guard<std::mutex> protect(m_content_mutex);
+    m_tables.erase(me.uid);
+}
+
+void ExpectiminimaxAttack::forgetMatch(Character const &me) {
+    std::lock_guard<std::mutex> protect(m_content_mutex);
+    m_tables.erase(me.uid);
+}
+
+// --- DEFENCE
+
+ExpectiminimaxDefence::ExpectiminimaxDefence(
+    ExpectiminimaxOptions const &options)
+  : m_options(options), m_policy(getDefenceExpertSystem(options.policy)) {}
+
+ExpectiminimaxDefence::~ExpectiminimaxDefence() {}
+
+char const * const ExpectiminimaxDefence::getName() const {
+    return "Expectiminimax";
+}
+
+std::shared_ptr<TranspositionTable> ExpectiminimaxDefence::getTable(
+    Character const &me) {
+    std::lock_guard<std::mutex> protect(m_content_mutex);
+    std::shared_ptr<TranspositionTable> &table = m_tables[me.uid];
+    if(!table) {
+        table = std::make_shared<TranspositionTable>(m_options.table_bits);
+    }
+    return table;
+}
+
+Move const & ExpectiminimaxDefence::getCounterMove(Character const &me,
+                                                   Character const &opponent,
+                                                   bool far,
+                                                   Move const &opponent_move) {
+    std::vector<size_t> candidates = getCounterCandidates(
+        me, getFighterState(me), far);
+    if(candidates.size() == 1) {
+        return me.moves[candidates.front()];
+    }
+    DuelState root = makeRoot(me, opponent, far, false);
+    // The attack has already been paid for; give the cost back so that the
+    // search can replay it. SP spent to lower the cost is counted as AP.
+    root.c2.cur_ap += opponent_move.apCost(far, false);
+    if(opponent_move.isSuper()) {
+        root.c2.cur_sp += 4;
+    }
+    std::shared_ptr<TranspositionTable> table = getTable(me);
+    int forced_move = 0;
+    for(size_t i = 0; i < opponent.moves.size(); ++i) {
+        if(opponent.moves[i] == opponent_move) {
+            forced_move = static_cast<int>(i);
+            break;
+        }
+    }
+    Search search(me, opponent, m_options, *table);
+    return me.moves[search.chooseMove(root, candidates, forced_move)];
+}
+
+bool ExpectiminimaxDefence::shouldSpendSPToComboBreak(
+    Character const &me, Character const &opponent, bool far,
+    Move const &opponent_move) {
+    return m_policy->shouldSpendSPToComboBreak(me, opponent, far,
+                                               opponent_move);
+}
+
+bool ExpectiminimaxDefence::shouldSpendSPToLowerAPCost(
+    Character const &me, Character const &opponent, bool far,
+    Move const &my_move, int current_ap_cost) {
+    return m_policy->shouldSpendSPToLowerAPCost(me, opponent, far, my_move,
+                                                current_ap_cost);
+}
+
+bool ExpectiminimaxDefence::shouldSpendSPForUltraAgility(
+    Character const &me, Character const &opponent, bool far,
+    Move const &my_move) {
+    return m_policy->shouldSpendSPForUltraAgility(me, opponent, far, my_move);
+}
+
+bool ExpectiminimaxDefence::shouldSpendSPToBoostDefence(
+    Character const &me, Character const &opponent, bool far,
+    Move const &my_move) {
+    return m_policy->shouldSpendSPToBoostDefence(me, opponent, far, my_move);
+}
+
+bool ExpectiminimaxDefence::shouldSpendSPToBoostCounterDamage(
+    Character const &me, Character const &opponent, bool far,
+    Move const &my_move) {
+    return m_policy->shouldSpendSPToBoostCounterDamage(me, opponent, far,
+                                                       my_move);
+}
+
+void ExpectiminimaxDefence::updateAfterMove(Character const &,
+                                            Character const &,
+                                            Move const &, bool) {}
+
+void ExpectiminimaxDefence::updateAfterMatch(Character const &me,
+                                             Character const &, bool) {
+    std::lock_guard<std::mutex> protect(m_content_mutex);
+    m_tables.erase(me.uid);
+}
+
+void ExpectiminimaxDefence::forgetMatch(Character const &me) {
+    std::lock_guard<std::mutex> protect(m_content_mutex);
+    m_tables.erase(me.uid);
+}
+
+}
+}
@@ -0,0 +1,400 @@
+// Copyright 2015 Dario Domizioli
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "core/ctrl/MCTSCtrl.h"
+#include "core/ctrl/ExpertSystemCtrl.h"
+#include "core/game/Move.h"
+#include "core/game/Character.h"
+#include "core/game/Dice.h"
+#include "core/game/Duel.h"
+#include "core/sim/ThreadPool.h"
+
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+namespace core {
+namespace ctrl {
+
+using namespace core::game;
+
+namespace {
+
+/// A candidate decision and its statistics.
+struct Arm {
+    size_t move;
+    SPStyle style;
+    size_t visits;
+    double value;
+};
+
+/// What the search starts from: the fight with 'me' as first character, and
+/// the opponent's attack to answer when defending.
+struct SearchRoot {
+    Character const *me;
+    Character const *opponent;
+    DuelState state;
+    bool defending;
+    size_t opponent_move;
+};
+
+void addArms(std::vector<Arm> &arms, size_t move, Character const &me) {
+    arms.push_back(Arm{move, SPS_POLICY, 0, 0.0});
+    if(me.cur_sp > 0 && !me.moves[move].isWait()) {
+        arms.push_back(Arm{move, SPS_NEVER, 0, 0.0});
+        arms.push_back(Arm{move, SPS_ALWAYS, 0, 0.0});
+    }
+}
+
+size_t selectArm(std::vector<Arm> const &arms, size_t total_visits,
+                 double exploration) {
+    size_t best = 0;
+    double best_score = -1.0;
+    double log_total = std::log(static_cast<double>(total_visits) + 1.0);
+    for(size_t i = 0; i < arms.size(); ++i) {
+        if(arms[i].visits == 0) {
+            return i;
+        }
+        double n = static_cast<double>(arms[i].visits);
+        double score = arms[i].value / n
+                       + exploration * std::sqrt(log_total / n);
+        if(score > best_score) {
+            best_score = score;
+            best = i;
+        }
+    }
+    return best;
+}
+
+/// \brief Runs the rollouts and returns the index of the chosen arm.
+size_t search(std::vector<Arm> &arms, SearchRoot const &root,
+              MCTSOptions const &options, sim::ThreadPool &pool) {
+    if(arms.size() == 1) {
+        return 0;
+    }
+    unsigned long seed = 0;
+    if(true) { // Just to have a scope
+        std::lock_guard<std::mutex> lock(getRandomGenMutex());
+        seed = getRandomGenerator()();
+    }
+    size_t max_rollouts = options.rollouts;
+    if(max_rollouts == 0 && options.milliseconds <= 0.0) {
+        max_rollouts = arms.size();
+    }
+    auto const deadline = std::chrono::steady_clock::now()
+        + std::chrono::microseconds(
+            static_cast<long long>(options.milliseconds * 1000.0));
+
+    std::mutex arms_mutex;
+    size_t started = 0;
+    pool.run([&](unsigned worker) {
+        MovePlan my_plan{false, 0, SPS_POLICY};
+        MovePlan opponent_plan{false, root.opponent_move, SPS_POLICY};
+        std::shared_ptr<Character> me = makeSimulatedCharacter(
+            *root.me,
+            std::make_shared<PlannedAttack>(
+                getAttackExpertSystem(options.policy), my_plan),
+            std::make_shared<PlannedDefence>(
+                getDefenceExpertSystem(options.policy), my_plan));
+        std::shared_ptr<Character> opponent = makeSimulatedCharacter(
+            *root.opponent,
+            std::make_shared<PlannedAttack>(
+                getAttackExpertSystem(options.policy), opponent_plan),
+            std::make_shared<PlannedDefence>(
+                getDefenceExpertSystem(options.policy), opponent_plan));
+        CounterDiceSource dice(seed, static_cast<uint64_t>(worker) << 40);
+        Duel duel(me, opponent, nullptr, &dice);
+
+        while(true) {
+            size_t chosen = 0;
+            if(true) { // Just to have a scope
+                std::lock_guard<std::mutex> lock(arms_mutex);
+                if((max_rollouts > 0 && started >= max_rollouts)
+                   || (options.milliseconds > 0.0
+                       && std::chrono::steady_clock::now() >= deadline)) {
+                    break;
+                }
+                chosen = selectArm(arms, started, options.exploration);
+                // Counting the visit now steers the other workers elsewhere
+                // until the value comes in.
+                arms[chosen].visits += 1;
+                ++started;
+            }
+            my_plan.armed = true;
+            my_plan.move = arms[chosen].move;
+            my_plan.style = arms[chosen].style;
+            opponent_plan.armed = root.defending;
+            duel.setState(root.state);
+            duel.step();
+            my_plan.armed = false;
+            opponent_plan.armed = false;
+            size_t steps = 1;
+            while(steps < options.max_steps && duel.step()) {
+                ++steps;
+            }
+            double value = 0.5;
+            switch(duel.result()) {
+            case DR_C1_WINS: value = 1.0; break;
+            case DR_C2_WINS: value = 0.0; break;
+            default: break;
+            }
+            std::lock_guard<std::mutex> lock(arms_mutex);
+            arms[chosen].value += value;
+        }
+    });
+
+    size_t best = 0;
+    for(size_t i = 1; i < arms.size(); ++i) {
+        if(arms[i].visits > arms[best].visits
+           || (arms[i].visits == arms[best].visits
+               && arms[i].value > arms[best].value)) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+}
+
+MCTSOptions::MCTSOptions()
+  : rollouts(256), milliseconds(0.0), exploration(0.7), policy(7),
+    max_steps(400), threads(1) {}
+
+// --- ATTACK
+
+MCTSAttack::MCTSAttack(MCTSOptions const &options)
+  : m_options(options),
+    m_pool(std::make_shared<sim::ThreadPool>(options.threads)),
+    m_policy(getAttackExpertSystem(options.policy)) {}
+
+MCTSAttack::~MCTSAttack() {}
+
+char const * const MCTSAttack::getName() const { return "MCTS"; }
+
+bool MCTSAttack::followPlan(Character const &me, bool policy_answer) {
+    std::lock_guard<std::mutex> protect(m_content_mutex);
+    auto it = m_plans.find(me.uid);
+    return applyStyle(it == m_plans.end() ? SPS_POLICY : it->second,
+                      policy_answer);
+}
+
+int MCTSAttack::shouldSpendAPToGainSP(Character const &me,
+                                      Character const &opponent,
+                                      bool far) {
+    return m_policy->shouldSpendAPToGainSP(me, opponent, far);
+}
+
+bool MCTSAttack::shouldSpendAPToFallStanding(Character const &me,
+                                             Character const &opponent,
+                                             bool far) {
+    return m_policy->shouldSpendAPToFallStanding(me, opponent, far);
+}
+
+Move const & MCTSAttack::getNextMove(Character const &me,
+                                     Character const &opponent,
+                                     bool far) {
+    std::vector<Arm> arms;
+    for(size_t move : getAttackCandidates(me, getFighterState(me), far)) {
+        addArms(arms, move, me);
+    }
+
+    SearchRoot root;
+    root.me = &me;
+    root.opponent = &opponent;
+    root.state.c1 = getFighterState(me);
+    root.state.c2 = getFighterState(opponent);
+    root.state.far = far;
+    // Past the first two turns, so that AP are restored at every turn.
+    root.state.turn_counter = 2;
+    root.state.c1_attacks = true;
+    root.state.phase = DP_ATTACK;
+    root.defending = false;
+    root.opponent_move = 0;
+    Arm const &chosen = arms[search(arms, root, m_options, *m_pool)];
+
+    std::lock_guard<std::mutex> protect(m_content_mutex);
+    m_plans[me.uid] = chosen.style;
+    return me.moves[chosen.move];
+}
+
+bool MCTSAttack::shouldSpendSPToLowerAPCost(Character const &me,
+                                            Character const &opponent,
+                                            bool far,
+                                            Move const &my_move,
+                                            int current_ap_cost) {
+    return followPlan(me, m_policy->shouldSpendSPToLowerAPCost(
+        me, opponent, far, my_move, current_ap_cost));
+}
+
+bool MCTSAttack::shouldSpendSPToConcatenate(Character const &me,
+                                            Character const &opponent,
+                                            bool far,
+                                            Move const &my_move) {
+    return followPlan(me, m_policy->shouldSpendSPToConcatenate(
+        me, opponent, far, my_move));
+}
+
+bool MCTSAttack::shouldSpendSPForUltraAgility(Character const &me,
+                                              Character const &opponent,
+                                              bool far,
+                                              Move const &my_move) {
+    return followPlan(me, m_policy->shouldSpendSPForUltraAgility(
+        me, opponent, far, my_move));
+}
+
+bool MCTSAttack::shouldSpendSPToBoostAttack(Character const &me,
+                                            Character const &opponent,
+                                            bool far,
+                                            Move const &my_move) {
+    return followPlan(me, m_policy->shouldSpendSPToBoostAttack(
+        me, opponent, far, my_move));
+}
+
+bool MCTSAttack::shouldSpendSPToBoostDamage(Character const &me,
+                                            Character const &opponent,
+                                            bool far,
+                                            Move const &my_move) {
+    return followPlan(me, m_policy->shouldSpendSPToBoostDamage(
+        me, opponent, far, my_move));
+}
+
+void MCTSAttack::updateAfterMove(Character const &, Character const &,
+                                 Move const &, bool) {}
+
+void MCTSAttack::updateAfterMatch(Character const &me, Character const &,
+                                  bool) {
+    std::lock_guard<std::mutex> protect(m_content_mutex);
+    m_plans.erase(me.uid);
+}
+
+void MCTSAttack::forgetMatch(Character const &me) {
+    std::lock_guard<std::mutex> protect(m_content_mutex);
+    m_plans.erase(me.uid);
+}
+
+// --- DEFENCE
+
+MCTSDefence::MCTSDefence(MCTSOptions const &options)
+  : m_options(options),
+    m_pool(std::make_shared<sim::ThreadPool>(options.threads)),
+    m_policy(getDefenceExpertSystem(options.policy)) {}
+
+MCTSDefence::~MCTSDefence() {}
+
+char const * const MCTSDefence::getName() const { return "MCTS"; }
+
+bool MCTSDefence::followPlan(Character const &me, bool policy_answer) {
+    std::lock_guard<std::mutex> protect(m_content_mutex);
+    auto it = m_plans.find(me.uid);
+    return applyStyle(it == m_plans.end() ? SPS_POLICY : it->second,
+                      policy_answer);
+}
+
+Move const & MCTSDefence::getCounterMove(Character const &me,
+                                         Character const &opponent,
+                                         bool far,
+                                         Move const &opponent_move) {
+    std::vector<Arm> arms;
+    for(size_t move : getCounterCandidates(me, getFighterState(me), far)) {
+        addArms(arms, move, me);
+    }
+
+    SearchRoot root;
+    root.me = &me;
+    root.opponent = &opponent;
+    root.state.c1 = getFighterState(me);
+    root.state.c2 = getFighterState(opponent);
+    root.state.far = far;
+    root.state.turn_counter = 2;
+    root.state.c1_attacks = false;
+    root.state.phase = DP_ATTACK;
+    root.defending = true;
+    root.opponent_move = 0;
+    for(size_t i = 0; i < opponent.moves.size(); ++i) {
+        if(opponent.moves[i] == opponent_move) {
+            root.opponent_move = i;
+            break;
+        }
+    }
+    // The attack has already been paid for; give the cost back so that the
+    // rollouts can replay it. SP spent to lower the cost is counted as AP.
+    root.state.c2.cur_ap += opponent_move.apCost(far, false);
+    if(opponent_move.isSuper()) {
+        root.state.c2.cur_sp += 4;
+    }
+    Arm const &chosen = arms[search(arms, root, m_options, *m_pool)];
+
+    std::lock_guard<std::mutex> protect(m_content_mutex);
+    m_plans[me.uid] = chosen.style;
+    return me.moves[chosen.move];
+}
+
+bool MCTSDefence::shouldSpendSPToComboBreak(Character const &me,
+                                            Character const &opponent,
+                                            bool far,
+                                            Move const &opponent_move) {
+    // This comes before the counter is chosen, so it is not planned.
+    return m_policy->shouldSpendSPToComboBreak(me, opponent, far,
+                                               opponent_move);
+}
+
+bool MCTSDefence::shouldSpendSPToLowerAPCost(Character const &me,
+                                             Character const &opponent,
+                                             bool far,
+                                             Move const &my_move,
+                                             int current_ap_cost) {
+    return followPlan(me, m_policy->shouldSpendSPToLowerAPCost(
+        me, opponent, far, my_move, current_ap_cost));
+}
+
+bool MCTSDefence::shouldSpendSPForUltraAgility(Character const &me,
+                                               Character const &opponent,
+                                               bool far,
+                                               Move const &my_move) {
+    return followPlan(me, m_policy->shouldSpendSPForUltraAgility(
+        me, opponent, far, my_move));
+}
+
+bool MCTSDefence::shouldSpendSPToBoostDefence(Character const &me,
+                                              Character const &opponent,
+                                              bool far,
+                                              Move const &my_move) {
+    return followPlan(me, m_policy->shouldSpendSPToBoostDefence(
+        me, opponent, far, my_move));
+}
+
+bool MCTSDefence::shouldSpendSPToBoostCounterDamage(Character const &me,
+                                                    Character const &opponent,
+                                                    bool far,
+                                                    Move const &my_move) {
+    return followPlan(me, m_policy->shouldSpendSPToBoostCounterDamage(
+        me, opponent, far, my_move));
+}
+
+void MCTSDefence::updateAfterMove(Character const &, Character const &,
+                                  Move const &, bool) {}
+
+void MCTSDefence::updateAfterMatch(Character const &me, Character const &,
+                                   bool) {
+    std::lock_guard<std::mutex> protect(m_content_mutex);
+    m_plans.erase(me.uid);
+}
+
+void MCTSDefence::forgetMatch(Character const &me) {
+    std::lock_guard<std::mutex> protect(m_content_mutex);
+    m_plans.erase(me.uid);
+}
+
+}
+}
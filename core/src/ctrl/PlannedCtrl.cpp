@@ -0,0 +1,252 @@
+// Copyright 2015 Dario Domizioli
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "core/ctrl/PlannedCtrl.h"
+#include "core/game/Move.h"
+#include "core/game/Character.h"
+
+namespace core {
+namespace ctrl {
+
+using namespace core::game;
+
+bool applyStyle(SPStyle style, bool policy_answer) {
+    switch(style) {
+    case SPS_NEVER: return false;
+    case SPS_ALWAYS: return true;
+    default: return policy_answer;
+    }
+}
+
+// --- ATTACK
+
+PlannedAttack::PlannedAttack(std::shared_ptr<AttackControl> policy,
+                             MovePlan const &plan)
+  : m_policy(policy), m_plan(plan) {}
+
+PlannedAttack::~PlannedAttack() {}
+
+char const * const PlannedAttack::getName() const { return "Planned"; }
+
+bool PlannedAttack::follow(bool policy_answer) const {
+    return m_plan.armed ? applyStyle(m_plan.style, policy_answer)
+                        : policy_answer;
+}
+
+int PlannedAttack::shouldSpendAPToGainSP(Character const &me,
+                                         Character const &opponent,
+                                         bool far) {
+    return m_policy->shouldSpendAPToGainSP(me, opponent, far);
+}
+
+bool PlannedAttack::shouldSpendAPToFallStanding(Character const &me,
+                                                Character const &opponent,
+                                                bool far) {
+    return m_policy->shouldSpendAPToFallStanding(me, opponent, far);
+}
+
+Move const & PlannedAttack::getNextMove(Character const &me,
+                                        Character const &opponent,
+                                        bool far) {
+    if(m_plan.armed) {
+        return me.moves[m_plan.move];
+    }
+    return m_policy->getNextMove(me, opponent, far);
+}
+
+bool PlannedAttack::shouldSpendSPToLowerAPCost(Character const &me,
+                                               Character const &opponent,
+                                               bool far,
+                                               Move const &my_move,
+                                               int current_ap_cost) {
+    return follow(m_policy->shouldSpendSPToLowerAPCost(
+        me, opponent, far, my_move, current_ap_cost));
+}
+
+bool PlannedAttack::shouldSpendSPToConcatenate(Character const &me,
+                                               Character const &opponent,
+                                               bool far,
+                                               Move const &my_move) {
+    return follow(m_policy->shouldSpendSPToConcatenate(
+        me, opponent, far, my_move));
+}
+
+bool PlannedAttack::shouldSpendSPForUltraAgility(Character const &me,
+                                                 Character const &opponent,
+                                                 bool far,
+                                                 Move const &my_move) {
+    return follow(m_policy->shouldSpendSPForUltraAgility(
+        me, opponent, far, my_move));
+}
+
+bool PlannedAttack::shouldSpendSPToBoostAttack(Character const &me,
+                                               Character const &opponent,
+                                               bool far,
+                                               Move const &my_move) {
+    return follow(m_policy->shouldSpendSPToBoostAttack(
+        me, opponent, far, my_move));
+}
+
+bool PlannedAttack::shouldSpendSPToBoostDamage(Character const &me,
+                                               Character const &opponent,
+                                               bool far,
+                                               Move const &my_move) {
+    return follow(m_policy->shouldSpendSPToBoostDamage(
+        me, opponent, far, my_move));
+}
+
+void PlannedAttack::updateAfterMove(Character const &, Character const &,
+                                    Move const &, bool) {}
+
+void PlannedAttack::updateAfterMatch(Character const &, Character const &,
+                                     bool) {}
+
+// --- DEFENCE
+
+PlannedDefence::PlannedDefence(std::shared_ptr<DefendControl> policy,
+                               MovePlan const &plan)
+  : m_policy(policy), m_plan(plan) {}
+
+PlannedDefence::~PlannedDefence() {}
+
+char const * const PlannedDefence::getName() const { return "Planned"; }
+
+bool PlannedDefence::follow(bool policy_answer) const {
+    return m_plan.armed ? applyStyle(m_plan.style, policy_answer)
+                        : policy_answer;
+}
+
+Move const & PlannedDefence::getCounterMove(Character const &me,
+                                            Character const &opponent,
+                                            bool far,
+                                            Move const &opponent_move) {
+    if(m_plan.armed) {
+        return me.moves[m_plan.move];
+    }
+    return m_policy->getCounterMove(me, opponent, far, opponent_move);
+}
+
+bool PlannedDefence::shouldSpendSPToComboBreak(Character const &me,
+                                               Character const &opponent,
+                                               bool far,
+                                               Move const &opponent_move) {
+    return m_policy->shouldSpendSPToComboBreak(me, opponent, far,
+                                               opponent_move);
+}
+
+bool PlannedDefence::shouldSpendSPToLowerAPCost(Character const &me,
+                                                Character const &opponent,
+                                                bool far,
+                                                Move const &my_move,
+                                                int current_ap_cost) {
+    return follow(m_policy->shouldSpendSPToLowerAPCost(
+        me, opponent, far, my_move, current_ap_cost));
+}
+
+bool PlannedDefence::shouldSpendSPForUltraAgility(Character const &me,
+                                                  Character const &opponent,
+                                                  bool far,
+                                                  Move const &my_move) {
+    return follow(m_policy->shouldSpendSPForUltraAgility(
+        me, opponent, far, my_move));
+}
+
+bool PlannedDefence::shouldSpendSPToBoostDefence(Character const &me,
+                                                 Character const &opponent,
+                                                 bool far,
+                                                 Move const &my_move) {
+    return follow(m_policy->shouldSpendSPToBoostDefence(
+        me, opponent, far, my_move));
+}
+
+bool PlannedDefence::shouldSpendSPToBoostCounterDamage(Character const &me,
+                                                       Character const &opponent,
+                                                       bool far,
+                                                       Move const &my_move) {
+    return follow(m_policy->shouldSpendSPToBoostCounterDamage(
+        me, opponent, far, my_move));
+}
+
+void PlannedDefence::updateAfterMove(Character const &, Character const &,
+                                     Move const &, bool) {}
+
+void PlannedDefence::updateAfterMatch(Character const &, Character const &,
+                                      bool) {}
+
+std::shared_ptr<Character> makeSimulatedCharacter(
+    Character const &c, std::shared_ptr<AttackControl> att,
+    std::shared_ptr<DefendControl> def) {
+    std::shared_ptr<Character> sc = std::make_shared<Character>(
+        c.name, c.ra, c.at, c.df, c.sp, att, def);
+    sc->moves = c.moves;
+    return sc;
+}
+std::vector<size_t> getAttackCandidates(Character const &c,
+                                        FighterState const &fs, bool far) {
+    size_t last_move_index = fs.moves_performed.empty()
+                             ? 0
+                             : fs.moves_performed.back();
+    std::vector<size_t> candidates;
+    size_t wait_move = 0;
+    for(size_t which_move = 0; which_move < c.moves.size(); ++which_move) {
+        Move const &m = c.moves[which_move];
+        if(m.isWait()) {
+            wait_move = which_move;
+            continue;
+        }
+        if(last_move_index == which_move || m.hasReflect()) {
+            continue;
+        }
+        if(m.apCost(far, false) > fs.cur_ap) {
+            continue;
+        }
+        if(m.isSuper() && fs.cur_sp < 4) {
+            continue;
+        }
+        if(!far && !m.isSuper() && m.hasSymbol(MS_DISTANCE)) {
+            continue;
+        }
+        candidates.push_back(which_move);
+    }
+    candidates.push_back(wait_move);
+    return candidates;
+}
+
+std::vector<size_t> getCounterCandidates(Character const &c,
+                                         FighterState const &fs, bool far) {
+    std::vector<size_t> candidates;
+    size_t wait_move = 0;
+    for(size_t which_move = 0; which_move < c.moves.size(); ++which_move) {
+        Move const &m = c.moves[which_move];
+        if(m.isWait()) {
+            wait_move = which_move;
+            continue;
+        }
+        if(far && !m.canHitDistance()) {
+            continue;
+        }
+        if(m.apCost(far, true) > fs.cur_ap) {
+            continue;
+        }
+        if(m.isSuper() && fs.cur_sp < 4) {
+            continue;
+        }
+        candidates.push_back(which_move);
+    }
+    candidates.push_back(wait_move);
+    return candidates;
+}
+
+}
+}
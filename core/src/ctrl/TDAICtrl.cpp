@@ -0,0 +1,325 @@
+// Copyright 2015 Dario Domizioli
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "core/ctrl/TDAICtrl.h"
+#include "core/ctrl/PlannedCtrl.h"
+#include "core/game/Move.h"
+#include "core/game/Character.h"
+#include "core/game/Dice.h"
+#include "core/game/Duel.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+namespace core {
+namespace ctrl {
+
+using namespace core::game;
+
+namespace {
+
+/// \brief The life lead of 'me', squashed between 0 and 1 so that it can be
+///        compared with the move values.
+double lifeLead(Character const &me, Character const &opponent) {
+    return 1.0 / (1.0 + std::exp(-(me.cur_life - opponent.cur_life) / 8.0));
+}
+
+/// \brief Chooses among the candidates: the best known one, or a random one
+///        with probability 'exploration'. Ties are broken at random.
+size_t chooseMove(DecisionMatrix &matrix, std::vector<size_t> const &candidates,
+                  Character const &me, Character const &opponent,
+                  int at_or_df, double exploration) {
+    std::lock_guard<std::mutex> protect(getRandomGenMutex());
+    std::uniform_real_distribution<double> zero_to_one(0.0, 1.0);
+    if(zero_to_one(getRandomGenerator()) < exploration) {
+        std::uniform_int_distribution<size_t> pick(0, candidates.size() - 1);
+        return candidates[pick(getRandomGenerator())];
+    }
+    size_t best = candidates.front();
+    double best_value = -1.0;
+    size_t ties = 0;
+    for(size_t move : candidates) {
+        assert(move < DecisionMatrix::MAX_PARAM_CASES);
+        double value = matrix.getGoodness(opponent.down, opponent.air,
+                                          at_or_df, me.cur_ap, me.cur_sp,
+                                          move);
+        if(value > best_value) {
+            best = move;
+            best_value = value;
+            ties = 1;
+        } else if(value == best_value) {
+            ++ties;
+            std::uniform_int_distribution<size_t> pick(0, ties - 1);
+            if(pick(getRandomGenerator()) == 0) {
+                best = move;
+            }
+        }
+    }
+    return best;
+}
+
+/// \brief Updates a decision towards 'target'.
+void learn(DecisionMatrix &matrix, DecisionRecord const &dr, double target,
+           double rate) {
+    if(target < 0.0) {
+        target = 0.0;
+    } else if(target > 1.0) {
+        target = 1.0;
+    }
+    matrix.learnGoodness(dr.down, dr.air, dr.enemy_at_or_df, dr.own_ap,
+                         dr.own_sp, dr.parameter, target, rate);
+}
+
+/// \brief Called when the move of the current decision has ended: now the
+///        successor of the previous decision is known, so update it (SARSA)
+///        and make the current decision the previous one.
+void endMove(TDTrace &trace, DecisionMatrix &matrix,
+             TDOptions const &options) {
+    if(!trace.has_current) {
+        return;
+    }
+    if(trace.has_previous) {
+        DecisionRecord const &dr = trace.current;
+        double target = matrix.getGoodness(dr.down, dr.air, dr.enemy_at_or_df,
+                                           dr.own_ap, dr.own_sp, dr.parameter)
+                        + options.shaping
+                          * (trace.current_lead - trace.previous_lead);
+        learn(matrix, trace.previous, target, options.learning_rate);
+    }
+    trace.previous = trace.current;
+    trace.previous_lead = trace.current_lead;
+    trace.has_previous = true;
+    trace.has_current = false;
+}
+
+/// \brief Records a new decision in the trace. A decision whose move never
+///        ended is ended first: Duel does not report the end of a wait, so
+///        it ends when the next decision is made.
+void decide(TDTrace &trace, DecisionMatrix &matrix, TDOptions const &options,
+            Character const &me, Character const &opponent, int at_or_df,
+            size_t move) {
+    endMove(trace, matrix, options);
+    trace.current = DecisionRecord{opponent.down, opponent.air, at_or_df,
+                                   me.cur_ap, me.cur_sp, move, 0.0};
+    trace.current_lead = lifeLead(me, opponent);
+    trace.has_current = true;
+}
+
+/// \brief Called at the end of the fight: the last decision is updated
+///        towards the outcome.
+void endMatch(TDTrace &trace, DecisionMatrix &matrix,
+              TDOptions const &options, bool has_won) {
+    endMove(trace, matrix, options);
+    if(trace.has_previous) {
+        learn(matrix, trace.previous, has_won ? 1.0 : 0.0,
+              options.learning_rate);
+    }
+}
+
+} // close anonymous namespace
+
+TDOptions::TDOptions()
+  : learning_rate(0.2), shaping(1.0), exploration(0.1) {}
+
+// --- ATTACK
+
+TDAIAttack::TDAIAttack(TDOptions const &options)
+  : EvolveAIAttack(), m_options(options) {}
+
+TDAIAttack::~TDAIAttack() {}
+
+char const * const TDAIAttack::getName() const { return "TD"; }
+
+Move const & TDAIAttack::getNextMove(Character const &me,
+                                     Character const &opponent,
+                                     bool far) {
+    std::vector<size_t> candidates =
+        getAttackCandidates(me, getFighterState(me), far);
+
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> protect(m_td_mutex);
+
+    size_t which_move = chooseMove(m_value_matrix, candidates, me, opponent,
+                                   opponent.df, m_options.exploration);
+    decide(m_traces[me.uid], m_value_matrix, m_options, me, opponent,
+           opponent.df, which_move);
+    return me.moves[which_move];
+}
+
+void TDAIAttack::updateAfterMove(Character const &me,
+                                 Character const &opponent,
+                                 Move const &move, bool successful) {
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> protect(m_td_mutex);
+
+    endMove(m_traces[me.uid], m_value_matrix, m_options);
+}
+
+void TDAIAttack::updateAfterMatch(Character const &me,
+                                  Character const &opponent,
+                                  bool has_won) {
+    EvolveAIAttack::updateAfterMatch(me, opponent, has_won);
+
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> protect(m_td_mutex);
+
+    endMatch(m_traces[me.uid], m_value_matrix, m_options, has_won);
+    m_traces.erase(me.uid);
+}
+
+void TDAIAttack::forgetMatch(Character const &me) {
+    EvolveAIAttack::forgetMatch(me);
+
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> protect(m_td_mutex);
+
+    m_traces.erase(me.uid);
+}
+
+double TDAIAttack::getConvergence() {
+    double sp_convergence = EvolveAIAttack::getConvergence();
+
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> protect(m_td_mutex);
+
+    return std::max(sp_convergence, m_value_matrix.getConvergence());
+}
+
+void TDAIAttack::saveState(std::ostream &out) {
+    EvolveAIAttack::saveState(out);
+
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> protect(m_td_mutex);
+
+    m_value_matrix.save(out);
+}
+
+bool TDAIAttack::loadState(std::istream &in) {
+    if(!EvolveAIAttack::loadState(in)) {
+        return false;
+    }
+
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> protect(m_td_mutex);
+
+    return m_value_matrix.load(in);
+}
+
+double TDAIAttack::getValue(Character const &me, Character const &opponent,
+                            size_t move) {
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> protect(m_td_mutex);
+
+    return m_value_matrix.getGoodness(opponent.down, opponent.air, opponent.df,
+                                      me.cur_ap, me.cur_sp, move);
+}
+
+// --- DEFENCE
+
+TDAIDefence::TDAIDefence(TDOptions const &options)
+  : EvolveAIDefence(), m_options(options) {}
+
+TDAIDefence::~TDAIDefence() {}
+
+char const * const TDAIDefence::getName() const { return "TD"; }
+
+Move const & TDAIDefence::getCounterMove(Character const &me,
+                                         Character const &opponent,
+                                         bool far,
+                                         Move const &opponent_move) {
+    std::vector<size_t> candidates =
+        getCounterCandidates(me, getFighterState(me), far);
+
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> protect(m_td_mutex);
+
+    size_t which_move = chooseMove(m_value_matrix, candidates, me, opponent,
+                                   opponent.at, m_options.exploration);
+    decide(m_traces[me.uid], m_value_matrix, m_options, me, opponent,
+           opponent.at, which_move);
+    return me.moves[which_move];
+}
+
+void TDAIDefence::updateAfterMove(Character const &me,
+                                  Character const &opponent,
+                                  Move const &move, bool successful) {
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> protect(m_td_mutex);
+
+    endMove(m_traces[me.uid], m_value_matrix, m_options);
+}
+
+void TDAIDefence::updateAfterMatch(Character const &me,
+                                   Character const &opponent,
+                                   bool has_won) {
+    EvolveAIDefence::updateAfterMatch(me, opponent, has_won);
+
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> protect(m_td_mutex);
+
+    endMatch(m_traces[me.uid], m_value_matrix, m_options, has_won);
+    m_traces.erase(me.uid);
+}
+
+void TDAIDefence::forgetMatch(Character const &me) {
+    EvolveAIDefence::forgetMatch(me);
+
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> protect(m_td_mutex);
+
+    m_traces.erase(me.uid);
+}
+
+double TDAIDefence::getConvergence() {
+    double sp_convergence = EvolveAIDefence::getConvergence();
+
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> protect(m_td_mutex);
+
+    return std::max(sp_convergence, m_value_matrix.getConvergence());
+}
+
+void TDAIDefence::saveState(std::ostream &out) {
+    EvolveAIDefence::saveState(out);
+
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> protect(m_td_mutex);
+
+    m_value_matrix.save(out);
+}
+
+bool TDAIDefence::loadState(std::istream &in) {
+    if(!EvolveAIDefence::loadState(in)) {
+        return false;
+    }
+
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> protect(m_td_mutex);
+
+    return m_value_matrix.load(in);
+}
+
+double TDAIDefence::getValue(Character const &me, Character const &opponent,
+                             size_t move) {
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> protect(m_td_mutex);
+
+    return m_value_matrix.getGoodness(opponent.down, opponent.air, opponent.at,
+                                      me.cur_ap, me.cur_sp, move);
+}
+
+}
+}
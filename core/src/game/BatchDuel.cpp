@@ -0,0 +1,107 @@
+// Copyright 2015 Dario Domizioli
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "core/game/BatchDuel.h"
+#include "core/game/Dice.h"
+
+namespace core {
+namespace game {
+
+namespace {
+
+/// \brief Returns true if the control systems of a character keep no state
+///        between the calls, so that lanes can share its clone.
+bool isStateless(Character const &c) {
+    return ctrl::getExpertSystemTag(*c.actrl) != ctrl::ES_NONE
+           && ctrl::getExpertSystemTag(*c.dctrl) != ctrl::ES_NONE;
+}
+
+} // close anonymous namespace
+
+BatchDuel::BatchDuel(std::shared_ptr<Character> c1,
+                     std::shared_ptr<Character> c2,
+                     size_t lanes, unsigned long seed)
+  : m_dice(new BlockDiceSource(seed)),
+    m_results(lanes, DR_ONGOING) {
+    if(!isStateless(*c1) || !isStateless(*c2)) {
+        for(size_t lane = 0; lane < lanes; ++lane) {
+            m_duels.emplace_back(new Duel(c1, c2, nullptr, m_dice.get()));
+        }
+        return;
+    }
+    m_engine.reset(new Duel(c1, c2, nullptr, m_dice.get()));
+    m_lanes.assign(lanes, m_engine->getState());
+    for(size_t lane = 0; lane < lanes; ++lane) {
+        m_active.push_back(lane);
+    }
+}
+
+BatchDuel::~BatchDuel() {}
+
+void BatchDuel::fight() {
+    if(!m_engine) {
+        for(size_t lane = 0; lane < m_duels.size(); ++lane) {
+            while(m_duels[lane]->step()) {}
+            m_results[lane] = m_duels[lane]->result();
+        }
+        return;
+    }
+    while(!m_active.empty()) {
+        size_t still_active = 0;
+        for(size_t i = 0; i < m_active.size(); ++i) {
+            size_t lane = m_active[i];
+            m_engine->swapState(m_lanes[lane]);
+            bool ongoing = m_engine->step();
+            while(ongoing && m_engine->phase() != DP_TURN_START) {
+                ongoing = m_engine->step();
+            }
+            if(!ongoing) {
+                m_results[lane] = m_engine->result();
+            }
+            m_engine->swapState(m_lanes[lane]);
+            if(ongoing) {
+                m_active[still_active++] = lane;
+            }
+        }
+        m_active.resize(still_active);
+    }
+}
+
+void BatchDuel::conclude() {
+    if(!m_engine) {
+        for(auto &d : m_duels) {
+            d->conclude();
+        }
+        return;
+    }
+    for(size_t lane = 0; lane < m_lanes.size(); ++lane) {
+        m_engine->swapState(m_lanes[lane]);
+        m_engine->conclude();
+        m_engine->swapState(m_lanes[lane]);
+    }
+}
+
+void BatchDuel::abandon() {
+    if(!m_engine) {
+        for(auto &d : m_duels) {
+            d->abandon();
+        }
+        return;
+    }
+    // The lanes share the clones of the engine.
+    m_engine->abandon();
+}
+
+}
+}
@@ -19,13 +19,15 @@
 #include "core/ctrl/ExpertSystemCtrl.h"
 #include "core/ctrl/EvolveAICtrl.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
 #include <iostream>
-#include <sstream>
 
 namespace {
 
 size_t nextUID() {
-    static size_t uid = 0;
+    static std::atomic<size_t> uid(0);
     return uid++;
 }
 
@@ -63,6 +65,7 @@ Character::Character(std::string const &n, int r, int a, int d, SPMode s,
 Character * Character::clone() const {
     Character *new_char = new Character(name, ra, at, df, sp, actrl, dctrl);
     new_char->moves = moves;
+    new_char->best_moves = std::atomic_load(&best_moves);
     return new_char;
 }
 
@@ -74,7 +77,7 @@ Character & Character::addMove(Move const &move) {
 
 void Character::dump(std::ostream &stream) {
     stream << "========================================" << std::endl;
-    stream << name << "    : " << total_points << " points" << std::endl
+    stream << name << "    : " << total_points.load() << " points" << std::endl
            << "--------------------" << std::endl
            << "RA: " << ra << std::endl
            << "AT: " << at << std::endl
@@ -111,25 +114,49 @@ void Character::brief(std::ostream &stream) {
 }
 
 std::shared_ptr<Character> generateRandomCharacter(bool allow_expert_systems) {
-    static size_t counter = 0ULL;
-    std::lock_guard<std::mutex> lock(getRandomGenMutex());
-    std::stringstream ss;
-    ss << "Char" << counter++;
-
-    std::uniform_int_distribution<int> rra(1, 5);
-    int ra = rra(getRandomGenerator());
-    std::uniform_int_distribution<int> rat(1, 6 - ra);
-    int at = rat(getRandomGenerator());
+    static std::atomic<size_t> counter(0);
+    std::string name = "Char" + std::to_string(counter++);
+
+    int ra = 0;
+    int at = 0;
+    SPMode sp = SP_COMBO;
+    int combination = -1;
+    MoveSymbol symbols[8];
+    if(true) { // Just to have a scope
+        // Only the draws need the generator; the AIs are built outside.
+        std::lock_guard<std::mutex> lock(getRandomGenMutex());
+        std::uniform_int_distribution<int> rra(1, 5);
+        ra = rra(getRandomGenerator());
+        std::uniform_int_distribution<int> rat(1, 6 - ra);
+        at = rat(getRandomGenerator());
+
+        std::uniform_int_distribution<int> rsp(SP_BEGIN__, SP_END__ - 1);
+        sp = static_cast<SPMode>(rsp(getRandomGenerator()));
+
+        // If expert systems are allowed, choose 40% Evolving, 60% Expert System
+        if(allow_expert_systems && rra(getRandomGenerator()) >= 3) {
+            std::uniform_int_distribution<int> expert_sys(
+                0, ctrl::getNumExpertSystemsCombinations() - 1);
+            combination = expert_sys(getRandomGenerator());
+        }
+
+        std::uniform_int_distribution<int> rms(MS_BEGIN__, MS_END__ - 1);
+        for(auto &s : symbols) {
+            s = static_cast<MoveSymbol>(rms(getRandomGenerator()));
+        }
+    }
+    return makeRandomCharacter(name, ra, at, sp, combination, symbols);
+}
+
+std::shared_ptr<Character> makeRandomCharacter(std::string const &name,
+                                               int ra, int at, SPMode sp,
+                                               int combination,
+                                               MoveSymbol const symbols[8]) {
     int df = 7 - ra - at;
-    
-    std::uniform_int_distribution<int> rsp(SP_BEGIN__, SP_END__ - 1);
-    SPMode sp = static_cast<SPMode>(rsp(getRandomGenerator()));
 
     std::shared_ptr<ctrl::AttackControl> actrl;
     std::shared_ptr<ctrl::DefendControl> dctrl;
-
-    // If expert systems are allowed, choose 40% Evolving, 60% Expert System
-    if(!allow_expert_systems || rra(getRandomGenerator()) < 3) {
+    if(combination < 0) {
         // Evolving.
         actrl = (sp == SP_COMBO) ? std::make_shared<ctrl::MarkovAIAttack>()
                                  : std::make_shared<ctrl::EvolveAIAttack>();
@@ -137,33 +164,63 @@ std::shared_ptr<Character> generateRandomCharacter(bool allow_expert_systems) {
     }
     else {
         // Expert System.
-        std::uniform_int_distribution<int> expert_sys(
-            0, ctrl::getNumExpertSystemsCombinations() - 1);
-        int combination = expert_sys(getRandomGenerator());
         actrl = ctrl::getAttackExpertSystem(combination);
         dctrl = ctrl::getDefenceExpertSystem(combination);
     }
 
     std::shared_ptr<Character> c = std::make_shared<Character>(
-        ss.str(), ra, at, df, sp, actrl, dctrl);
-
-    std::vector<MoveSymbol> first_move, second_move, third_move, super_move;
-    std::uniform_int_distribution<int> rms(MS_BEGIN__, MS_END__ - 1);
-    first_move.push_back( (MoveSymbol) rms(getRandomGenerator()) );
-    second_move.push_back( (MoveSymbol) rms(getRandomGenerator()) );
-    second_move.push_back( (MoveSymbol) rms(getRandomGenerator()) );
-    third_move.push_back( (MoveSymbol) rms(getRandomGenerator()) );
-    third_move.push_back( (MoveSymbol) rms(getRandomGenerator()) );
-    super_move.push_back( (MoveSymbol) rms(getRandomGenerator()) );
-    super_move.push_back( (MoveSymbol) rms(getRandomGenerator()) );
-    super_move.push_back( (MoveSymbol) rms(getRandomGenerator()) );
-    c->addMove(Move{"First", MT_SPECIAL, first_move});
-    c->addMove(Move{"Second", MT_SPECIAL, second_move});
-    c->addMove(Move{"Third", MT_SPECIAL, third_move});
-    c->addMove(Move{"Super", MT_SUPER, super_move});
-
+        name, ra, at, df, sp, actrl, dctrl);
+    c->addMove(Move{"First", MT_SPECIAL, {symbols[0]}});
+    c->addMove(Move{"Second", MT_SPECIAL, {symbols[1], symbols[2]}});
+    c->addMove(Move{"Third", MT_SPECIAL, {symbols[3], symbols[4]}});
+    c->addMove(Move{"Super", MT_SUPER, {symbols[5], symbols[6], symbols[7]}});
     return c;
 }
 
+std::vector<size_t> mapMoves(Character const &from, Character const &to) {
+    std::vector<size_t> map(to.moves.size(), NO_MOVE);
+    for(size_t i = 0; i < to.moves.size(); ++i) {
+        double best = -1.0;
+        for(size_t j = 0; j < from.moves.size(); ++j) {
+            if(from.moves[j].getType() != to.moves[i].getType()) {
+                continue;
+            }
+            double s = moveSimilarity(from.moves[j], to.moves[i]);
+            if(s > best || (s == best && j == i)) {
+                best = s;
+                map[i] = j;
+            }
+        }
+    }
+    return map;
+}
+
+/// \brief Returns the average similarity of the moves of 'to' with their
+///        counterparts in 'from'.
+static double movesSimilarity(Character const &from, Character const &to) {
+    if(to.moves.empty()) {
+        return 1.0;
+    }
+    std::vector<size_t> map = mapMoves(from, to);
+    double total = 0.0;
+    for(size_t i = 0; i < to.moves.size(); ++i) {
+        if(map[i] != NO_MOVE) {
+            total += moveSimilarity(from.moves[map[i]], to.moves[i]);
+        }
+    }
+    return total / to.moves.size();
+}
+
+double similarity(Character const &a, Character const &b) {
+    // RA, AT and DF add up to 7 and are at least 1, so two characters differ
+    // by at most 8 in total.
+    int distance = std::abs(a.ra - b.ra) + std::abs(a.at - b.at)
+                   + std::abs(a.df - b.df);
+    double stats = 1.0 - std::min(distance, 8) / 8.0;
+    double sp = (a.sp == b.sp) ? 1.0 : 0.0;
+    double moves = (movesSimilarity(a, b) + movesSimilarity(b, a)) / 2.0;
+    return 0.4 * stats + 0.2 * sp + 0.4 * moves;
+}
+
 }
 }
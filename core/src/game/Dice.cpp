@@ -15,34 +15,339 @@
 
 #include "core/game/Dice.h"
 
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <sstream>
+
 namespace {
 std::default_random_engine random_generator;
 std::mutex rgen_mutex;
-std::uniform_int_distribution<int> d6(1,6);
-std::uniform_int_distribution<int> d20(1,20);
+
+/// The seed of the dice, and how many times it has been set.
+std::atomic<unsigned long> dice_seed(0);
+std::atomic<unsigned> dice_generation(0);
+/// How many threads have started rolling since the seed was set.
+std::atomic<unsigned long> dice_threads(0);
+
+/// \brief Returns the next output of the SplitMix64 generator, which is used
+///        to expand a seed into a xoshiro256** state.
+uint64_t splitMix64(uint64_t &x) {
+    uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+/// \brief Returns the dice of this thread, reseeding them if the seed has
+///        changed since they were last used.
+core::game::BlockDiceSource &threadDice() {
+    static thread_local core::game::BlockDiceSource dice;
+    static thread_local unsigned generation = 0;
+    unsigned current = dice_generation.load();
+    if(generation != current + 1) {
+        generation = current + 1;
+        dice.reset(dice_seed.load() + 0x632BE59BD9B4E019ULL * dice_threads++);
+    }
+    return dice;
+}
 }
 
 namespace core {
 namespace game {
 
 int d6WithCrit() {
-    std::lock_guard<std::mutex> protect(rgen_mutex);
-    int x = d6(random_generator);
+    return threadDice().d6WithCrit();
+}
+
+bool fuzz() {
+    return threadDice().fuzz();
+}
+
+void seedDice(unsigned long seed) {
+    dice_seed = seed;
+    dice_threads = 0;
+    ++dice_generation;
+}
+
+DiceSource::~DiceSource() {}
+
+int DiceSource::d6WithCritFor(int) {
+    return d6WithCrit();
+}
+
+bool DiceSource::getPosition(DicePosition &) const {
+    return false;
+}
+
+bool DiceSource::setPosition(DicePosition const &) {
+    return false;
+}
+
+namespace {
+/// The dice source rolling the dice of the calling thread.
+class GlobalDiceSource : public DiceSource {
+public:
+    int d6WithCrit() override { return game::d6WithCrit(); }
+    bool fuzz() override { return game::fuzz(); }
+};
+}
+
+DiceSource &getGlobalDiceSource() {
+    static GlobalDiceSource source;
+    return source;
+}
+
+SeededDiceSource::SeededDiceSource(unsigned long seed, bool antithetic)
+  : m_d6(1, 6), m_d20(1, 20) {
+    reset(seed, antithetic);
+}
+
+void SeededDiceSource::reset(unsigned long seed, bool antithetic) {
+    for(unsigned i = 0; i < 2; ++i) {
+        std::seed_seq sequence{static_cast<unsigned>(seed),
+                               static_cast<unsigned>(seed >> 16 >> 16), i};
+        m_generators[i].seed(sequence);
+    }
+    m_d6.reset();
+    m_d20.reset();
+    m_antithetic = antithetic;
+}
+
+int SeededDiceSource::d6WithCrit() {
+    return d6WithCritFor(0);
+}
+
+int SeededDiceSource::d6WithCritFor(int fighter) {
+    int x = m_d6(m_generators[fighter]);
+    if(m_antithetic) {
+        x = 7 - x;
+    }
     if(x == 6) {
         x = 8;
     }
     return x;
 }
 
-bool fuzz() {
-    std::lock_guard<std::mutex> protect(rgen_mutex);
-    int x = d20(random_generator);
+bool SeededDiceSource::fuzz() {
+    int x = m_d20(m_generators[0]);
+    if(m_antithetic) {
+        x = 21 - x;
+    }
     return x < 2;
 }
 
+BlockDiceSource::BlockDiceSource(unsigned long seed) {
+    reset(seed);
+}
+
+void BlockDiceSource::reset(unsigned long seed) {
+    uint64_t x = seed;
+    for(size_t lane = 0; lane < s_lanes; ++lane) {
+        for(size_t word = 0; word < 4; ++word) {
+            m_state[word][lane] = splitMix64(x);
+        }
+    }
+    m_next_d6 = s_block;
+    m_next_d20 = s_block;
+}
+
+void BlockDiceSource::save(std::ostream &out) const {
+    uint64_t next[2] = { m_next_d6, m_next_d20 };
+    out.write(reinterpret_cast<char const *>(m_state), sizeof(m_state));
+    out.write(reinterpret_cast<char const *>(next), sizeof(next));
+    out.write(reinterpret_cast<char const *>(m_d6), sizeof(m_d6));
+    out.write(reinterpret_cast<char const *>(m_d20), sizeof(m_d20));
+}
+
+bool BlockDiceSource::load(std::istream &in) {
+    uint64_t state[4][s_lanes];
+    uint64_t next[2];
+    unsigned char d6[s_block];
+    unsigned char d20[s_block];
+    if(!in.read(reinterpret_cast<char *>(state), sizeof(state))
+       || !in.read(reinterpret_cast<char *>(next), sizeof(next))
+       || !in.read(reinterpret_cast<char *>(d6), sizeof(d6))
+       || !in.read(reinterpret_cast<char *>(d20), sizeof(d20))
+       || next[0] > s_block || next[1] > s_block) {
+        return false;
+    }
+    std::memcpy(m_state, state, sizeof(state));
+    std::memcpy(m_d6, d6, sizeof(d6));
+    std::memcpy(m_d20, d20, sizeof(d20));
+    m_next_d6 = static_cast<size_t>(next[0]);
+    m_next_d20 = static_cast<size_t>(next[1]);
+    return true;
+}
+
+void BlockDiceSource::refill(unsigned char *buffer, uint32_t faces) {
+    static unsigned char const d6_faces[6] = {1, 2, 3, 4, 5, 8};
+    // Values below this would make the low faces more likely.
+    uint32_t const threshold = (0u - faces) % faces;
+    size_t filled = 0;
+    while(filled < s_block) {
+        // Generate the words first; the lanes are independent, so this loop
+        // can be vectorized.
+        uint64_t words[s_block / 2];
+        for(size_t i = 0; i < s_block / 2; i += s_lanes) {
+            for(size_t lane = 0; lane < s_lanes; ++lane) {
+                uint64_t s0 = m_state[0][lane];
+                uint64_t s1 = m_state[1][lane];
+                uint64_t s2 = m_state[2][lane];
+                uint64_t s3 = m_state[3][lane];
+                words[i + lane] = rotl(s1 * 5, 7) * 9;
+                uint64_t t = s1 << 17;
+                s2 ^= s0;
+                s3 ^= s1;
+                s1 ^= s2;
+                s0 ^= s3;
+                s2 ^= t;
+                s3 = rotl(s3, 45);
+                m_state[0][lane] = s0;
+                m_state[1][lane] = s1;
+                m_state[2][lane] = s2;
+                m_state[3][lane] = s3;
+            }
+        }
+        // Then reduce each half word to a face; rejected values are
+        // overwritten by the next one.
+        for(size_t k = 0; k < s_block && filled < s_block; ++k) {
+            uint32_t x = static_cast<uint32_t>(words[k / 2] >> (32 * (k % 2)));
+            uint64_t m = static_cast<uint64_t>(x) * faces;
+            unsigned face = static_cast<unsigned>(m >> 32);
+            buffer[filled] = (faces == 6) ? d6_faces[face] : face + 1;
+            filled += (static_cast<uint32_t>(m) >= threshold) ? 1 : 0;
+        }
+    }
+}
+
+CounterDiceSource::CounterDiceSource(uint64_t key, uint64_t counter) {
+    m_position.key = key;
+    m_position.counter = counter;
+}
+
+uint32_t CounterDiceSource::roll(uint32_t faces) {
+    uint32_t const threshold = (0u - faces) % faces;
+    while(true) {
+        uint64_t x = m_position.key ^ (m_position.counter++ * 0xD1B54A32D192ED03ULL);
+        uint64_t word = splitMix64(x);
+        uint64_t m = (word >> 32) * faces;
+        if(static_cast<uint32_t>(m) >= threshold) {
+            return static_cast<uint32_t>(m >> 32);
+        }
+    }
+}
+
+int CounterDiceSource::d6WithCrit() {
+    static int const d6_faces[6] = {1, 2, 3, 4, 5, 8};
+    return d6_faces[roll(6)];
+}
+
+bool CounterDiceSource::fuzz() {
+    return roll(20) == 0;
+}
+
+bool CounterDiceSource::getPosition(DicePosition &position) const {
+    position = m_position;
+    return true;
+}
+
+bool CounterDiceSource::setPosition(DicePosition const &position) {
+    m_position = position;
+    return true;
+}
+
+ScriptedDiceSource::ScriptedDiceSource() : m_pos(0) {}
+
+double ScriptedDiceSource::probability() const {
+    double p = 1.0;
+    for(auto const &r : m_rolls) {
+        p *= r.is_d6 ? (1.0 / 6.0) : (r.choice ? 0.05 : 0.95);
+    }
+    return p;
+}
+
+bool ScriptedDiceSource::advance() {
+    // Drop the rolls that were not used in the last run.
+    m_rolls.resize(m_pos);
+    while(!m_rolls.empty()) {
+        Roll &r = m_rolls.back();
+        if(r.choice + 1 < (r.is_d6 ? 6 : 2)) {
+            ++r.choice;
+            return true;
+        }
+        m_rolls.pop_back();
+    }
+    return false;
+}
+
+int ScriptedDiceSource::d6WithCrit() {
+    static int const d6_faces[6] = {1, 2, 3, 4, 5, 8};
+    return d6_faces[next(true).choice];
+}
+
+bool ScriptedDiceSource::fuzz() {
+    return next(false).choice != 0;
+}
+
+ScriptedDiceSource::Roll const & ScriptedDiceSource::next(bool is_d6) {
+    if(m_pos == m_rolls.size()) {
+        m_rolls.push_back(Roll{is_d6, 0});
+    }
+    assert(m_rolls[m_pos].is_d6 == is_d6);
+    return m_rolls[m_pos++];
+}
+
 std::mutex &getRandomGenMutex() { return rgen_mutex; }
 
 std::default_random_engine &getRandomGenerator() { return random_generator; }
 
+void saveRandomState(std::ostream &out) {
+    std::ostringstream generator;
+    if(true) { // Just to have a scope
+        // Protect ourselves against multi-threading
+        std::lock_guard<std::mutex> protect(rgen_mutex);
+        generator << random_generator;
+    }
+    std::string text = generator.str();
+    uint64_t header[3] = { dice_seed.load(), dice_threads.load(),
+                           text.size() };
+    out.write(reinterpret_cast<char const *>(header), sizeof(header));
+    out.write(text.data(), text.size());
+    threadDice().save(out);
+}
+
+bool loadRandomState(std::istream &in) {
+    uint64_t header[3];
+    if(!in.read(reinterpret_cast<char *>(header), sizeof(header))
+       || header[2] > 4096) {
+        return false;
+    }
+    std::string text(static_cast<size_t>(header[2]), '\0');
+    if(!in.read(&text[0], text.size())) {
+        return false;
+    }
+    std::default_random_engine generator;
+    std::istringstream in_generator(text);
+    if(!(in_generator >> generator)) {
+        return false;
+    }
+    // Reseed first, so that this thread does not reseed its dice later; the
+    // other threads will be seeded as they would have been.
+    seedDice(static_cast<unsigned long>(header[0]));
+    if(!threadDice().load(in)) {
+        return false;
+    }
+    dice_threads = static_cast<unsigned long>(header[1]);
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> protect(rgen_mutex);
+    random_generator = generator;
+    return true;
+}
+
 } 
 }
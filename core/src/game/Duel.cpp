@@ -13,91 +13,390 @@
 // limitations under the License.
 
 #include "core/game/Duel.h"
+#include "core/game/ScoreSheet.h"
 #include "core/game/Dice.h"
 #include "core/ctrl/CtrlInterfaces.h"
+#include "core/ctrl/ExpertSystemCtrl.h"
 
 #include <cassert>
+#include <utility>
 
 namespace core {
 namespace game {
 
+namespace {
+
+/// \brief Forwards the attack decisions to the virtual interface.
+class VirtualAttackDispatch {
+public:
+    explicit VirtualAttackDispatch(ctrl::AttackControl &ctrl) : m_ctrl(ctrl) {}
+
+    int shouldSpendAPToGainSP(Character const &me, Character const &opponent,
+                              bool far) {
+        return m_ctrl.shouldSpendAPToGainSP(me, opponent, far);
+    }
+
+    bool shouldSpendAPToFallStanding(Character const &me,
+                                     Character const &opponent, bool far) {
+        return m_ctrl.shouldSpendAPToFallStanding(me, opponent, far);
+    }
+
+    Move const & getNextMove(Character const &me, Character const &opponent,
+                             bool far) {
+        return m_ctrl.getNextMove(me, opponent, far);
+    }
+
+    bool shouldSpendSPToLowerAPCost(Character const &me,
+                                    Character const &opponent, bool far,
+                                    Move const &my_move, int current_ap_cost) {
+        return m_ctrl.shouldSpendSPToLowerAPCost(me, opponent, far, my_move,
+                                                 current_ap_cost);
+    }
+
+    bool shouldSpendSPToConcatenate(Character const &me,
+                                    Character const &opponent, bool far,
+                                    Move const &my_move) {
+        return m_ctrl.shouldSpendSPToConcatenate(me, opponent, far, my_move);
+    }
+
+    bool shouldSpendSPForUltraAgility(Character const &me,
+                                      Character const &opponent, bool far,
+                                      Move const &my_move) {
+        return m_ctrl.shouldSpendSPForUltraAgility(me, opponent, far, my_move);
+    }
+
+    bool shouldSpendSPToBoostAttack(Character const &me,
+                                    Character const &opponent, bool far,
+                                    Move const &my_move) {
+        return m_ctrl.shouldSpendSPToBoostAttack(me, opponent, far, my_move);
+    }
+
+    bool shouldSpendSPToBoostDamage(Character const &me,
+                                    Character const &opponent, bool far,
+                                    Move const &my_move) {
+        return m_ctrl.shouldSpendSPToBoostDamage(me, opponent, far, my_move);
+    }
+
+    void updateAfterMove(Character const &me, Character const &opponent,
+                         Move const &move, bool successful) {
+        m_ctrl.updateAfterMove(me, opponent, move, successful);
+    }
+
+private:
+    ctrl::AttackControl &m_ctrl;
+};
+
+/// \brief Forwards the defence decisions to the virtual interface.
+class VirtualDefenceDispatch {
+public:
+    explicit VirtualDefenceDispatch(ctrl::DefendControl &ctrl) : m_ctrl(ctrl) {}
+
+    Move const & getCounterMove(Character const &me, Character const &opponent,
+                                bool far, Move const &opponent_move) {
+        return m_ctrl.getCounterMove(me, opponent, far, opponent_move);
+    }
+
+    bool shouldSpendSPToComboBreak(Character const &me,
+                                   Character const &opponent, bool far,
+                                   Move const &opponent_move) {
+        return m_ctrl.shouldSpendSPToComboBreak(me, opponent, far,
+                                                opponent_move);
+    }
+
+    bool shouldSpendSPToLowerAPCost(Character const &me,
+                                    Character const &opponent, bool far,
+                                    Move const &my_move, int current_ap_cost) {
+        return m_ctrl.shouldSpendSPToLowerAPCost(me, opponent, far, my_move,
+                                                 current_ap_cost);
+    }
+
+    bool shouldSpendSPForUltraAgility(Character const &me,
+                                      Character const &opponent, bool far,
+                                      Move const &my_move) {
+        return m_ctrl.shouldSpendSPForUltraAgility(me, opponent, far, my_move);
+    }
+
+    bool shouldSpendSPToBoostDefence(Character const &me,
+                                     Character const &opponent, bool far,
+                                     Move const &my_move) {
+        return m_ctrl.shouldSpendSPToBoostDefence(me, opponent, far, my_move);
+    }
+
+    bool shouldSpendSPToBoostCounterDamage(Character const &me,
+                                           Character const &opponent, bool far,
+                                           Move const &my_move) {
+        return m_ctrl.shouldSpendSPToBoostCounterDamage(me, opponent, far,
+                                                        my_move);
+    }
+
+    void updateAfterMove(Character const &me, Character const &opponent,
+                         Move const &move, bool successful) {
+        m_ctrl.updateAfterMove(me, opponent, move, successful);
+    }
+
+private:
+    ctrl::DefendControl &m_ctrl;
+};
+
+}
+
 Duel::Duel(std::shared_ptr<Character> c1, std::shared_ptr<Character> c2, 
-           std::ostream *report_stream)
+           std::ostream *report_stream, DiceSource *dice)
 :   m_c1(c1), m_c2(c2), m_report_stream(report_stream), 
+    m_dice(dice ? dice : &getGlobalDiceSource()), m_score_sheet(nullptr),
     m_c1_clone(c1->clone()), m_c2_clone(c2->clone()), 
-    m_far(true), m_turn_counter(0) {}
+    m_far(true), m_turn_counter(0), m_c1_attacks(true),
+    m_phase(DP_INITIATIVE), m_static_dispatch(false) {
+    // Build the decision tables on the models, so that all concurrent fights
+    // of a character share them.
+    ctrl::prepareBestMoveTable(*m_c1);
+    ctrl::prepareBestMoveTable(*m_c2);
+    m_c1_clone->best_moves = std::atomic_load(&m_c1->best_moves);
+    m_c2_clone->best_moves = std::atomic_load(&m_c2->best_moves);
+    // Take the fast path if nobody needs virtual dispatch.
+    m_ctrl_tags[0] = ctrl::getExpertSystemTag(*m_c1_clone->actrl);
+    m_ctrl_tags[1] = ctrl::getExpertSystemTag(*m_c1_clone->dctrl);
+    m_ctrl_tags[2] = ctrl::getExpertSystemTag(*m_c2_clone->actrl);
+    m_ctrl_tags[3] = ctrl::getExpertSystemTag(*m_c2_clone->dctrl);
+    setStaticDispatch(true);
+}
+
+void Duel::setStaticDispatch(bool enabled) {
+    m_static_dispatch = enabled
+                        && m_ctrl_tags[0] != ctrl::ES_NONE
+                        && m_ctrl_tags[1] != ctrl::ES_NONE
+                        && m_ctrl_tags[2] != ctrl::ES_NONE
+                        && m_ctrl_tags[3] != ctrl::ES_NONE;
+}
 
 void Duel::fight() {
-    // Initiative
-    auto init1 = d6WithCrit() + m_c1_clone->ra;
-    auto init2 = d6WithCrit() + m_c2_clone->ra;
-    bool t = init1 > init2;
+    if(m_static_dispatch) {
+        mainLoop<ctrl::ExpertAttackDispatch, ctrl::ExpertDefenceDispatch>();
+    }
+    else {
+        mainLoop<VirtualAttackDispatch, VirtualDefenceDispatch>();
+    }
+    conclude();
+}
 
-    // Main loop
-    while(m_c1_clone->cur_life > 0 && m_c2_clone->cur_life > 0) {
-        if(t) {
-            turn(*m_c1_clone, *m_c2_clone);
-        }
-        else {
-            turn(*m_c2_clone, *m_c1_clone);
-        }
-        t = !t;
-        // Catch the case where the AIs are stuck. If both arrived to 20AP then
-        // nobody is doing anything.
-        if(m_c1_clone->cur_ap >= 20 && m_c2_clone->cur_ap >= 20) {
-            // Force a draw.
-            m_c1_clone->cur_life = 0;
-            m_c2_clone->cur_life = 0;
-        }
+bool Duel::step() {
+    if(m_static_dispatch) {
+        ctrl::ExpertAttackDispatch c1_actrl(*m_c1_clone->actrl, m_ctrl_tags[0]);
+        ctrl::ExpertDefenceDispatch c1_dctrl(*m_c1_clone->dctrl, m_ctrl_tags[1]);
+        ctrl::ExpertAttackDispatch c2_actrl(*m_c2_clone->actrl, m_ctrl_tags[2]);
+        ctrl::ExpertDefenceDispatch c2_dctrl(*m_c2_clone->dctrl, m_ctrl_tags[3]);
+        return stepWith(c1_actrl, c1_dctrl, c2_actrl, c2_dctrl);
     }
+    VirtualAttackDispatch c1_actrl(*m_c1_clone->actrl);
+    VirtualDefenceDispatch c1_dctrl(*m_c1_clone->dctrl);
+    VirtualAttackDispatch c2_actrl(*m_c2_clone->actrl);
+    VirtualDefenceDispatch c2_dctrl(*m_c2_clone->dctrl);
+    return stepWith(c1_actrl, c1_dctrl, c2_actrl, c2_dctrl);
+}
 
+DuelResult Duel::result() const {
     if(m_c1_clone->cur_life <= 0 && m_c2_clone->cur_life <= 0) {
-        if(m_report_stream) {
+        return DR_DRAW;
+    }
+    else if(m_c1_clone->cur_life <= 0) {
+        return DR_C2_WINS;
+    }
+    else if(m_c2_clone->cur_life <= 0) {
+        return DR_C1_WINS;
+    }
+    return DR_ONGOING;
+}
+
+void Duel::conclude() {
+    DuelResult outcome = result();
+    if(outcome == DR_ONGOING) {
+        return;
+    }
+    if(m_report_stream) {
+        if(outcome == DR_DRAW) {
             *m_report_stream << m_c1_clone->name << " and " << m_c2_clone->name 
                              << " draw!" << std::endl << std::endl;
+        } else {
+            *m_report_stream << (outcome == DR_C1_WINS ? m_c1_clone->name
+                                                       : m_c2_clone->name)
+                             << " wins!" << std::endl << std::endl;
         }
-        std::lock(m_c1->content_mutex, m_c2->content_mutex);
+    }
+    // The points are atomic and the control systems protect themselves, so
+    // no lock on the characters is needed.
+    if(m_score_sheet) {
+        m_score_sheet->record(*m_c1, *m_c2, outcome);
+    } else if(outcome == DR_DRAW) {
         m_c1->total_points += 1;
         m_c2->total_points += 1;
-        // A draw is considered a win by both for AI purposes.
-        m_c1->actrl->updateAfterMatch(*m_c1_clone, *m_c2_clone, true);
-        m_c1->dctrl->updateAfterMatch(*m_c1_clone, *m_c2_clone, true);
-        m_c2->actrl->updateAfterMatch(*m_c2_clone, *m_c1_clone, true);
-        m_c2->dctrl->updateAfterMatch(*m_c2_clone, *m_c1_clone, true);
-        m_c1->content_mutex.unlock();
-        m_c2->content_mutex.unlock();
+    } else {
+        (outcome == DR_C1_WINS ? m_c1 : m_c2)->total_points += 3;
     }
-    else if(m_c1_clone->cur_life <= 0) {
-        if(m_report_stream) {
-            *m_report_stream << m_c2_clone->name << " wins!" << std::endl 
-                             << std::endl;
-        }
-        std::lock(m_c1->content_mutex, m_c2->content_mutex);
-        m_c2->total_points += 3;
-        m_c1->actrl->updateAfterMatch(*m_c1_clone, *m_c2_clone, false);
-        m_c1->dctrl->updateAfterMatch(*m_c1_clone, *m_c2_clone, false);
-        m_c2->actrl->updateAfterMatch(*m_c2_clone, *m_c1_clone, true);
-        m_c2->dctrl->updateAfterMatch(*m_c2_clone, *m_c1_clone, true);
-        m_c1->content_mutex.unlock();
-        m_c2->content_mutex.unlock();
+    // A draw is considered a win by both for AI purposes.
+    bool c1_won = outcome != DR_C2_WINS;
+    bool c2_won = outcome != DR_C1_WINS;
+    m_c1->actrl->updateAfterMatch(*m_c1_clone, *m_c2_clone, c1_won);
+    m_c1->dctrl->updateAfterMatch(*m_c1_clone, *m_c2_clone, c1_won);
+    m_c2->actrl->updateAfterMatch(*m_c2_clone, *m_c1_clone, c2_won);
+    m_c2->dctrl->updateAfterMatch(*m_c2_clone, *m_c1_clone, c2_won);
+}
+
+void Duel::abandon() {
+    m_c1->actrl->forgetMatch(*m_c1_clone);
+    m_c1->dctrl->forgetMatch(*m_c1_clone);
+    m_c2->actrl->forgetMatch(*m_c2_clone);
+    m_c2->dctrl->forgetMatch(*m_c2_clone);
+}
+
+FighterState getFighterState(Character const &c) {
+    FighterState fs;
+    fs.cur_ap = c.cur_ap;
+    fs.cur_sp = c.cur_sp;
+    fs.cur_life = c.cur_life;
+    fs.cur_combo = c.cur_combo;
+    fs.air = c.air;
+    fs.down = c.down;
+    fs.nth_move_of_the_round = c.nth_move_of_the_round;
+    fs.moves_performed = c.moves_performed;
+    return fs;
+}
+
+static void setFighterState(Character &c, FighterState const &fs) {
+    c.cur_ap = fs.cur_ap;
+    c.cur_sp = fs.cur_sp;
+    c.cur_life = fs.cur_life;
+    c.cur_combo = fs.cur_combo;
+    c.air = fs.air;
+    c.down = fs.down;
+    c.nth_move_of_the_round = fs.nth_move_of_the_round;
+    c.moves_performed = fs.moves_performed;
+}
+
+DuelState Duel::getState() const {
+    DuelState state;
+    state.c1 = getFighterState(*m_c1_clone);
+    state.c2 = getFighterState(*m_c2_clone);
+    state.far = m_far;
+    state.turn_counter = m_turn_counter;
+    state.c1_attacks = m_c1_attacks;
+    state.phase = m_phase;
+    return state;
+}
+
+void Duel::setState(DuelState const &state) {
+    setFighterState(*m_c1_clone, state.c1);
+    setFighterState(*m_c2_clone, state.c2);
+    m_far = state.far;
+    m_turn_counter = state.turn_counter;
+    m_c1_attacks = state.c1_attacks;
+    m_phase = state.phase;
+}
+
+DuelSnapshot Duel::snapshot() const {
+    DuelSnapshot snapshot;
+    snapshot.state = getState();
+    snapshot.has_dice = m_dice->getPosition(snapshot.dice);
+    return snapshot;
+}
+
+void Duel::restore(DuelSnapshot const &snapshot) {
+    setState(snapshot.state);
+    if(snapshot.has_dice) {
+        m_dice->setPosition(snapshot.dice);
     }
-    else if(m_c2_clone->cur_life <= 0) {
-        if(m_report_stream) {
-            *m_report_stream << m_c1_clone->name << " wins!" << std::endl 
-                             << std::endl;
+}
+
+std::unique_ptr<Duel> Duel::fork(DiceSource *dice) const {
+    std::unique_ptr<Duel> forked(new Duel(m_c1, m_c2, nullptr,
+                                          dice ? dice : m_dice));
+    forked->setState(getState());
+    return forked;
+}
+
+static void swapFighterState(Character &c, FighterState &fs) {
+    std::swap(c.cur_ap, fs.cur_ap);
+    std::swap(c.cur_sp, fs.cur_sp);
+    std::swap(c.cur_life, fs.cur_life);
+    std::swap(c.cur_combo, fs.cur_combo);
+    std::swap(c.air, fs.air);
+    std::swap(c.down, fs.down);
+    std::swap(c.nth_move_of_the_round, fs.nth_move_of_the_round);
+    c.moves_performed.swap(fs.moves_performed);
+}
+
+void Duel::swapState(DuelState &state) {
+    swapFighterState(*m_c1_clone, state.c1);
+    swapFighterState(*m_c2_clone, state.c2);
+    std::swap(m_far, state.far);
+    std::swap(m_turn_counter, state.turn_counter);
+    std::swap(m_c1_attacks, state.c1_attacks);
+    std::swap(m_phase, state.phase);
+}
+
+template<typename AttackDispatch, typename DefenceDispatch>
+void Duel::mainLoop() {
+    AttackDispatch c1_actrl(*m_c1_clone->actrl);
+    DefenceDispatch c1_dctrl(*m_c1_clone->dctrl);
+    AttackDispatch c2_actrl(*m_c2_clone->actrl);
+    DefenceDispatch c2_dctrl(*m_c2_clone->dctrl);
+    while(stepWith(c1_actrl, c1_dctrl, c2_actrl, c2_dctrl)) {}
+}
+
+template<typename AttackDispatch, typename DefenceDispatch>
+bool Duel::stepWith(AttackDispatch &c1_actrl, DefenceDispatch &c1_dctrl,
+                    AttackDispatch &c2_actrl, DefenceDispatch &c2_dctrl) {
+    Character &attacker = m_c1_attacks ? *m_c1_clone : *m_c2_clone;
+    Character &defender = m_c1_attacks ? *m_c2_clone : *m_c1_clone;
+    AttackDispatch &actrl = m_c1_attacks ? c1_actrl : c2_actrl;
+    DefenceDispatch &dctrl = m_c1_attacks ? c2_dctrl : c1_dctrl;
+
+    switch(m_phase) {
+    case DP_INITIATIVE: {
+        auto init1 = m_dice->d6WithCritFor(0) + m_c1_clone->ra;
+        auto init2 = m_dice->d6WithCritFor(1) + m_c2_clone->ra;
+        m_c1_attacks = init1 > init2;
+        m_phase = DP_TURN_START;
+        break;
+    }
+    case DP_TURN_START:
+        if(beginTurn(attacker, defender, actrl)) {
+            m_phase = DP_ATTACK;
+        }
+        else {
+            // The attacker succumbed, the turn is over straight away.
+            finishTurn();
         }
-        std::lock(m_c1->content_mutex, m_c2->content_mutex);
-        m_c1->total_points += 3;
-        m_c1->actrl->updateAfterMatch(*m_c1_clone, *m_c2_clone, true);
-        m_c1->dctrl->updateAfterMatch(*m_c1_clone, *m_c2_clone, true);
-        m_c2->actrl->updateAfterMatch(*m_c2_clone, *m_c1_clone, false);
-        m_c2->dctrl->updateAfterMatch(*m_c2_clone, *m_c1_clone, false);
-        m_c1->content_mutex.unlock();
-        m_c2->content_mutex.unlock();
+        break;
+    case DP_ATTACK:
+        if(!attackStep(attacker, defender, actrl, dctrl)
+           || defender.cur_life <= 0 || attacker.cur_life <= 0) {
+            endTurn(attacker);
+            finishTurn();
+        }
+        break;
+    default:
+        break;
+    }
+    return m_phase != DP_OVER;
+}
+
+void Duel::finishTurn() {
+    m_c1_attacks = !m_c1_attacks;
+    // Catch the case where the AIs are stuck. If both arrived to 20AP then
+    // nobody is doing anything.
+    if(m_c1_clone->cur_ap >= 20 && m_c2_clone->cur_ap >= 20) {
+        // Force a draw.
+        m_c1_clone->cur_life = 0;
+        m_c2_clone->cur_life = 0;
     }
+    m_phase = (m_c1_clone->cur_life > 0 && m_c2_clone->cur_life > 0)
+              ? DP_TURN_START
+              : DP_OVER;
 }
 
-void Duel::turn(Character &attacker, Character &defender) {
+template<typename AttackDispatch>
+bool Duel::beginTurn(Character &attacker, Character &defender,
+                     AttackDispatch &actrl) {
     // Restore AP
     if(m_turn_counter >= 2) {
         attacker.cur_ap += attacker.ra;
@@ -122,7 +421,7 @@ void Duel::turn(Character &attacker, Character &defender) {
 
         // DECISION POINT.
         if(attacker.cur_ap > 0
-           && attacker.actrl->shouldSpendAPToFallStanding(
+           && actrl.shouldSpendAPToFallStanding(
                 attacker, defender, m_far)) {
             if(m_report_stream) {
                 *m_report_stream << attacker.name 
@@ -162,7 +461,7 @@ void Duel::turn(Character &attacker, Character &defender) {
                              << " has succumbed due to the damage!"
                              << std::endl;
         }
-        return;
+        return false;
     }
 
     // Reset combo accumulated during defence (???).
@@ -171,7 +470,7 @@ void Duel::turn(Character &attacker, Character &defender) {
     // Gain SP in SP_AP mode.
     if(attacker.sp == SP_AP && attacker.cur_sp < 6) {
         // DECISION POINT.
-        int how_many = attacker.actrl->shouldSpendAPToGainSP(
+        int how_many = actrl.shouldSpendAPToGainSP(
             attacker, defender, m_far);
         if(how_many > 0) {
             if(m_report_stream) {
@@ -185,112 +484,113 @@ void Duel::turn(Character &attacker, Character &defender) {
         }
     }
 
-    bool pass = false;
-    while(!pass && defender.cur_life > 0 && attacker.cur_life > 0) {
-        // DECISION POINT.
-        Move const &attack_move = attacker.actrl->getNextMove(attacker, 
-                                                              defender, 
-                                                              m_far);
+    return true;
+}
 
-        // If we decided to pass, then pass.
-        if(attack_move.isWait()) {
-            if(m_report_stream) {
-                *m_report_stream << attacker.name 
-                                 << " has decided to pass."
-                                 << std::endl;
-            }
-            // It was a "successful wait". :-)
-            attacker.actrl->updateAfterMove(attacker, defender, attack_move, true);
-            pass = true;
-            continue;
-        }
+template<typename AttackDispatch, typename DefenceDispatch>
+bool Duel::attackStep(Character &attacker, Character &defender,
+                      AttackDispatch &actrl, DefenceDispatch &dctrl) {
+    // DECISION POINT.
+    Move const &attack_move = actrl.getNextMove(attacker, defender, m_far);
+
+    // If we decided to pass, then pass.
+    if(attack_move.isWait()) {
         if(m_report_stream) {
             *m_report_stream << attacker.name 
-                             << " has decided to attack with '" 
-                             << attack_move.getName() << "' [ ";
-            for(auto const &s : attack_move.getSymbols()) {
-                *m_report_stream << toString(s) << " ";
-            }
-            *m_report_stream << "]..." << std::endl;
+                             << " has decided to pass."
+                             << std::endl;
+        }
+        // It was a "successful wait". :-)
+        actrl.updateAfterMove(attacker, defender, attack_move, true);
+        return false;
+    }
+    if(m_report_stream) {
+        *m_report_stream << attacker.name 
+                         << " has decided to attack with '" 
+                         << attack_move.getName() << "' [ ";
+        for(auto const &s : attack_move.getSymbols()) {
+            *m_report_stream << toString(s) << " ";
         }
+        *m_report_stream << "]..." << std::endl;
+    }
 
-        // Calculate AP cost.
-        int original_ap_cost = attack_move.apCost(m_far, false);
-        int ap_cost = original_ap_cost;
+    // Calculate AP cost.
+    int original_ap_cost = attack_move.apCost(m_far, false);
+    int ap_cost = original_ap_cost;
 
-        // Lower the AP cost.
-        while(attacker.cur_sp > (attack_move.isSuper() ? 4 : 0)
-              && ap_cost > 1) {
-            // DECISION POINT.
-            bool lower = attacker.actrl->shouldSpendSPToLowerAPCost(
-                attacker, defender, m_far, attack_move, ap_cost);
-            if(lower) {
-                ap_cost -= 1;
-                attacker.cur_sp -= 1;
-            } else {
-                break;
-            }
+    // Lower the AP cost.
+    while(attacker.cur_sp > (attack_move.isSuper() ? 4 : 0)
+          && ap_cost > 1) {
+        // DECISION POINT.
+        bool lower = actrl.shouldSpendSPToLowerAPCost(
+            attacker, defender, m_far, attack_move, ap_cost);
+        if(lower) {
+            ap_cost -= 1;
+            attacker.cur_sp -= 1;
+        } else {
+            break;
         }
-        if(m_report_stream && original_ap_cost > ap_cost) {
-            *m_report_stream << "  (" << attacker.name 
-                             << " has decided to spend "
-                             << (original_ap_cost - ap_cost) << "SP to lower "
-                             << "the AP cost of the move by "
-                             << (original_ap_cost - ap_cost) << ")" 
+    }
+    if(m_report_stream && original_ap_cost > ap_cost) {
+        *m_report_stream << "  (" << attacker.name 
+                         << " has decided to spend "
+                         << (original_ap_cost - ap_cost) << "SP to lower "
+                         << "the AP cost of the move by "
+                         << (original_ap_cost - ap_cost) << ")" 
+                         << std::endl;
+    }
+
+    // Sanity check.
+    if(ap_cost > attacker.cur_ap) {
+        if(m_report_stream) {
+            *m_report_stream << "... but has not enough AP and must pass."
                              << std::endl;
         }
-
-        // Sanity check.
-        if(ap_cost > attacker.cur_ap) {
+        // It was a "successful wait". :-)
+        actrl.updateAfterMove(attacker, defender, attack_move, true);
+        return false;
+    }
+    assert(ap_cost <= attacker.cur_ap);
+    if(attack_move.isSuper()) {
+        if(attacker.cur_sp < 4) {
             if(m_report_stream) {
-                *m_report_stream << "... but has not enough AP and must pass."
-                                 << std::endl;
+                *m_report_stream << "... but has not enough SP and must "
+                                 << "pass." << std::endl;
             }
             // It was a "successful wait". :-)
-            attacker.actrl->updateAfterMove(attacker, defender, attack_move, true);
-            pass = true;
-            continue;
-        }
-        assert(ap_cost <= attacker.cur_ap);
-        if(attack_move.isSuper()) {
-            if(attacker.cur_sp < 4) {
-                if(m_report_stream) {
-                    *m_report_stream << "... but has not enough SP and must "
-                                     << "pass." << std::endl;
-                }
-                // It was a "successful wait". :-)
-                attacker.actrl->updateAfterMove(attacker, defender, attack_move, true);
-                pass = true;
-                continue;
-            }
-            assert(attacker.cur_sp >= 4);
+            actrl.updateAfterMove(attacker, defender, attack_move, true);
+            return false;
         }
+        assert(attacker.cur_sp >= 4);
+    }
 
-        // Now do it.
-        bool interrupted = false;
-        performAttack(attacker, defender, attack_move, ap_cost, interrupted);
+    // Now do it.
+    bool interrupted = false;
+    performAttack(attacker, defender, actrl, dctrl, attack_move, ap_cost,
+                  interrupted);
 
-        // Have we been interrupted?
-        if(interrupted) {
-            if(m_report_stream) {
-                *m_report_stream << attacker.name 
-                                 << " has been interrupted and must pass."
-                                 << std::endl;
-            }
-            pass = true;
-            continue;
+    // Have we been interrupted?
+    if(interrupted) {
+        if(m_report_stream) {
+            *m_report_stream << attacker.name 
+                             << " has been interrupted and must pass."
+                             << std::endl;
         }
+        return false;
+    }
 
-        // Update move counter.
-        attacker.nth_move_of_the_round += 1;
-        for(size_t i = 0; i < attacker.moves.size(); ++i) {
-            if(attacker.moves[i] == attack_move) {
-                attacker.moves_performed.push_back(i);
-                break;
-            }
+    // Update move counter.
+    attacker.nth_move_of_the_round += 1;
+    for(size_t i = 0; i < attacker.moves.size(); ++i) {
+        if(attacker.moves[i] == attack_move) {
+            attacker.moves_performed.push_back(i);
+            break;
         }
     }
+    return true;
+}
 
+void Duel::endTurn(Character &attacker) {
     // At the end of turn, handle combo points.
     int sp_from_combo = attacker.cur_combo / 6;
     if(attacker.sp == SP_COMBO) {
@@ -310,7 +610,9 @@ void Duel::turn(Character &attacker, Character &defender) {
     attacker.moves_performed.clear();
 }
 
+template<typename AttackDispatch, typename DefenceDispatch>
 bool Duel::performAttack(Character &attacker, Character &defender, 
+                         AttackDispatch &actrl, DefenceDispatch &dctrl,
                          Move const &attack_move, int modified_ap_cost,
                          bool &interrupted) {
     // Init some variables.
@@ -340,7 +642,7 @@ bool Duel::performAttack(Character &attacker, Character &defender,
        && (attacker.cur_combo > 0) // Must not be the first move.
        && attacker.cur_sp > (attack_move.isSuper() ? 4 : 0)) {
         // DECISION POINT.
-        if(attacker.actrl->shouldSpendSPToConcatenate(
+        if(actrl.shouldSpendSPToConcatenate(
                 attacker, defender, m_far, attack_move)) {
             if(m_report_stream) {
                 *m_report_stream << "  (" << attacker.name 
@@ -354,7 +656,7 @@ bool Duel::performAttack(Character &attacker, Character &defender,
     // Then see if the defender wants to spend SP to defend even if they can't.
     if(!can_defend) {
         // DECISION POINT.
-        if(defender.cur_sp > 1 && defender.dctrl->shouldSpendSPToComboBreak(
+        if(defender.cur_sp > 1 && dctrl.shouldSpendSPToComboBreak(
                 attacker, defender, m_far, attack_move)) {
             if(m_report_stream) {
                 *m_report_stream << "  (" << defender.name 
@@ -369,7 +671,7 @@ bool Duel::performAttack(Character &attacker, Character &defender,
     if(attacker.cur_sp > (attack_move.isSuper() ? 4 : 0) 
        && attack_move.hasUltraAgility()) {
         // DECISION POINT.
-        if(attacker.actrl->shouldSpendSPForUltraAgility(
+        if(actrl.shouldSpendSPForUltraAgility(
                 attacker, defender, m_far, attack_move)) {
             if(m_report_stream) {
                 *m_report_stream << "  (" << attacker.name
@@ -382,7 +684,7 @@ bool Duel::performAttack(Character &attacker, Character &defender,
     }
     if(attacker.cur_sp > (attack_move.isSuper() ? 4 : 0)) {
         // DECISION POINT.
-        if(attacker.actrl->shouldSpendSPToBoostAttack(
+        if(actrl.shouldSpendSPToBoostAttack(
                 attacker, defender, m_far, attack_move)) {
             if(m_report_stream) {
                 *m_report_stream << "  (" << attacker.name
@@ -401,7 +703,7 @@ bool Duel::performAttack(Character &attacker, Character &defender,
                                          defender.air, defender.down);
 
     // At this point we can roll the attack test.
-    int at_test = d6WithCrit();
+    int at_test = m_dice->d6WithCritFor(m_c1_attacks ? 0 : 1);
     if(m_report_stream) {
         *m_report_stream << "  (" << attacker.name << " rolls " 
                          << at_test << ")" << std::endl;
@@ -439,7 +741,7 @@ bool Duel::performAttack(Character &attacker, Character &defender,
     // Process defence if possible
     if(can_defend) {
         // DECISION POINT.
-        Move const &tentative_counter_move = defender.dctrl->getCounterMove(
+        Move const &tentative_counter_move = dctrl.getCounterMove(
             defender, attacker, m_far, attack_move);
         if(m_report_stream && !tentative_counter_move.isWait()) {
             *m_report_stream << "  (" << defender.name
@@ -456,7 +758,7 @@ bool Duel::performAttack(Character &attacker, Character &defender,
         // Lower the AP cost.
         while(defender.cur_sp > counter_sp_cost && counter_ap_cost > 1) {
             // DECISION POINT.
-            bool lower = defender.dctrl->shouldSpendSPToLowerAPCost(
+            bool lower = dctrl.shouldSpendSPToLowerAPCost(
                 defender, attacker, m_far, tentative_counter_move, counter_ap_cost);
             if(lower) {
                 counter_ap_cost -= 1;
@@ -519,7 +821,7 @@ bool Duel::performAttack(Character &attacker, Character &defender,
             if(defender.cur_sp > (counter_move.isSuper() ? 4 : 0) 
                && counter_move.hasUltraAgility()) {
                 // DECISION POINT.
-                if(defender.dctrl->shouldSpendSPForUltraAgility(
+                if(dctrl.shouldSpendSPForUltraAgility(
                         defender, attacker, m_far, counter_move)) {
                     if(m_report_stream) {
                         *m_report_stream << "  (" << defender.name
@@ -534,7 +836,7 @@ bool Duel::performAttack(Character &attacker, Character &defender,
         // Check boost. We can do this even without a counter.
         if(defender.cur_sp > (counter_move.isSuper() ? 4 : 0)) {
             // DECISION POINT.
-            if(defender.dctrl->shouldSpendSPToBoostDefence(
+            if(dctrl.shouldSpendSPToBoostDefence(
                     defender, attacker, m_far, counter_move)) {
                 if(m_report_stream) {
                     *m_report_stream << "  (" << defender.name
@@ -547,7 +849,7 @@ bool Duel::performAttack(Character &attacker, Character &defender,
         }
 
         // Now roll defence.
-        int df_test = d6WithCrit();
+        int df_test = m_dice->d6WithCritFor(m_c1_attacks ? 1 : 0);
         if(m_report_stream) {
             *m_report_stream << "  (" << defender.name << " rolls " 
                              << df_test << ")" << std::endl;
@@ -606,7 +908,7 @@ bool Duel::performAttack(Character &attacker, Character &defender,
                 }
                 
                 // Update control system.
-                attacker.actrl->updateAfterMove(attacker, defender, attack_move, false);
+                actrl.updateAfterMove(attacker, defender, attack_move, false);
                 // Get out, attack failed.
                 return false;
             } else {
@@ -623,7 +925,7 @@ bool Duel::performAttack(Character &attacker, Character &defender,
                 int sp_for_uh = 0;
                 if(defender.cur_sp > 0 && counter_move.hasUltraHardness()) {
                     // DECISION POINT.
-                    if(defender.dctrl->shouldSpendSPToBoostCounterDamage(
+                    if(dctrl.shouldSpendSPToBoostCounterDamage(
                             defender, attacker, m_far, counter_move)){
                         if(m_report_stream) {
                             *m_report_stream << "  (" << defender.name
@@ -668,7 +970,7 @@ bool Duel::performAttack(Character &attacker, Character &defender,
                 defender.cur_combo += counter_move.comboPoints();
 
                 // Update control system.
-                defender.dctrl->updateAfterMove(defender, attacker, counter_move, true);
+                dctrl.updateAfterMove(defender, attacker, counter_move, true);
                 // Counter was successful, record move in defender.
                 for(size_t i = 0; i < defender.moves.size(); ++i) {
                     if(defender.moves[i] == counter_move) {
@@ -717,7 +1019,7 @@ bool Duel::performAttack(Character &attacker, Character &defender,
             // Attack failed only if it was not a draw with a counter.
             if(final_test_result != 0) {
                 // Update control system.
-                attacker.actrl->updateAfterMove(attacker, defender, attack_move, false);
+                actrl.updateAfterMove(attacker, defender, attack_move, false);
                 return false;
             }
         }
@@ -725,7 +1027,7 @@ bool Duel::performAttack(Character &attacker, Character &defender,
             // Failed to defend. If it was a counter, record that it failed.
             if(!counter_move.isWait()) {
                 // Update control system.
-                defender.dctrl->updateAfterMove(defender, attacker, counter_move, false);                
+                dctrl.updateAfterMove(defender, attacker, counter_move, false);                
             }
         }
     }
@@ -737,7 +1039,7 @@ bool Duel::performAttack(Character &attacker, Character &defender,
     int actual_damage = preliminary_damage;
     if(attacker.cur_sp > 0 && attack_move.hasUltraHardness()) {
         // DECISION POINT.
-        if(attacker.actrl->shouldSpendSPToBoostDamage(
+        if(actrl.shouldSpendSPToBoostDamage(
                 attacker, defender, m_far, attack_move)){
             if(m_report_stream) {
                 *m_report_stream << "  (" << attacker.name
@@ -805,7 +1107,7 @@ bool Duel::performAttack(Character &attacker, Character &defender,
     attacker.cur_combo += attack_move.comboPoints();
 
     // Update control system.
-    attacker.actrl->updateAfterMove(attacker, defender, attack_move, true);
+    actrl.updateAfterMove(attacker, defender, attack_move, true);
 
     // We were successful even if we had a counter draw.
     return true;
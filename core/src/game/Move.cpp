@@ -15,6 +15,12 @@
 
 #include "core/game/Move.h"
 
+#include <bitset>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <tuple>
+
 namespace core {
 namespace game {
 
@@ -53,51 +59,118 @@ std::string const & toString(MoveType m)  {
     return s_move_symbol_names[static_cast<int>(m)];
 }
 
+// Move table
+
+namespace {
+
+/// The table of the interned moves.
+struct MoveTable {
+    /// The key of a move: type, name and symbols.
+    typedef std::tuple<MoveType, std::string, std::vector<MoveSymbol>> Key;
+
+    /// The data and the moves, by id; deques never move their elements.
+    std::deque<Move::Data> data;
+    std::deque<Move> moves;
+    /// The ids, by key.
+    std::map<Key, MoveId> ids;
+    /// Protects the table.
+    std::mutex mutex;
+};
+
+/// \brief Returns the table; it is built on first use, as moves are created
+///        during static initialization.
+MoveTable & getMoveTable() {
+    static MoveTable table;
+    return table;
+}
+
+/// \brief Returns the moves this thread has already interned, so that finding
+///        them again does not take the lock of the table. Interned data is
+///        never freed or moved, so the pointers stay valid.
+std::map<MoveTable::Key, Move::Data const *> & getThreadMoves() {
+    static thread_local std::map<MoveTable::Key, Move::Data const *> moves;
+    return moves;
+}
+
+} // close anonymous namespace
+
 // Move class
 
 Move::Move(std::string name, MoveType type, 
-           std::vector<MoveSymbol> const &symbols)
-: m_name(name), m_type(type), m_symbols(symbols) {}
-
-bool Move::operator==(Move const &other) const {
-    return m_type == other.m_type
-           && m_name == other.m_name 
-           && m_symbols == other.m_symbols;
+           std::vector<MoveSymbol> const &symbols) : m_data(nullptr) {
+    // Most moves are created again and again by the same threads, so look in
+    // the moves of this thread first, which needs no lock.
+    MoveTable::Key key(type, name, symbols);
+    auto &thread_moves = getThreadMoves();
+    auto known = thread_moves.find(key);
+    if(known != thread_moves.end()) {
+        m_data = known->second;
+        return;
+    }
+    MoveTable &table = getMoveTable();
+    if(true) { // Just to have a scope
+        // Protect ourselves against multi-threading
+        std::lock_guard<std::mutex> lock(table.mutex);
+        auto found = table.ids.find(key);
+        if(found != table.ids.end()) {
+            m_data = &table.data[found->second];
+        } else {
+            MoveId id = static_cast<MoveId>(table.data.size());
+            uint32_t mask = 0;
+            for(auto ms : symbols) {
+                mask |= 1U << ms;
+            }
+            table.data.push_back(Data{id, std::move(name), type, symbols,
+                                      mask});
+            m_data = &table.data.back();
+            table.moves.push_back(Move(m_data));
+            table.ids.emplace(key, id);
+        }
+    }
+    thread_moves.emplace(std::move(key), m_data);
 }
 
 bool Move::operator<(Move const &other) const {
-    if(m_type < other.m_type) {
+    if(m_data == other.m_data) {
+        return false;
+    }
+    if(m_data->type < other.m_data->type) {
         return true;
-    } else if(other.m_type < m_type) {
+    } else if(other.m_data->type < m_data->type) {
         return false;
     }
-    if(m_name < other.m_name) {
+    if(m_data->name < other.m_data->name) {
         return true;
-    } else if(other.m_name < m_name) {
+    } else if(other.m_data->name < m_data->name) {
         return false;
     }
-    return m_symbols < other.m_symbols;
+    return m_data->symbols < other.m_data->symbols;
 }
 
-bool Move::hasSymbol(MoveSymbol sym) const {
-    for(auto const &ms : m_symbols) {
-        if(ms == sym) {
-            return true;
-        }
-    }
-    return false;
+Move const & getMove(MoveId id) {
+    MoveTable &table = getMoveTable();
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> lock(table.mutex);
+    return table.moves[id];
+}
+
+size_t getNumMoves() {
+    MoveTable &table = getMoveTable();
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> lock(table.mutex);
+    return table.data.size();
 }
 
 int Move::apCost(bool is_far, bool is_countering) const {
     int cost = 0;
-    if(m_type == MT_WAIT) {
+    if(m_data->type == MT_WAIT) {
         return cost;
-    } else if(m_type == MT_NORMAL) {
-        cost = 1 + 2 * m_symbols.size();
-    } else if(m_type == MT_SPECIAL) {
-        cost = 1 + m_symbols.size();
-    } else if(m_type == MT_SUPER) {
-        cost = m_symbols.size();
+    } else if(m_data->type == MT_NORMAL) {
+        cost = 1 + 2 * m_data->symbols.size();
+    } else if(m_data->type == MT_SPECIAL) {
+        cost = 1 + m_data->symbols.size();
+    } else if(m_data->type == MT_SUPER) {
+        cost = m_data->symbols.size();
     }
     // Consider movement.
     if(is_far) {
@@ -118,29 +191,29 @@ int Move::apCost(bool is_far, bool is_countering) const {
 
 int Move::damage(int test_result, int character_at, int character_df, 
                  int sp_spent) const {
-    if(m_type == MT_WAIT) {
+    if(m_data->type == MT_WAIT) {
         return 0;
     }
     // Check for damage/at modifiers.
     if(hasJumpOk()) {
         character_at = character_df;
     }
-    for(auto const &ms : m_symbols) {
+    for(auto const &ms : m_data->symbols) {
         if(ms == MS_POWERFUL) {
             character_at += 1;
         }
     }
     // Check for move type
     int damage = 0;
-    if(m_type == MT_NORMAL) {
+    if(m_data->type == MT_NORMAL) {
         damage = test_result + character_at;
-    } else if(m_type == MT_SPECIAL) {
+    } else if(m_data->type == MT_SPECIAL) {
         damage = test_result + 2 * character_at;
-    } else if(m_type == MT_SUPER) {
+    } else if(m_data->type == MT_SUPER) {
         damage = test_result + 4 * character_at;
     }
     // Process Ultra Hardness after multiplication.
-    for(auto const &ms : m_symbols) {
+    for(auto const &ms : m_data->symbols) {
         if(ms == MS_ULTRA_HARDNESS) {
             damage += 2 * sp_spent;
         }
@@ -150,7 +223,7 @@ int Move::damage(int test_result, int character_at, int character_df,
 
 int Move::counterDamage(int test_result, int character_at, int character_df, 
                         int sp_spent, int reflected) const {
-    if(m_type == MT_WAIT) {
+    if(m_data->type == MT_WAIT) {
         return 0;
     }
     if(!hasReflect()) {
@@ -158,12 +231,12 @@ int Move::counterDamage(int test_result, int character_at, int character_df,
     }
     // Check for damage/at modifiers.
     int multiplier = 1;
-    if(m_type == MT_SPECIAL) {
+    if(m_data->type == MT_SPECIAL) {
         multiplier = 2;
-    } else if(m_type == MT_SUPER) {
+    } else if(m_data->type == MT_SUPER) {
         multiplier = 4;
     }
-    for(auto const &ms : m_symbols) {
+    for(auto const &ms : m_data->symbols) {
         if(ms == MS_POWERFUL) {
             reflected += multiplier;
         } else if(ms == MS_ULTRA_HARDNESS) {
@@ -220,7 +293,7 @@ void Move::modifyStatePostResolution(bool &far,
 
 int Move::comboPoints() const {
     int cp = 0;
-    for(auto const &ms : m_symbols) {
+    for(auto const &ms : m_data->symbols) {
         if(ms == MS_2XCOMBO) {
             cp += 2;
         }
@@ -247,5 +320,24 @@ std::vector<Move> const & getStandardMoves() {
     return s_standard_moves;
 }
 
+double moveSimilarity(Move const &a, Move const &b) {
+    if(a.getType() != b.getType()) {
+        return 0.0;
+    }
+    std::bitset<MS_END__> in_a;
+    std::bitset<MS_END__> in_b;
+    for(auto ms : a.getSymbols()) {
+        in_a.set(ms);
+    }
+    for(auto ms : b.getSymbols()) {
+        in_b.set(ms);
+    }
+    size_t either = (in_a | in_b).count();
+    if(either == 0) {
+        return 1.0;
+    }
+    return static_cast<double>((in_a & in_b).count()) / either;
+}
+
 }
 }
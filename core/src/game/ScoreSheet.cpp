@@ -0,0 +1,90 @@
+// Copyright 2015 Dario Domizioli
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "core/game/ScoreSheet.h"
+
+namespace core {
+namespace game {
+
+namespace {
+
+/// \brief Returns a tally seen from the other character.
+Tally mirror(Tally const &t) {
+    return Tally{t.losses, t.draws, t.wins};
+}
+
+} // close anonymous namespace
+
+Tally & Tally::operator+=(Tally const &other) {
+    wins += other.wins;
+    draws += other.draws;
+    losses += other.losses;
+    return *this;
+}
+
+void ScoreSheet::record(Character const &c1, Character const &c2,
+                        DuelResult result) {
+    Tally &t = m_tallies[std::make_pair(c1.uid, c2.uid)];
+    switch(result) {
+    case DR_C1_WINS:
+        ++t.wins;
+        break;
+    case DR_C2_WINS:
+        ++t.losses;
+        break;
+    case DR_DRAW:
+        ++t.draws;
+        break;
+    default:
+        break;
+    }
+}
+
+void ScoreSheet::add(Character const &c1, Character const &c2,
+                     Tally const &tally) {
+    m_tallies[std::make_pair(c1.uid, c2.uid)] += tally;
+}
+
+void ScoreSheet::merge(ScoreSheet const &other) {
+    for(auto const &entry : other.m_tallies) {
+        m_tallies[entry.first] += entry.second;
+    }
+}
+
+Tally ScoreSheet::getTally(Character const &c1, Character const &c2) const {
+    auto found = m_tallies.find(std::make_pair(c1.uid, c2.uid));
+    return found != m_tallies.end() ? found->second : Tally{0, 0, 0};
+}
+
+Tally ScoreSheet::getResults(Character const &a, Character const &b) const {
+    Tally t = getTally(a, b);
+    t += mirror(getTally(b, a));
+    return t;
+}
+
+Tally ScoreSheet::getTotal(Character const &c) const {
+    Tally t{0, 0, 0};
+    for(auto const &entry : m_tallies) {
+        if(entry.first.first == c.uid) {
+            t += entry.second;
+        }
+        if(entry.first.second == c.uid) {
+            t += mirror(entry.second);
+        }
+    }
+    return t;
+}
+
+}
+}
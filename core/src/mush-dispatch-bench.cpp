@@ -0,0 +1,108 @@
+//  Copyright 2015 Dario Domizioli
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+/// \file mush-dispatch-bench.cpp
+/// \brief Main file for a program that times the fights between the original
+///        characters, driven by the expert systems, with the decisions called
+///        through the static fast path and through the virtual interface.
+
+#include "core/chars/NamedCharacters.h"
+#include "core/ctrl/ExpertSystemCtrl.h"
+#include "core/game/Character.h"
+#include "core/game/Dice.h"
+#include "core/game/Duel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+/// The number of times each path is timed.
+static int const BENCH_ROUNDS = 5;
+
+/// \brief Fights every pair of original characters 'fights' times with the
+///        given dispatch, from the same seed; returns the elapsed seconds and
+///        stores the number of wins of the first characters in 'c1_wins'.
+static double timeFights(
+    std::vector<std::shared_ptr<core::game::Character>> const &chars,
+    int fights, bool static_dispatch, unsigned long &c1_wins) {
+    core::game::seedDice(42);
+    c1_wins = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(size_t i = 0; i < chars.size(); ++i) {
+        for(size_t j = i + 1; j < chars.size(); ++j) {
+            core::game::Duel d{chars[i], chars[j], nullptr};
+            d.setStaticDispatch(static_dispatch);
+            core::game::DuelState initial = d.getState();
+            for(int f = 0; f < fights; ++f) {
+                d.setState(initial);
+                d.fight();
+                if(d.result() == core::game::DR_C1_WINS) {
+                    ++c1_wins;
+                }
+            }
+        }
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+/// \brief Main function for a program that compares the static and virtual
+///        dispatch of the expert systems; the optional argument is the number
+///        of fights per pair of characters.
+int main(int argc, char **argv) {
+    int fights = argc > 1 ? std::atoi(argv[1]) : 1000;
+    if(fights <= 0) {
+        std::cerr << "The number of fights must be positive." << std::endl;
+        return 1;
+    }
+    auto chars = core::chars::getOriginalCharacters();
+    // The roster uses learning AIs; give everyone an expert system instead.
+    int combinations = core::ctrl::getNumExpertSystemsCombinations();
+    for(size_t i = 0; i < chars.size(); ++i) {
+        chars[i]->actrl = core::ctrl::getAttackExpertSystem(i % combinations);
+        chars[i]->dctrl = core::ctrl::getDefenceExpertSystem(i % combinations);
+    }
+    size_t pairs = chars.size() * (chars.size() - 1) / 2;
+    double total = static_cast<double>(pairs) * fights;
+
+    // Alternate the two paths and keep the best time of each, which is the
+    // least disturbed by whatever else runs on the machine.
+    unsigned long virtual_wins = 0;
+    unsigned long static_wins = 0;
+    double virtual_secs = 0.0;
+    double static_secs = 0.0;
+    for(int round = 0; round < BENCH_ROUNDS; ++round) {
+        double v = timeFights(chars, fights, false, virtual_wins);
+        double s = timeFights(chars, fights, true, static_wins);
+        virtual_secs = round == 0 ? v : std::min(virtual_secs, v);
+        static_secs = round == 0 ? s : std::min(static_secs, s);
+    }
+
+    std::cout << "Best of " << BENCH_ROUNDS << " rounds of " << total
+              << " fights." << std::endl;
+    std::cout << "Virtual dispatch: " << virtual_secs << " s, "
+              << total / virtual_secs << " fights/s" << std::endl;
+    std::cout << "Static dispatch:  " << static_secs << " s, "
+              << total / static_secs << " fights/s" << std::endl;
+    std::cout << "Speedup: " << virtual_secs / static_secs << "x" << std::endl;
+    if(virtual_wins != static_wins) {
+        std::cerr << "The two paths gave different results!" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,341 @@
+// Copyright 2015 Dario Domizioli
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "core/sim/Checkpoint.h"
+
+#include "core/ctrl/CtrlInterfaces.h"
+#include "core/game/Dice.h"
+#include "core/sim/ResultCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+namespace core {
+namespace sim {
+
+namespace {
+
+/// The version of the checkpoint layout.
+uint32_t const CHECKPOINT_VERSION = 1;
+
+/// The header of a checkpoint file, followed by a record, a name and the
+/// states of the control systems of each character, then by the outcomes,
+/// the random generators and the ratings.
+struct CheckpointHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t characters;
+    uint64_t round;
+    uint64_t tallies;
+    uint64_t random_size;
+    uint64_t ratings_size;
+};
+static_assert(sizeof(CheckpointHeader) == 48,
+              "Unexpected CheckpointHeader padding");
+
+struct CharacterRecord {
+    uint64_t hash;
+    int64_t total_points;
+    uint64_t attack_size;
+    uint64_t defence_size;
+};
+static_assert(sizeof(CharacterRecord) == 32,
+              "Unexpected CharacterRecord padding");
+
+struct TallyRecord {
+    uint32_t first;
+    uint32_t second;
+    uint64_t wins;
+    uint64_t draws;
+    uint64_t losses;
+};
+static_assert(sizeof(TallyRecord) == 32, "Unexpected TallyRecord padding");
+
+char const s_checkpoint_magic[8] = { 'M', 'U', 'S', 'H', 'C', 'K', 'P', 'T' };
+
+/// The largest state of a control system that is believed; the Markov AI
+/// needs about 10MB.
+uint64_t const MAX_STATE_SIZE = 1ULL << 30;
+
+/// \brief Reads 'size' bytes into 'data'.
+bool readBlob(std::istream &in, uint64_t size, std::string &data) {
+    if(size > MAX_STATE_SIZE) {
+        return false;
+    }
+    data.assign(static_cast<size_t>(size), '\0');
+    return size == 0 || static_cast<bool>(in.read(&data[0], data.size()));
+}
+
+} // close anonymous namespace
+
+Checkpoint::Checkpoint() : m_round(0) {}
+
+void Checkpoint::take(
+    std::vector<std::shared_ptr<game::Character>> const &characters,
+    game::ScoreSheet const &scores, RatingEngine const *ratings,
+    uint64_t round) {
+    m_round = round;
+    m_characters.clear();
+    std::map<size_t, uint32_t> indices;
+    for(auto const &c : characters) {
+        indices[c->uid] = static_cast<uint32_t>(m_characters.size());
+        std::ostringstream attack;
+        std::ostringstream defence;
+        c->actrl->saveState(attack);
+        c->dctrl->saveState(defence);
+        m_characters.push_back(CharacterState{
+            c->name, characterHash(*c), c->total_points.load(), attack.str(),
+            defence.str() });
+    }
+    m_tallies.clear();
+    for(auto const &entry : scores.getTallies()) {
+        auto first = indices.find(entry.first.first);
+        auto second = indices.find(entry.first.second);
+        if(first != indices.end() && second != indices.end()) {
+            m_tallies.push_back(
+                TallyState{ first->second, second->second, entry.second });
+        }
+    }
+    std::ostringstream random;
+    game::saveRandomState(random);
+    m_random = random.str();
+    m_ratings.clear();
+    if(ratings) {
+        std::ostringstream out;
+        ratings->save(out);
+        m_ratings = out.str();
+    }
+}
+
+bool Checkpoint::restore(
+    std::vector<std::shared_ptr<game::Character>> const &characters,
+    game::ScoreSheet &scores, RatingEngine *ratings,
+    std::string &error) const {
+    if(characters.size() != m_characters.size()) {
+        error = "the checkpoint has " + std::to_string(m_characters.size())
+                + " characters instead of "
+                + std::to_string(characters.size());
+        return false;
+    }
+    for(size_t i = 0; i < characters.size(); ++i) {
+        if(characters[i]->name != m_characters[i].name
+           || characterHash(*characters[i]) != m_characters[i].hash) {
+            error = "character " + characters[i]->name
+                    + " is not the one in the checkpoint";
+            return false;
+        }
+    }
+    for(size_t i = 0; i < characters.size(); ++i) {
+        game::Character &c = *characters[i];
+        std::istringstream attack(m_characters[i].attack);
+        std::istringstream defence(m_characters[i].defence);
+        if(!c.actrl->loadState(attack) || !c.dctrl->loadState(defence)) {
+            error = "cannot restore the AIs of " + c.name;
+            return false;
+        }
+        c.total_points = m_characters[i].total_points;
+    }
+    for(auto const &t : m_tallies) {
+        if(t.first >= characters.size() || t.second >= characters.size()) {
+            error = "malformed outcomes";
+            return false;
+        }
+        scores.add(*characters[t.first], *characters[t.second], t.tally);
+    }
+    std::istringstream random(m_random);
+    if(!game::loadRandomState(random)) {
+        error = "cannot restore the random generators";
+        return false;
+    }
+    if(ratings && !m_ratings.empty()) {
+        std::istringstream in(m_ratings);
+        if(!ratings->load(in, error)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Checkpoint::write(std::string const &path, std::string &error) const {
+    // Write a new file and then replace the old one, so that a crash while
+    // writing leaves the previous checkpoint intact.
+    std::string temporary = path + ".tmp";
+    std::ofstream out(temporary, std::ios::binary);
+
+    CheckpointHeader h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, s_checkpoint_magic, sizeof(s_checkpoint_magic));
+    h.version = CHECKPOINT_VERSION;
+    h.characters = static_cast<uint32_t>(m_characters.size());
+    h.round = m_round;
+    h.tallies = m_tallies.size();
+    h.random_size = m_random.size();
+    h.ratings_size = m_ratings.size();
+    out.write(reinterpret_cast<char const *>(&h), sizeof(h));
+
+    for(auto const &c : m_characters) {
+        CharacterRecord r;
+        r.hash = c.hash;
+        r.total_points = c.total_points;
+        r.attack_size = c.attack.size();
+        r.defence_size = c.defence.size();
+        out.write(reinterpret_cast<char const *>(&r), sizeof(r));
+        out.write(c.name.c_str(), c.name.size() + 1);
+        out.write(c.attack.data(), c.attack.size());
+        out.write(c.defence.data(), c.defence.size());
+    }
+    for(auto const &t : m_tallies) {
+        TallyRecord r = { t.first, t.second, t.tally.wins, t.tally.draws,
+                          t.tally.losses };
+        out.write(reinterpret_cast<char const *>(&r), sizeof(r));
+    }
+    out.write(m_random.data(), m_random.size());
+    out.write(m_ratings.data(), m_ratings.size());
+    out.close();
+    if(!out || std::rename(temporary.c_str(), path.c_str()) != 0) {
+        error = "cannot write '" + path + "'";
+        return false;
+    }
+    return true;
+}
+
+bool Checkpoint::read(std::string const &path, std::string &error) {
+    std::ifstream in(path, std::ios::binary);
+    if(!in) {
+        error = "cannot read '" + path + "'";
+        return false;
+    }
+    error = "'" + path + "' is not a valid checkpoint";
+
+    CheckpointHeader h;
+    if(!in.read(reinterpret_cast<char *>(&h), sizeof(h))
+       || std::memcmp(h.magic, s_checkpoint_magic, sizeof(s_checkpoint_magic))
+       || h.version != CHECKPOINT_VERSION) {
+        return false;
+    }
+    std::vector<CharacterState> characters(h.characters);
+    for(auto &c : characters) {
+        CharacterRecord r;
+        if(!in.read(reinterpret_cast<char *>(&r), sizeof(r))
+           || !std::getline(in, c.name, '\0')
+           || !readBlob(in, r.attack_size, c.attack)
+           || !readBlob(in, r.defence_size, c.defence)) {
+            return false;
+        }
+        c.hash = r.hash;
+        c.total_points = static_cast<int>(r.total_points);
+    }
+    std::vector<TallyState> tallies;
+    for(uint64_t i = 0; i < h.tallies; ++i) {
+        TallyRecord r;
+        if(!in.read(reinterpret_cast<char *>(&r), sizeof(r))) {
+            return false;
+        }
+        game::Tally t;
+        t.wins = static_cast<size_t>(r.wins);
+        t.draws = static_cast<size_t>(r.draws);
+        t.losses = static_cast<size_t>(r.losses);
+        tallies.push_back(TallyState{ r.first, r.second, t });
+    }
+    std::string random;
+    std::string ratings;
+    if(!readBlob(in, h.random_size, random)
+       || !readBlob(in, h.ratings_size, ratings)) {
+        return false;
+    }
+
+    m_round = h.round;
+    m_characters.swap(characters);
+    m_tallies.swap(tallies);
+    m_random.swap(random);
+    m_ratings.swap(ratings);
+    error.clear();
+    return true;
+}
+
+CheckpointWriter::CheckpointWriter(std::string const &path, double interval)
+  : m_path(path), m_interval(interval),
+    m_last(std::chrono::steady_clock::now()), m_busy(false), m_stop(false),
+    m_written(0) {
+    m_thread = std::thread(&CheckpointWriter::work, this);
+}
+
+CheckpointWriter::~CheckpointWriter() {
+    if(true) { // Just to have a scope
+        std::lock_guard<std::mutex> protect(m_mutex);
+        m_stop = true;
+    }
+    m_changed.notify_all();
+    m_thread.join();
+}
+
+bool CheckpointWriter::isDue() const {
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> protect(m_mutex);
+    return std::chrono::steady_clock::now() - m_last >= m_interval;
+}
+
+void CheckpointWriter::submit(std::unique_ptr<Checkpoint> checkpoint) {
+    if(true) { // Just to have a scope
+        std::lock_guard<std::mutex> protect(m_mutex);
+        m_pending = std::move(checkpoint);
+        m_last = std::chrono::steady_clock::now();
+    }
+    m_changed.notify_all();
+}
+
+bool CheckpointWriter::flush(std::string &error) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_changed.wait(lock, [this]() { return !m_pending && !m_busy; });
+    if(!m_error.empty()) {
+        error = m_error;
+        return false;
+    }
+    return true;
+}
+
+size_t CheckpointWriter::written() const {
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> protect(m_mutex);
+    return m_written;
+}
+
+void CheckpointWriter::work() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for(;;) {
+        m_changed.wait(lock, [this]() { return m_pending || m_stop; });
+        if(!m_pending) {
+            return;
+        }
+        std::unique_ptr<Checkpoint> checkpoint = std::move(m_pending);
+        m_busy = true;
+        lock.unlock();
+        std::string error;
+        bool ok = checkpoint->write(m_path, error);
+        lock.lock();
+        m_busy = false;
+        if(ok) {
+            ++m_written;
+        } else {
+            m_error = error;
+        }
+        m_changed.notify_all();
+    }
+}
+
+}
+}
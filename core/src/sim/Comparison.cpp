@@ -0,0 +1,161 @@
+// Copyright 2015 Dario Domizioli
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "core/sim/Comparison.h"
+
+#include "core/game/Dice.h"
+#include "core/game/Duel.h"
+
+#include <cmath>
+
+namespace core {
+namespace sim {
+
+namespace {
+
+/// \brief Derives the seed of a fight from the seed of a comparison, so that
+///        neighbouring fights get unrelated dice.
+unsigned long fightSeed(unsigned long seed, size_t fight) {
+    unsigned long long z = seed + 0x9E3779B97F4A7C15ULL * (fight + 1);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return static_cast<unsigned long>(z ^ (z >> 31));
+}
+
+/// \brief Returns the score of c1 in a fight on the given dice.
+double fightScore(std::shared_ptr<game::Character> c1,
+                  std::shared_ptr<game::Character> c2,
+                  game::SeededDiceSource &dice) {
+    game::Duel duel(c1, c2, nullptr, &dice);
+    while(duel.step()) {}
+    // The fight only measures the characters, so nothing is learnt from it.
+    duel.abandon();
+    switch(duel.result()) {
+        case game::DR_C1_WINS: return 1.0;
+        case game::DR_C2_WINS: return 0.0;
+        default: return 0.5;
+    }
+}
+
+/// \brief Accumulates the variance of values grouped by opponent, so that
+///        the differences between opponents do not count.
+class PooledVariance {
+public:
+    PooledVariance() : m_sum_sq(0.0), m_dof(0) {}
+
+    void add(std::vector<double> const &values) {
+        if(values.size() < 2) {
+            return;
+        }
+        double mean = 0.0;
+        for(double v : values) {
+            mean += v;
+        }
+        mean /= values.size();
+        for(double v : values) {
+            m_sum_sq += (v - mean) * (v - mean);
+        }
+        m_dof += values.size() - 1;
+    }
+
+    double variance() const { return m_dof ? m_sum_sq / m_dof : 0.0; }
+
+private:
+    double m_sum_sq;
+    size_t m_dof;
+};
+
+}
+
+Comparison compare(std::shared_ptr<game::Character> a,
+                   std::shared_ptr<game::Character> b,
+                   std::vector<std::shared_ptr<game::Character>> const &opponents,
+                   size_t samples, unsigned long seed,
+                   DiceSharing sharing) {
+    game::SeededDiceSource dice;
+    size_t passes = (sharing == DS_ANTITHETIC) ? 2 : 1;
+    // Fights of "a" and of "b" in one sample.
+    size_t fights_per_sample = 2 * passes;
+
+    PooledVariance var_a, var_b, var_diff;
+    double total_diff = 0.0;
+    size_t total_samples = 0;
+    size_t sample = 0;
+    // Single fights are grouped by opponent and side.
+    std::vector<double> fights_a[2], fights_b[2], diffs;
+    for(auto const &o : opponents) {
+        if(o == a || o == b) {
+            continue;
+        }
+        for(size_t side = 0; side < 2; ++side) {
+            fights_a[side].clear();
+            fights_b[side].clear();
+        }
+        diffs.clear();
+        for(size_t i = 0; i < samples; ++i, ++sample) {
+            double score_a = 0.0, score_b = 0.0;
+            for(size_t pass = 0; pass < passes; ++pass) {
+                // The mirrored pass reuses the seeds of the plain one.
+                bool mirror = (pass == 1);
+                for(size_t side = 0; side < 2; ++side) {
+                    size_t id = (sample * 2 + side) * 2;
+                    unsigned long seed_a = fightSeed(seed, id);
+                    unsigned long seed_b = (sharing == DS_INDEPENDENT)
+                                           ? fightSeed(seed, id + 1)
+                                           : seed_a;
+                    double sa, sb;
+                    dice.reset(seed_a, mirror);
+                    sa = side ? 1.0 - fightScore(o, a, dice)
+                              : fightScore(a, o, dice);
+                    dice.reset(seed_b, mirror);
+                    sb = side ? 1.0 - fightScore(o, b, dice)
+                              : fightScore(b, o, dice);
+                    fights_a[side].push_back(sa);
+                    fights_b[side].push_back(sb);
+                    score_a += sa;
+                    score_b += sb;
+                }
+            }
+            diffs.push_back((score_a - score_b) / fights_per_sample);
+        }
+        for(size_t side = 0; side < 2; ++side) {
+            var_a.add(fights_a[side]);
+            var_b.add(fights_b[side]);
+        }
+        var_diff.add(diffs);
+        for(double d : diffs) {
+            total_diff += d;
+        }
+        total_samples += diffs.size();
+    }
+
+    Comparison result;
+    result.fights = total_samples * fights_per_sample * 2;
+    result.difference = total_samples ? total_diff / total_samples : 0.0;
+    result.std_error = total_samples
+                       ? std::sqrt(var_diff.variance() / total_samples)
+                       : 0.0;
+    // With independent dice, a sample of the same cost would have the
+    // variance of a single fight of each character, divided by the number of
+    // fights per character in a sample.
+    double independent = (var_a.variance() + var_b.variance())
+                         / fights_per_sample;
+    result.variance_reduction = var_diff.variance() > 0.0
+                                ? independent / var_diff.variance()
+                                : 0.0;
+    return result;
+}
+
+}
+}
@@ -0,0 +1,300 @@
+// Copyright 2015 Dario Domizioli
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "core/sim/MatchupSampler.h"
+#include "core/sim/ThreadPool.h"
+
+#include "core/game/BatchDuel.h"
+#include "core/game/Dice.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <stdint.h>
+
+namespace core {
+namespace sim {
+
+namespace {
+
+/// \brief Returns the tally of a single fight.
+PairTally tallyOf(game::DuelResult result) {
+    PairTally t;
+    switch(result) {
+        case game::DR_C1_WINS: ++t.wins; break;
+        case game::DR_C2_WINS: ++t.losses; break;
+        default: ++t.draws; break;
+    }
+    return t;
+}
+
+/// The version of the binary matrix layout.
+uint32_t const BINARY_MATRIX_VERSION = 1;
+
+/// The header of a binary matrix, followed by a record per ordered pair,
+/// row by row, and by the names, each NUL-terminated.
+struct MatrixHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t characters;
+    uint32_t names_size;
+    uint32_t reserved;
+};
+static_assert(sizeof(MatrixHeader) == 24, "Unexpected MatrixHeader padding");
+
+struct PairRecord {
+    uint32_t wins;
+    uint32_t draws;
+    uint32_t losses;
+};
+static_assert(sizeof(PairRecord) == 12, "Unexpected PairRecord padding");
+
+char const s_matrix_magic[8] = { 'M', 'U', 'S', 'H', 'M', 'T', 'R', 'X' };
+
+} // close anonymous namespace
+
+SamplerOptions SamplerOptions::forBudget(size_t characters, size_t reps) {
+    SamplerOptions options;
+    options.min_fights = std::max<size_t>(reps / 10, 4);
+    options.batch = std::max<size_t>(options.min_fights / 2, 2);
+    options.max_fights = reps * 2;
+    options.budget = reps * characters * (characters > 0 ? characters - 1 : 0);
+    options.z = 2.576;
+    options.resolution = 0.1;
+    options.precision = 0.0;
+    return options;
+}
+
+SamplerOptions SamplerOptions::forPrecision(size_t characters,
+                                            double precision) {
+    SamplerOptions options;
+    options.z = 1.96;
+    // The widest interval, at a score of 0.5, is about z / sqrt(fights).
+    double needed = std::ceil(options.z * options.z / (precision * precision));
+    options.max_fights = static_cast<size_t>(needed) + 1;
+    options.min_fights = std::min<size_t>(8, options.max_fights);
+    options.batch = std::max<size_t>(options.max_fights / 16, 2);
+    options.budget = options.max_fights * characters
+                     * (characters > 0 ? characters - 1 : 0);
+    options.resolution = precision;
+    options.precision = precision;
+    return options;
+}
+
+MatchupSampler::MatchupSampler(
+    std::vector<std::shared_ptr<game::Character>> const &characters,
+    SamplerOptions const &options)
+  : m_characters(characters),
+    m_options(options),
+    m_tallies(characters.size() * characters.size()),
+    m_fights(0) {
+}
+
+bool MatchupSampler::isSettled(size_t i, size_t j) const {
+    PairTally const &t = tally(i, j);
+    if(t.fights() < m_options.min_fights) {
+        return false;
+    }
+    if(t.fights() >= m_options.max_fights) {
+        return true;
+    }
+    Interval interval = t.scoreInterval(m_options.z);
+    if(m_options.precision > 0.0) {
+        return interval.width() <= m_options.precision;
+    }
+    return !interval.contains(0.5) || interval.width() < m_options.resolution;
+}
+
+size_t MatchupSampler::unsettledPairs() const {
+    size_t count = 0;
+    for(size_t i = 0; i < m_characters.size(); ++i) {
+        for(size_t j = 0; j < m_characters.size(); ++j) {
+            if(i != j && !isSettled(i, j)) {
+                ++count;
+            }
+        }
+    }
+    return count;
+}
+
+double MatchupSampler::widestInterval() const {
+    double widest = 0.0;
+    for(size_t i = 0; i < m_characters.size(); ++i) {
+        for(size_t j = 0; j < m_characters.size(); ++j) {
+            if(i != j) {
+                widest = std::max(widest,
+                                  tally(i, j).scoreInterval(m_options.z).width());
+            }
+        }
+    }
+    return widest;
+}
+
+double MatchupSampler::expectedPoints(size_t i) const {
+    double points = 0.0;
+    for(size_t j = 0; j < m_characters.size(); ++j) {
+        if(i != j) {
+            points += tally(i, j).points() + tally(j, i).opponentPoints();
+        }
+    }
+    return points;
+}
+
+void MatchupSampler::run(unsigned threads, std::ostream *report_stream,
+                         std::ostream *progress_stream) {
+    size_t n = m_characters.size();
+    std::vector<std::pair<size_t, size_t>> pairs;
+    ThreadPool pool(std::max(threads, 1U));
+    size_t round = 0;
+    while(m_fights < m_options.budget) {
+        // Pick the pairs which need more fights, widest intervals first so
+        // that they get the budget if it is about to run out.
+        std::vector<std::pair<double, size_t>> candidates;
+        for(size_t i = 0; i < n; ++i) {
+            for(size_t j = 0; j < n; ++j) {
+                if(i != j && !isSettled(i, j)) {
+                    double width = tally(i, j).scoreInterval(m_options.z).width();
+                    candidates.push_back(std::make_pair(-width, i * n + j));
+                }
+            }
+        }
+        if(candidates.empty()) {
+            break;
+        }
+        std::stable_sort(candidates.begin(), candidates.end());
+
+        pairs.clear();
+        size_t left = m_options.budget - m_fights;
+        for(auto const &c : candidates) {
+            PairTally const &t = m_tallies[c.second];
+            size_t wanted = t.fights() < m_options.min_fights
+                            ? m_options.min_fights - t.fights()
+                            : m_options.batch;
+            wanted = std::min(wanted, m_options.max_fights - t.fights());
+            wanted = std::min(wanted, left);
+            pairs.push_back(std::make_pair(c.second, wanted));
+            left -= wanted;
+            if(left == 0) {
+                break;
+            }
+        }
+        runFights(pairs, pool, report_stream);
+        ++round;
+        if(progress_stream) {
+            *progress_stream << "Round " << round << ": " << m_fights
+                             << " fights, " << unsettledPairs()
+                             << " pairs unsettled, widest interval "
+                             << widestInterval() << "." << std::endl;
+        }
+    }
+}
+
+void MatchupSampler::writeMatrix(std::ostream &out) const {
+    out << "first,second,fights,win,draw,loss,score,score_low,score_high"
+        << std::endl;
+    for(size_t i = 0; i < m_characters.size(); ++i) {
+        for(size_t j = 0; j < m_characters.size(); ++j) {
+            if(i == j) {
+                continue;
+            }
+            PairTally const &t = tally(i, j);
+            double n = t.fights() ? static_cast<double>(t.fights()) : 1.0;
+            Interval interval = t.scoreInterval(m_options.z);
+            out << "\"" << m_characters[i]->name << "\",\""
+                << m_characters[j]->name << "\"," << t.fights() << ","
+                << t.wins / n << "," << t.draws / n << "," << t.losses / n
+                << "," << t.score() << "," << interval.low << ","
+                << interval.high << std::endl;
+        }
+    }
+}
+
+bool MatchupSampler::writeBinaryMatrix(std::string const &path,
+                                       std::string &error) const {
+    size_t n = m_characters.size();
+    std::vector<PairRecord> records(n * n);
+    for(size_t p = 0; p < records.size(); ++p) {
+        records[p].wins = static_cast<uint32_t>(m_tallies[p].wins);
+        records[p].draws = static_cast<uint32_t>(m_tallies[p].draws);
+        records[p].losses = static_cast<uint32_t>(m_tallies[p].losses);
+    }
+    std::string names;
+    for(auto const &c : m_characters) {
+        names.append(c->name.c_str(), c->name.size() + 1);
+    }
+    MatrixHeader h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, s_matrix_magic, sizeof(s_matrix_magic));
+    h.version = BINARY_MATRIX_VERSION;
+    h.characters = static_cast<uint32_t>(n);
+    h.names_size = static_cast<uint32_t>(names.size());
+
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<char const *>(&h), sizeof(h));
+    out.write(reinterpret_cast<char const *>(records.data()),
+              records.size() * sizeof(PairRecord));
+    out.write(names.data(), names.size());
+    if(!out) {
+        error = "cannot write '" + path + "'";
+        return false;
+    }
+    return true;
+}
+
+void MatchupSampler::runFights(
+        std::vector<std::pair<size_t, size_t>> const &pairs,
+        ThreadPool &pool, std::ostream *report_stream) {
+    size_t n = m_characters.size();
+    std::mutex tallies_mutex;
+    std::atomic<size_t> next(0);
+    pool.run([&](unsigned) {
+        for(size_t k = next++; k < pairs.size(); k = next++) {
+            size_t p = pairs[k].first;
+            size_t count = pairs[k].second;
+            PairTally tally;
+            if(report_stream) {
+                // Chronicles need the fights one by one.
+                for(size_t i = 0; i < count; ++i) {
+                    game::Duel d(m_characters[p / n], m_characters[p % n],
+                                 report_stream);
+                    while(d.step()) {}
+                    tally += tallyOf(d.result());
+                    d.conclude();
+                }
+            } else {
+                unsigned long seed = 0;
+                if(true) { // Just to have a scope
+                    std::lock_guard<std::mutex> lock(game::getRandomGenMutex());
+                    seed = game::getRandomGenerator()();
+                }
+                game::BatchDuel batch(m_characters[p / n],
+                                      m_characters[p % n], count, seed);
+                batch.fight();
+                for(game::DuelResult r : batch.results()) {
+                    tally += tallyOf(r);
+                }
+                batch.conclude();
+            }
+            std::lock_guard<std::mutex> lock(tallies_mutex);
+            m_tallies[p] += tally;
+            m_fights += count;
+        }
+    });
+}
+
+}
+}
@@ -0,0 +1,302 @@
+// Copyright 2015 Dario Domizioli
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "core/sim/Rating.h"
+#include "core/sim/ResultCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <sstream>
+
+namespace core {
+namespace sim {
+
+namespace {
+
+/// The factor between the Glicko and Glicko-2 scales.
+double const GLICKO2_SCALE = 173.7178;
+/// The convergence threshold of the volatility.
+double const GLICKO2_EPSILON = 0.000001;
+double const PI = 3.14159265358979323846;
+
+/// \brief The Glicko-2 weight of a deviation, on the Glicko-2 scale.
+double g(double phi) {
+    return 1.0 / std::sqrt(1.0 + 3.0 * phi * phi / (PI * PI));
+}
+
+/// \brief The Glicko-2 expected score of 'mu' against 'mu_j', whose
+///        deviation is 'phi_j'.
+double expected(double mu, double mu_j, double phi_j) {
+    return 1.0 / (1.0 + std::exp(-g(phi_j) * (mu - mu_j)));
+}
+
+/// \brief The Elo expected score of 'r' against 'r_j'.
+double eloExpected(double r, double r_j) {
+    return 1.0 / (1.0 + std::pow(10.0, (r_j - r) / 400.0));
+}
+
+/// \brief The sums a rating period needs for one character.
+struct Period {
+    Period() : variance(0.0), improvement(0.0), elo(0.0), fights(0) {}
+
+    /// Sum of g^2 E (1 - E) per fight (Glicko-2).
+    double variance;
+    /// Sum of g (s - E) per fight (Glicko-2).
+    double improvement;
+    /// Sum of s - E per fight (Elo).
+    double elo;
+    /// The number of fights.
+    size_t fights;
+};
+
+/// \brief Returns the new Glicko-2 volatility (step 5 of the algorithm, with
+///        the Illinois method).
+double newVolatility(double phi, double sigma, double v, double delta,
+                     double tau) {
+    double a = std::log(sigma * sigma);
+    auto f = [&](double x) {
+        double ex = std::exp(x);
+        double d = phi * phi + v + ex;
+        return ex * (delta * delta - phi * phi - v - ex) / (2.0 * d * d)
+               - (x - a) / (tau * tau);
+    };
+    double low = a;
+    double high = 0.0;
+    if(delta * delta > phi * phi + v) {
+        high = std::log(delta * delta - phi * phi - v);
+    } else {
+        double k = 1.0;
+        while(f(a - k * tau) < 0.0) {
+            k += 1.0;
+        }
+        high = a - k * tau;
+    }
+    double f_low = f(low);
+    double f_high = f(high);
+    while(std::fabs(high - low) > GLICKO2_EPSILON) {
+        double c = low + (low - high) * f_low / (f_high - f_low);
+        double f_c = f(c);
+        if(f_c * f_high <= 0.0) {
+            low = high;
+            f_low = f_high;
+        } else {
+            f_low /= 2.0;
+        }
+        high = c;
+        f_high = f_c;
+    }
+    return std::exp(low / 2.0);
+}
+
+} // close anonymous namespace
+
+Rating Rating::initial() {
+    return Rating{1500.0, 350.0, 0.06, 0};
+}
+
+RatingOptions RatingOptions::forSystem(RatingSystem system) {
+    RatingOptions options;
+    options.system = system;
+    options.elo_k = 16.0;
+    options.tau = 0.5;
+    return options;
+}
+
+RatingEngine::RatingEngine(RatingOptions const &options)
+  : m_options(options) {
+}
+
+void RatingEngine::addCharacter(game::Character const &c) {
+    uint64_t hash = characterHash(c);
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> protect(m_mutex);
+    m_names[c.uid] = c.name;
+    auto known = m_hashes.find(c.name);
+    if(known == m_hashes.end() || known->second != hash) {
+        // A new character, even if an old one had the same name.
+        m_ratings[c.name] = Rating::initial();
+        m_hashes[c.name] = hash;
+    }
+}
+
+void RatingEngine::update(game::ScoreSheet const &sheet) {
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> protect(m_mutex);
+
+    // All the fights of a period are rated against the ratings before it.
+    std::map<std::string, Period> periods;
+    auto account = [&](std::string const &name, Rating const &r,
+                       Rating const &o, size_t n, double score) {
+        Period &p = periods[name];
+        p.fights += n;
+        if(m_options.system == RS_ELO) {
+            p.elo += score - n * eloExpected(r.rating, o.rating);
+            return;
+        }
+        double mu = (r.rating - 1500.0) / GLICKO2_SCALE;
+        double mu_j = (o.rating - 1500.0) / GLICKO2_SCALE;
+        double phi_j = o.deviation / GLICKO2_SCALE;
+        double e = expected(mu, mu_j, phi_j);
+        p.variance += n * g(phi_j) * g(phi_j) * e * (1.0 - e);
+        p.improvement += g(phi_j) * (score - n * e);
+    };
+    for(auto const &entry : sheet.getTallies()) {
+        auto first = m_names.find(entry.first.first);
+        auto second = m_names.find(entry.first.second);
+        if(first == m_names.end() || second == m_names.end()
+           || first->second == second->second) {
+            continue;
+        }
+        game::Tally const &t = entry.second;
+        Rating const &r1 = m_ratings[first->second];
+        Rating const &r2 = m_ratings[second->second];
+        account(first->second, r1, r2, t.fights(), t.wins + 0.5 * t.draws);
+        account(second->second, r2, r1, t.fights(), t.losses + 0.5 * t.draws);
+    }
+
+    std::map<std::string, Rating> updated;
+    for(auto const &entry : m_names) {
+        std::string const &name = entry.second;
+        if(updated.count(name)) {
+            continue;
+        }
+        Rating r = m_ratings[name];
+        auto found = periods.find(name);
+        if(m_options.system == RS_ELO) {
+            if(found != periods.end()) {
+                r.rating += m_options.elo_k * found->second.elo;
+                r.fights += found->second.fights;
+            }
+            updated[name] = r;
+            continue;
+        }
+        double phi = r.deviation / GLICKO2_SCALE;
+        if(found == periods.end() || found->second.fights == 0) {
+            // No fights: only the uncertainty grows.
+            phi = std::sqrt(phi * phi + r.volatility * r.volatility);
+            r.deviation = phi * GLICKO2_SCALE;
+            updated[name] = r;
+            continue;
+        }
+        Period const &p = found->second;
+        double v = 1.0 / p.variance;
+        double delta = v * p.improvement;
+        r.volatility = newVolatility(phi, r.volatility, v, delta,
+                                     m_options.tau);
+        double phi_star = std::sqrt(phi * phi + r.volatility * r.volatility);
+        double new_phi = 1.0 / std::sqrt(1.0 / (phi_star * phi_star) + 1.0 / v);
+        double mu = (r.rating - 1500.0) / GLICKO2_SCALE
+                    + new_phi * new_phi * p.improvement;
+        r.rating = 1500.0 + mu * GLICKO2_SCALE;
+        r.deviation = new_phi * GLICKO2_SCALE;
+        r.fights += p.fights;
+        updated[name] = r;
+    }
+    for(auto const &entry : updated) {
+        m_ratings[entry.first] = entry.second;
+    }
+}
+
+Rating RatingEngine::getRating(std::string const &name) const {
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> protect(m_mutex);
+    auto found = m_ratings.find(name);
+    return found != m_ratings.end() ? found->second : Rating::initial();
+}
+
+std::vector<std::pair<std::string, Rating>> RatingEngine::getRanking() const {
+    std::vector<std::pair<std::string, Rating>> ranking;
+    if(true) { // Just to have a scope
+        // Protect ourselves against multi-threading
+        std::lock_guard<std::mutex> protect(m_mutex);
+        ranking.assign(m_ratings.begin(), m_ratings.end());
+    }
+    std::stable_sort(ranking.begin(), ranking.end(),
+                     [](std::pair<std::string, Rating> const &a,
+                        std::pair<std::string, Rating> const &b) {
+                         return a.second.rating > b.second.rating;
+                     });
+    return ranking;
+}
+
+double RatingEngine::expectedScore(Rating const &a, Rating const &b) const {
+    if(m_options.system == RS_ELO) {
+        return eloExpected(a.rating, b.rating);
+    }
+    double phi_a = a.deviation / GLICKO2_SCALE;
+    double phi_b = b.deviation / GLICKO2_SCALE;
+    return expected((a.rating - 1500.0) / GLICKO2_SCALE,
+                    (b.rating - 1500.0) / GLICKO2_SCALE,
+                    std::sqrt(phi_a * phi_a + phi_b * phi_b));
+}
+
+bool RatingEngine::load(std::istream &in, std::string &error) {
+    std::map<std::string, std::pair<uint64_t, Rating>> loaded;
+    std::string line;
+    size_t line_number = 0;
+    while(std::getline(in, line)) {
+        ++line_number;
+        if(line.empty() || line[0] == '#') {
+            continue;
+        }
+        size_t tab = line.find('\t');
+        if(tab == std::string::npos) {
+            error = "Line " + std::to_string(line_number) + ": no ratings";
+            return false;
+        }
+        uint64_t hash = 0;
+        Rating r;
+        std::istringstream fields(line.substr(tab + 1));
+        if(!(fields >> hash >> r.rating >> r.deviation >> r.volatility
+                    >> r.fights)) {
+            error = "Line " + std::to_string(line_number)
+                    + ": malformed ratings";
+            return false;
+        }
+        loaded[line.substr(0, tab)] = std::make_pair(hash, r);
+    }
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> protect(m_mutex);
+    std::set<std::string> added;
+    for(auto const &entry : m_names) {
+        added.insert(entry.second);
+    }
+    for(auto const &entry : loaded) {
+        // The characters added keep their own ratings over those of other
+        // characters with the same name.
+        if(added.count(entry.first)
+           && m_hashes[entry.first] != entry.second.first) {
+            continue;
+        }
+        m_hashes[entry.first] = entry.second.first;
+        m_ratings[entry.first] = entry.second.second;
+    }
+    return true;
+}
+
+void RatingEngine::save(std::ostream &out) const {
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> protect(m_mutex);
+    out.precision(10);
+    for(auto const &entry : m_ratings) {
+        Rating const &r = entry.second;
+        out << entry.first << "\t" << m_hashes.at(entry.first) << "\t"
+            << r.rating << "\t" << r.deviation << "\t" << r.volatility
+            << "\t" << r.fights << std::endl;
+    }
+}
+
+}
+}
@@ -0,0 +1,275 @@
+// Copyright 2015 Dario Domizioli
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "core/sim/ResultCache.h"
+
+#include "core/ctrl/CtrlInterfaces.h"
+#include "core/ctrl/ExpertSystemCtrl.h"
+#include "core/game/BatchDuel.h"
+#include "core/game/Dice.h"
+#include "core/sim/ThreadPool.h"
+
+#include <atomic>
+#include <cstring>
+#include <unistd.h>
+
+namespace core {
+namespace sim {
+
+namespace {
+
+/// The version of the cache layout. Bump it, or the version mixed into the
+/// hashes, when the rules change and the cached outcomes become stale.
+uint32_t const RESULT_CACHE_VERSION = 1;
+int64_t const CHARACTER_HASH_VERSION = 1;
+
+/// The header of a cache file, followed by the records.
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+};
+static_assert(sizeof(CacheHeader) == 16, "Unexpected CacheHeader padding");
+
+struct ResultRecord {
+    uint64_t first;
+    uint64_t second;
+    uint32_t wins;
+    uint32_t draws;
+    uint32_t losses;
+    uint32_t reserved;
+};
+static_assert(sizeof(ResultRecord) == 32, "Unexpected ResultRecord padding");
+
+char const s_cache_magic[8] = { 'M', 'U', 'S', 'H', 'R', 'S', 'L', 'T' };
+
+uint64_t mixIn(uint64_t h, int64_t value) {
+    // FNV-1a over the whole value.
+    h ^= static_cast<uint64_t>(value);
+    return h * 0x100000001B3ULL;
+}
+
+uint64_t mixIn(uint64_t h, std::string const &text) {
+    h = mixIn(h, static_cast<int64_t>(text.size()));
+    for(char ch : text) {
+        h = mixIn(h, static_cast<int64_t>(ch));
+    }
+    return h;
+}
+
+} // close anonymous namespace
+
+uint64_t characterHash(game::Character const &c) {
+    uint64_t h = 0xCBF29CE484222325ULL;
+    h = mixIn(h, CHARACTER_HASH_VERSION);
+    h = mixIn(h, c.ra);
+    h = mixIn(h, c.at);
+    h = mixIn(h, c.df);
+    h = mixIn(h, c.sp);
+    h = mixIn(h, std::string(c.actrl->getName()));
+    h = mixIn(h, std::string(c.dctrl->getName()));
+    h = mixIn(h, ctrl::getExpertSystemTag(*c.actrl));
+    h = mixIn(h, ctrl::getExpertSystemTag(*c.dctrl));
+    h = mixIn(h, static_cast<int64_t>(c.moves.size()));
+    for(auto const &m : c.moves) {
+        h = mixIn(h, m.getType());
+        h = mixIn(h, m.getName());
+        h = mixIn(h, static_cast<int64_t>(m.getSymbols().size()));
+        for(auto ms : m.getSymbols()) {
+            h = mixIn(h, ms);
+        }
+    }
+    return h;
+}
+
+bool isCacheable(game::Character const &c) {
+    return ctrl::getExpertSystemTag(*c.actrl) != ctrl::ES_NONE
+           && ctrl::getExpertSystemTag(*c.dctrl) != ctrl::ES_NONE;
+}
+
+ResultCache::ResultCache() {}
+
+bool ResultCache::open(std::string const &path, std::string &error) {
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> protect(m_mutex);
+    m_index.clear();
+    if(m_out.is_open()) {
+        m_out.close();
+    }
+
+    std::ifstream in(path, std::ios::binary);
+    bool fresh = !in;
+    if(!fresh) {
+        CacheHeader h;
+        in.read(reinterpret_cast<char *>(&h), sizeof(h));
+        if(!in || std::memcmp(h.magic, s_cache_magic, sizeof(s_cache_magic))
+           || h.version != RESULT_CACHE_VERSION) {
+            error = "'" + path + "' is not a result cache";
+            return false;
+        }
+        ResultRecord r;
+        uint64_t records = 0;
+        while(in.read(reinterpret_cast<char *>(&r), sizeof(r))) {
+            PairTally &t = m_index[std::make_pair(r.first, r.second)];
+            t.wins += r.wins;
+            t.draws += r.draws;
+            t.losses += r.losses;
+            ++records;
+        }
+        bool torn = in.gcount() != 0;
+        in.close();
+        // Drop a record cut short by a crash, so that the next ones are
+        // appended where they belong.
+        if(torn && ::truncate(path.c_str(), static_cast<off_t>(
+                                  sizeof(CacheHeader)
+                                  + records * sizeof(ResultRecord))) != 0) {
+            error = "cannot write '" + path + "'";
+            return false;
+        }
+    }
+
+    m_out.open(path, std::ios::binary | std::ios::app);
+    if(fresh) {
+        CacheHeader h;
+        std::memset(&h, 0, sizeof(h));
+        std::memcpy(h.magic, s_cache_magic, sizeof(s_cache_magic));
+        h.version = RESULT_CACHE_VERSION;
+        m_out.write(reinterpret_cast<char const *>(&h), sizeof(h));
+        m_out.flush();
+    }
+    if(!m_out) {
+        error = "cannot write '" + path + "'";
+        return false;
+    }
+    return true;
+}
+
+PairTally ResultCache::lookup(uint64_t first, uint64_t second) const {
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> protect(m_mutex);
+    auto found = m_index.find(std::make_pair(first, second));
+    return found != m_index.end() ? found->second : PairTally();
+}
+
+bool ResultCache::add(uint64_t first, uint64_t second, PairTally const &tally,
+                      std::string &error) {
+    ResultRecord r;
+    std::memset(&r, 0, sizeof(r));
+    r.first = first;
+    r.second = second;
+    r.wins = static_cast<uint32_t>(tally.wins);
+    r.draws = static_cast<uint32_t>(tally.draws);
+    r.losses = static_cast<uint32_t>(tally.losses);
+
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> protect(m_mutex);
+    m_out.write(reinterpret_cast<char const *>(&r), sizeof(r));
+    m_out.flush();
+    if(!m_out) {
+        error = "cannot write the result cache";
+        return false;
+    }
+    m_index[std::make_pair(first, second)] += tally;
+    return true;
+}
+
+size_t ResultCache::size() const {
+    // Protect ourselves against multi-threading
+    std::lock_guard<std::mutex> protect(m_mutex);
+    return m_index.size();
+}
+
+bool collectMatrix(
+    std::vector<std::shared_ptr<game::Character>> const &characters,
+    size_t fights, ResultCache &cache, unsigned threads,
+    std::vector<PairTally> &tallies, size_t &fought, std::string &error) {
+    size_t n = characters.size();
+    std::vector<uint64_t> hashes(n);
+    std::vector<bool> cacheable(n);
+    for(size_t i = 0; i < n; ++i) {
+        hashes[i] = characterHash(*characters[i]);
+        cacheable[i] = isCacheable(*characters[i]);
+    }
+
+    // Take what the cache has, and list the fights still needed.
+    tallies.assign(n * n, PairTally());
+    std::vector<std::pair<size_t, size_t>> missing;
+    for(size_t i = 0; i < n; ++i) {
+        for(size_t j = 0; j < n; ++j) {
+            if(i == j) {
+                continue;
+            }
+            size_t have = 0;
+            if(cacheable[i] && cacheable[j]) {
+                tallies[i * n + j] = cache.lookup(hashes[i], hashes[j]);
+                have = tallies[i * n + j].fights();
+            }
+            if(have < fights) {
+                missing.push_back(std::make_pair(i * n + j, fights - have));
+            }
+        }
+    }
+
+    // Draw the seeds up front, so that they do not depend on the threads.
+    std::vector<unsigned long> seeds(missing.size());
+    if(true) { // Just to have a scope
+        std::lock_guard<std::mutex> lock(game::getRandomGenMutex());
+        for(auto &s : seeds) {
+            s = game::getRandomGenerator()();
+        }
+    }
+    std::atomic<size_t> next(0);
+    std::atomic<size_t> total(0);
+    std::mutex error_mutex;
+    std::string first_error;
+    ThreadPool pool(std::max(threads, 1U));
+    pool.run([&](unsigned) {
+        for(size_t k = next++; k < missing.size(); k = next++) {
+            size_t p = missing[k].first;
+            size_t i = p / n;
+            size_t j = p % n;
+            game::BatchDuel batch(characters[i], characters[j],
+                                  missing[k].second, seeds[k]);
+            batch.fight();
+            PairTally t;
+            for(game::DuelResult r : batch.results()) {
+                switch(r) {
+                    case game::DR_C1_WINS: ++t.wins; break;
+                    case game::DR_C2_WINS: ++t.losses; break;
+                    default: ++t.draws; break;
+                }
+            }
+            batch.conclude();
+            tallies[p] += t;
+            total += t.fights();
+            std::string add_error;
+            if(cacheable[i] && cacheable[j]
+               && !cache.add(hashes[i], hashes[j], t, add_error)) {
+                std::lock_guard<std::mutex> protect(error_mutex);
+                if(first_error.empty()) {
+                    first_error = add_error;
+                }
+            }
+        }
+    });
+    fought = total;
+    if(!first_error.empty()) {
+        error = first_error;
+        return false;
+    }
+    return true;
+}
+
+}
+}
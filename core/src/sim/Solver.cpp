@@ -0,0 +1,241 @@
+// Copyright 2015 Dario Domizioli
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "core/sim/Solver.h"
+#include "core/game/BatchDuel.h"
+#include "core/game/Dice.h"
+#include "core/game/Duel.h"
+#include "core/ctrl/ExpertSystemCtrl.h"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace core {
+namespace sim {
+
+namespace {
+
+/// Terminal "states" in the transitions.
+int const s_c1_wins = -1;
+int const s_c2_wins = -2;
+int const s_draw = -3;
+
+/// A transition to another state (or a terminal) with its probability.
+struct Transition {
+    int target;
+    double probability;
+};
+
+void appendInt(std::string &key, int value) {
+    key.push_back(static_cast<char>(value & 0xFF));
+    key.push_back(static_cast<char>((value >> 8) & 0xFF));
+}
+
+void appendFighter(std::string &key, game::FighterState const &fs) {
+    appendInt(key, fs.cur_ap);
+    appendInt(key, fs.cur_sp);
+    appendInt(key, fs.cur_life);
+    appendInt(key, fs.cur_combo);
+    appendInt(key, (fs.air ? 1 : 0) | (fs.down ? 2 : 0));
+    appendInt(key, static_cast<int>(fs.nth_move_of_the_round));
+    appendInt(key, static_cast<int>(fs.moves_performed.size()));
+    for(auto m : fs.moves_performed) {
+        appendInt(key, static_cast<int>(m));
+    }
+}
+
+/// Normalizes a state so that equivalent states compare equal, and encodes it.
+std::string encode(game::DuelState &state) {
+    // The turn counter only matters for the first two turns.
+    if(state.turn_counter > 2) {
+        state.turn_counter = 2;
+    }
+    std::string key;
+    key.reserve(64);
+    appendFighter(key, state.c1);
+    appendFighter(key, state.c2);
+    appendInt(key, state.far ? 1 : 0);
+    appendInt(key, state.turn_counter);
+    appendInt(key, state.c1_attacks ? 1 : 0);
+    appendInt(key, static_cast<int>(state.phase));
+    return key;
+}
+
+}
+
+Solver::Solver(size_t max_states, size_t fallback_fights)
+:   m_max_states(max_states), m_fallback_fights(fallback_fights) {}
+
+bool Solver::canSolve(game::Character const &c1, game::Character const &c2) {
+    return ctrl::getExpertSystemTag(*c1.actrl) != ctrl::ES_NONE
+           && ctrl::getExpertSystemTag(*c1.dctrl) != ctrl::ES_NONE
+           && ctrl::getExpertSystemTag(*c2.actrl) != ctrl::ES_NONE
+           && ctrl::getExpertSystemTag(*c2.dctrl) != ctrl::ES_NONE;
+}
+
+MatchupOdds Solver::solve(std::shared_ptr<game::Character> c1,
+                          std::shared_ptr<game::Character> c2) {
+    auto key = std::make_pair(c1->uid, c2->uid);
+    {
+        std::lock_guard<std::mutex> lock(m_cache_mutex);
+        auto it = m_cache.find(key);
+        if(it != m_cache.end()) {
+            return it->second;
+        }
+    }
+    MatchupOdds odds;
+    if(!canSolve(*c1, *c2) || !solveExactly(c1, c2, odds)) {
+        size_t states = canSolve(*c1, *c2) ? m_max_states : 0;
+        odds = simulate(c1, c2, m_fallback_fights);
+        odds.states = states;
+    }
+    std::lock_guard<std::mutex> lock(m_cache_mutex);
+    m_cache[key] = odds;
+    return odds;
+}
+
+bool Solver::solveExactly(std::shared_ptr<game::Character> c1,
+                          std::shared_ptr<game::Character> c2,
+                          MatchupOdds &odds) const {
+    game::ScriptedDiceSource dice;
+    game::Duel duel(c1, c2, nullptr, &dice);
+
+    // Explore the graph breadth first. Transitions are stored flat, with
+    // "offsets[i]" being the first transition of state i.
+    std::unordered_map<std::string, int> index;
+    std::deque<game::DuelState> to_expand;
+    std::vector<Transition> transitions;
+    std::vector<size_t> offsets;
+
+    game::DuelState initial = duel.getState();
+    index.emplace(encode(initial), 0);
+    to_expand.push_back(initial);
+
+    std::map<int, double> outcomes;
+    while(!to_expand.empty()) {
+        game::DuelState state = to_expand.front();
+        to_expand.pop_front();
+        offsets.push_back(transitions.size());
+        outcomes.clear();
+        do {
+            dice.rewind();
+            duel.setState(state);
+            duel.step();
+            int target = 0;
+            switch(duel.result()) {
+                case game::DR_C1_WINS: target = s_c1_wins; break;
+                case game::DR_C2_WINS: target = s_c2_wins; break;
+                case game::DR_DRAW: target = s_draw; break;
+                default: {
+                    game::DuelState next = duel.getState();
+                    auto ins = index.emplace(encode(next),
+                                             static_cast<int>(index.size()));
+                    if(ins.second) {
+                        to_expand.push_back(next);
+                    }
+                    target = ins.first->second;
+                    break;
+                }
+            }
+            outcomes[target] += dice.probability();
+        } while(dice.advance());
+        for(auto const &o : outcomes) {
+            transitions.push_back(Transition{o.first, o.second});
+        }
+        if(index.size() > m_max_states) {
+            return false;
+        }
+    }
+    offsets.push_back(transitions.size());
+
+    // Now compute the probability of each outcome from each state. Deeper
+    // states were discovered later, so sweeping backwards converges faster.
+    size_t num_states = index.size();
+    std::vector<double> win(num_states, 0.0);
+    std::vector<double> draw(num_states, 0.0);
+    std::vector<double> loss(num_states, 0.0);
+    for(int iteration = 0; iteration < 100000; ++iteration) {
+        double max_delta = 0.0;
+        for(size_t i = num_states; i-- > 0; ) {
+            double w = 0.0, d = 0.0, l = 0.0;
+            for(size_t t = offsets[i]; t < offsets[i + 1]; ++t) {
+                Transition const &tr = transitions[t];
+                switch(tr.target) {
+                    case s_c1_wins: w += tr.probability; break;
+                    case s_c2_wins: l += tr.probability; break;
+                    case s_draw: d += tr.probability; break;
+                    default:
+                        w += tr.probability * win[tr.target];
+                        d += tr.probability * draw[tr.target];
+                        l += tr.probability * loss[tr.target];
+                        break;
+                }
+            }
+            max_delta = std::max(max_delta, std::fabs(w - win[i]));
+            max_delta = std::max(max_delta, std::fabs(d - draw[i]));
+            max_delta = std::max(max_delta, std::fabs(l - loss[i]));
+            win[i] = w;
+            draw[i] = d;
+            loss[i] = l;
+        }
+        if(max_delta < 1e-13) {
+            break;
+        }
+    }
+
+    odds.win = win[0];
+    odds.draw = draw[0];
+    odds.loss = loss[0];
+    odds.exact = true;
+    odds.states = num_states;
+    odds.fights = 0;
+    return true;
+}
+
+MatchupOdds simulate(std::shared_ptr<game::Character> c1,
+                     std::shared_ptr<game::Character> c2,
+                     size_t fights) {
+    unsigned long seed = 0;
+    if(true) { // Just to have a scope
+        std::lock_guard<std::mutex> lock(game::getRandomGenMutex());
+        seed = game::getRandomGenerator()();
+    }
+    game::BatchDuel batch(c1, c2, fights, seed);
+    batch.fight();
+    batch.abandon();
+    size_t wins = 0, draws = 0, losses = 0;
+    for(game::DuelResult r : batch.results()) {
+        switch(r) {
+            case game::DR_C1_WINS: ++wins; break;
+            case game::DR_C2_WINS: ++losses; break;
+            default: ++draws; break;
+        }
+    }
+    MatchupOdds odds;
+    double n = fights > 0 ? static_cast<double>(fights) : 1.0;
+    odds.win = wins / n;
+    odds.draw = draws / n;
+    odds.loss = losses / n;
+    odds.exact = false;
+    odds.states = 0;
+    odds.fights = fights;
+    return odds;
+}
+
+}
+}
@@ -0,0 +1,39 @@
+// Copyright 2015 Dario Domizioli
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "core/sim/Statistics.h"
+
+#include <cmath>
+
+namespace core {
+namespace sim {
+
+Interval wilsonInterval(double successes, size_t trials, double z) {
+    if(trials == 0) {
+        return Interval{0.0, 1.0};
+    }
+    double n = static_cast<double>(trials);
+    double p = successes / n;
+    double z2 = z * z;
+    double denominator = 1.0 + z2 / n;
+    double centre = (p + z2 / (2.0 * n)) / denominator;
+    double half = z * std::sqrt(p * (1.0 - p) / n + z2 / (4.0 * n * n))
+                  / denominator;
+    double low = centre - half;
+    double high = centre + half;
+    return Interval{low < 0.0 ? 0.0 : low, high > 1.0 ? 1.0 : high};
+}
+
+}
+}
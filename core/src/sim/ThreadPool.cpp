@@ -0,0 +1,81 @@
+// Copyright 2015 Dario Domizioli
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "core/sim/ThreadPool.h"
+
+namespace core {
+namespace sim {
+
+ThreadPool::ThreadPool(unsigned workers)
+  : m_size(workers ? workers : std::thread::hardware_concurrency()),
+    m_task(nullptr), m_generation(0), m_running(0), m_stop(false) {
+    if(m_size == 0) {
+        m_size = 1;
+    }
+    for(unsigned i = 1; i < m_size; ++i) {
+        m_threads.push_back(std::thread(&ThreadPool::workerLoop, this, i));
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    if(true) { // Just to have a scope
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_start.notify_all();
+    for(auto &t : m_threads) {
+        t.join();
+    }
+}
+
+void ThreadPool::run(std::function<void(unsigned)> const &task) {
+    std::lock_guard<std::mutex> serialize(m_run_mutex);
+    if(true) { // Just to have a scope
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_task = &task;
+        m_running = m_size - 1;
+        ++m_generation;
+    }
+    m_start.notify_all();
+    task(0);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this]() { return m_running == 0; });
+    m_task = nullptr;
+}
+
+void ThreadPool::workerLoop(unsigned worker) {
+    unsigned long seen = 0;
+    while(true) {
+        std::function<void(unsigned)> const *task = nullptr;
+        if(true) { // Just to have a scope
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_start.wait(lock, [&]() {
+                return m_stop || m_generation != seen;
+            });
+            if(m_stop) {
+                return;
+            }
+            seen = m_generation;
+            task = m_task;
+        }
+        (*task)(worker);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(--m_running == 0) {
+            m_done.notify_one();
+        }
+    }
+}
+
+}
+}
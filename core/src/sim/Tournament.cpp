@@ -0,0 +1,422 @@
+// Copyright 2015 Dario Domizioli
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "core/sim/Tournament.h"
+
+#include "core/game/BatchDuel.h"
+#include "core/game/Dice.h"
+#include "core/sim/ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <set>
+
+namespace core {
+namespace sim {
+
+namespace {
+
+/// \brief Returns the tally of a batch of fights, seen from the first
+///        character if 'mirrored' is false, from the second otherwise.
+PairTally tallyOf(std::vector<game::DuelResult> const &results,
+                  bool mirrored) {
+    PairTally t;
+    for(game::DuelResult r : results) {
+        switch(r) {
+            case game::DR_C1_WINS: ++(mirrored ? t.losses : t.wins); break;
+            case game::DR_C2_WINS: ++(mirrored ? t.wins : t.losses); break;
+            default: ++t.draws; break;
+        }
+    }
+    return t;
+}
+
+/// \brief Returns ceil(log2(n)).
+size_t ceilLog2(size_t n) {
+    size_t bits = 0;
+    while((static_cast<size_t>(1) << bits) < n) {
+        ++bits;
+    }
+    return bits;
+}
+
+} // close anonymous namespace
+
+TournamentOptions TournamentOptions::forFormat(TournamentFormat format) {
+    TournamentOptions options;
+    options.format = format;
+    options.fights_per_match = 4;
+    options.rounds = 0;
+    options.group_size = 8;
+    options.qualifiers = 2;
+    return options;
+}
+
+Tournament::Tournament(
+    std::vector<std::shared_ptr<game::Character>> const &characters,
+    TournamentOptions const &options)
+  : m_characters(characters),
+    m_options(options),
+    m_points(characters.size(), 0.0),
+    m_rounds(0),
+    m_matches(0),
+    m_fights(0) {
+}
+
+void Tournament::run(unsigned threads, std::ostream *progress_stream) {
+    m_ranking.clear();
+    switch(m_options.format) {
+    case TF_SWISS:
+        runSwiss(threads, progress_stream);
+        break;
+    case TF_SINGLE_ELIMINATION:
+    case TF_DOUBLE_ELIMINATION: {
+        std::vector<size_t> entrants(m_characters.size());
+        for(size_t i = 0; i < entrants.size(); ++i) {
+            entrants[i] = i;
+        }
+        m_ranking = runElimination(
+            entrants, m_options.format == TF_SINGLE_ELIMINATION ? 1 : 2,
+            threads, progress_stream);
+        break;
+    }
+    case TF_GROUPS:
+        runGroups(threads, progress_stream);
+        break;
+    }
+}
+
+std::vector<PairTally> Tournament::playRound(
+        std::vector<Match> const &matches, unsigned threads,
+        std::ostream *progress_stream) {
+    // Draw the seeds up front, so that they do not depend on the threads.
+    std::vector<unsigned long> seeds(matches.size() * 2);
+    if(true) { // Just to have a scope
+        std::lock_guard<std::mutex> lock(game::getRandomGenMutex());
+        for(auto &s : seeds) {
+            s = game::getRandomGenerator()();
+        }
+    }
+    size_t first_lanes = (m_options.fights_per_match + 1) / 2;
+    size_t second_lanes = m_options.fights_per_match / 2;
+    std::vector<PairTally> tallies(matches.size());
+    std::atomic<size_t> next(0);
+    ThreadPool pool(std::max(threads, 1U));
+    pool.run([&](unsigned) {
+        for(size_t k = next++; k < matches.size(); k = next++) {
+            auto const &a = m_characters[matches[k].first];
+            auto const &b = m_characters[matches[k].second];
+            PairTally tally;
+            if(first_lanes > 0) {
+                game::BatchDuel batch(a, b, first_lanes, seeds[2 * k]);
+                batch.fight();
+                tally += tallyOf(batch.results(), false);
+                batch.conclude();
+            }
+            if(second_lanes > 0) {
+                game::BatchDuel batch(b, a, second_lanes, seeds[2 * k + 1]);
+                batch.fight();
+                tally += tallyOf(batch.results(), true);
+                batch.conclude();
+            }
+            tallies[k] = tally;
+        }
+    });
+
+    for(size_t k = 0; k < matches.size(); ++k) {
+        PairTally const &t = tallies[k];
+        m_points[matches[k].first] += 3.0 * t.wins + t.draws;
+        m_points[matches[k].second] += 3.0 * t.losses + t.draws;
+        m_fights += t.fights();
+    }
+    m_matches += matches.size();
+    ++m_rounds;
+    if(progress_stream) {
+        *progress_stream << "Round " << m_rounds << ": " << matches.size()
+                         << " matches, " << m_fights << " fights so far."
+                         << std::endl;
+    }
+    return tallies;
+}
+
+void Tournament::runSwiss(unsigned threads, std::ostream *progress_stream) {
+    size_t n = m_characters.size();
+    size_t rounds = m_options.rounds ? m_options.rounds : ceilLog2(n) + 1;
+    std::vector<double> score(n, 0.0);
+    std::vector<std::vector<size_t>> opponents(n);
+    std::vector<bool> had_bye(n, false);
+    std::set<Match> played;
+
+    // Current standing: score, then points, then seed.
+    auto better = [&](size_t a, size_t b) {
+        if(score[a] != score[b]) {
+            return score[a] > score[b];
+        }
+        if(m_points[a] != m_points[b]) {
+            return m_points[a] > m_points[b];
+        }
+        return a < b;
+    };
+
+    for(size_t round = 0; round < rounds && n > 1; ++round) {
+        std::vector<size_t> order(n);
+        for(size_t i = 0; i < n; ++i) {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), better);
+
+        // The lowest character without a bye sits out and wins.
+        if(n % 2 == 1) {
+            auto bye = std::find_if(order.rbegin(), order.rend(),
+                                    [&](size_t i) { return !had_bye[i]; });
+            size_t sitter = (bye != order.rend()) ? *bye : order.back();
+            had_bye[sitter] = true;
+            score[sitter] += 1.0;
+            order.erase(std::find(order.begin(), order.end(), sitter));
+        }
+
+        // Pair each character with the next one it has not met yet.
+        std::vector<Match> matches;
+        std::vector<bool> paired(n, false);
+        for(size_t p = 0; p < order.size(); ++p) {
+            size_t a = order[p];
+            if(paired[a]) {
+                continue;
+            }
+            size_t pick = order.size();
+            for(size_t q = p + 1; q < order.size(); ++q) {
+                size_t b = order[q];
+                if(paired[b]) {
+                    continue;
+                }
+                if(pick == order.size()) {
+                    pick = q; // A rematch, if nobody else is left.
+                }
+                if(!played.count(std::make_pair(std::min(a, b),
+                                                std::max(a, b)))) {
+                    pick = q;
+                    break;
+                }
+            }
+            if(pick == order.size()) {
+                continue;
+            }
+            size_t b = order[pick];
+            paired[a] = paired[b] = true;
+            matches.push_back(std::make_pair(a, b));
+        }
+
+        std::vector<PairTally> tallies =
+            playRound(matches, threads, progress_stream);
+        for(size_t k = 0; k < matches.size(); ++k) {
+            size_t a = matches[k].first;
+            size_t b = matches[k].second;
+            PairTally const &t = tallies[k];
+            if(t.wins == t.losses) {
+                score[a] += 0.5;
+                score[b] += 0.5;
+            } else {
+                score[t.wins > t.losses ? a : b] += 1.0;
+            }
+            opponents[a].push_back(b);
+            opponents[b].push_back(a);
+            played.insert(std::make_pair(std::min(a, b), std::max(a, b)));
+        }
+    }
+
+    // Final standing: score, then the scores of the opponents met (Buchholz),
+    // then points, then seed.
+    std::vector<double> buchholz(n, 0.0);
+    for(size_t i = 0; i < n; ++i) {
+        for(size_t o : opponents[i]) {
+            buchholz[i] += score[o];
+        }
+    }
+    m_ranking.resize(n);
+    for(size_t i = 0; i < n; ++i) {
+        m_ranking[i] = i;
+    }
+    std::sort(m_ranking.begin(), m_ranking.end(), [&](size_t a, size_t b) {
+        if(score[a] != score[b]) {
+            return score[a] > score[b];
+        }
+        if(buchholz[a] != buchholz[b]) {
+            return buchholz[a] > buchholz[b];
+        }
+        return better(a, b);
+    });
+}
+
+std::vector<size_t> Tournament::runElimination(
+        std::vector<size_t> const &entrants, size_t lives, unsigned threads,
+        std::ostream *progress_stream) {
+    // Entrants are in seed order; remember each one's seed.
+    std::vector<size_t> seed(m_characters.size(), 0);
+    for(size_t s = 0; s < entrants.size(); ++s) {
+        seed[entrants[s]] = s;
+    }
+    std::vector<size_t> losses(m_characters.size(), 0);
+    std::vector<size_t> out_round(m_characters.size(), 0);
+    std::vector<size_t> alive = entrants;
+    size_t round = 0;
+    while(alive.size() > 1) {
+        ++round;
+        // Characters with the same losses are paired best against worst
+        // seed; the odd ones of two brackets meet, otherwise they sit out.
+        std::vector<Match> matches;
+        size_t odd = m_characters.size();
+        for(size_t l = 0; l < lives; ++l) {
+            std::vector<size_t> bracket;
+            for(size_t i : alive) {
+                if(losses[i] == l) {
+                    bracket.push_back(i);
+                }
+            }
+            size_t half = bracket.size() / 2;
+            if(bracket.size() % 2 == 1) {
+                size_t middle = bracket[half];
+                if(odd != m_characters.size()) {
+                    matches.push_back(std::make_pair(odd, middle));
+                    odd = m_characters.size();
+                } else {
+                    odd = middle;
+                }
+                bracket.erase(bracket.begin() + half);
+            }
+            for(size_t k = 0; k < half; ++k) {
+                matches.push_back(std::make_pair(
+                    bracket[k], bracket[bracket.size() - 1 - k]));
+            }
+        }
+        // Seed order decides ties, so put the better seed first.
+        for(auto &m : matches) {
+            if(seed[m.second] < seed[m.first]) {
+                std::swap(m.first, m.second);
+            }
+        }
+
+        std::vector<PairTally> tallies =
+            playRound(matches, threads, progress_stream);
+        for(size_t k = 0; k < matches.size(); ++k) {
+            PairTally const &t = tallies[k];
+            bool first_wins = t.wins >= t.losses;
+            size_t loser = first_wins ? matches[k].second : matches[k].first;
+            if(++losses[loser] == lives) {
+                out_round[loser] = round;
+            }
+        }
+        alive.erase(std::remove_if(alive.begin(), alive.end(),
+                                   [&](size_t i) { return losses[i] == lives; }),
+                    alive.end());
+    }
+
+    // The last one standing, then the latest to go out; ties by points, then
+    // by seed.
+    std::vector<size_t> ranking = entrants;
+    for(size_t i : alive) {
+        out_round[i] = round + 1;
+    }
+    std::sort(ranking.begin(), ranking.end(), [&](size_t a, size_t b) {
+        if(out_round[a] != out_round[b]) {
+            return out_round[a] > out_round[b];
+        }
+        if(m_points[a] != m_points[b]) {
+            return m_points[a] > m_points[b];
+        }
+        return seed[a] < seed[b];
+    });
+    return ranking;
+}
+
+void Tournament::runGroups(unsigned threads, std::ostream *progress_stream) {
+    size_t n = m_characters.size();
+    size_t size = std::max<size_t>(m_options.group_size, 2);
+    size_t groups = (n + size - 1) / size;
+    if(groups == 0) {
+        return;
+    }
+    // Deal the seeds to the groups back and forth, so that the groups are
+    // equally strong.
+    std::vector<std::vector<size_t>> members(groups);
+    for(size_t s = 0; s < n; ++s) {
+        size_t pass = s / groups;
+        size_t g = s % groups;
+        members[pass % 2 == 0 ? g : groups - 1 - g].push_back(s);
+    }
+
+    // All the group matches are independent, so they are a single round.
+    std::vector<Match> matches;
+    for(auto const &m : members) {
+        for(size_t a = 0; a < m.size(); ++a) {
+            for(size_t b = a + 1; b < m.size(); ++b) {
+                matches.push_back(std::make_pair(m[a], m[b]));
+            }
+        }
+    }
+    std::vector<PairTally> tallies = playRound(matches, threads,
+                                               progress_stream);
+    std::vector<double> score(n, 0.0);
+    for(size_t k = 0; k < matches.size(); ++k) {
+        PairTally const &t = tallies[k];
+        if(t.wins == t.losses) {
+            score[matches[k].first] += 0.5;
+            score[matches[k].second] += 0.5;
+        } else {
+            score[t.wins > t.losses ? matches[k].first
+                                    : matches[k].second] += 1.0;
+        }
+    }
+
+    // Rank each group, and everyone by place in the group.
+    auto better = [&](size_t a, size_t b) {
+        if(score[a] != score[b]) {
+            return score[a] > score[b];
+        }
+        if(m_points[a] != m_points[b]) {
+            return m_points[a] > m_points[b];
+        }
+        return a < b;
+    };
+    std::vector<size_t> place(n, 0);
+    for(auto &m : members) {
+        std::sort(m.begin(), m.end(), better);
+        for(size_t p = 0; p < m.size(); ++p) {
+            place[m[p]] = p;
+        }
+    }
+    std::vector<size_t> by_place(n);
+    for(size_t i = 0; i < n; ++i) {
+        by_place[i] = i;
+    }
+    std::sort(by_place.begin(), by_place.end(), [&](size_t a, size_t b) {
+        if(place[a] != place[b]) {
+            return place[a] < place[b];
+        }
+        return better(a, b);
+    });
+
+    // The qualifiers play a knockout seeded by their group results; the
+    // others follow in the order of their group results.
+    std::vector<size_t> qualified;
+    std::vector<size_t> others;
+    for(size_t i : by_place) {
+        (place[i] < m_options.qualifiers ? qualified : others).push_back(i);
+    }
+    m_ranking = runElimination(qualified, 1, threads, progress_stream);
+    m_ranking.insert(m_ranking.end(), others.begin(), others.end());
+}
+
+}
+}
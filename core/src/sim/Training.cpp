@@ -0,0 +1,165 @@
+// Copyright 2015 Dario Domizioli
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "core/sim/Training.h"
+
+#include "core/ctrl/EvolveAICtrl.h"
+#include "core/game/Duel.h"
+#include "core/sim/ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+
+namespace core {
+namespace sim {
+
+TrainingOptions TrainingOptions::forLevel(int level) {
+    level = std::max(0, std::min(level, 3));
+    static double const tolerances[] = { 0.05, 0.03, 0.02, 0.01 };
+    static size_t const windows[] = { 5, 10, 20, 40 };
+    static double const drifts[] = { 0.1, 0.05, 0.03, 0.02 };
+    TrainingOptions options;
+    options.max_rounds = (level + 2) * 100;
+    options.seconds = 10.0 * (1 << level);
+    options.tolerance = tolerances[level];
+    options.window = windows[level];
+    options.drift = drifts[level];
+    return options;
+}
+
+Trainer::Trainer(std::vector<std::shared_ptr<game::Character>> const &characters,
+                 TrainingOptions const &options)
+  : m_characters(characters),
+    m_options(options),
+    m_fights(0),
+    m_seconds(0.0) {
+}
+
+double Trainer::worstChange() const {
+    double worst = 0.0;
+    for(auto const &c : m_characters) {
+        auto att = std::dynamic_pointer_cast<ctrl::EvolveAIAttack>(c->actrl);
+        if(att) {
+            worst = std::max(worst, att->getConvergence());
+        }
+        auto def = std::dynamic_pointer_cast<ctrl::EvolveAIDefence>(c->dctrl);
+        if(def) {
+            worst = std::max(worst, def->getConvergence());
+        }
+    }
+    return worst;
+}
+
+double Trainer::worstDrift() const {
+    size_t w = m_options.window;
+    if(w == 0 || m_scores.size() < 2 * w || m_characters.size() < 2) {
+        return 1.0;
+    }
+    // Each character fights twice every other character in a round.
+    double fights = 2.0 * (m_characters.size() - 1) * w;
+    double worst = 0.0;
+    for(size_t i = 0; i < m_characters.size(); ++i) {
+        double before = 0.0;
+        double last = 0.0;
+        for(size_t r = m_scores.size() - 2 * w; r < m_scores.size() - w; ++r) {
+            before += m_scores[r][i] / w;
+            last += m_scores[r + w][i] / w;
+        }
+        // Only the drift beyond two standard errors of the difference counts,
+        // so that noise alone does not keep the training going.
+        double p = (before + last) / 2.0;
+        double noise = 2.0 * std::sqrt(p * (1.0 - p) * 2.0 / fights);
+        worst = std::max(worst, std::fabs(last - before) - noise);
+    }
+    return worst;
+}
+
+bool Trainer::isStable() const {
+    return worstChange() < m_options.tolerance
+           && worstDrift() < m_options.drift;
+}
+
+void Trainer::run(unsigned threads, std::ostream *progress_stream) {
+    ThreadPool pool(threads);
+    auto start = std::chrono::steady_clock::now();
+    bool stable = false;
+    bool out_of_time = false;
+    while(rounds() < m_options.max_rounds && !stable && !out_of_time) {
+        runRound(pool);
+        m_seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+        stable = isStable();
+        out_of_time = m_options.seconds > 0.0
+                      && m_seconds >= m_options.seconds;
+        if(progress_stream && (rounds() % 10 == 0 || stable || out_of_time
+                               || rounds() == m_options.max_rounds)) {
+            *progress_stream << "Round " << rounds() << ": " << m_fights
+                             << " fights in " << m_seconds << "s, change "
+                             << worstChange() << " (target "
+                             << m_options.tolerance << "), drift "
+                             << worstDrift() << " (target "
+                             << m_options.drift << ")." << std::endl;
+        }
+    }
+    if(progress_stream) {
+        *progress_stream << (stable ? "Training is stable"
+                             : out_of_time ? "Training ran out of time"
+                             : "Training ran out of rounds")
+                         << " after " << rounds() << " rounds." << std::endl;
+    }
+}
+
+void Trainer::runRound(ThreadPool &pool) {
+    size_t n = m_characters.size();
+    std::vector<std::pair<size_t, size_t>> pairs;
+    for(size_t i = 0; i < n; ++i) {
+        for(size_t j = 0; j < n; ++j) {
+            if(i != j) {
+                pairs.push_back(std::make_pair(i, j));
+            }
+        }
+    }
+    std::vector<double> scores(n, 0.0);
+    std::mutex scores_mutex;
+    std::atomic<size_t> next(0);
+    pool.run([&](unsigned) {
+        std::vector<double> local(n, 0.0);
+        for(size_t k = next++; k < pairs.size(); k = next++) {
+            size_t i = pairs[k].first;
+            size_t j = pairs[k].second;
+            game::Duel d(m_characters[i], m_characters[j], nullptr);
+            d.fight();
+            switch(d.result()) {
+                case game::DR_C1_WINS: local[i] += 1.0; break;
+                case game::DR_C2_WINS: local[j] += 1.0; break;
+                default: local[i] += 0.5; local[j] += 0.5; break;
+            }
+        }
+        std::lock_guard<std::mutex> lock(scores_mutex);
+        for(size_t i = 0; i < n; ++i) {
+            scores[i] += local[i];
+        }
+    });
+    for(auto &s : scores) {
+        s /= n > 1 ? 2.0 * (n - 1) : 1.0;
+    }
+    m_scores.push_back(scores);
+    m_fights += pairs.size();
+}
+
+}
+}
@@ -0,0 +1,70 @@
+//  Copyright 2015 Dario Domizioli
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#ifndef CORE_TEST_UNIT_TESTCHARACTERS_H
+#define CORE_TEST_UNIT_TESTCHARACTERS_H
+
+#include "core/game/Character.h"
+#include "core/ctrl/CtrlInterfaces.h"
+#include "core/ctrl/ExpertSystemCtrl.h"
+
+#include <memory>
+#include <string>
+
+namespace test {
+
+/// \brief Builds a 2/3/2 character with three specials and a super, which
+///        gives the control systems several moves to choose from.
+inline std::shared_ptr<core::game::Character> makeCharacter(
+    std::string const &name, std::shared_ptr<core::ctrl::AttackControl> att,
+    std::shared_ptr<core::ctrl::DefendControl> def) {
+    using namespace core::game;
+    std::shared_ptr<Character> c = std::make_shared<Character>(
+        name, 2, 3, 2, SP_DAMAGE, att, def);
+    c->addMove(Move{"First", MT_SPECIAL, {MS_PUSH}});
+    c->addMove(Move{"Second", MT_SPECIAL, {MS_DISTANCE, MS_POWERFUL}});
+    c->addMove(Move{"Third", MT_SPECIAL, {MS_PUSH, MS_DISTANCE}});
+    c->addMove(Move{"Super", MT_SUPER, {MS_POWERFUL, MS_THROW, MS_SMASH}});
+    return c;
+}
+
+/// \brief Builds "Grunt", a 2/4/1 character driven by the first expert
+///        systems, with a single special and a super.
+inline std::shared_ptr<core::game::Character> makeGrunt() {
+    using namespace core::game;
+    std::shared_ptr<Character> grunt = std::make_shared<Character>(
+        "Grunt", 2, 4, 1, SP_DAMAGE,
+        core::ctrl::getAttackExpertSystem(0),
+        core::ctrl::getDefenceExpertSystem(0));
+    grunt->addMove(Move{"First", MT_SPECIAL, {MS_POWERFUL}});
+    grunt->addMove(Move{"Super", MT_SUPER, {MS_POWERFUL, MS_SMASH, MS_FALL}});
+    return grunt;
+}
+
+/// \brief Builds "Counter", a 3/2/2 character driven by the fourth expert
+///        systems, with a single special and a super.
+inline std::shared_ptr<core::game::Character> makeCounter() {
+    using namespace core::game;
+    std::shared_ptr<Character> counter = std::make_shared<Character>(
+        "Counter", 3, 2, 2, SP_COMBO,
+        core::ctrl::getAttackExpertSystem(3),
+        core::ctrl::getDefenceExpertSystem(3));
+    counter->addMove(Move{"First", MT_SPECIAL, {MS_PUSH}});
+    counter->addMove(Move{"Super", MT_SUPER, {MS_POWERFUL, MS_THROW}});
+    return counter;
+}
+
+}
+
+#endif
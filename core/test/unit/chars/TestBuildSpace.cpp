@@ -0,0 +1,82 @@
+//  Copyright 2015 Dario Domizioli
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "catch/catch.hpp"
+
+#include "core/chars/BuildSpace.h"
+
+using namespace core;
+using namespace core::chars;
+using namespace core::game;
+
+TEST_CASE( "BuildSpace", "[chars]" ) {
+
+    SECTION("Size") {
+        // 15 stats, 5 SP modes, 17 single-symbol moves, unordered pairs of
+        // the 153 two-symbol moves, 969 three-symbol moves.
+        REQUIRE(BuildSpace::size() == 15ULL * 5 * 17 * (153 * 154 / 2) * 969);
+    }
+
+    SECTION("Ids") {
+        uint64_t ids[] = { 0, 1, 968, 969, 123456789, BuildSpace::size() - 1 };
+        for(uint64_t id : ids) {
+            Build b = BuildSpace::getBuild(id);
+            int total = b.ra + b.at + b.df;
+            REQUIRE(total == 7);
+            REQUIRE(BuildSpace::getId(b) == id);
+        }
+        Build last = BuildSpace::getBuild(BuildSpace::size() - 1);
+        REQUIRE(last.ra == 5);
+        REQUIRE(last.sp == SP_DEFENCE);
+        REQUIRE(last.symbols[7] == MS_ULTRA_HARDNESS);
+    }
+
+    SECTION("Canonical") {
+        Build b{2, 3, 2, SP_AP,
+                {MS_FALL, MS_THROW, MS_DASH, MS_PUSH, MS_2XCOMBO,
+                 MS_SMASH, MS_FALL, MS_SMASH}};
+        uint64_t id = BuildSpace::getId(b);
+        Build c = BuildSpace::getBuild(id);
+        // Second and third are swapped, and each move is sorted.
+        Build expected{2, 3, 2, SP_AP,
+                       {MS_FALL, MS_2XCOMBO, MS_PUSH, MS_THROW, MS_DASH,
+                        MS_FALL, MS_SMASH, MS_SMASH}};
+        REQUIRE(c == expected);
+        BuildSpace::canonicalize(b);
+        REQUIRE(b == expected);
+    }
+
+    SECTION("Shards") {
+        uint64_t covered = 0;
+        uint64_t next = 0;
+        for(uint64_t i = 0; i < 7; ++i) {
+            BuildEnumerator e = BuildEnumerator::shard(i, 7);
+            REQUIRE(e.first() == next);
+            next = e.last();
+            covered += e.last() - e.first();
+        }
+        REQUIRE(covered == BuildSpace::size());
+
+        BuildEnumerator e(10, 13);
+        Build b;
+        uint64_t id = 0;
+        int count = 0;
+        while(e.next(b, id)) {
+            REQUIRE(BuildSpace::getId(b) == id);
+            ++count;
+        }
+        REQUIRE(count == 3);
+    }
+
+}
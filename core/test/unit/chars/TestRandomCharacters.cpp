@@ -0,0 +1,68 @@
+//  Copyright 2015 Dario Domizioli
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "catch/catch.hpp"
+
+#include "core/chars/RandomCharacters.h"
+
+#include <set>
+
+using namespace core;
+using namespace core::chars;
+using namespace core::game;
+
+TEST_CASE( "RandomCharacters", "[chars]" ) {
+    GenerationOptions options;
+    options.count = 200;
+    options.seed = 42;
+    options.allow_expert_systems = true;
+
+    SECTION("Deterministic") {
+        std::vector<RandomBuild> serial = drawRandomBuilds(options);
+        options.threads = 3;
+        std::vector<RandomBuild> parallel = drawRandomBuilds(options);
+        REQUIRE(serial.size() == 200);
+        REQUIRE(parallel.size() == 200);
+        for(size_t i = 0; i < serial.size(); ++i) {
+            REQUIRE(serial[i].build == parallel[i].build);
+            REQUIRE(serial[i].combination == parallel[i].combination);
+        }
+        options.seed = 43;
+        std::vector<RandomBuild> other = drawRandomBuilds(options);
+        REQUIRE_FALSE(other[0].build == serial[0].build);
+    }
+
+    SECTION("Characters") {
+        options.count = 20;
+        options.threads = 2;
+        options.unique = true;
+        options.prefix = "Bulk";
+        std::vector<uint64_t> ids;
+        auto characters = generateRandomCharacters(options, &ids);
+        REQUIRE(characters.size() == 20);
+        REQUIRE(ids.size() == 20);
+        REQUIRE(characters[0]->name == "Bulk0");
+        REQUIRE(characters[19]->name == "Bulk19");
+        std::set<uint64_t> distinct(ids.cbegin(), ids.cend());
+        REQUIRE(distinct.size() == 20);
+        std::vector<CharacterSpec> specs = generateRandomSpecs(options);
+        for(size_t i = 0; i < characters.size(); ++i) {
+            CharacterSpec described = describeCharacter(*characters[i]);
+            REQUIRE(described.name == specs[i].name);
+            REQUIRE(described.attack_ai == specs[i].attack_ai);
+            REQUIRE(described.defence_ai == specs[i].defence_ai);
+            REQUIRE(described.moves.size() == specs[i].moves.size());
+        }
+    }
+}
@@ -0,0 +1,78 @@
+//  Copyright 2015 Dario Domizioli
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "catch/catch.hpp"
+
+#include "core/chars/NamedCharacters.h"
+#include "core/chars/Roster.h"
+
+#include <cstdio>
+#include <sstream>
+
+using namespace core;
+using namespace core::chars;
+using namespace core::game;
+
+TEST_CASE( "Roster", "[chars]" ) {
+    std::vector<CharacterSpec> specs;
+    for(auto const &c : getOriginalCharacters()) {
+        specs.push_back(describeCharacter(*c));
+    }
+
+    SECTION("Text") {
+        std::stringstream text;
+        writeRoster(text, specs);
+        std::vector<CharacterSpec> back;
+        std::string error;
+        REQUIRE(readRoster(text, back, error));
+        REQUIRE(back.size() == specs.size());
+        for(size_t i = 0; i < specs.size(); ++i) {
+            REQUIRE(back[i].name == specs[i].name);
+            REQUIRE(back[i].df == specs[i].df);
+            REQUIRE(back[i].sp == specs[i].sp);
+            REQUIRE(back[i].attack_ai == specs[i].attack_ai);
+            REQUIRE(back[i].moves == specs[i].moves);
+        }
+
+        std::istringstream bad("character X\nstats 1 2 3 Combo\n"
+                               "special Y: Fly\n");
+        REQUIRE(!readRoster(bad, back, error));
+        REQUIRE(error == "line 3: unknown move symbol 'Fly'");
+    }
+
+    SECTION("Binary") {
+        std::string path = "test-roster.bin";
+        std::string error;
+        REQUIRE(writeBinaryRoster(path, specs, error));
+        MappedRoster roster;
+        REQUIRE(roster.open(path, error));
+        REQUIRE(roster.size() == specs.size());
+        REQUIRE(std::string(roster.getName(1)) == specs[1].name);
+        auto c = roster.makeCharacter(0);
+        REQUIRE(c->name == specs[0].name);
+        REQUIRE(c->ra == specs[0].ra);
+        REQUIRE(std::string(c->actrl->getName()) == specs[0].attack_ai);
+        REQUIRE(c->moves.size() == getStandardMoves().size()
+                                   + specs[0].moves.size());
+        REQUIRE(c->moves.back() == specs[0].moves.back());
+        roster.close();
+
+        std::vector<std::shared_ptr<Character>> loaded;
+        REQUIRE(loadRoster(path, loaded, error));
+        REQUIRE(loaded.size() == specs.size());
+        std::remove(path.c_str());
+        REQUIRE(!roster.open(path, error));
+    }
+
+}
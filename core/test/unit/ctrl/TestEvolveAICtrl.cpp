@@ -0,0 +1,168 @@
+//  Copyright 2015 Dario Domizioli
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+
+#include "catch/catch.hpp"
+
+#include "core/ctrl/EvolveAICtrl.h"
+#include "core/game/Character.h"
+
+#include <memory>
+
+using namespace core;
+using namespace core::ctrl;
+
+TEST_CASE( "DecisionMatrix", "[ctrl]" ) {
+    std::unique_ptr<DecisionMatrix> m(new DecisionMatrix());
+
+    SECTION("AveragesPerCell") {
+        REQUIRE(m->getGoodness(false, false, 2, 5, 1, 3) == 0.5);
+        REQUIRE(m->getVisits(false, false, 2, 5, 1, 3) == 0);
+        m->updateGoodness(false, false, 2, 5, 1, 3, 1.0);
+        REQUIRE(m->getGoodness(false, false, 2, 5, 1, 3) == Approx(0.75));
+        m->updateGoodness(false, false, 2, 5, 1, 3, 1.0);
+        REQUIRE(m->getGoodness(false, false, 2, 5, 1, 3) == Approx(2.5 / 3));
+        REQUIRE(m->getVisits(false, false, 2, 5, 1, 3) == 2);
+        // Updating other cells does not slow this one down.
+        for(int i = 0; i < 1000; ++i) {
+            m->updateGoodness(true, false, 2, 5, 1, 3, 0.0);
+        }
+        m->updateGoodness(false, false, 2, 5, 1, 3, 0.0);
+        REQUIRE(m->getGoodness(false, false, 2, 5, 1, 3) == Approx(2.5 / 4));
+        REQUIRE(m->getVisitedCells() == 2);
+        REQUIRE(m->getUpdates() == 1003);
+        // AP and SP saturate.
+        REQUIRE(m->getVisits(false, false, 2, 12, 1, 3) == 0);
+        m->updateGoodness(false, false, 2, 12, 9, 3, 1.0);
+        REQUIRE(m->getVisits(false, false, 2, 9, 6, 3) == 1);
+    }
+
+    SECTION("Converges") {
+        REQUIRE(m->getConvergence() == 1.0);
+        REQUIRE(!m->hasConverged());
+        m->updateGoodness(false, false, 0, 0, 0, 0, 1.0);
+        REQUIRE(m->getConvergence() == Approx(0.25));
+        for(int i = 0; i < 20000; ++i) {
+            m->updateGoodness(false, false, 0, 0, 0, i % 2, 1.0);
+        }
+        REQUIRE(m->hasConverged());
+    }
+
+    SECTION("WarmStarts") {
+        for(int i = 0; i < 20; ++i) {
+            m->updateGoodness(false, false, 2, 5, 1, 3, 1.0);
+        }
+        std::unique_ptr<DecisionMatrix> n(new DecisionMatrix());
+        std::vector<size_t> map = { 0, 1, 2, game::NO_MOVE, 3 };
+        n->warmStartFrom(*m, map);
+        double good = m->getGoodness(false, false, 2, 5, 1, 3);
+        REQUIRE(n->getGoodness(false, false, 2, 5, 1, 4) == good);
+        REQUIRE(n->getVisits(false, false, 2, 5, 1, 4)
+                == DecisionMatrix::WARM_START_VISITS);
+        REQUIRE(n->getGoodness(false, false, 2, 5, 1, 3) == 0.5);
+        REQUIRE(n->getUpdates() == 0);
+    }
+
+}
+
+TEST_CASE( "MarkovDecisionMatrix", "[ctrl]" ) {
+
+    SECTION("WarmStarts") {
+        std::unique_ptr<MarkovDecisionMatrix> m(new MarkovDecisionMatrix());
+        int trained[3] = { 1, 2, 3 };
+        for(int i = 0; i < 20; ++i) {
+            m->updateGoodness(2, 5, 1, trained, 1.0);
+        }
+        std::unique_ptr<MarkovDecisionMatrix> n(new MarkovDecisionMatrix());
+        std::vector<size_t> map = { 0, 1, 2, game::NO_MOVE, 3 };
+        n->warmStartFrom(*m, map);
+        double good = m->getGoodness(2, 5, 1, trained);
+        int mapped[3] = { 1, 2, 4 };
+        REQUIRE(n->getGoodness(2, 5, 1, mapped) == good);
+        REQUIRE(n->getGoodness(2, 5, 1, trained) == 0.5);
+        REQUIRE(n->getUpdates() == 0);
+    }
+
+}
+
+TEST_CASE( "ReplayBuffer", "[ctrl]" ) {
+
+    SECTION("PacksDecisions") {
+        DecisionRecord dr{true, false, 5, 12, 9, 11, 1.0};
+        DecisionRecord back{false, true, 0, 0, 0, 0, 0.0};
+        REQUIRE(unpackDecision(packDecision(6, dr), back) == 6);
+        REQUIRE(back.down);
+        REQUIRE(!back.air);
+        REQUIRE(back.enemy_at_or_df == 5);
+        // AP and SP saturate like in DecisionMatrix.
+        REQUIRE(back.own_ap == 9);
+        REQUIRE(back.own_sp == 6);
+        REQUIRE(back.parameter == 11);
+        REQUIRE(back.goodness == 1.0);
+    }
+
+    SECTION("KeepsTheLatest") {
+        ReplayBuffer b(2);
+        for(uint32_t i = 0; i < 3; ++i) {
+            b.add(Trajectory{{i}, true});
+        }
+        REQUIRE(b.size() == 2);
+        std::default_random_engine engine(1);
+        for(int i = 0; i < 20; ++i) {
+            REQUIRE(b.sample(engine).decisions.front() != 0);
+        }
+        ReplayBuffer none;
+        none.add(Trajectory{{0}, true});
+        REQUIRE(none.size() == 0);
+    }
+
+}
+
+TEST_CASE( "WarmStart", "[ctrl]" ) {
+    using namespace core::game;
+    auto trained = std::make_shared<Character>(
+        "Trained", 3, 2, 2, SP_DAMAGE,
+        std::make_shared<EvolveAIAttack>(), std::make_shared<EvolveAIDefence>());
+    trained->addMove(Move("Special", MT_SPECIAL, {MS_FALL}));
+    trained->addMove(Move("Super", MT_SUPER, {MS_DASH, MS_SMASH}));
+    auto other = std::make_shared<Character>(
+        "Other", 1, 1, 5, SP_COMBO,
+        std::make_shared<EvolveAIAttack>(), std::make_shared<EvolveAIDefence>());
+    auto fresh = std::make_shared<Character>(
+        "Fresh", 3, 2, 2, SP_DAMAGE,
+        std::make_shared<EvolveAIAttack>(), std::make_shared<EvolveAIDefence>());
+    fresh->addMove(Move("Super", MT_SUPER, {MS_DASH}));
+    fresh->addMove(Move("Special", MT_SPECIAL, {MS_FALL}));
+
+    SECTION("MapsMoves") {
+        size_t n = getStandardMoves().size();
+        std::vector<size_t> map = mapMoves(*trained, *fresh);
+        REQUIRE(map.size() == n + 2);
+        for(size_t i = 0; i < n; ++i) {
+            REQUIRE(map[i] == i);
+        }
+        REQUIRE(map[n] == n + 1);
+        REQUIRE(map[n + 1] == n);
+        REQUIRE(mapMoves(*other, *fresh)[n] == NO_MOVE);
+    }
+
+    SECTION("PicksTheNearest") {
+        REQUIRE(similarity(*trained, *trained) == 1.0);
+        REQUIRE(similarity(*fresh, *trained) > similarity(*fresh, *other));
+        std::vector<std::shared_ptr<Character>> roster = { other, trained,
+                                                           fresh };
+        REQUIRE(warmStart(*fresh, roster) == trained);
+    }
+
+}
@@ -0,0 +1,98 @@
+//  Copyright 2015 Dario Domizioli
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "catch/catch.hpp"
+#include "../TestCharacters.h"
+
+#include "core/game/Character.h"
+#include "core/game/Duel.h"
+#include "core/ctrl/ExpertSystemCtrl.h"
+#include "core/ctrl/ExpectiminimaxCtrl.h"
+
+using namespace core;
+using namespace core::game;
+using namespace core::ctrl;
+using test::makeCharacter;
+
+TEST_CASE( "ExpectiminimaxCtrl", "[ctrl]" ) {
+    ExpectiminimaxOptions options;
+    options.milliseconds = 0.0;
+    options.max_depth = 2;
+    std::shared_ptr<ExpectiminimaxAttack> att =
+        std::make_shared<ExpectiminimaxAttack>(options);
+    std::shared_ptr<ExpectiminimaxDefence> def =
+        std::make_shared<ExpectiminimaxDefence>(options);
+    std::shared_ptr<Character> me = makeCharacter("Me", att, def);
+    std::shared_ptr<Character> opp = makeCharacter(
+        "Opp", getAttackExpertSystem(7), getDefenceExpertSystem(7));
+
+    SECTION("HashDuelState") {
+        DuelState a;
+        a.c1 = getFighterState(*me);
+        a.c2 = getFighterState(*opp);
+        a.far = true;
+        a.turn_counter = 2;
+        a.c1_attacks = true;
+        a.phase = DP_ATTACK;
+        DuelState b = a;
+        REQUIRE(hashDuelState(a) == hashDuelState(b));
+        b.turn_counter = 7;
+        REQUIRE(hashDuelState(a) == hashDuelState(b));
+        b.c2.cur_life -= 1;
+        REQUIRE(hashDuelState(a) != hashDuelState(b));
+        b = a;
+        b.c1.moves_performed.push_back(1);
+        REQUIRE(hashDuelState(a) != hashDuelState(b));
+    }
+
+    SECTION("LegalMoves") {
+        for(int f = 0; f < 2; ++f) {
+            for(int ap = 0; ap <= 8; ap += 2) {
+                for(int sp = 0; sp <= 5; sp += 5) {
+                    me->cur_ap = ap;
+                    me->cur_sp = sp;
+                    Move const &m = att->getNextMove(*me, *opp, f != 0);
+                    REQUIRE((m.isWait() || m.apCost(f != 0, false) <= ap));
+                    REQUIRE((!m.isSuper() || sp >= 4));
+                    Move const &c = def->getCounterMove(
+                        *me, *opp, f != 0, opp->moves[1]);
+                    REQUIRE((c.isWait() || c.apCost(f != 0, true) <= ap));
+                    REQUIRE((c.isWait() || f == 0 || c.canHitDistance()));
+                }
+            }
+        }
+    }
+
+    SECTION("GoesForTheKill") {
+        me->cur_ap = 6;
+        me->cur_life = 5;
+        opp->cur_ap = 0;
+        opp->cur_life = 1;
+        REQUIRE(!att->getNextMove(*me, *opp, false).isWait());
+    }
+
+    SECTION("TableIsReused") {
+        me->cur_ap = 6;
+        std::shared_ptr<TranspositionTable> table = att->getTable(*me);
+        att->getNextMove(*me, *opp, false);
+        REQUIRE(table->lookups() > 0);
+        size_t hits = table->hits();
+        att->getNextMove(*me, *opp, false);
+        REQUIRE(table->hits() > hits);
+        REQUIRE(att->getTable(*me) == table);
+        att->updateAfterMatch(*me, *opp, true);
+        REQUIRE(att->getTable(*me) != table);
+    }
+
+}
@@ -0,0 +1,89 @@
+//  Copyright 2015 Dario Domizioli
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "catch/catch.hpp"
+#include "../TestCharacters.h"
+
+#include "core/game/Character.h"
+#include "core/ctrl/ExpertSystemCtrl.h"
+
+using namespace core;
+using namespace core::game;
+using namespace core::ctrl;
+
+static std::shared_ptr<Character> makeCharacter(int combination) {
+    return test::makeCharacter("Test", getAttackExpertSystem(combination),
+                               getDefenceExpertSystem(combination));
+}
+
+TEST_CASE( "ExpertSystemCtrl", "[ctrl]" ) {
+
+    SECTION("Tags") {
+        REQUIRE(getExpertSystemTag(*getAttackExpertSystem(0)) == ES_GRUNT);
+        REQUIRE(getExpertSystemTag(*getDefenceExpertSystem(6)) == ES_SNIPER);
+        REQUIRE(getExpertSystemTag(*getAttackExpertSystem(-1)) == ES_DUMB);
+        REQUIRE(getExpertSystemTag(*getDefenceExpertSystem(-1)) == ES_DUMB);
+    }
+
+    SECTION("BestMoveTableMatchesScan") {
+        for(int comb = 0; comb < getNumExpertSystemsCombinations(); ++comb) {
+            std::shared_ptr<Character> c = makeCharacter(comb);
+            std::shared_ptr<Character> opp = makeCharacter(0);
+            std::unique_ptr<Character> with_table(c->clone());
+            REQUIRE(!with_table->best_moves);
+            prepareBestMoveTable(*c);
+            REQUIRE(c->best_moves);
+            REQUIRE(c->best_moves->isValidFor(*c));
+            with_table.reset(c->clone());
+            REQUIRE(with_table->best_moves == c->best_moves);
+            c->best_moves.reset();
+
+            for(int f = 0; f < 2; ++f) {
+                for(int ap = 0; ap <= 20; ++ap) {
+                    for(int sp = 0; sp <= 6; ++sp) {
+                        for(size_t last = 0; last < c->moves.size(); ++last) {
+                            for(auto ch : {c.get(), with_table.get()}) {
+                                ch->cur_ap = ap;
+                                ch->cur_sp = sp;
+                                ch->moves_performed.clear();
+                                if(last > 0) {
+                                    ch->moves_performed.push_back(last);
+                                }
+                            }
+                            Move const &scanned = c->actrl->getNextMove(
+                                *c, *opp, f != 0);
+                            Move const &looked_up = c->actrl->getNextMove(
+                                *with_table, *opp, f != 0);
+                            REQUIRE(scanned == looked_up);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    SECTION("BestMoveTableNoticesChangedMoves") {
+        std::shared_ptr<Character> c = makeCharacter(2);
+        prepareBestMoveTable(*c);
+        std::shared_ptr<BestMoveTable const> old_table = c->best_moves;
+        REQUIRE(old_table->isValidFor(*c));
+        // Same number of moves, but a different one.
+        c->moves[2] = Move{"Other", MT_SPECIAL, {MS_DASH}};
+        REQUIRE(!old_table->isValidFor(*c));
+        prepareBestMoveTable(*c);
+        REQUIRE(c->best_moves != old_table);
+        REQUIRE(c->best_moves->isValidFor(*c));
+    }
+
+}
@@ -0,0 +1,81 @@
+//  Copyright 2015 Dario Domizioli
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "catch/catch.hpp"
+#include "../TestCharacters.h"
+
+#include "core/game/Character.h"
+#include "core/game/Duel.h"
+#include "core/ctrl/ExpertSystemCtrl.h"
+#include "core/ctrl/MCTSCtrl.h"
+
+using namespace core;
+using namespace core::game;
+using namespace core::ctrl;
+using test::makeCharacter;
+
+TEST_CASE( "MCTSCtrl", "[ctrl]" ) {
+    MCTSOptions options;
+    options.rollouts = 48;
+    options.threads = 2;
+    std::shared_ptr<MCTSAttack> att = std::make_shared<MCTSAttack>(options);
+    std::shared_ptr<MCTSDefence> def = std::make_shared<MCTSDefence>(options);
+
+    SECTION("LegalMoves") {
+        std::shared_ptr<Character> me = makeCharacter("Me", att, def);
+        std::shared_ptr<Character> opp = makeCharacter(
+            "Opp", getAttackExpertSystem(7), getDefenceExpertSystem(7));
+        for(int f = 0; f < 2; ++f) {
+            for(int ap = 0; ap <= 8; ap += 2) {
+                for(int sp = 0; sp <= 5; sp += 5) {
+                    me->cur_ap = ap;
+                    me->cur_sp = sp;
+                    Move const &m = att->getNextMove(*me, *opp, f != 0);
+                    REQUIRE((m.isWait() || m.apCost(f != 0, false) <= ap));
+                    REQUIRE((m.isWait() || !m.hasReflect()));
+                    REQUIRE((!m.isSuper() || sp >= 4));
+                    Move const &c = def->getCounterMove(
+                        *me, *opp, f != 0, opp->moves[1]);
+                    REQUIRE((c.isWait() || c.apCost(f != 0, true) <= ap));
+                    REQUIRE((c.isWait() || f == 0 || c.canHitDistance()));
+                }
+            }
+        }
+    }
+
+    SECTION("GoesForTheKill") {
+        std::shared_ptr<Character> me = makeCharacter("Me", att, def);
+        std::shared_ptr<Character> opp = makeCharacter(
+            "Opp", getAttackExpertSystem(0), getDefenceExpertSystem(0));
+        me->cur_ap = 6;
+        me->cur_life = 5;
+        opp->cur_ap = 0;
+        opp->cur_life = 1;
+        REQUIRE(!att->getNextMove(*me, *opp, false).isWait());
+    }
+
+    SECTION("PlaysWholeFights") {
+        std::shared_ptr<Character> me = makeCharacter("Me", att, def);
+        std::shared_ptr<Character> opp = makeCharacter(
+            "Opp", getAttackExpertSystem(7), getDefenceExpertSystem(7));
+        for(int i = 0; i < 4; ++i) {
+            Duel duel(me, opp, nullptr);
+            duel.fight();
+        }
+        // Every fight has ended, with 3 points for a win and 1 each for a draw.
+        int points = me->total_points + opp->total_points;
+        REQUIRE(points >= 8);
+    }
+
+}
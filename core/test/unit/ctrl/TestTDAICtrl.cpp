@@ -0,0 +1,106 @@
+//  Copyright 2015 Dario Domizioli
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+
+#include "catch/catch.hpp"
+#include "../TestCharacters.h"
+
+#include "core/game/Character.h"
+#include "core/ctrl/ExpertSystemCtrl.h"
+#include "core/ctrl/TDAICtrl.h"
+
+using namespace core;
+using namespace core::game;
+using namespace core::ctrl;
+using test::makeCharacter;
+
+static size_t indexOf(Character const &c, Move const &m) {
+    for(size_t i = 0; i < c.moves.size(); ++i) {
+        if(&c.moves[i] == &m) {
+            return i;
+        }
+    }
+    return c.moves.size();
+}
+
+TEST_CASE( "TDAICtrl", "[ctrl]" ) {
+    TDOptions options;
+    options.exploration = 0.0;
+    std::shared_ptr<TDAIAttack> att = std::make_shared<TDAIAttack>(options);
+    std::shared_ptr<TDAIDefence> def = std::make_shared<TDAIDefence>(options);
+    std::shared_ptr<Character> me = makeCharacter("Me", att, def);
+    std::shared_ptr<Character> opp = makeCharacter(
+        "Opp", getAttackExpertSystem(7), getDefenceExpertSystem(7));
+
+    SECTION("LegalMoves") {
+        for(int f = 0; f < 2; ++f) {
+            for(int ap = 0; ap <= 8; ap += 2) {
+                for(int sp = 0; sp <= 5; sp += 5) {
+                    me->cur_ap = ap;
+                    me->cur_sp = sp;
+                    Move const &m = att->getNextMove(*me, *opp, f != 0);
+                    REQUIRE((m.isWait() || m.apCost(f != 0, false) <= ap));
+                    REQUIRE((!m.isSuper() || sp >= 4));
+                    Move const &c = def->getCounterMove(
+                        *me, *opp, f != 0, opp->moves[1]);
+                    REQUIRE((c.isWait() || c.apCost(f != 0, true) <= ap));
+                    REQUIRE((c.isWait() || f == 0 || c.canHitDistance()));
+                }
+            }
+        }
+    }
+
+    SECTION("CreditsEachMove") {
+        // A move after which the opponent lost life gains value before the
+        // end of the fight...
+        me->cur_ap = 6;
+        Move const &first = att->getNextMove(*me, *opp, false);
+        size_t first_index = indexOf(*me, first);
+        REQUIRE(first_index < me->moves.size());
+        REQUIRE(att->getValue(*me, *opp, first_index) == 0.5);
+        att->updateAfterMove(*me, *opp, first, true);
+        opp->cur_life -= 10;
+        me->cur_ap = 4;
+        Move const &second = att->getNextMove(*me, *opp, false);
+        att->updateAfterMove(*me, *opp, second, true);
+        me->cur_ap = 6;
+        REQUIRE(att->getValue(*me, *opp, first_index) > 0.5);
+
+        // ... and the last move gets the outcome.
+        me->cur_ap = 2;
+        Move const &last = att->getNextMove(*me, *opp, false);
+        size_t last_index = indexOf(*me, last);
+        att->updateAfterMove(*me, *opp, last, true);
+        att->updateAfterMatch(*me, *opp, false);
+        REQUIRE(att->getValue(*me, *opp, last_index) < 0.5);
+    }
+
+    SECTION("CreditsWaits") {
+        // Duel does not report the end of a wait, so the next decision must
+        // end it and give it credit for what happened meanwhile.
+        me->cur_ap = 0;
+        Move const &wait = def->getCounterMove(*me, *opp, false,
+                                               opp->moves[1]);
+        REQUIRE(wait.isWait());
+        size_t wait_index = indexOf(*me, wait);
+        REQUIRE(def->getValue(*me, *opp, wait_index) == 0.5);
+        opp->cur_life -= 10;
+        me->cur_ap = 6;
+        Move const &next = def->getCounterMove(*me, *opp, false,
+                                               opp->moves[1]);
+        def->updateAfterMove(*me, *opp, next, true);
+        me->cur_ap = 0;
+        REQUIRE(def->getValue(*me, *opp, wait_index) > 0.5);
+    }
+}
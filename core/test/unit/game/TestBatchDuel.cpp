@@ -0,0 +1,137 @@
+//  Copyright 2015 Dario Domizioli
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "catch/catch.hpp"
+#include "core/game/BatchDuel.h"
+#include "core/game/Dice.h"
+#include "core/ctrl/EvolveAICtrl.h"
+#include "core/ctrl/ExpertSystemCtrl.h"
+
+#include <cmath>
+#include <sstream>
+
+using namespace core;
+using namespace core::game;
+
+namespace {
+
+std::shared_ptr<Character> makeLearner(std::string const &name) {
+    std::shared_ptr<Character> c = std::make_shared<Character>(
+        name, 2, 3, 2, SP_DAMAGE,
+        std::make_shared<ctrl::EvolveAIAttack>(),
+        std::make_shared<ctrl::EvolveAIDefence>());
+    c->addMove(Move{"First", MT_SPECIAL, {MS_POWERFUL}});
+    c->addMove(Move{"Super", MT_SUPER, {MS_POWERFUL, MS_SMASH, MS_FALL}});
+    return c;
+}
+
+std::string learnt(Character const &c) {
+    std::ostringstream out;
+    c.actrl->saveState(out);
+    c.dctrl->saveState(out);
+    return out.str();
+}
+
+}
+
+TEST_CASE( "BatchDuel", "[game]" ) {
+
+    std::shared_ptr<Character> brawler = std::make_shared<Character>(
+        "Brawler", 2, 3, 2, SP_DAMAGE,
+        ctrl::getAttackExpertSystem(1), ctrl::getDefenceExpertSystem(1));
+    brawler->addMove(Move{"First", MT_SPECIAL, {MS_POWERFUL}});
+    brawler->addMove(Move{"Super", MT_SUPER, {MS_POWERFUL, MS_SMASH, MS_FALL}});
+    std::shared_ptr<Character> sniper = std::make_shared<Character>(
+        "Sniper", 3, 1, 3, SP_COMBO,
+        ctrl::getAttackExpertSystem(7), ctrl::getDefenceExpertSystem(7));
+    sniper->addMove(Move{"First", MT_SPECIAL, {MS_PUSH}});
+    sniper->addMove(Move{"Super", MT_SUPER, {MS_POWERFUL, MS_THROW}});
+
+    size_t const fights = 4000;
+
+    SECTION("AgreesWithScalarDuel") {
+        double scalar[4] = {0};
+        SeededDiceSource dice(11);
+        for(size_t i = 0; i < fights; ++i) {
+            Duel d(brawler, sniper, nullptr, &dice);
+            while(d.step()) {}
+            scalar[d.result()] += 1.0 / fights;
+        }
+        double batched[4] = {0};
+        BatchDuel batch(brawler, sniper, fights, 11);
+        batch.fight();
+        REQUIRE(batch.results().size() == fights);
+        for(DuelResult r : batch.results()) {
+            REQUIRE(r != DR_ONGOING);
+            batched[r] += 1.0 / fights;
+        }
+        for(int r = DR_C1_WINS; r <= DR_DRAW; ++r) {
+            double p = (scalar[r] + batched[r]) / 2.0;
+            double sigma = std::sqrt(2.0 * p * (1.0 - p) / fights);
+            REQUIRE(std::fabs(scalar[r] - batched[r]) < 5.0 * sigma + 1e-3);
+        }
+    }
+
+    SECTION("Reproducible") {
+        BatchDuel first(brawler, sniper, 100, 5);
+        first.fight();
+        BatchDuel second(brawler, sniper, 100, 5);
+        second.fight();
+        REQUIRE(first.results() == second.results());
+    }
+
+    SECTION("Conclude") {
+        BatchDuel batch(brawler, sniper, 100, 3);
+        batch.fight();
+        int expected[2] = {0, 0};
+        for(DuelResult r : batch.results()) {
+            expected[0] += (r == DR_C1_WINS) ? 3 : (r == DR_DRAW ? 1 : 0);
+            expected[1] += (r == DR_C2_WINS) ? 3 : (r == DR_DRAW ? 1 : 0);
+        }
+        batch.conclude();
+        REQUIRE(brawler->total_points == expected[0]);
+        REQUIRE(sniper->total_points == expected[1]);
+    }
+
+    SECTION("LearningAIs") {
+        // Each lane must learn like a Duel of its own: fight all of them on
+        // the same dice, then conclude all of them.
+        size_t const lanes = 20;
+        auto a = makeLearner("A");
+        auto b = makeLearner("B");
+        getRandomGenerator().seed(9);
+        BatchDuel batch(a, b, lanes, 9);
+        batch.fight();
+        batch.conclude();
+
+        auto scalar_a = makeLearner("A");
+        auto scalar_b = makeLearner("B");
+        getRandomGenerator().seed(9);
+        BlockDiceSource dice(9);
+        std::vector<std::unique_ptr<Duel>> duels;
+        std::vector<DuelResult> results;
+        for(size_t i = 0; i < lanes; ++i) {
+            duels.emplace_back(new Duel(scalar_a, scalar_b, nullptr, &dice));
+            while(duels.back()->step()) {}
+            results.push_back(duels.back()->result());
+        }
+        for(auto &d : duels) {
+            d->conclude();
+        }
+        REQUIRE(batch.results() == results);
+        REQUIRE(learnt(*a) == learnt(*scalar_a));
+        REQUIRE(learnt(*b) == learnt(*scalar_b));
+        REQUIRE(a->total_points == scalar_a->total_points);
+    }
+}
@@ -0,0 +1,199 @@
+//  Copyright 2015 Dario Domizioli
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "catch/catch.hpp"
+#include "core/game/Dice.h"
+
+#include <cmath>
+#include <vector>
+
+using namespace core;
+using namespace core::game;
+
+TEST_CASE( "SeededDiceSource", "[game]" ) {
+
+    SECTION("Reproducible") {
+        SeededDiceSource dice(42);
+        std::vector<int> rolls;
+        for(int i = 0; i < 100; ++i) {
+            rolls.push_back(dice.d6WithCritFor(i % 2));
+        }
+        dice.reset(42);
+        for(int i = 0; i < 100; ++i) {
+            REQUIRE(dice.d6WithCritFor(i % 2) == rolls[i]);
+        }
+    }
+
+    SECTION("Separate sequences") {
+        // The rolls of one character do not depend on the other's.
+        SeededDiceSource dice(7);
+        std::vector<int> rolls;
+        for(int i = 0; i < 50; ++i) {
+            rolls.push_back(dice.d6WithCritFor(1));
+        }
+        dice.reset(7);
+        for(int i = 0; i < 50; ++i) {
+            dice.d6WithCritFor(0);
+            REQUIRE(dice.d6WithCritFor(1) == rolls[i]);
+        }
+    }
+
+    SECTION("Antithetic") {
+        SeededDiceSource plain(3);
+        SeededDiceSource mirrored(3, true);
+        int counts[9] = {0};
+        for(int i = 0; i < 600; ++i) {
+            int x = plain.d6WithCrit();
+            int y = mirrored.d6WithCrit();
+            REQUIRE(x != 6);
+            REQUIRE(x >= 1);
+            REQUIRE(x <= 8);
+            // 1 <-> 8, 2 <-> 5, 3 <-> 4
+            int mirror[9] = {0, 8, 5, 4, 3, 2, 0, 0, 1};
+            REQUIRE(y == mirror[x]);
+            ++counts[x];
+        }
+        for(int face : {1, 2, 3, 4, 5, 8}) {
+            REQUIRE(counts[face] > 50);
+        }
+    }
+}
+
+namespace {
+
+/// \brief Returns the chi-square statistic of the counts against a uniform
+///        distribution over the given faces.
+double chiSquare(std::vector<int> const &counts, std::vector<int> const &faces,
+                 int rolls) {
+    double expected = static_cast<double>(rolls) / faces.size();
+    double chi2 = 0.0;
+    for(int face : faces) {
+        double d = counts[face] - expected;
+        chi2 += d * d / expected;
+    }
+    return chi2;
+}
+
+}
+
+TEST_CASE( "BlockDiceSource", "[game]" ) {
+
+    SECTION("Uniform d6") {
+        BlockDiceSource dice(123);
+        int const rolls = 600000;
+        std::vector<int> counts(9, 0);
+        for(int i = 0; i < rolls; ++i) {
+            int x = dice.d6WithCrit();
+            REQUIRE((x >= 1 && x <= 8 && x != 6 && x != 7));
+            ++counts[x];
+        }
+        // 20.52 is the 0.999 quantile of chi-square with 5 degrees of freedom.
+        REQUIRE(chiSquare(counts, {1, 2, 3, 4, 5, 8}, rolls) < 20.52);
+    }
+
+    SECTION("Fuzz rate") {
+        BlockDiceSource dice(456);
+        int const rolls = 200000;
+        int hits = 0;
+        for(int i = 0; i < rolls; ++i) {
+            hits += dice.fuzz() ? 1 : 0;
+        }
+        // One in twenty, within five standard deviations.
+        double sigma = std::sqrt(rolls * 0.05 * 0.95);
+        REQUIRE(std::fabs(hits - rolls * 0.05) < 5.0 * sigma);
+    }
+
+    SECTION("Serial pairs") {
+        // Consecutive rolls must be independent: all 36 pairs are equally
+        // likely.
+        BlockDiceSource dice(789);
+        int const pairs = 360000;
+        std::vector<int> counts(81, 0);
+        for(int i = 0; i < pairs; ++i) {
+            int x = dice.d6WithCrit();
+            int y = dice.d6WithCrit();
+            ++counts[x * 9 + y];
+        }
+        std::vector<int> faces;
+        for(int x : {1, 2, 3, 4, 5, 8}) {
+            for(int y : {1, 2, 3, 4, 5, 8}) {
+                faces.push_back(x * 9 + y);
+            }
+        }
+        // 66.62 is the 0.999 quantile of chi-square with 35 degrees of
+        // freedom.
+        REQUIRE(chiSquare(counts, faces, pairs) < 66.62);
+    }
+
+    SECTION("Reproducible") {
+        BlockDiceSource dice(42);
+        std::vector<int> rolls;
+        for(int i = 0; i < 1000; ++i) {
+            rolls.push_back(dice.d6WithCrit());
+        }
+        dice.reset(42);
+        for(int i = 0; i < 1000; ++i) {
+            REQUIRE(dice.d6WithCrit() == rolls[i]);
+        }
+    }
+
+    SECTION("Global dice follow the seed") {
+        seedDice(99);
+        std::vector<int> rolls;
+        for(int i = 0; i < 1000; ++i) {
+            rolls.push_back(d6WithCrit());
+        }
+        seedDice(99);
+        for(int i = 0; i < 1000; ++i) {
+            REQUIRE(d6WithCrit() == rolls[i]);
+        }
+    }
+}
+
+TEST_CASE( "CounterDiceSource", "[game]" ) {
+
+    SECTION("Position") {
+        CounterDiceSource dice(5);
+        for(int i = 0; i < 17; ++i) {
+            dice.d6WithCrit();
+        }
+        DicePosition position;
+        REQUIRE(dice.getPosition(position));
+        std::vector<int> rolls;
+        for(int i = 0; i < 100; ++i) {
+            rolls.push_back(dice.d6WithCrit());
+        }
+        REQUIRE(dice.setPosition(position));
+        for(int i = 0; i < 100; ++i) {
+            REQUIRE(dice.d6WithCrit() == rolls[i]);
+        }
+    }
+
+    SECTION("Uniform d6") {
+        CounterDiceSource dice(321);
+        int const rolls = 600000;
+        std::vector<int> counts(9, 0);
+        for(int i = 0; i < rolls; ++i) {
+            ++counts[dice.d6WithCrit()];
+        }
+        REQUIRE(chiSquare(counts, {1, 2, 3, 4, 5, 8}, rolls) < 20.52);
+    }
+
+    SECTION("Other sources have no position") {
+        SeededDiceSource seeded(1);
+        DicePosition position;
+        REQUIRE(!seeded.getPosition(position));
+        REQUIRE(!seeded.setPosition(position));
+    }
+}
@@ -0,0 +1,126 @@
+//  Copyright 2015 Dario Domizioli
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "catch/catch.hpp"
+#include "../TestCharacters.h"
+#include "core/game/Duel.h"
+#include "core/game/Dice.h"
+#include "core/game/ScoreSheet.h"
+#include "core/ctrl/ExpertSystemCtrl.h"
+
+#include <vector>
+
+using namespace core;
+using namespace core::game;
+
+namespace {
+
+bool sameState(DuelState const &a, DuelState const &b) {
+    FighterState const *fa[2] = { &a.c1, &a.c2 };
+    FighterState const *fb[2] = { &b.c1, &b.c2 };
+    for(int f = 0; f < 2; ++f) {
+        if(fa[f]->cur_ap != fb[f]->cur_ap || fa[f]->cur_sp != fb[f]->cur_sp
+           || fa[f]->cur_life != fb[f]->cur_life
+           || fa[f]->cur_combo != fb[f]->cur_combo
+           || fa[f]->air != fb[f]->air || fa[f]->down != fb[f]->down
+           || fa[f]->nth_move_of_the_round != fb[f]->nth_move_of_the_round
+           || fa[f]->moves_performed != fb[f]->moves_performed) {
+            return false;
+        }
+    }
+    return a.far == b.far && a.turn_counter == b.turn_counter
+           && a.c1_attacks == b.c1_attacks && a.phase == b.phase;
+}
+
+/// \brief Runs the fight to the end, recording the states.
+std::vector<DuelState> runToEnd(Duel &d) {
+    std::vector<DuelState> states;
+    while(d.step()) {
+        states.push_back(d.getState());
+    }
+    states.push_back(d.getState());
+    return states;
+}
+
+}
+
+TEST_CASE( "Duel snapshots", "[game]" ) {
+
+    std::shared_ptr<Character> grunt = test::makeGrunt();
+    std::shared_ptr<Character> counter = test::makeCounter();
+
+    CounterDiceSource dice(17);
+    Duel d(grunt, counter, nullptr, &dice);
+    for(int i = 0; i < 10 && d.step(); ++i) {}
+    DuelSnapshot snap = d.snapshot();
+    REQUIRE(snap.has_dice);
+
+    SECTION("Restore replays the same fight") {
+        std::vector<DuelState> first = runToEnd(d);
+        DuelResult result = d.result();
+        d.restore(snap);
+        REQUIRE(sameState(d.getState(), snap.state));
+        std::vector<DuelState> second = runToEnd(d);
+        REQUIRE(d.result() == result);
+        REQUIRE(first.size() == second.size());
+        for(size_t i = 0; i < first.size(); ++i) {
+            REQUIRE(sameState(first[i], second[i]));
+        }
+    }
+
+    SECTION("Fork with a copy of the dice") {
+        CounterDiceSource copy;
+        copy.setPosition(snap.dice);
+        std::unique_ptr<Duel> forked = d.fork(&copy);
+        REQUIRE(sameState(forked->getState(), d.getState()));
+        std::vector<DuelState> original = runToEnd(d);
+        std::vector<DuelState> branch = runToEnd(*forked);
+        REQUIRE(forked->result() == d.result());
+        REQUIRE(original.size() == branch.size());
+        REQUIRE(sameState(original.back(), branch.back()));
+    }
+
+    SECTION("Forks do not touch the original") {
+        DuelState before = d.getState();
+        CounterDiceSource other(99);
+        std::unique_ptr<Duel> forked = d.fork(&other);
+        runToEnd(*forked);
+        REQUIRE(sameState(d.getState(), before));
+        REQUIRE(grunt->total_points == 0);
+        REQUIRE(counter->total_points == 0);
+    }
+
+    SECTION("Score sheets replace the points") {
+        ScoreSheet sheet;
+        d.setScoreSheet(&sheet);
+        runToEnd(d);
+        d.conclude();
+        REQUIRE(grunt->total_points == 0);
+        REQUIRE(counter->total_points == 0);
+        Tally t = sheet.getTally(*grunt, *counter);
+        REQUIRE(t.fights() == 1);
+        REQUIRE(sheet.getTally(*counter, *grunt).fights() == 0);
+        Tally mirrored = sheet.getResults(*counter, *grunt);
+        REQUIRE(mirrored.wins == t.losses);
+        REQUIRE(mirrored.draws == t.draws);
+        int points = sheet.getPoints(*grunt) + sheet.getPoints(*counter);
+        REQUIRE(points == (t.draws == 1 ? 2 : 3));
+
+        ScoreSheet total;
+        total.merge(sheet);
+        total.merge(sheet);
+        REQUIRE(total.getTotal(*grunt).fights() == 2);
+        REQUIRE(total.getPoints(*grunt) == 2 * sheet.getPoints(*grunt));
+    }
+}
@@ -16,6 +16,9 @@
 
 #include "core/game/Move.h"
 
+#include <thread>
+#include <vector>
+
 using namespace core;
 using namespace core::game;
 
@@ -49,4 +52,59 @@ TEST_CASE( "Move", "[game]" ) {
         REQUIRE(moves[6].apCost(true, false) == 3);
     }
 
+    SECTION("Similarity") {
+        Move a("A", MT_SPECIAL, {MS_FALL, MS_DASH});
+        Move b("B", MT_SPECIAL, {MS_FALL, MS_PUSH});
+        Move c("C", MT_SUPER, {MS_FALL, MS_DASH});
+
+        REQUIRE(moveSimilarity(a, a) == 1.0);
+        REQUIRE(moveSimilarity(a, b) == Approx(1.0 / 3));
+        REQUIRE(moveSimilarity(a, c) == 0.0);
+        REQUIRE(moveSimilarity(getWaitMove(), getWaitMove()) == 1.0);
+    }
+
+    SECTION("Interning") {
+        Move a("A", MT_SPECIAL, {MS_FALL, MS_DASH});
+        Move same("A", MT_SPECIAL, {MS_FALL, MS_DASH});
+        Move swapped("A", MT_SPECIAL, {MS_DASH, MS_FALL});
+        Move other("B", MT_SPECIAL, {MS_FALL, MS_DASH});
+
+        REQUIRE(a.getId() == same.getId());
+        REQUIRE(a == same);
+        REQUIRE(a.getId() != swapped.getId());
+        REQUIRE(a.getId() != other.getId());
+        REQUIRE(a < other);
+        REQUIRE_FALSE(other < a);
+        REQUIRE(getMove(a.getId()) == a);
+        REQUIRE(getMove(a.getId()).getName() == "A");
+        REQUIRE(getNumMoves() > other.getId());
+        REQUIRE(a.hasSymbol(MS_DASH));
+        REQUIRE_FALSE(a.hasSymbol(MS_PUSH));
+    }
+
+    SECTION("InterningOnManyThreads") {
+        // Every thread creates the same new moves twice: the second time
+        // they come from the moves of the thread, and must be the same.
+        std::vector<std::vector<MoveId>> ids(4);
+        std::vector<std::thread> threads;
+        for(size_t t = 0; t < ids.size(); ++t) {
+            threads.push_back(std::thread([t, &ids]() {
+                for(int round = 0; round < 2; ++round) {
+                    for(int i = 0; i < 50; ++i) {
+                        Move m("Threaded" + std::to_string(i), MT_SPECIAL,
+                               {MS_PUSH});
+                        ids[t].push_back(m.getId());
+                    }
+                }
+            }));
+        }
+        for(auto &th : threads) th.join();
+        Move first("Threaded0", MT_SPECIAL, {MS_PUSH});
+        for(auto const &thread_ids : ids) {
+            REQUIRE(thread_ids == ids[0]);
+            REQUIRE(thread_ids[0] == first.getId());
+            REQUIRE(thread_ids[50] == first.getId());
+        }
+    }
+
 }
@@ -0,0 +1,122 @@
+//  Copyright 2015 Dario Domizioli
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "catch/catch.hpp"
+#include "core/sim/Checkpoint.h"
+#include "core/game/Character.h"
+#include "core/game/Dice.h"
+#include "core/game/Duel.h"
+#include "core/ctrl/EvolveAICtrl.h"
+
+#include <cstdio>
+#include <sstream>
+
+using namespace core;
+using namespace core::game;
+using namespace core::sim;
+
+namespace {
+
+std::vector<std::shared_ptr<Character>> makeLearners() {
+    std::vector<std::shared_ptr<Character>> characters;
+    for(std::string name : { "A", "B" }) {
+        auto c = std::make_shared<Character>(
+            name, 2, 3, 2, SP_DAMAGE,
+            std::make_shared<ctrl::EvolveAIAttack>(),
+            std::make_shared<ctrl::EvolveAIDefence>());
+        c->addMove(Move{"First", MT_SPECIAL, {MS_POWERFUL}});
+        c->addMove(Move{"Super", MT_SUPER, {MS_POWERFUL, MS_SMASH, MS_FALL}});
+        characters.push_back(c);
+    }
+    return characters;
+}
+
+/// \brief Fights some rounds, returning the outcomes.
+std::string fightRounds(std::vector<std::shared_ptr<Character>> const &cs,
+                        ScoreSheet &scores, int rounds) {
+    std::string outcomes;
+    for(int i = 0; i < rounds; ++i) {
+        Duel first(cs[0], cs[1], nullptr);
+        first.setScoreSheet(&scores);
+        first.fight();
+        Duel second(cs[1], cs[0], nullptr);
+        second.setScoreSheet(&scores);
+        second.fight();
+        outcomes += std::to_string(first.result());
+        outcomes += std::to_string(second.result());
+    }
+    return outcomes;
+}
+
+std::string learnt(Character const &c) {
+    std::ostringstream out;
+    c.actrl->saveState(out);
+    c.dctrl->saveState(out);
+    return out.str();
+}
+
+}
+
+TEST_CASE( "Checkpoint", "[sim]" ) {
+    std::string path = "test_checkpoint.bin";
+    getRandomGenerator().seed(5);
+    seedDice(5);
+    auto characters = makeLearners();
+    ScoreSheet scores;
+    fightRounds(characters, scores, 20);
+    characters[0]->total_points = 7;
+
+    Checkpoint taken;
+    taken.take(characters, scores, nullptr, 20);
+    std::string error;
+    REQUIRE(taken.write(path, error));
+    std::string before = fightRounds(characters, scores, 20);
+
+    // A new run restores the checkpoint and continues exactly the same.
+    auto again = makeLearners();
+    Checkpoint read;
+    REQUIRE(read.read(path, error));
+    REQUIRE(read.round() == 20);
+    ScoreSheet restored;
+    REQUIRE(read.restore(again, restored, nullptr, error));
+    REQUIRE(again[0]->total_points == 7);
+    Tally t = restored.getTally(*again[0], *again[1]);
+    REQUIRE(t.fights() == 20);
+    std::string after = fightRounds(again, restored, 20);
+    REQUIRE(after == before);
+    REQUIRE(learnt(*again[0]) == learnt(*characters[0]));
+    REQUIRE(learnt(*again[1]) == learnt(*characters[1]));
+
+    // Other characters are refused.
+    auto others = makeLearners();
+    others.pop_back();
+    REQUIRE_FALSE(read.restore(others, restored, nullptr, error));
+
+    SECTION("Writer") {
+        std::remove(path.c_str());
+        if(true) { // Just to have a scope
+            CheckpointWriter writer(path, 0.0);
+            REQUIRE(writer.isDue());
+            std::unique_ptr<Checkpoint> checkpoint(new Checkpoint());
+            checkpoint->take(characters, scores, nullptr, 40);
+            writer.submit(std::move(checkpoint));
+            REQUIRE(writer.flush(error));
+            REQUIRE(writer.written() == 1);
+        }
+        Checkpoint written;
+        REQUIRE(written.read(path, error));
+        REQUIRE(written.round() == 40);
+    }
+    std::remove(path.c_str());
+}
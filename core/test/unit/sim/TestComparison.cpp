@@ -0,0 +1,61 @@
+//  Copyright 2015 Dario Domizioli
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "catch/catch.hpp"
+#include "core/sim/Comparison.h"
+#include "core/game/Character.h"
+#include "core/ctrl/ExpertSystemCtrl.h"
+
+using namespace core;
+using namespace core::game;
+using namespace core::sim;
+
+TEST_CASE( "Comparison", "[sim]" ) {
+
+    std::vector<std::shared_ptr<Character>> characters;
+    for(int i = 0; i < 4; ++i) {
+        std::shared_ptr<Character> c = std::make_shared<Character>(
+            "Expert", 1 + i % 3, 3 - i % 3, 2, SP_DAMAGE,
+            ctrl::getAttackExpertSystem(i), ctrl::getDefenceExpertSystem(i));
+        c->addMove(Move{"First", MT_SPECIAL, {MS_POWERFUL}});
+        c->addMove(Move{"Super", MT_SUPER, {MS_POWERFUL, MS_SMASH, MS_FALL}});
+        characters.push_back(c);
+    }
+    std::shared_ptr<Character> twin = std::make_shared<Character>(
+        "Twin", 1, 3, 2, SP_DAMAGE,
+        ctrl::getAttackExpertSystem(0), ctrl::getDefenceExpertSystem(0));
+    twin->addMove(Move{"First", MT_SPECIAL, {MS_POWERFUL}});
+    twin->addMove(Move{"Super", MT_SUPER, {MS_POWERFUL, MS_SMASH, MS_FALL}});
+
+    SECTION("Identical characters on common dice") {
+        Comparison c = compare(characters[0], twin, characters, 20, 1,
+                               DS_COMMON);
+        REQUIRE(c.difference == 0.0);
+        REQUIRE(c.std_error == 0.0);
+        REQUIRE(c.fights == 3 * 20 * 2 * 2);
+    }
+
+    SECTION("Identical characters on independent dice") {
+        Comparison c = compare(characters[0], twin, characters, 20, 1,
+                               DS_INDEPENDENT);
+        REQUIRE(c.std_error > 0.0);
+    }
+
+    SECTION("Antithetic fights twice") {
+        Comparison c = compare(characters[1], characters[2], characters, 20, 1,
+                               DS_ANTITHETIC);
+        REQUIRE(c.fights == 2 * 20 * 2 * 2 * 2);
+        REQUIRE(c.variance_reduction > 0.0);
+    }
+}
@@ -0,0 +1,54 @@
+//  Copyright 2015 Dario Domizioli
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "catch/catch.hpp"
+#include "core/sim/MatchupSampler.h"
+#include "core/game/Character.h"
+#include "core/ctrl/ExpertSystemCtrl.h"
+
+#include <algorithm>
+#include <sstream>
+
+using namespace core;
+using namespace core::game;
+using namespace core::sim;
+
+TEST_CASE( "MatchupSampler", "[sim]" ) {
+
+    std::vector<std::shared_ptr<Character>> characters;
+    for(int i = 0; i < 3; ++i) {
+        std::shared_ptr<Character> c = std::make_shared<Character>(
+            "Expert" + std::to_string(i), 1 + i, 3 - i, 3, SP_DAMAGE,
+            ctrl::getAttackExpertSystem(i), ctrl::getDefenceExpertSystem(i));
+        c->addMove(Move{"First", MT_SPECIAL, {MS_POWERFUL}});
+        c->addMove(Move{"Super", MT_SUPER, {MS_POWERFUL, MS_SMASH, MS_FALL}});
+        characters.push_back(c);
+    }
+
+    SECTION("Precision") {
+        SamplerOptions options = SamplerOptions::forPrecision(3, 0.3);
+        MatchupSampler sampler(characters, options);
+        sampler.run(2, nullptr, nullptr);
+        REQUIRE(sampler.unsettledPairs() == 0);
+        REQUIRE(sampler.widestInterval() <= 0.3);
+        REQUIRE(sampler.fights() <= options.budget);
+
+        std::ostringstream csv;
+        sampler.writeMatrix(csv);
+        std::string text = csv.str();
+        size_t lines = std::count(text.begin(), text.end(), '\n');
+        REQUIRE(lines == 1 + 3 * 2);
+        REQUIRE(text.find("\"Expert0\",\"Expert1\",") != std::string::npos);
+    }
+}
@@ -0,0 +1,133 @@
+//  Copyright 2015 Dario Domizioli
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "catch/catch.hpp"
+#include "core/sim/Rating.h"
+#include "core/sim/ResultCache.h"
+#include "core/game/Character.h"
+#include "core/ctrl/DumbCtrl.h"
+
+#include <sstream>
+
+using namespace core;
+using namespace core::game;
+using namespace core::sim;
+
+namespace {
+
+std::shared_ptr<Character> makeDummy(std::string const &name) {
+    return std::make_shared<Character>(
+        name, 2, 3, 2, SP_COMBO,
+        std::make_shared<ctrl::DumbAttackControl>(),
+        std::make_shared<ctrl::DumbDefendControl>());
+}
+
+}
+
+TEST_CASE( "Rating", "[sim]" ) {
+
+    std::shared_ptr<Character> player = makeDummy("Player");
+    std::shared_ptr<Character> a = makeDummy("A");
+    std::shared_ptr<Character> b = makeDummy("B");
+    std::shared_ptr<Character> c = makeDummy("C");
+
+    SECTION("Glicko-2") {
+        // The example of Glickman's description of Glicko-2.
+        RatingEngine engine(RatingOptions::forSystem(RS_GLICKO2));
+        std::string hash = "\t" + std::to_string(characterHash(*player));
+        std::istringstream saved("Player" + hash + "\t1500\t200\t0.06\t0\n"
+                                 "A" + hash + "\t1400\t30\t0.06\t0\n"
+                                 "B" + hash + "\t1550\t100\t0.06\t0\n"
+                                 "C" + hash + "\t1700\t300\t0.06\t0\n");
+        std::string error;
+        REQUIRE(engine.load(saved, error));
+        for(auto const &ch : { player, a, b, c }) {
+            engine.addCharacter(*ch);
+        }
+        ScoreSheet sheet;
+        sheet.record(*player, *a, DR_C1_WINS);
+        sheet.record(*b, *player, DR_C1_WINS);
+        sheet.record(*player, *c, DR_C2_WINS);
+        engine.update(sheet);
+        Rating r = engine.getRating("Player");
+        REQUIRE(r.rating == Approx(1464.06).epsilon(0.0001));
+        REQUIRE(r.deviation == Approx(151.52).epsilon(0.0001));
+        REQUIRE(r.volatility == Approx(0.05999).epsilon(0.0001));
+        REQUIRE(r.fights == 3);
+    }
+
+    SECTION("Incremental") {
+        RatingEngine engine(RatingOptions::forSystem(RS_ELO));
+        engine.addCharacter(*a);
+        engine.addCharacter(*b);
+        ScoreSheet sheet;
+        for(int i = 0; i < 10; ++i) {
+            sheet.record(*a, *b, DR_C1_WINS);
+        }
+        engine.update(sheet);
+        REQUIRE(engine.getRating("A").rating > 1500.0);
+        REQUIRE(engine.getRating("B").rating < 1500.0);
+        REQUIRE(engine.getRanking()[0].first == "A");
+
+        // A later run adds C to the saved ratings.
+        std::stringstream saved;
+        engine.save(saved);
+        RatingEngine later(RatingOptions::forSystem(RS_ELO));
+        std::string error;
+        REQUIRE(later.load(saved, error));
+        REQUIRE(later.getRating("A").rating == Approx(engine.getRating("A").rating));
+        later.addCharacter(*a);
+        later.addCharacter(*c);
+        ScoreSheet more;
+        more.record(*c, *a, DR_C1_WINS);
+        later.update(more);
+        REQUIRE(later.getRating("C").rating > 1500.0);
+        REQUIRE(later.getRating("B").fights == 10);
+        REQUIRE(later.getRating("A").fights == 11);
+    }
+
+    SECTION("NewCharacterUnderOldName") {
+        RatingEngine engine(RatingOptions::forSystem(RS_ELO));
+        engine.addCharacter(*a);
+        engine.addCharacter(*b);
+        ScoreSheet sheet;
+        for(int i = 0; i < 10; ++i) {
+            sheet.record(*a, *b, DR_C1_WINS);
+        }
+        engine.update(sheet);
+        std::stringstream saved;
+        engine.save(saved);
+
+        // A later run has a different build called "A", e.g. a new random
+        // character: it must start afresh, while "B" keeps its rating.
+        std::shared_ptr<Character> new_a = std::make_shared<Character>(
+            "A", 3, 2, 2, SP_COMBO,
+            std::make_shared<ctrl::DumbAttackControl>(),
+            std::make_shared<ctrl::DumbDefendControl>());
+        RatingEngine later(RatingOptions::forSystem(RS_ELO));
+        std::string error;
+        REQUIRE(later.load(saved, error));
+        later.addCharacter(*new_a);
+        later.addCharacter(*b);
+        REQUIRE(later.getRating("A").fights == 0);
+        REQUIRE(later.getRating("A").rating == 1500.0);
+        REQUIRE(later.getRating("B").fights == 10);
+
+        // Loading after adding does not bring the old rating back either.
+        saved.clear();
+        saved.seekg(0);
+        REQUIRE(later.load(saved, error));
+        REQUIRE(later.getRating("A").fights == 0);
+    }
+}
@@ -0,0 +1,121 @@
+//  Copyright 2015 Dario Domizioli
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "catch/catch.hpp"
+#include "core/sim/ResultCache.h"
+#include "core/game/Character.h"
+#include "core/ctrl/EvolveAICtrl.h"
+#include "core/ctrl/ExpertSystemCtrl.h"
+
+#include <cstdio>
+#include <fstream>
+
+using namespace core;
+using namespace core::game;
+using namespace core::sim;
+
+namespace {
+
+std::shared_ptr<Character> makeExpert(std::string const &name, int es) {
+    std::shared_ptr<Character> c = std::make_shared<Character>(
+        name, 2, 3, 2, SP_DAMAGE,
+        ctrl::getAttackExpertSystem(es), ctrl::getDefenceExpertSystem(es));
+    c->addMove(Move{"First", MT_SPECIAL, {MS_POWERFUL}});
+    c->addMove(Move{"Super", MT_SUPER, {MS_POWERFUL, MS_SMASH, MS_FALL}});
+    return c;
+}
+
+}
+
+TEST_CASE( "ResultCache", "[sim]" ) {
+
+    SECTION("Hashes") {
+        auto a = makeExpert("A", 0);
+        auto twin = makeExpert("Twin", 0);
+        auto other = makeExpert("A", 1);
+        REQUIRE(characterHash(*a) == characterHash(*twin));
+        REQUIRE(characterHash(*a) != characterHash(*other));
+        REQUIRE(isCacheable(*a));
+        auto evolving = std::make_shared<Character>(
+            "Evolving", 2, 3, 2, SP_DAMAGE,
+            std::make_shared<ctrl::EvolveAIAttack>(),
+            std::make_shared<ctrl::EvolveAIDefence>());
+        REQUIRE_FALSE(isCacheable(*evolving));
+    }
+
+    SECTION("Reuse") {
+        std::string path = "test_result_cache.bin";
+        std::remove(path.c_str());
+        std::vector<std::shared_ptr<Character>> characters = {
+            makeExpert("A", 0), makeExpert("B", 1), makeExpert("C", 2) };
+        std::string error;
+        size_t fought = 0;
+        if(true) { // Just to have a scope
+            ResultCache cache;
+            REQUIRE(cache.open(path, error));
+            std::vector<PairTally> tallies;
+            REQUIRE(collectMatrix(characters, 10, cache, 2, tallies, fought,
+                                  error));
+            REQUIRE(fought == 6 * 10);
+            REQUIRE(tallies[0 * 3 + 1].fights() == 10);
+            REQUIRE(cache.size() == 6);
+        }
+
+        // A later run only fights the new character.
+        characters.push_back(makeExpert("D", 3));
+        ResultCache cache;
+        REQUIRE(cache.open(path, error));
+        REQUIRE(cache.size() == 6);
+        std::vector<PairTally> tallies;
+        REQUIRE(collectMatrix(characters, 10, cache, 1, tallies, fought,
+                              error));
+        REQUIRE(fought == 6 * 10);
+        REQUIRE(tallies[3 * 4 + 0].fights() == 10);
+        REQUIRE(cache.size() == 12);
+        std::remove(path.c_str());
+    }
+
+    SECTION("TornRecord") {
+        std::string path = "test_result_cache_torn.bin";
+        std::remove(path.c_str());
+        std::string error;
+        if(true) { // Just to have a scope
+            ResultCache cache;
+            REQUIRE(cache.open(path, error));
+            PairTally t;
+            t.wins = 10;
+            REQUIRE(cache.add(1, 2, t, error));
+        }
+        // Half a record, as left by a crash.
+        if(true) { // Just to have a scope
+            std::ofstream out(path, std::ios::binary | std::ios::app);
+            out.write("0123456789abcdef", 16);
+        }
+        if(true) { // Just to have a scope
+            ResultCache cache;
+            REQUIRE(cache.open(path, error));
+            PairTally t;
+            t.wins = 3;
+            REQUIRE(cache.add(3, 4, t, error));
+        }
+        ResultCache cache;
+        REQUIRE(cache.open(path, error));
+        REQUIRE(cache.size() == 2);
+        PairTally first = cache.lookup(1, 2);
+        PairTally second = cache.lookup(3, 4);
+        REQUIRE(first.wins == 10);
+        REQUIRE(second.wins == 3);
+        std::remove(path.c_str());
+    }
+}
@@ -0,0 +1,106 @@
+//  Copyright 2015 Dario Domizioli
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "catch/catch.hpp"
+#include "../TestCharacters.h"
+
+#include "core/sim/Solver.h"
+#include "core/game/Character.h"
+#include "core/ctrl/ExpertSystemCtrl.h"
+#include "core/ctrl/EvolveAICtrl.h"
+
+#include <atomic>
+#include <cmath>
+#include <sstream>
+
+using namespace core;
+using namespace core::game;
+using namespace core::sim;
+
+namespace {
+
+/// \brief An evolving AI which counts the matches it is told to forget.
+class ForgetfulAttack : public ctrl::EvolveAIAttack {
+public:
+    ForgetfulAttack() : forgotten(0) {}
+
+    void forgetMatch(Character const &me) override {
+        EvolveAIAttack::forgetMatch(me);
+        ++forgotten;
+    }
+
+    std::atomic<size_t> forgotten;
+};
+
+} // close anonymous namespace
+
+TEST_CASE( "Solver", "[sim]" ) {
+
+    std::shared_ptr<Character> grunt = test::makeGrunt();
+    std::shared_ptr<Character> counter = test::makeCounter();
+
+    SECTION("ExactAgreesWithMonteCarlo") {
+        REQUIRE(Solver::canSolve(*grunt, *counter));
+        Solver solver;
+        MatchupOdds exact = solver.solve(grunt, counter);
+        REQUIRE(exact.exact);
+        REQUIRE(exact.states > 0);
+        REQUIRE(std::fabs(exact.win + exact.draw + exact.loss - 1.0) < 1e-9);
+
+        size_t const fights = 3000;
+        MatchupOdds mc = simulate(grunt, counter, fights);
+        REQUIRE(!mc.exact);
+        REQUIRE(mc.fights == fights);
+        double sigma = std::sqrt(exact.win * (1.0 - exact.win) / fights);
+        REQUIRE(std::fabs(mc.win - exact.win) < 5.0 * sigma + 1e-3);
+
+        // Simulating must not touch the points.
+        REQUIRE(grunt->total_points == 0);
+        REQUIRE(counter->total_points == 0);
+    }
+
+    SECTION("FallBackToSimulation") {
+        Solver small(1000, 200);
+        MatchupOdds odds = small.solve(grunt, counter);
+        REQUIRE(!odds.exact);
+        REQUIRE(odds.fights == 200);
+        REQUIRE(std::fabs(odds.win + odds.draw + odds.loss - 1.0) < 1e-9);
+
+        std::shared_ptr<Character> ai = std::make_shared<Character>(
+            "AI", 3, 2, 2, SP_AP, std::make_shared<ctrl::EvolveAIAttack>(),
+            std::make_shared<ctrl::EvolveAIDefence>());
+        REQUIRE(!Solver::canSolve(*grunt, *ai));
+    }
+
+    SECTION("ForgetsSimulatedFights") {
+        auto forgetful = std::make_shared<ForgetfulAttack>();
+        std::shared_ptr<Character> ai = std::make_shared<Character>(
+            "AI", 3, 2, 2, SP_AP, forgetful,
+            std::make_shared<ctrl::EvolveAIDefence>());
+        ai->addMove(Move{"First", MT_SPECIAL, {MS_POWERFUL}});
+        ai->addMove(Move{"Super", MT_SUPER, {MS_POWERFUL, MS_SMASH, MS_FALL}});
+        std::ostringstream before;
+        ai->actrl->saveState(before);
+
+        MatchupOdds odds = simulate(ai, counter, 50);
+        REQUIRE(odds.fights == 50);
+        size_t forgotten = forgetful->forgotten;
+        REQUIRE(forgotten == 50);
+        std::ostringstream after;
+        ai->actrl->saveState(after);
+        REQUIRE(after.str() == before.str());
+        REQUIRE(ai->total_points == 0);
+    }
+
+}
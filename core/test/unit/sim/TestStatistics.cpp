@@ -0,0 +1,61 @@
+//  Copyright 2015 Dario Domizioli
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "catch/catch.hpp"
+
+#include "core/sim/Statistics.h"
+
+#include <cmath>
+
+using namespace core::sim;
+
+TEST_CASE( "Wilson interval", "[sim]" ) {
+
+    SECTION( "No trials" ) {
+        Interval i = wilsonInterval(0, 0, 1.96);
+        REQUIRE( i.low == 0.0 );
+        REQUIRE( i.high == 1.0 );
+    }
+
+    SECTION( "Known values" ) {
+        Interval i = wilsonInterval(50, 100, 1.96);
+        REQUIRE( std::abs(i.low - 0.4038) < 1e-4 );
+        REQUIRE( std::abs(i.high - 0.5962) < 1e-4 );
+        Interval j = wilsonInterval(0, 10, 1.96);
+        REQUIRE( j.low == 0.0 );
+        REQUIRE( std::abs(j.high - 0.2775) < 1e-4 );
+    }
+
+    SECTION( "Narrows with trials" ) {
+        Interval few = wilsonInterval(15, 20, 2.576);
+        Interval many = wilsonInterval(150, 200, 2.576);
+        REQUIRE( many.width() < few.width() );
+        REQUIRE( few.contains(0.75) );
+        REQUIRE( many.contains(0.75) );
+        REQUIRE( !many.contains(0.5) );
+    }
+}
+
+TEST_CASE( "Pair tally", "[sim]" ) {
+    PairTally t;
+    REQUIRE( t.fights() == 0 );
+    REQUIRE( t.score() == 0.5 );
+    t.wins = 3;
+    t.draws = 2;
+    t.losses = 5;
+    REQUIRE( t.fights() == 10 );
+    REQUIRE( std::abs(t.score() - 0.4) < 1e-12 );
+    REQUIRE( std::abs(t.points() - 1.1) < 1e-12 );
+    REQUIRE( std::abs(t.opponentPoints() - 1.7) < 1e-12 );
+}
@@ -0,0 +1,90 @@
+//  Copyright 2015 Dario Domizioli
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "catch/catch.hpp"
+#include "core/sim/Tournament.h"
+#include "core/game/Character.h"
+#include "core/ctrl/ExpertSystemCtrl.h"
+
+#include <algorithm>
+
+using namespace core;
+using namespace core::game;
+using namespace core::sim;
+
+namespace {
+
+/// \brief Returns true if the ranking has every character once.
+bool isPermutation(std::vector<size_t> ranking, size_t n) {
+    std::sort(ranking.begin(), ranking.end());
+    for(size_t i = 0; i < ranking.size(); ++i) {
+        if(ranking[i] != i) {
+            return false;
+        }
+    }
+    return ranking.size() == n;
+}
+
+}
+
+TEST_CASE( "Tournament", "[sim]" ) {
+
+    std::vector<std::shared_ptr<Character>> characters;
+    for(int i = 0; i < 11; ++i) {
+        std::shared_ptr<Character> c = std::make_shared<Character>(
+            "Expert", 1 + i % 3, 3 - i % 3, 3, SP_DAMAGE,
+            ctrl::getAttackExpertSystem(i % 9),
+            ctrl::getDefenceExpertSystem(i % 9));
+        c->addMove(Move{"First", MT_SPECIAL, {MS_POWERFUL}});
+        c->addMove(Move{"Super", MT_SUPER, {MS_POWERFUL, MS_SMASH, MS_FALL}});
+        characters.push_back(c);
+    }
+
+    SECTION("Swiss") {
+        Tournament t(characters, TournamentOptions::forFormat(TF_SWISS));
+        t.run(2, nullptr);
+        REQUIRE(isPermutation(t.ranking(), 11));
+        // ceil(log2(11)) + 1 rounds of 5 matches, one character sitting out.
+        REQUIRE(t.matches() == 5 * 5);
+        REQUIRE(t.fights() == 5 * 5 * 4);
+    }
+
+    SECTION("Single elimination") {
+        Tournament t(characters,
+                     TournamentOptions::forFormat(TF_SINGLE_ELIMINATION));
+        t.run(2, nullptr);
+        REQUIRE(isPermutation(t.ranking(), 11));
+        REQUIRE(t.matches() == 10);
+    }
+
+    SECTION("Double elimination") {
+        Tournament t(characters,
+                     TournamentOptions::forFormat(TF_DOUBLE_ELIMINATION));
+        t.run(1, nullptr);
+        REQUIRE(isPermutation(t.ranking(), 11));
+        // Everyone but the winner loses twice, the winner at most once.
+        REQUIRE(t.matches() >= 20);
+        REQUIRE(t.matches() <= 21);
+    }
+
+    SECTION("Groups") {
+        TournamentOptions options = TournamentOptions::forFormat(TF_GROUPS);
+        options.group_size = 4;
+        Tournament t(characters, options);
+        t.run(2, nullptr);
+        REQUIRE(isPermutation(t.ranking(), 11));
+        // Groups of 4, 4 and 3, then a knockout of 6 qualifiers.
+        REQUIRE(t.matches() == 6 + 6 + 3 + 5);
+    }
+}
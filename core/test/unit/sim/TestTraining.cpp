@@ -0,0 +1,78 @@
+//  Copyright 2015 Dario Domizioli
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+
+#include "catch/catch.hpp"
+#include "core/sim/Training.h"
+#include "core/game/Character.h"
+#include "core/ctrl/EvolveAICtrl.h"
+#include "core/ctrl/ExpertSystemCtrl.h"
+
+#include <sstream>
+
+using namespace core;
+using namespace core::game;
+using namespace core::sim;
+
+TEST_CASE( "Training", "[sim]" ) {
+
+    std::vector<std::shared_ptr<Character>> characters;
+    for(int i = 0; i < 3; ++i) {
+        std::shared_ptr<Character> c = std::make_shared<Character>(
+            "Expert", 1 + i % 3, 3 - i % 3, 2, SP_DAMAGE,
+            ctrl::getAttackExpertSystem(i), ctrl::getDefenceExpertSystem(i));
+        c->addMove(Move{"First", MT_SPECIAL, {MS_POWERFUL}});
+        c->addMove(Move{"Super", MT_SUPER, {MS_POWERFUL, MS_SMASH, MS_FALL}});
+        characters.push_back(c);
+    }
+    TrainingOptions options = TrainingOptions::forLevel(0);
+    options.seconds = 0.0;
+
+    SECTION("Levels") {
+        TrainingOptions low = TrainingOptions::forLevel(0);
+        TrainingOptions high = TrainingOptions::forLevel(3);
+        REQUIRE(low.max_rounds < high.max_rounds);
+        REQUIRE(low.tolerance > high.tolerance);
+        REQUIRE(low.drift > high.drift);
+    }
+
+    SECTION("Stops when stable") {
+        // Expert systems do not learn, so only the win rates matter.
+        options.window = 2;
+        options.drift = 1.0;
+        Trainer trainer(characters, options);
+        std::ostringstream progress;
+        trainer.run(2, &progress);
+        REQUIRE(trainer.rounds() == 4);
+        REQUIRE(trainer.fights() == 4 * 6);
+        REQUIRE(trainer.isStable());
+        REQUIRE(progress.str().find("stable") != std::string::npos);
+    }
+
+    SECTION("Stops at the limits") {
+        characters[0]->actrl = std::make_shared<ctrl::EvolveAIAttack>();
+        options.max_rounds = 3;
+        Trainer trainer(characters, options);
+        REQUIRE(trainer.worstChange() == 1.0);
+        trainer.run(1, nullptr);
+        REQUIRE(trainer.rounds() == 3);
+        REQUIRE(!trainer.isStable());
+        options.max_rounds = 100;
+        options.seconds = 1e-9;
+        Trainer hurried(characters, options);
+        hurried.run(1, nullptr);
+        REQUIRE(hurried.rounds() == 1);
+    }
+
+}
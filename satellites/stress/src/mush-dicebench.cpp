@@ -0,0 +1,70 @@
+//  Copyright 2015 Dario Domizioli
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+
+/// \file mush-dicebench.cpp
+/// \brief Microbenchmark of the dice sources.
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "core/game/Dice.h"
+
+namespace {
+
+using namespace core::game;
+
+/// The number of rolls per measurement.
+long rolls = 10000000;
+
+/// \brief Rolls the given function "rolls" times and prints the cost per roll.
+template<typename F>
+void measure(char const *name, F roll) {
+    long sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(long i = 0; i < rolls; ++i) {
+        sum += roll();
+    }
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    // Print the sum so that the rolls cannot be optimized away.
+    std::cout << name << ": " << ns / rolls << " ns per roll (mean "
+              << static_cast<double>(sum) / rolls << ")" << std::endl;
+}
+
+} // close anonymous namespace
+
+/// \brief The main function for the dice microbenchmark.
+int main(int argc, char* argv[]) {
+    if(argc > 1) {
+        rolls = std::stol(argv[1]);
+    }
+    std::default_random_engine engine;
+    std::uniform_int_distribution<int> d6(1, 6);
+    std::mutex mutex;
+    measure("std::uniform_int_distribution, locked", [&]() {
+        std::lock_guard<std::mutex> protect(mutex);
+        int x = d6(engine);
+        return x == 6 ? 8 : x;
+    });
+    SeededDiceSource seeded(1);
+    DiceSource &seeded_source = seeded;
+    measure("SeededDiceSource", [&]() { return seeded_source.d6WithCrit(); });
+    BlockDiceSource block(1);
+    DiceSource &block_source = block;
+    measure("BlockDiceSource", [&]() { return block_source.d6WithCrit(); });
+    measure("d6WithCrit()", []() { return d6WithCrit(); });
+    return 0;
+}
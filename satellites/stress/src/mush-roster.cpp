@@ -0,0 +1,185 @@
+//  Copyright 2015 Dario Domizioli
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+
+/// \file mush-roster.cpp
+/// \brief Tool to write, convert and load roster files.
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "core/game/Character.h"
+#include "core/chars/NamedCharacters.h"
+#include "core/chars/RandomCharacters.h"
+#include "core/chars/Roster.h"
+
+namespace {
+
+using namespace core::game;
+using namespace core::chars;
+
+/// \brief Returns true if a file name asks for the binary form.
+bool isBinary(std::string const &path) {
+    return path.size() > 4 && path.compare(path.size() - 4, 4, ".bin") == 0;
+}
+
+/// \brief Writes a roster in the form asked for by the file name.
+int write(std::string const &path, std::vector<CharacterSpec> const &specs) {
+    std::string error;
+    if(isBinary(path)) {
+        if(!writeBinaryRoster(path, specs, error)) {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+    std::ofstream out(path);
+    writeRoster(out, specs);
+    if(!out) {
+        std::cerr << "Cannot write '" << path << "'" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+/// \brief Writes the built-in roster.
+int exportBuiltIn(std::string const &path) {
+    std::vector<CharacterSpec> specs;
+    for(char const *roster : { getOriginalRoster(), getSiegeOfSydeRoster() }) {
+        std::istringstream in(roster);
+        std::string error;
+        if(!readRoster(in, specs, error)) {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+    }
+    return write(path, specs);
+}
+
+/// \brief Writes a roster of distinct random characters, on all the threads.
+int generate(size_t count, uint64_t seed, std::string const &path) {
+    GenerationOptions options;
+    options.count = count;
+    options.seed = seed;
+    options.threads = 0;
+    options.allow_expert_systems = true;
+    options.unique = true;
+    return write(path, generateRandomSpecs(options));
+}
+
+/// \brief Converts a roster to the form asked for by the output file name.
+int convert(std::string const &in_path, std::string const &out_path) {
+    std::vector<CharacterSpec> specs;
+    std::string error;
+    MappedRoster roster;
+    if(roster.open(in_path, error)) {
+        specs.reserve(roster.size());
+        for(size_t i = 0; i < roster.size(); ++i) {
+            specs.push_back(roster.getSpec(i));
+        }
+    } else {
+        std::ifstream in(in_path);
+        if(!in || !readRoster(in, specs, error)) {
+            std::cerr << in_path << ": " << error << std::endl;
+            return 1;
+        }
+    }
+    return write(out_path, specs);
+}
+
+/// \brief Loads a roster, printing how long it took; only the first 'count'
+///        characters are created, as each has AIs of its own.
+int load(std::string const &path, size_t count) {
+    auto start = std::chrono::steady_clock::now();
+    std::string error;
+    std::vector<CharacterSpec> specs;
+    MappedRoster roster;
+    if(roster.open(path, error)) {
+        auto mapped = std::chrono::steady_clock::now();
+        std::cout << "Mapped " << roster.size() << " characters in "
+                  << std::chrono::duration<double>(mapped - start).count()
+                  << "s." << std::endl;
+        specs.reserve(roster.size());
+        for(size_t i = 0; i < roster.size(); ++i) {
+            specs.push_back(roster.getSpec(i));
+        }
+    } else {
+        std::ifstream in(path);
+        if(!in || !readRoster(in, specs, error)) {
+            std::cerr << path << ": " << error << std::endl;
+            return 1;
+        }
+    }
+    auto read = std::chrono::steady_clock::now();
+    std::cout << "Read " << specs.size() << " characters in "
+              << std::chrono::duration<double>(read - start).count()
+              << "s." << std::endl;
+    std::vector<std::shared_ptr<Character>> characters;
+    for(size_t i = 0; i < specs.size() && i < count; ++i) {
+        characters.push_back(makeCharacter(specs[i]));
+    }
+    auto created = std::chrono::steady_clock::now();
+    std::cout << "Created " << characters.size() << " characters in "
+              << std::chrono::duration<double>(created - read).count()
+              << "s." << std::endl;
+    return 0;
+}
+
+int usage() {
+    std::cout << "mush-roster - Musha Shugyo roster tool" << std::endl
+              << std::endl
+              << "Usage:" << std::endl
+              << "    mush-roster export <output>" << std::endl
+              << "    mush-roster generate <number> <output> [<seed>]" << std::endl
+              << "    mush-roster convert <input> <output>" << std::endl
+              << "    mush-roster load <input> [<number>]" << std::endl
+              << std::endl
+              << "Commands:" << std::endl
+              << "    export   : Write the built-in roster." << std::endl
+              << "    generate : Write a roster of distinct random characters;" << std::endl
+              << "               the same seed (0 by default) gives the same." << std::endl
+              << "    convert  : Rewrite a roster in another form." << std::endl
+              << "    load     : Read a roster and create its first <number>" << std::endl
+              << "               characters (100 by default), timing both." << std::endl
+              << std::endl
+              << "Outputs whose name ends in .bin are written in binary form," << std::endl
+              << "the others in text form. Inputs can be in either form." << std::endl
+              << std::endl;
+    return 1;
+}
+
+} // close anonymous namespace
+
+/// \brief The main function for the roster tool.
+int main(int argc, char* argv[]) {
+    std::vector<std::string> args(argv + 1, argv + argc);
+    if(args.size() == 2 && args[0] == "export") {
+        return exportBuiltIn(args[1]);
+    }
+    if((args.size() == 3 || args.size() == 4) && args[0] == "generate") {
+        return generate(std::stoul(args[1]),
+                        args.size() == 4 ? std::stoull(args[3]) : 0, args[2]);
+    }
+    if(args.size() == 3 && args[0] == "convert") {
+        return convert(args[1], args[2]);
+    }
+    if((args.size() == 2 || args.size() == 3) && args[0] == "load") {
+        return load(args[1], args.size() == 3 ? std::stoul(args[2]) : 100);
+    }
+    return usage();
+}
@@ -16,6 +16,7 @@
 /// \file mush-stress.cpp
 /// \brief Main file for the MUSH Stress Test.
 
+#include <fstream>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -23,10 +24,25 @@
 #include <thread>
 #include <sstream>
 #include <algorithm>
+#include <atomic>
+#include <cmath>
 
 #include "core/game/Dice.h"
 #include "core/game/Duel.h"
+#include "core/game/ScoreSheet.h"
+#include "core/chars/BuildSpace.h"
 #include "core/chars/NamedCharacters.h"
+#include "core/chars/RandomCharacters.h"
+#include "core/chars/Roster.h"
+#include "core/ctrl/EvolveAICtrl.h"
+#include "core/sim/Checkpoint.h"
+#include "core/sim/Comparison.h"
+#include "core/sim/MatchupSampler.h"
+#include "core/sim/Rating.h"
+#include "core/sim/ResultCache.h"
+#include "core/sim/ThreadPool.h"
+#include "core/sim/Tournament.h"
+#include "core/sim/Training.h"
 
 namespace {
 
@@ -38,8 +54,36 @@ bool progress = false;
 bool verbose = false;
 bool threaded = false;
 bool expert_systems = false;
+bool adaptive = false;
+bool comparisons = false;
+bool warm_start = false;
+bool bulk = false;
+bool results = false;
+bool tournament = false;
+std::string ratings_path;
+core::sim::RatingSystem rating_system = core::sim::RS_GLICKO2;
+std::string matrix_path;
+std::string cache_path;
+std::string checkpoint_path;
+double checkpoint_interval = 60.0;
+bool resume = false;
+double precision = 0.0;
+core::sim::TournamentFormat tournament_format = core::sim::TF_SWISS;
+unsigned long seed = 0;
+bool builds = false;
+uint64_t build_shard = 0;
+uint64_t build_shards = 1;
+uint64_t max_builds = 0;
+double tolerance = 0.0;
+core::sim::DiceSharing dice_sharing = core::sim::DS_COMMON;
 int extra_chars = 0;
 
+void seedAll(unsigned long s) {
+    seed = s;
+    getRandomGenerator().seed(seed);
+    seedDice(seed);
+}
+
 bool parseCommandLine(int argc, char* argv[]) {
     for(int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
@@ -51,6 +95,130 @@ bool parseCommandLine(int argc, char* argv[]) {
             threaded = true;
         } else if(arg == std::string("-e")) {
             expert_systems = true;
+        } else if(arg == std::string("-a")) {
+            adaptive = true;
+        } else if(arg == std::string("-w")) {
+            warm_start = true;
+        } else if(arg == std::string("-g")) {
+            bulk = true;
+        } else if(arg == std::string("-x")) {
+            results = true;
+        } else if(arg == std::string("-E")) {
+            rating_system = core::sim::RS_ELO;
+        } else if(arg == std::string("--resume")) {
+            resume = true;
+        } else if(arg[0] == '-' && arg[1] == 'u') {
+            if(arg.length() > 2) {
+                tolerance = std::stod(arg.substr(2, arg.npos));
+            }
+            else if(i + 1 < argc) {
+                ++i;
+                tolerance = std::stod(argv[i]);
+            }
+        } else if(arg[0] == '-' && arg[1] == 'r') {
+            std::string mode = arg.substr(2, arg.npos);
+            if(mode.empty() && i + 1 < argc) {
+                ++i;
+                mode = argv[i];
+            }
+            comparisons = true;
+            if(mode == "i") {
+                dice_sharing = core::sim::DS_INDEPENDENT;
+            } else if(mode == "c") {
+                dice_sharing = core::sim::DS_COMMON;
+            } else if(mode == "a") {
+                dice_sharing = core::sim::DS_ANTITHETIC;
+            } else {
+                std::cerr << "Invalid dice sharing " << mode << std::endl;
+                return false;
+            }
+        } else if(arg[0] == '-' && arg[1] == 'M') {
+            matrix_path = arg.substr(2, arg.npos);
+            if(matrix_path.empty() && i + 1 < argc) {
+                ++i;
+                matrix_path = argv[i];
+            }
+            adaptive = true;
+        } else if(arg[0] == '-' && arg[1] == 'k') {
+            checkpoint_path = arg.substr(2, arg.npos);
+            if(checkpoint_path.empty() && i + 1 < argc) {
+                ++i;
+                checkpoint_path = argv[i];
+            }
+        } else if(arg[0] == '-' && arg[1] == 'K') {
+            if(arg.length() > 2) {
+                checkpoint_interval = std::stod(arg.substr(2, arg.npos));
+            }
+            else if(i + 1 < argc) {
+                ++i;
+                checkpoint_interval = std::stod(argv[i]);
+            }
+        } else if(arg[0] == '-' && arg[1] == 'C') {
+            cache_path = arg.substr(2, arg.npos);
+            if(cache_path.empty() && i + 1 < argc) {
+                ++i;
+                cache_path = argv[i];
+            }
+        } else if(arg[0] == '-' && arg[1] == 'P') {
+            if(arg.length() > 2) {
+                precision = std::stod(arg.substr(2, arg.npos));
+            }
+            else if(i + 1 < argc) {
+                ++i;
+                precision = std::stod(argv[i]);
+            }
+            adaptive = true;
+        } else if(arg[0] == '-' && arg[1] == 'R') {
+            ratings_path = arg.substr(2, arg.npos);
+            if(ratings_path.empty() && i + 1 < argc) {
+                ++i;
+                ratings_path = argv[i];
+            }
+        } else if(arg[0] == '-' && arg[1] == 'o') {
+            std::string format = arg.substr(2, arg.npos);
+            if(format.empty() && i + 1 < argc) {
+                ++i;
+                format = argv[i];
+            }
+            tournament = true;
+            if(format == "s") {
+                tournament_format = core::sim::TF_SWISS;
+            } else if(format == "e") {
+                tournament_format = core::sim::TF_SINGLE_ELIMINATION;
+            } else if(format == "d") {
+                tournament_format = core::sim::TF_DOUBLE_ELIMINATION;
+            } else if(format == "g") {
+                tournament_format = core::sim::TF_GROUPS;
+            } else {
+                std::cerr << "Invalid tournament " << format << std::endl;
+                return false;
+            }
+        } else if(arg[0] == '-' && arg[1] == 'b') {
+            std::string shard = arg.substr(2, arg.npos);
+            if(shard.empty() && i + 1 < argc) {
+                ++i;
+                shard = argv[i];
+            }
+            size_t slash = shard.find('/');
+            if(slash == shard.npos) {
+                std::cerr << "Invalid shard " << shard << std::endl;
+                return false;
+            }
+            builds = true;
+            build_shard = std::stoull(shard.substr(0, slash));
+            build_shards = std::stoull(shard.substr(slash + 1));
+            if(build_shards == 0 || build_shard >= build_shards) {
+                std::cerr << "Invalid shard " << shard << std::endl;
+                return false;
+            }
+        } else if(arg[0] == '-' && arg[1] == 'm') {
+            if(arg.length() > 2) {
+                max_builds = std::stoull(arg.substr(2, arg.npos));
+            }
+            else if(i + 1 < argc) {
+                ++i;
+                max_builds = std::stoull(argv[i]);
+            }
         } else if(arg[0] == '-' && arg[1] == 'c') {
             if(arg.length() > 2) {
                 extra_chars = std::stoi(arg.substr(2, arg.npos).c_str());
@@ -61,11 +229,11 @@ bool parseCommandLine(int argc, char* argv[]) {
             }
         } else if(arg[0] == '-' && arg[1] == 's') {
             if(arg.length() > 2) {
-                getRandomGenerator().seed(std::stoul(arg.substr(2, arg.npos).c_str()));
+                seedAll(std::stoul(arg.substr(2, arg.npos).c_str()));
             }
             else if(i + 1 < argc) {
                 ++i;
-                getRandomGenerator().seed(std::stoul(argv[i]));
+                seedAll(std::stoul(argv[i]));
             }
         } else if(arg == std::string("-h")
                   || arg == std::string("--help")) {
@@ -75,6 +243,32 @@ bool parseCommandLine(int argc, char* argv[]) {
             return false;
         }
     }
+    if(resume && checkpoint_path.empty()) {
+        std::cerr << "--resume needs a checkpoint file (-k)" << std::endl;
+        return false;
+    }
+    if(rating_system != core::sim::RS_GLICKO2 && ratings_path.empty()) {
+        std::cerr << "-E needs a ratings file (-R)" << std::endl;
+        return false;
+    }
+    if(!cache_path.empty() && (builds || comparisons || adaptive
+                               || tournament)) {
+        std::cerr << "-C does not work with -a, -b, -o or -r" << std::endl;
+        return false;
+    }
+    // Only the round robin rates the characters and saves its state.
+    bool round_robin = !builds && !comparisons && !adaptive && !tournament
+                       && cache_path.empty();
+    if(!checkpoint_path.empty() && !round_robin) {
+        std::cerr << "-k only works with the round robin, not with"
+                  << " -a, -b, -C, -o or -r" << std::endl;
+        return false;
+    }
+    if(!ratings_path.empty() && !round_robin) {
+        std::cerr << "-R only works with the round robin, not with"
+                  << " -a, -b, -C, -o or -r" << std::endl;
+        return false;
+    }
     return true;
 }
 
@@ -84,7 +278,12 @@ int usage() {
               << "Usage:" << std::endl
               << "    mush -h" << std::endl
               << "or" << std::endl
-              << "    mush [-c <number>] [-p] [-v] [-t] [-s <number>]" << std::endl
+              << "    mush [-c <number>] [-p] [-v] [-t] [-e] [-a] [-w] [-g] [-x] [-r <mode>]" << std::endl
+              << "         [-o <format>] [-R <file>] [-E] [-M <file>] [-P <number>]" << std::endl
+              << "         [-C <file>] [-k <file>] [-K <number>] [--resume]" << std::endl
+              << "         [-u <number>] [-s <number>]" << std::endl
+              << "or" << std::endl
+              << "    mush -b <k>/<n> [-m <number>] [-t] [-s <number>]" << std::endl
               << std::endl
               << "Options:" << std::endl
               << "    -h     : Display this help and exit." << std::endl
@@ -93,13 +292,65 @@ int usage() {
               << "    -v     : Verbose (chronicle for debugging)." << std::endl
               << "    -t     : Multi-threaded mode. CPU intensive." << std::endl
               << "    -e     : Use expert systems instead of evolving AIs." << std::endl
+              << "    -a     : Adaptive mode: stop fighting a pair once its" << std::endl
+              << "             outcome is settled, and spend the budget on" << std::endl
+              << "             the uncertain pairs." << std::endl
+              << "    -w     : Train the named characters first, then start the" << std::endl
+              << "             AIs of each extra character from those of the" << std::endl
+              << "             most similar named character." << std::endl
+              << "    -g     : Generate the extra characters in bulk, on all the" << std::endl
+              << "             threads with -t: their builds only depend on" << std::endl
+              << "             the seed, and are all different." << std::endl
+              << "    -x     : Print the wins, draws and losses of each" << std::endl
+              << "             character against each other one." << std::endl
+              << "    -r <m> : Compare each character with the next one against" << std::endl
+              << "             all the others instead; <m> is the dice sharing" << std::endl
+              << "             between the two: i (independent), c (common)" << std::endl
+              << "             or a (common and antithetic)." << std::endl
+              << "    -o <f> : Rank with a tournament instead of a round robin;" << std::endl
+              << "             <f> is the format: s (Swiss), e (single" << std::endl
+              << "             elimination), d (double elimination) or g" << std::endl
+              << "             (groups, then single elimination)." << std::endl
+              << "    -M <f> : Adaptive mode, writing the matrix of the outcomes" << std::endl
+              << "             of every ordered pair to file <f>: binary if" << std::endl
+              << "             its name ends in .bin, CSV otherwise." << std::endl
+              << "    -P <p> : Adaptive mode, fighting until the score of every" << std::endl
+              << "             ordered pair is known within an interval (95%)" << std::endl
+              << "             no wider than <p>." << std::endl
+              << "    -C <f> : Reuse the outcomes of the pairs of characters" << std::endl
+              << "             with built-in AIs saved in cache file <f>," << std::endl
+              << "             fighting only the pairs it misses, and save" << std::endl
+              << "             their outcomes to it." << std::endl
+              << "    -k <f> : Save the state of the round robin (rounds run," << std::endl
+              << "             points, AIs and random generators) to file" << std::endl
+              << "             <f> now and then, on a thread of its own." << std::endl
+              << "    -K <s> : Save the state every <s> seconds (60 by" << std::endl
+              << "             default)." << std::endl
+              << "    --resume : Continue the run saved in the file given" << std::endl
+              << "             with -k, with the same other options; runs" << std::endl
+              << "             without -t continue exactly the same." << std::endl
+              << "    -R <f> : Rate the characters with Glicko-2 as the fights" << std::endl
+              << "             end, starting from the ratings saved in file" << std::endl
+              << "             <f> if any, and save them back to it; new" << std::endl
+              << "             characters can be rated against old ones." << std::endl
+              << "    -E     : Rate with Elo instead of Glicko-2 (with -R)." << std::endl
+              << "    -u <t> : Stop fighting once the evolving AIs have" << std::endl
+              << "             converged, i.e. their updates change the" << std::endl
+              << "             decisions by less than <t> on average." << std::endl
               << "    -s <n> : Random number generator seed." << std::endl
+              << "    -b <k>/<n> : Evaluate the builds of shard <k> out of <n>" << std::endl
+              << "             of all the legal builds, printing the id and" << std::endl
+              << "             win rate against the named characters of each;" << std::endl
+              << "             all of them use the Balanced expert systems." << std::endl
+              << "    -m <n> : Evaluate at most <n> builds of the shard." << std::endl
               << std::endl;
     return 1;
 }
 
-void singleFight(std::shared_ptr<Character> c1, std::shared_ptr<Character> c2) {
+void singleFight(std::shared_ptr<Character> c1, std::shared_ptr<Character> c2,
+                 ScoreSheet *scores) {
     Duel d(c1, c2, verbose ? &std::cout : nullptr);
+    d.setScoreSheet(scores);
     d.fight();
     if(progress) {
         std::cerr << c1->name << " vs " << c2->name << " just ended."
@@ -108,7 +359,8 @@ void singleFight(std::shared_ptr<Character> c1, std::shared_ptr<Character> c2) {
 }
 
 void keepPickingFights(std::mutex *fights_mutex, 
-                       std::vector<std::pair<std::shared_ptr<Character>, std::shared_ptr<Character>>> *fights) {
+                       std::vector<std::pair<std::shared_ptr<Character>, std::shared_ptr<Character>>> *fights,
+                       ScoreSheet *scores) {
     while(true) {
         std::pair<std::shared_ptr<Character>, std::shared_ptr<Character>> f;
         if(true) { // Just to have a scope
@@ -124,10 +376,205 @@ void keepPickingFights(std::mutex *fights_mutex,
             }
         }
         Duel d(f.first, f.second, verbose ? &std::cout : nullptr);
+        d.setScoreSheet(scores);
         d.fight();
     }
 }
 
+void dumpResults(std::vector<std::shared_ptr<Character>> const &characters,
+                 ScoreSheet const &scores) {
+    std::cout << "Wins/draws/losses of each row against each column:"
+              << std::endl;
+    for(auto const &a : characters) {
+        std::cout << a->name;
+        for(auto const &b : characters) {
+            if(a == b) {
+                std::cout << "\t-";
+                continue;
+            }
+            Tally t = scores.getResults(*a, *b);
+            std::cout << "\t" << t.wins << "/" << t.draws << "/" << t.losses;
+        }
+        std::cout << std::endl;
+    }
+}
+
+void dumpRanking(std::vector<std::shared_ptr<Character>> characters) {
+    std::sort(characters.begin(), characters.end(), 
+              [](std::shared_ptr<Character> c1, std::shared_ptr<Character>  c2){
+                return c1->total_points < c2->total_points; 
+              });
+    for(auto const &c : characters) {
+        c->dump(std::cout);
+    }
+}
+
+void dumpRatings(core::sim::RatingEngine const &ratings) {
+    std::cout << "Ratings (with 95% intervals):" << std::endl;
+    for(auto const &entry : ratings.getRanking()) {
+        core::sim::Rating const &r = entry.second;
+        std::cout << entry.first << "\t" << std::lround(r.rating) << " +/- "
+                  << std::lround(2.0 * r.deviation) << "\t(" << r.fights
+                  << " fights)" << std::endl;
+    }
+}
+
+int runAdaptive(std::vector<std::shared_ptr<Character>> const &characters,
+                int reps) {
+    core::sim::SamplerOptions options = precision > 0.0
+        ? core::sim::SamplerOptions::forPrecision(characters.size(), precision)
+        : core::sim::SamplerOptions::forBudget(characters.size(), reps);
+    core::sim::MatchupSampler sampler(characters, options);
+    sampler.run(threaded ? 4 : 1, verbose ? &std::cout : nullptr,
+                progress ? &std::cerr : nullptr);
+
+    // Pairs got different numbers of fights, so rank on the points expected
+    // from the fixed number of repetitions instead of the points collected.
+    for(size_t i = 0; i < characters.size(); ++i) {
+        characters[i]->total_points =
+            static_cast<int>(std::lround(sampler.expectedPoints(i) * reps));
+    }
+    std::cerr << "Adaptive mode: " << sampler.fights() << " fights out of "
+              << options.budget << ", " << sampler.unsettledPairs()
+              << " pairs unsettled, widest interval "
+              << sampler.widestInterval() << "." << std::endl;
+    dumpRanking(characters);
+    if(!matrix_path.empty()) {
+        std::string error;
+        bool binary = matrix_path.size() > 4
+                      && matrix_path.compare(matrix_path.size() - 4, 4,
+                                             ".bin") == 0;
+        if(binary) {
+            if(!sampler.writeBinaryMatrix(matrix_path, error)) {
+                std::cerr << error << std::endl;
+                return 1;
+            }
+        } else {
+            std::ofstream out(matrix_path);
+            sampler.writeMatrix(out);
+            if(!out) {
+                std::cerr << "Cannot write '" << matrix_path << "'"
+                          << std::endl;
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+int runCached(std::vector<std::shared_ptr<Character>> const &characters,
+              int reps) {
+    core::sim::ResultCache cache;
+    std::string error;
+    if(!cache.open(cache_path, error)) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    size_t fought = 0;
+    std::vector<core::sim::PairTally> tallies;
+    if(!core::sim::collectMatrix(characters, static_cast<size_t>(reps), cache,
+                                 threaded ? 4 : 1, tallies, fought, error)) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+
+    // Cached pairs may have more fights than asked for, so rank on the points
+    // expected from the fixed number of repetitions.
+    size_t n = characters.size();
+    std::vector<double> points(n, 0.0);
+    for(size_t i = 0; i < n; ++i) {
+        for(size_t j = 0; j < n; ++j) {
+            if(i != j) {
+                points[i] += tallies[i * n + j].points();
+                points[j] += tallies[i * n + j].opponentPoints();
+            }
+        }
+    }
+    for(size_t i = 0; i < n; ++i) {
+        characters[i]->total_points =
+            static_cast<int>(std::lround(points[i] * reps));
+    }
+    size_t all = n * (n - 1) * static_cast<size_t>(reps);
+    std::cerr << "Result cache: " << fought << " fights out of " << all
+              << ", " << cache.size() << " pairs cached." << std::endl;
+    dumpRanking(characters);
+    return 0;
+}
+
+int runTournament(std::vector<std::shared_ptr<Character>> const &characters) {
+    core::sim::Tournament t(
+        characters, core::sim::TournamentOptions::forFormat(tournament_format));
+    t.run(threaded ? 4 : 1, progress ? &std::cerr : nullptr);
+    std::cerr << "Tournament: " << t.matches() << " matches, " << t.fights()
+              << " fights." << std::endl;
+    // Like dumpRanking, the best character comes last.
+    for(auto i = t.ranking().crbegin(); i != t.ranking().crend(); ++i) {
+        characters[*i]->dump(std::cout);
+    }
+    return 0;
+}
+
+int runComparisons(std::vector<std::shared_ptr<Character>> const &characters,
+                   int reps) {
+    unsigned long seed = 0;
+    if(true) { // Just to have a scope
+        std::lock_guard<std::mutex> protect(getRandomGenMutex());
+        seed = getRandomGenerator()();
+    }
+    size_t samples = std::max(reps / 10, 5);
+    for(size_t i = 0; i + 1 < characters.size(); ++i) {
+        core::sim::Comparison c = core::sim::compare(
+            characters[i], characters[i + 1], characters, samples,
+            seed + i, dice_sharing);
+        std::cout << characters[i]->name << " - " << characters[i + 1]->name
+                  << " : " << c.difference << " +/- " << c.std_error
+                  << " (variance reduction " << c.variance_reduction
+                  << ", " << c.fights << " fights)" << std::endl;
+    }
+    return 0;
+}
+
+int runBuilds(std::vector<std::shared_ptr<Character>> const &named) {
+    // Everybody uses the same expert systems, so that the builds are compared
+    // and not the AIs.
+    std::vector<std::shared_ptr<Character>> opponents;
+    for(auto const &c : named) {
+        CharacterSpec spec = describeCharacter(*c);
+        spec.attack_ai = "Balanced";
+        spec.defence_ai = "Balanced";
+        opponents.push_back(makeCharacter(spec));
+    }
+    BuildEnumerator shard = BuildEnumerator::shard(build_shard, build_shards);
+    uint64_t last = shard.last();
+    if(max_builds > 0 && shard.first() + max_builds < last) {
+        last = shard.first() + max_builds;
+    }
+    std::atomic<uint64_t> next(shard.first());
+    std::mutex output_mutex;
+    core::sim::ThreadPool pool(threaded ? 4 : 1);
+    pool.run([&](unsigned) {
+        for(uint64_t id = next++; id < last; id = next++) {
+            auto c = makeCharacter(BuildSpace::getSpec(
+                BuildSpace::getBuild(id), "Balanced", "Balanced"));
+            double score = 0.0;
+            for(auto const &o : opponents) {
+                Duel first(c, o, nullptr);
+                first.fight();
+                Duel second(o, c, nullptr);
+                second.fight();
+                score += (first.result() == DR_C1_WINS) ? 1.0
+                         : (first.result() == DR_DRAW) ? 0.5 : 0.0;
+                score += (second.result() == DR_C2_WINS) ? 1.0
+                         : (second.result() == DR_DRAW) ? 0.5 : 0.0;
+            }
+            std::lock_guard<std::mutex> protect(output_mutex);
+            std::cout << id << " " << score / (2.0 * opponents.size())
+                      << std::endl;
+        }
+    });
+    return 0;
+}
+
 int run() {
     std::vector<std::shared_ptr<Character>> characters;
     std::vector<std::shared_ptr<Character>> original_characters = 
@@ -140,14 +587,93 @@ int run() {
     characters.insert(characters.end(),
                       siege_of_syde_characters.cbegin(), 
                       siege_of_syde_characters.cend());
+    if(builds) {
+        return runBuilds(characters);
+    }
+    // A resumed run gets its AIs from the checkpoint.
+    if(warm_start && extra_chars > 0 && !resume) {
+        core::sim::Trainer trainer(characters,
+                                   core::sim::TrainingOptions::forLevel(0));
+        trainer.run(1, progress ? &std::cerr : nullptr);
+    }
+    std::vector<std::shared_ptr<Character>> named_characters = characters;
+    std::vector<std::shared_ptr<Character>> extra_characters;
+    if(bulk) {
+        GenerationOptions options;
+        options.count = static_cast<size_t>(std::max(extra_chars, 0));
+        options.seed = seed;
+        options.threads = threaded ? 0 : 1;
+        options.allow_expert_systems = expert_systems;
+        options.unique = true;
+        extra_characters = generateRandomCharacters(options);
+    }
     for(int i = 0; i < extra_chars; ++i) {
-        auto c = generateRandomCharacter(expert_systems);
+        auto c = bulk ? extra_characters[i]
+                      : generateRandomCharacter(expert_systems);
+        if(warm_start) {
+            auto nearest = core::ctrl::warmStart(*c, named_characters);
+            if(nearest) {
+                std::cerr << c->name << " starts from " << nearest->name
+                          << " (similarity " << similarity(*c, *nearest)
+                          << ")." << std::endl;
+            }
+        }
         characters.push_back(c);
     }
 
-    // Handle automated batch of fights first...
-    std::vector<std::pair<std::shared_ptr<Character>, std::shared_ptr<Character>>> fights;
-    for(int i = 0; i < (extra_chars == 0 ? 500 : 10); ++i) {
+    int reps = (extra_chars == 0 ? 500 : 10);
+    if(comparisons) {
+        return runComparisons(characters, reps);
+    }
+    if(adaptive) {
+        return runAdaptive(characters, reps);
+    }
+    if(tournament) {
+        return runTournament(characters);
+    }
+    if(!cache_path.empty()) {
+        return runCached(characters, reps);
+    }
+
+    // Handle automated batch of fights first, one round at a time...
+    ScoreSheet scores;
+    core::sim::RatingEngine ratings(
+        core::sim::RatingOptions::forSystem(rating_system));
+    if(!ratings_path.empty()) {
+        std::ifstream in(ratings_path);
+        std::string error;
+        if(in && !ratings.load(in, error)) {
+            std::cerr << ratings_path << ": " << error << std::endl;
+            return 1;
+        }
+        for(auto const &c : characters) {
+            ratings.addCharacter(*c);
+        }
+    }
+    int round = 0;
+    std::unique_ptr<core::sim::CheckpointWriter> checkpoints;
+    if(!checkpoint_path.empty()) {
+        if(resume) {
+            core::sim::Checkpoint checkpoint;
+            std::string error;
+            if(!checkpoint.read(checkpoint_path, error)
+               || !checkpoint.restore(characters, scores,
+                                      ratings_path.empty() ? nullptr
+                                                           : &ratings,
+                                      error)) {
+                std::cerr << checkpoint_path << ": " << error << std::endl;
+                return 1;
+            }
+            round = static_cast<int>(checkpoint.round());
+            std::cerr << "Resuming after " << round << " rounds."
+                      << std::endl;
+        }
+        checkpoints.reset(new core::sim::CheckpointWriter(
+            checkpoint_path, checkpoint_interval));
+    }
+    bool converged = false;
+    for(; round < reps && !converged; ++round) {
+        std::vector<std::pair<std::shared_ptr<Character>, std::shared_ptr<Character>>> fights;
         for(auto const &c1 : characters) {
             for(auto const &c2 : characters) {
                 if(c1 != c2) {
@@ -155,29 +681,76 @@ int run() {
                 }
             }
         }
-    }
-    if(threaded) {
-        std::vector<std::thread> threads;
-        std::mutex fights_mutex;
-        for(int i = 0; i < 4; ++i) {
-            threads.push_back(
-                std::thread(keepPickingFights, &fights_mutex, &fights));
+        ScoreSheet round_scores;
+        if(threaded) {
+            // Each thread keeps its own score sheet, merged after the round.
+            std::vector<std::thread> threads;
+            std::vector<ScoreSheet> thread_scores(4);
+            std::mutex fights_mutex;
+            for(int i = 0; i < 4; ++i) {
+                threads.push_back(
+                    std::thread(keepPickingFights, &fights_mutex, &fights,
+                                &thread_scores[i]));
+            }
+            for (auto& th : threads) th.join();
+            for(auto const &ts : thread_scores) {
+                round_scores.merge(ts);
+            }
+        } else {
+            for(auto &f: fights) {
+                singleFight(f.first, f.second, &round_scores);
+            }
         }
-        for (auto& th : threads) th.join();
-    } else {
-        for(auto &f: fights) {
-            singleFight(f.first, f.second);
+        scores.merge(round_scores);
+        if(!ratings_path.empty()) {
+            ratings.update(round_scores);
         }
+        converged = tolerance > 0.0
+                    && std::all_of(characters.cbegin(), characters.cend(),
+                                   [](std::shared_ptr<Character> const &c) {
+                                       return core::ctrl::hasConverged(
+                                           *c, tolerance);
+                                   });
+        if(checkpoints && !converged && round + 1 < reps
+           && checkpoints->isDue()) {
+            // Only the copy is made here; the writing happens meanwhile.
+            std::unique_ptr<core::sim::Checkpoint> checkpoint(
+                new core::sim::Checkpoint());
+            checkpoint->take(characters, scores,
+                             ratings_path.empty() ? nullptr : &ratings,
+                             round + 1);
+            checkpoints->submit(std::move(checkpoint));
+        }
+    }
+    if(tolerance > 0.0) {
+        std::cerr << (converged ? "Converged" : "Not converged") << " after "
+                  << round << " rounds out of " << reps << "." << std::endl;
     }
 
-    std::sort(characters.begin(), characters.end(), 
-              [](std::shared_ptr<Character> c1, std::shared_ptr<Character>  c2){
-                return c1->total_points < c2->total_points; 
-              });
-    for(auto const &c : characters) {
-        c->dump(std::cout);
+    if(checkpoints) {
+        std::string error;
+        if(!checkpoints->flush(error)) {
+            std::cerr << error << std::endl;
+            return 1;
+        }
     }
 
+    for(auto const &c : characters) {
+        c->total_points += scores.getPoints(*c);
+    }
+    dumpRanking(characters);
+    if(results) {
+        dumpResults(characters, scores);
+    }
+    if(!ratings_path.empty()) {
+        dumpRatings(ratings);
+        std::ofstream out(ratings_path);
+        ratings.save(out);
+        if(!out) {
+            std::cerr << "Cannot write '" << ratings_path << "'" << std::endl;
+            return 1;
+        }
+    }
     return 0;
 }
 
@@ -0,0 +1,182 @@
+//  Copyright 2015 Dario Domizioli
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+
+/// \file mush-tdbench.cpp
+/// \brief Benchmark of how many fights the learning AIs need to get good.
+
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "core/game/Dice.h"
+#include "core/game/Duel.h"
+#include "core/chars/NamedCharacters.h"
+#include "core/ctrl/EvolveAICtrl.h"
+#include "core/ctrl/ExpertSystemCtrl.h"
+#include "core/ctrl/PlannedCtrl.h"
+#include "core/ctrl/TDAICtrl.h"
+
+namespace {
+
+using namespace core::game;
+using namespace core::ctrl;
+
+/// The maximum number of fights per run.
+long max_fights = 20000;
+/// The number of fights the win rate is measured on.
+long window = 500;
+/// The win rate to reach.
+double goal = 0.6;
+/// The number of runs per AI.
+int runs = 3;
+/// The seed of the first run.
+unsigned long seed = 1;
+/// The replay parameters of the Evolve AIs with replay.
+ReplayOptions replay_options;
+
+/// \brief Trains a fresh AI against the Balanced expert systems, playing every
+///        original character against every other, and returns the number of
+///        fights after which the win rate over the window reached the goal, or
+///        0 if it never did.
+long fightsToGoal(std::shared_ptr<AttackControl> att,
+                  std::shared_ptr<DefendControl> def,
+                  double &final_rate) {
+    std::vector<std::shared_ptr<Character>> originals =
+        core::chars::getOriginalCharacters();
+    std::vector<std::shared_ptr<Character>> learners;
+    std::vector<std::shared_ptr<Character>> opponents;
+    for(auto const &c : originals) {
+        learners.push_back(makeSimulatedCharacter(*c, att, def));
+        opponents.push_back(makeSimulatedCharacter(
+            *c, getAttackExpertSystem(7), getDefenceExpertSystem(7)));
+    }
+    size_t n = originals.size();
+    std::deque<int> outcomes;
+    long wins = 0;
+    final_rate = 0.0;
+    for(long f = 0; f < max_fights; ++f) {
+        // Every pair, mirrors included, so the expert systems would win
+        // exactly half of the fights against themselves.
+        size_t pair = static_cast<size_t>(f) % (n * n);
+        Duel d(learners[pair / n], opponents[pair % n], nullptr);
+        d.fight();
+        int won = (d.result() == DR_C1_WINS) ? 1 : 0;
+        outcomes.push_back(won);
+        wins += won;
+        if(static_cast<long>(outcomes.size()) > window) {
+            wins -= outcomes.front();
+            outcomes.pop_front();
+        }
+        if(static_cast<long>(outcomes.size()) == window) {
+            final_rate = static_cast<double>(wins) / window;
+            if(final_rate >= goal) {
+                return f + 1;
+            }
+        }
+    }
+    return 0;
+}
+
+/// \brief Runs the benchmark for one kind of AI, built fresh for every run by
+///        the given functions.
+void measure(char const *name,
+             std::function<std::shared_ptr<AttackControl>()> make_attack,
+             std::function<std::shared_ptr<DefendControl>()> make_defence) {
+    long total = 0;
+    int reached = 0;
+    for(int r = 0; r < runs; ++r) {
+        getRandomGenerator().seed(seed + r);
+        seedDice(seed + r);
+        double final_rate = 0.0;
+        long fights = fightsToGoal(make_attack(), make_defence(), final_rate);
+        std::cout << name << " run " << r << ": ";
+        if(fights > 0) {
+            std::cout << fights << " fights";
+            total += fights;
+            ++reached;
+        } else {
+            std::cout << "goal not reached, last win rate " << final_rate;
+        }
+        std::cout << std::endl;
+    }
+    std::cout << name << ": goal reached in " << reached << " of " << runs
+              << " runs";
+    if(reached > 0) {
+        std::cout << ", " << total / reached << " fights on average";
+    }
+    std::cout << std::endl;
+}
+
+int usage() {
+    std::cout << "mush-tdbench - Musha Shugyo learning AI benchmark" << std::endl
+              << std::endl
+              << "Usage:" << std::endl
+              << "    mush-tdbench [-f <number>] [-w <number>] [-g <rate>]" << std::endl
+              << "                 [-r <number>] [-s <number>] [-b <number>]" << std::endl
+              << "                 [-p <number>]" << std::endl
+              << std::endl
+              << "Options:" << std::endl
+              << "    -f <n> : Maximum number of fights per run." << std::endl
+              << "    -w <n> : Number of fights the win rate is measured on." << std::endl
+              << "    -g <r> : Win rate against the Balanced expert systems" << std::endl
+              << "             to reach, between 0 and 1." << std::endl
+              << "    -r <n> : Number of runs per AI." << std::endl
+              << "    -s <n> : Random number generator seed." << std::endl
+              << "    -b <n> : Number of past fights kept for replay." << std::endl
+              << "    -p <n> : Number of past fights replayed after a fight." << std::endl
+              << std::endl;
+    return 1;
+}
+
+} // close anonymous namespace
+
+/// \brief The main function for the learning AI benchmark.
+int main(int argc, char* argv[]) {
+    replay_options.capacity = 256;
+    replay_options.replays_per_match = 4;
+    for(int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if(arg.length() != 2 || arg[0] != '-' || i + 1 >= argc) {
+            return usage();
+        }
+        std::string value = argv[++i];
+        switch(arg[1]) {
+        case 'f': max_fights = std::stol(value); break;
+        case 'w': window = std::stol(value); break;
+        case 'g': goal = std::stod(value); break;
+        case 'r': runs = std::stoi(value); break;
+        case 's': seed = std::stoul(value); break;
+        case 'b': replay_options.capacity = std::stoul(value); break;
+        case 'p': replay_options.replays_per_match = std::stoul(value); break;
+        default: return usage();
+        }
+    }
+    if(window <= 0 || window > max_fights) {
+        return usage();
+    }
+    measure("Evolve",
+            [] { return std::make_shared<EvolveAIAttack>(); },
+            [] { return std::make_shared<EvolveAIDefence>(); });
+    measure("Evolve+replay",
+            [] { return std::make_shared<EvolveAIAttack>(replay_options); },
+            [] { return std::make_shared<EvolveAIDefence>(replay_options); });
+    measure("TD",
+            [] { return std::make_shared<TDAIAttack>(); },
+            [] { return std::make_shared<TDAIDefence>(); });
+    return 0;
+}
@@ -15,8 +15,6 @@
 #include <iostream>
 #include <string>
 #include <vector>
-#include <mutex>
-#include <thread>
 #include <sstream>
 #include <algorithm>
 
@@ -26,6 +24,10 @@
 #include "core/ctrl/InteractiveCtrl.h"
 #include "core/ctrl/EvolveAICtrl.h"
 #include "core/ctrl/ExpertSystemCtrl.h"
+#include "core/ctrl/MCTSCtrl.h"
+#include "core/ctrl/ExpectiminimaxCtrl.h"
+#include "core/ctrl/TDAICtrl.h"
+#include "core/sim/Training.h"
 
 namespace {
 
@@ -99,6 +101,12 @@ std::shared_ptr<Character> interactiveCreateCharacter() {
                                       std::make_shared<EvolveAIDefence>()));
     ai_modes.push_back(std::make_pair(std::make_shared<MarkovAIAttack>(), 
                                       std::make_shared<EvolveAIDefence>()));
+    ai_modes.push_back(std::make_pair(std::make_shared<TDAIAttack>(), 
+                                      std::make_shared<TDAIDefence>()));
+    ai_modes.push_back(std::make_pair(std::make_shared<MCTSAttack>(), 
+                                      std::make_shared<MCTSDefence>()));
+    ai_modes.push_back(std::make_pair(std::make_shared<ExpectiminimaxAttack>(), 
+                                      std::make_shared<ExpectiminimaxDefence>()));
     std::cout << "Available AI combinations:" << std::endl;
     for(size_t i = 0; i < ai_modes.size(); ++i) {
         std::cout << i << ") " << ai_modes[i].first->getName() << "," 
@@ -190,23 +198,6 @@ void singleFight(std::shared_ptr<Character> c1, std::shared_ptr<Character> c2) {
     d.fight();
 }
 
-void keepPickingFights(std::mutex *fights_mutex, 
-                       std::vector<std::pair<std::shared_ptr<Character>, std::shared_ptr<Character>>> *fights) {
-    while(true) {
-        std::pair<std::shared_ptr<Character>, std::shared_ptr<Character>> f;
-        if(true) { // Just to have a scope
-            std::lock_guard<std::mutex> protect(*fights_mutex);
-            if(fights->size() == 0) {
-                break;
-            }
-            f = fights->back();
-            fights->pop_back();
-        }
-        Duel d(f.first, f.second, nullptr);
-        d.fight();
-    }
-}
-
 int run() {
     bool p1_human = true;
     bool p2_human = false;
@@ -248,7 +239,6 @@ int run() {
     p2_human = askTrueFalse("Is Player 2 human?");
 
     // Handle AI training first, if needed.
-    std::vector<std::pair<std::shared_ptr<Character>, std::shared_ptr<Character>>> fights;
     if(!p1_human || !p2_human) {
         int level = -1;
         while (level < 0 || level > 3) {
@@ -263,22 +253,10 @@ int run() {
         std::cout << std::endl 
                   << "Please wait while the AIs are being trained with these characters..."
                   << std::endl << std::endl;
-        for(int i = 0; i < (level+2) * 100; ++i) {
-            for(auto const &c1 : characters) {
-                for(auto const &c2 : characters) {
-                    if(c1 != c2) {
-                        fights.push_back(std::make_pair(c1, c2));
-                    }
-                }
-            }
-        }
-        std::vector<std::thread> threads;
-        std::mutex fights_mutex;
-        for(int i = 0; i < 4; ++i) {
-            threads.push_back(
-                std::thread(keepPickingFights, &fights_mutex, &fights));
-        }
-        for (auto& th : threads) th.join();
+        core::sim::Trainer trainer(characters,
+                                   core::sim::TrainingOptions::forLevel(level));
+        trainer.run(0, &std::cout);
+        std::cout << std::endl;
     }
 
     std::cout << "These are the available characters:" << std::endl;